@@ -14,6 +14,7 @@ BuildRequires: pkgconfig(Qt5Test)
 BuildRequires: pkgconfig(libwbxml2) >= 0.11.6
 BuildRequires: pkgconfig(sqlite3)
 BuildRequires: pkgconfig(openobex)
+BuildRequires: pkgconfig(zlib)
 BuildRequires: pkgconfig(buteosyncfw5) >= 0.6.24
 
 %description
@@ -35,13 +35,15 @@
 
 #include <QtSql>
 
+#include "DatabaseHandler.h"
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
 ChangeLog::ChangeLog( const QString& aRemoteDevice, const QString& aSourceDbURI,
                       SyncDirection aSyncDirection )
-: iRemoteDevice( aRemoteDevice ), iSourceDbURI( aSourceDbURI ), iSyncDirection( aSyncDirection )
+: iRemoteDevice( aRemoteDevice ), iSourceDbURI( aSourceDbURI ), iSyncDirection( aSyncDirection ),
+  iStoredMapsKnown( false ), iFingerprintsChanged( false ), iStoredFingerprintsKnown( false )
 
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -62,6 +64,11 @@ bool ChangeLog::load( QSqlDatabase& aDbHandle )
     qCDebug(lcSyncML) << "Database URI:" << iSourceDbURI;
     qCDebug(lcSyncML) << "Sync direction:" << iSyncDirection;
 
+    if( !ensureAnchorDatabase( aDbHandle ) || !ensureMapsDatabase( aDbHandle ) )
+    {
+        return false;
+    }
+
     return ( loadAnchors( aDbHandle ) && loadMaps( aDbHandle ) );
 }
 
@@ -69,26 +76,16 @@ bool ChangeLog::load( const QString& aDbName )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool success = false;
-
-    QString connectionName = generateConnectionName();
-    QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", connectionName );
-    database.setDatabaseName( aDbName );
+    // Uses the pooled connection of the database if one is open
+    DatabaseHandler handler( aDbName );
 
-    if( database.open() )
-    {
-        success = load( database );
-        database.close();
-    }
-    else
+    if( !handler.isValid() )
     {
         qCCritical(lcSyncML) << "Could not open database!";
+        return false;
     }
 
-    database = QSqlDatabase();
-    QSqlDatabase::removeDatabase( connectionName );
-
-    return success;
+    return load( handler.getDbHandle() );
 }
 
 bool ChangeLog::save( QSqlDatabase& aDbHandle )
@@ -105,13 +102,28 @@ bool ChangeLog::save( QSqlDatabase& aDbHandle )
         return false;
     }
 
-    bool transaction = aDbHandle.transaction();
+    // Nested in the transaction of the caller if there is one
+    bool transaction = DatabaseHandler::beginTransaction( aDbHandle );
 
     bool success = ( saveAnchors( aDbHandle ) && saveMaps( aDbHandle ) );
 
-    if( transaction && ( !success || !aDbHandle.commit() ) ) {
-        success = false;
-        aDbHandle.rollback();
+    if( success && iFingerprintsChanged ) {
+        success = ( ensureFingerprintsDatabase( aDbHandle ) && saveFingerprints( aDbHandle ) );
+    }
+
+    if( transaction ) {
+        if( !success ) {
+            DatabaseHandler::rollbackTransaction( aDbHandle );
+        }
+        else if( !DatabaseHandler::commitTransaction( aDbHandle ) ) {
+            success = false;
+        }
+    }
+
+    if( !success ) {
+        // Changes were rolled back, so we no longer know what is in the database
+        iStoredMapsKnown = false;
+        iStoredFingerprintsKnown = false;
     }
 
     return success;
@@ -122,26 +134,16 @@ bool ChangeLog::save( const QString& aDbName )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool success = false;
-
-    QString connectionName = generateConnectionName();
-    QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", connectionName );
-    database.setDatabaseName( aDbName );
+    // Uses the pooled connection of the database if one is open
+    DatabaseHandler handler( aDbName );
 
-    if( database.open() )
-    {
-        success = save( database );
-        database.close();
-    }
-    else
+    if( !handler.isValid() )
     {
         qCCritical(lcSyncML) << "Could not open database!";
+        return false;
     }
 
-    database = QSqlDatabase();
-    QSqlDatabase::removeDatabase( connectionName );
-
-    return success;
+    return save( handler.getDbHandle() );
 }
 
 bool ChangeLog::remove( QSqlDatabase& aDbHandle )
@@ -153,33 +155,30 @@ bool ChangeLog::remove( QSqlDatabase& aDbHandle )
     qCDebug(lcSyncML) << "Database URI:" << iSourceDbURI;
     qCDebug(lcSyncML) << "Sync direction:" << iSyncDirection;
 
-    return ( removeAnchors( aDbHandle ) && removeMaps( aDbHandle ) );
+    if( !ensureAnchorDatabase( aDbHandle ) || !ensureMapsDatabase( aDbHandle ) ||
+        !ensureFingerprintsDatabase( aDbHandle ) )
+    {
+        return false;
+    }
+
+    return ( removeAnchors( aDbHandle ) && removeMaps( aDbHandle ) &&
+             removeFingerprints( aDbHandle ) );
 }
 
 bool ChangeLog::remove( const QString& aDbName )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool success = false;
-
-    QString connectionName = generateConnectionName();
-    QSqlDatabase database = QSqlDatabase::addDatabase( "QSQLITE", connectionName );
-    database.setDatabaseName( aDbName );
+    // Uses the pooled connection of the database if one is open
+    DatabaseHandler handler( aDbName );
 
-    if( database.open() )
-    {
-        success = remove( database );
-        database.close();
-    }
-    else
+    if( !handler.isValid() )
     {
         qCCritical(lcSyncML) << "Could not open database!";
+        return false;
     }
 
-    database = QSqlDatabase();
-    QSqlDatabase::removeDatabase( connectionName );
-
-    return success;
+    return remove( handler.getDbHandle() );
 }
 
 const QString& ChangeLog::getLastLocalAnchor() const
@@ -222,16 +221,56 @@ void ChangeLog::setMaps( const QList<UIDMapping>& aMaps )
     iMaps = aMaps;
 }
 
-QString ChangeLog::generateConnectionName()
+bool ChangeLog::loadFingerprints( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString CONNECTIONNAME( "changelog" );
+    if( !ensureFingerprintsDatabase( aDbHandle ) ) {
+        return false;
+    }
+
+    bool loaded = false;
+
+    const QString queryString( "SELECT item_key, fingerprint FROM item_fingerprints WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+    query.bindValue( ":sync_direction", iSyncDirection );
+
+    if( query.exec() )
+    {
+        iFingerprints.clear();
+
+        while( query.next() )
+        {
+            iFingerprints.insert( query.value(0).toString(), query.value(1).toByteArray() );
+        }
+
+        qCDebug(lcSyncML) << "Loaded" << iFingerprints.count() << "item fingerprints";
 
-    static unsigned connectionNumber = 0;
+        iStoredFingerprints = iFingerprints;
+        iStoredFingerprintsKnown = true;
+        iFingerprintsChanged = false;
+        loaded = true;
+    }
+    else
+    {
+        qCCritical(lcSyncML) << "Could not load item fingerprints:" << query.lastError();
+    }
 
-    return CONNECTIONNAME + QString::number( connectionNumber++ );
+    return loaded;
+}
 
+const QHash<SyncItemKey, QByteArray>& ChangeLog::getFingerprints() const
+{
+    return iFingerprints;
+}
+
+void ChangeLog::setFingerprints( const QHash<SyncItemKey, QByteArray>& aFingerprints )
+{
+    iFingerprints = aFingerprints;
+    iFingerprintsChanged = true;
 }
 
 bool ChangeLog::ensureAnchorDatabase( QSqlDatabase& aDbHandle )
@@ -240,17 +279,14 @@ bool ChangeLog::ensureAnchorDatabase( QSqlDatabase& aDbHandle )
 
     const QString queryString( "CREATE TABLE if not exists change_logs(id integer primary key autoincrement, remote_device varchar(512), source_db_uri varchar(512), sync_direction INTEGER, local_sync_anchor varchar(128), remote_sync_anchor varchar(128),  last_sync_time timestamp)" );
 
-    QSqlQuery query( queryString, aDbHandle );
-
-    if( query.exec() ) {
+    if( DatabaseHandler::ensureSchema( aDbHandle, queryString ) ) {
         return true;
     }
     else {
-        qCCritical(lcSyncML) << "Could not ensure anchor database table:" << query.lastError();
+        qCCritical(lcSyncML) << "Could not ensure anchor database table";
         return false;
     }
 
-
 }
 
 bool ChangeLog::ensureMapsDatabase( QSqlDatabase& aDbHandle )
@@ -259,16 +295,42 @@ bool ChangeLog::ensureMapsDatabase( QSqlDatabase& aDbHandle )
 
     const QString queryString( "CREATE TABLE IF NOT EXISTS id_maps(id integer primary key autoincrement, remote_device varchar(512), source_db_uri varchar(512), sync_direction INTEGER, local_id varchar(128), remote_id varchar(128))" );
 
-    QSqlQuery query( queryString, aDbHandle );
+    if( !DatabaseHandler::ensureSchema( aDbHandle, queryString ) ) {
+        qCCritical(lcSyncML) << "Could not ensure ID maps database table";
+        return false;
+    }
+
+    const QString indexString( "CREATE INDEX IF NOT EXISTS id_maps_local_id ON id_maps(remote_device, source_db_uri, sync_direction, local_id)" );
 
-    if( query.exec() ) {
-        return true;
+    if( !DatabaseHandler::ensureSchema( aDbHandle, indexString ) ) {
+        qCCritical(lcSyncML) << "Could not ensure ID maps index";
+        return false;
     }
-    else {
-        qCCritical(lcSyncML) << "Could not ensure ID maps database table:" << query.lastError();
+
+    return true;
+
+}
+
+bool ChangeLog::ensureFingerprintsDatabase( QSqlDatabase& aDbHandle )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const QString queryString( "CREATE TABLE IF NOT EXISTS item_fingerprints(id integer primary key autoincrement, remote_device varchar(512), source_db_uri varchar(512), sync_direction INTEGER, item_key varchar(128), fingerprint blob)" );
+
+    if( !DatabaseHandler::ensureSchema( aDbHandle, queryString ) ) {
+        qCCritical(lcSyncML) << "Could not ensure item fingerprints database table";
+        return false;
+    }
+
+    const QString indexString( "CREATE INDEX IF NOT EXISTS item_fingerprints_item_key ON item_fingerprints(remote_device, source_db_uri, sync_direction, item_key)" );
+
+    if( !DatabaseHandler::ensureSchema( aDbHandle, indexString ) ) {
+        qCCritical(lcSyncML) << "Could not ensure item fingerprints index";
         return false;
     }
 
+    return true;
+
 }
 
 bool ChangeLog::loadAnchors( QSqlDatabase& aDbHandle )
@@ -279,8 +341,7 @@ bool ChangeLog::loadAnchors( QSqlDatabase& aDbHandle )
 
     const QString queryString( "SELECT local_sync_anchor, remote_sync_anchor, last_sync_time FROM change_logs WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
 
-    QSqlQuery query( queryString, aDbHandle );
-    query.prepare( queryString );
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
     query.bindValue( ":remote_device", iRemoteDevice );
     query.bindValue( ":source_db_uri", iSourceDbURI );
     query.bindValue( ":sync_direction", iSyncDirection );
@@ -304,6 +365,8 @@ bool ChangeLog::loadAnchors( QSqlDatabase& aDbHandle )
             qCDebug(lcSyncML) << "No existing anchor entry found from database, creating new";
         }
 
+        query.finish();
+
     }
     else {
         qCWarning(lcSyncML) << "Could not load anchors:" << query.lastError();
@@ -322,8 +385,7 @@ bool ChangeLog::saveAnchors( QSqlDatabase& aDbHandle )
 
         const QString queryString( "INSERT INTO change_logs(remote_device, source_db_uri, sync_direction, local_sync_anchor, remote_sync_anchor, last_sync_time) VALUES (:remote_device, :source_db_uri, :sync_direction, :local_sync_anchor, :remote_sync_anchor, :last_sync_time)" );
 
-        QSqlQuery query( queryString, aDbHandle );
-        query.prepare( queryString );
+        QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
         query.bindValue( ":remote_device", iRemoteDevice );
         query.bindValue( ":source_db_uri", iSourceDbURI );
         query.bindValue( ":sync_direction", iSyncDirection );
@@ -356,31 +418,23 @@ bool ChangeLog::removeAnchors( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Table has been ensured by the caller
     bool success = false;
 
-    QStringList tables = aDbHandle.tables();
+    const QString queryString( "DELETE FROM change_logs WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+    query.bindValue( ":sync_direction", iSyncDirection );
 
-    if( !tables.contains("change_logs") ) {
-        qCDebug(lcSyncML) << "Change logs table not present. Considering anchors as removed";
+    if( query.exec() ) {
         success = true;
     }
     else {
-        const QString queryString( "DELETE FROM change_logs WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
-
-        QSqlQuery query( queryString, aDbHandle );
-        query.prepare( queryString );
-        query.bindValue( ":remote_device", iRemoteDevice );
-        query.bindValue( ":source_db_uri", iSourceDbURI );
-        query.bindValue( ":sync_direction", iSyncDirection );
-
-
-        if( query.exec() ) {
-            success = true;
-        }
-        else {
-            qCWarning(lcSyncML) << "Could not remove anchors:" << query.lastError();
-        }
+        qCWarning(lcSyncML) << "Could not remove anchors:" << query.lastError();
     }
+
     return success;
 }
 
@@ -390,10 +444,9 @@ bool ChangeLog::loadMaps( QSqlDatabase& aDbHandle )
 
     bool loaded = false;
 
-    const QString queryString("SELECT local_id, remote_id FROM id_maps WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
+    const QString queryString("SELECT local_id, remote_id FROM id_maps WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction ORDER BY id" );
 
-    QSqlQuery query( queryString, aDbHandle );
-    query.prepare( queryString );
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
     query.bindValue( ":remote_device", iRemoteDevice );
     query.bindValue( ":source_db_uri", iSourceDbURI );
     query.bindValue( ":sync_direction", iSyncDirection );
@@ -401,6 +454,7 @@ bool ChangeLog::loadMaps( QSqlDatabase& aDbHandle )
     if( query.exec() )
     {
         iMaps.clear();
+        iStoredMaps.clear();
 
         while( query.next() )
         {
@@ -408,8 +462,10 @@ bool ChangeLog::loadMaps( QSqlDatabase& aDbHandle )
             mapping.iLocalUID = query.value(0).toString();
             mapping.iRemoteUID = query.value(1).toString();
             iMaps.append( mapping );
+            iStoredMaps.insert( qMakePair( mapping.iLocalUID, mapping.iRemoteUID ) );
         }
 
+        iStoredMapsKnown = true;
         loaded = true;
     }
     else
@@ -425,79 +481,319 @@ bool ChangeLog::saveMaps( QSqlDatabase& aDbHandle )
 
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool success = false;
-
-    if( removeMaps( aDbHandle ) )
+    if( !iStoredMapsKnown && !removeMaps( aDbHandle ) )
     {
-        const QString queryString( "INSERT INTO id_maps(remote_device, source_db_uri, sync_direction, local_id, remote_id) values(:remote_device, :source_db_uri, :sync_direction, :local_id, :remote_id)" );
-
-        QSqlQuery query( queryString, aDbHandle );
-        query.prepare( queryString );
-
-        QVariantList device;
-        QVariantList sourceDbURI;
-        QVariantList syncDirection;
-        QVariantList localId;
-        QVariantList remoteId;
-
-        for( int i = 0; i < iMaps.count(); ++i ) {
-            device << iRemoteDevice;
-            sourceDbURI << iSourceDbURI;
-            syncDirection << iSyncDirection;
-            localId << iMaps[i].iLocalUID;
-            remoteId << iMaps[i].iRemoteUID;
-        }
+        qCCritical(lcSyncML) << "Could not save ID maps as database cleaning failed";
+        return false;
+    }
 
-        query.addBindValue( device );
-        query.addBindValue( sourceDbURI );
-        query.addBindValue( syncDirection );
-        query.addBindValue( localId );
-        query.addBindValue( remoteId );
+    // Only write the maps that have changed since the maps were last loaded
+    // or saved
+    QSet<QPair<QString, QString> > maps;
+    maps.reserve( iMaps.count() );
+    QList<UIDMapping> addedMaps;
 
-        if( query.execBatch() ) {
-            qCDebug(lcSyncML) << "ID maps information saved";
-            success = true;
+    for( int i = 0; i < iMaps.count(); ++i ) {
+        QPair<QString, QString> map = qMakePair( iMaps[i].iLocalUID, iMaps[i].iRemoteUID );
+
+        if( !iStoredMaps.contains( map ) ) {
+            addedMaps.append( iMaps[i] );
         }
-        else {
-            qCWarning(lcSyncML) << "Query failed: " << query.lastError();
+
+        maps.insert( map );
+    }
+
+    QList<UIDMapping> removedMaps;
+
+    QSetIterator<QPair<QString, QString> > i( iStoredMaps );
+    while( i.hasNext() ) {
+        const QPair<QString, QString>& map = i.next();
+
+        if( !maps.contains( map ) ) {
+            UIDMapping mapping;
+            mapping.iLocalUID = map.first;
+            mapping.iRemoteUID = map.second;
+            removedMaps.append( mapping );
         }
     }
-    else
-    {
-        qCCritical(lcSyncML) << "Could not save ID maps as database cleaning failed";
+
+    if( !deleteMaps( aDbHandle, removedMaps ) || !insertMaps( aDbHandle, addedMaps ) ) {
+        return false;
     }
 
-    return success;
+    qCDebug(lcSyncML) << "ID maps information saved:" << addedMaps.count() << "added,"
+                      << removedMaps.count() << "removed";
+
+    iStoredMaps = maps;
+    iStoredMapsKnown = true;
+
+    return true;
+}
+
+bool ChangeLog::insertMaps( QSqlDatabase& aDbHandle, const QList<UIDMapping>& aMaps )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aMaps.isEmpty() ) {
+        return true;
+    }
+
+    const QString queryString( "INSERT INTO id_maps(remote_device, source_db_uri, sync_direction, local_id, remote_id) values(:remote_device, :source_db_uri, :sync_direction, :local_id, :remote_id)" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+
+    QVariantList device;
+    QVariantList sourceDbURI;
+    QVariantList syncDirection;
+    QVariantList localId;
+    QVariantList remoteId;
+
+    for( int i = 0; i < aMaps.count(); ++i ) {
+        device << iRemoteDevice;
+        sourceDbURI << iSourceDbURI;
+        syncDirection << iSyncDirection;
+        localId << aMaps[i].iLocalUID;
+        remoteId << aMaps[i].iRemoteUID;
+    }
+
+    query.bindValue( ":remote_device", device );
+    query.bindValue( ":source_db_uri", sourceDbURI );
+    query.bindValue( ":sync_direction", syncDirection );
+    query.bindValue( ":local_id", localId );
+    query.bindValue( ":remote_id", remoteId );
+
+    if( !query.execBatch() ) {
+        qCWarning(lcSyncML) << "Could not insert ID maps:" << query.lastError();
+        return false;
+    }
+
+    return true;
+}
+
+bool ChangeLog::deleteMaps( QSqlDatabase& aDbHandle, const QList<UIDMapping>& aMaps )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aMaps.isEmpty() ) {
+        return true;
+    }
+
+    const QString queryString( "DELETE FROM id_maps WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction AND local_id = :local_id AND remote_id = :remote_id" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+
+    QVariantList device;
+    QVariantList sourceDbURI;
+    QVariantList syncDirection;
+    QVariantList localId;
+    QVariantList remoteId;
+
+    for( int i = 0; i < aMaps.count(); ++i ) {
+        device << iRemoteDevice;
+        sourceDbURI << iSourceDbURI;
+        syncDirection << iSyncDirection;
+        localId << aMaps[i].iLocalUID;
+        remoteId << aMaps[i].iRemoteUID;
+    }
+
+    query.bindValue( ":remote_device", device );
+    query.bindValue( ":source_db_uri", sourceDbURI );
+    query.bindValue( ":sync_direction", syncDirection );
+    query.bindValue( ":local_id", localId );
+    query.bindValue( ":remote_id", remoteId );
+
+    if( !query.execBatch() ) {
+        qCWarning(lcSyncML) << "Could not delete ID maps:" << query.lastError();
+        return false;
+    }
+
+    return true;
 }
 
 bool ChangeLog::removeMaps( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Table has been ensured by the caller
     bool success = false;
 
-    QStringList tables = aDbHandle.tables();
+    const QString queryString( "DELETE FROM id_maps WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+    query.bindValue( ":sync_direction", iSyncDirection );
 
-    if( !tables.contains("id_maps") ) {
-        qCDebug(lcSyncML) << "id maps table not present";
+    if( query.exec() ) {
         success = true;
     }
     else {
-        const QString queryString( "DELETE FROM id_maps WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
+        qCWarning(lcSyncML) << "Could not remove ID maps:" << query.lastError();
+    }
 
-        QSqlQuery query( queryString, aDbHandle );
-        query.prepare( queryString );
-        query.bindValue( ":remote_device", iRemoteDevice );
-        query.bindValue( ":source_db_uri", iSourceDbURI );
-        query.bindValue( ":sync_direction", iSyncDirection );
+    if( success ) {
+        iStoredMaps.clear();
+        iStoredMapsKnown = true;
+    }
 
-        if( query.exec() ) {
-            success = true;
+    return success;
+}
+
+bool ChangeLog::saveFingerprints( QSqlDatabase& aDbHandle )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iStoredFingerprintsKnown && !removeFingerprints( aDbHandle ) )
+    {
+        qCCritical(lcSyncML) << "Could not save item fingerprints as database cleaning failed";
+        return false;
+    }
+
+    // Only write the fingerprints that have changed since they were last
+    // loaded or saved. Changed fingerprints are both deleted and inserted
+    QList<SyncItemKey> insertedKeys;
+    QList<SyncItemKey> deletedKeys;
+
+    QHashIterator<SyncItemKey, QByteArray> i( iFingerprints );
+    while( i.hasNext() ) {
+        i.next();
+
+        QHash<SyncItemKey, QByteArray>::const_iterator stored = iStoredFingerprints.constFind( i.key() );
+
+        if( stored == iStoredFingerprints.constEnd() ) {
+            insertedKeys.append( i.key() );
         }
-        else {
-            qCWarning(lcSyncML) << "Could not remove ID maps:" << query.lastError();
+        else if( stored.value() != i.value() ) {
+            deletedKeys.append( i.key() );
+            insertedKeys.append( i.key() );
         }
     }
 
+    QHashIterator<SyncItemKey, QByteArray> j( iStoredFingerprints );
+    while( j.hasNext() ) {
+        j.next();
+
+        if( !iFingerprints.contains( j.key() ) ) {
+            deletedKeys.append( j.key() );
+        }
+    }
+
+    if( !deleteFingerprints( aDbHandle, deletedKeys ) || !insertFingerprints( aDbHandle, insertedKeys ) ) {
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "Item fingerprints saved:" << insertedKeys.count() << "written,"
+                      << deletedKeys.count() << "deleted";
+
+    iStoredFingerprints = iFingerprints;
+    iStoredFingerprintsKnown = true;
+    iFingerprintsChanged = false;
+
+    return true;
+}
+
+bool ChangeLog::removeFingerprints( QSqlDatabase& aDbHandle )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Table has been ensured by the caller
+    bool success = false;
+
+    const QString queryString( "DELETE FROM item_fingerprints WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+    query.bindValue( ":sync_direction", iSyncDirection );
+
+    if( query.exec() ) {
+        success = true;
+    }
+    else {
+        qCWarning(lcSyncML) << "Could not remove item fingerprints:" << query.lastError();
+    }
+
+    if( success ) {
+        iStoredFingerprints.clear();
+        iStoredFingerprintsKnown = true;
+    }
+
     return success;
 }
+
+bool ChangeLog::insertFingerprints( QSqlDatabase& aDbHandle, const QList<SyncItemKey>& aKeys )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aKeys.isEmpty() ) {
+        return true;
+    }
+
+    const QString queryString( "INSERT INTO item_fingerprints(remote_device, source_db_uri, sync_direction, item_key, fingerprint) values(:remote_device, :source_db_uri, :sync_direction, :item_key, :fingerprint)" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+
+    QVariantList device;
+    QVariantList sourceDbURI;
+    QVariantList syncDirection;
+    QVariantList itemKey;
+    QVariantList fingerprint;
+
+    for( int i = 0; i < aKeys.count(); ++i ) {
+        device << iRemoteDevice;
+        sourceDbURI << iSourceDbURI;
+        syncDirection << iSyncDirection;
+        itemKey << aKeys[i];
+        fingerprint << iFingerprints.value( aKeys[i] );
+    }
+
+    query.bindValue( ":remote_device", device );
+    query.bindValue( ":source_db_uri", sourceDbURI );
+    query.bindValue( ":sync_direction", syncDirection );
+    query.bindValue( ":item_key", itemKey );
+    query.bindValue( ":fingerprint", fingerprint );
+
+    if( !query.execBatch() ) {
+        qCWarning(lcSyncML) << "Could not insert item fingerprints:" << query.lastError();
+        return false;
+    }
+
+    return true;
+}
+
+bool ChangeLog::deleteFingerprints( QSqlDatabase& aDbHandle, const QList<SyncItemKey>& aKeys )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aKeys.isEmpty() ) {
+        return true;
+    }
+
+    const QString queryString( "DELETE FROM item_fingerprints WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri AND sync_direction = :sync_direction AND item_key = :item_key" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+
+    QVariantList device;
+    QVariantList sourceDbURI;
+    QVariantList syncDirection;
+    QVariantList itemKey;
+
+    for( int i = 0; i < aKeys.count(); ++i ) {
+        device << iRemoteDevice;
+        sourceDbURI << iSourceDbURI;
+        syncDirection << iSyncDirection;
+        itemKey << aKeys[i];
+    }
+
+    query.bindValue( ":remote_device", device );
+    query.bindValue( ":source_db_uri", sourceDbURI );
+    query.bindValue( ":sync_direction", syncDirection );
+    query.bindValue( ":item_key", itemKey );
+
+    if( !query.execBatch() ) {
+        qCWarning(lcSyncML) << "Could not delete item fingerprints:" << query.lastError();
+        return false;
+    }
+
+    return true;
+}
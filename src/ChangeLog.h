@@ -36,6 +36,10 @@
 
 #include <QString>
 #include <QDateTime>
+#include <QPair>
+#include <QSet>
+#include <QHash>
+#include <QByteArray>
 
 #include "SyncAgentConsts.h"
 #include "SyncMLGlobals.h"
@@ -158,12 +162,35 @@ public:
      */
     void setMaps( const QList<UIDMapping>& aMaps );
 
-private:
+    /*! \brief Loads the item fingerprints associated with this ChangeLog
+     *
+     * Fingerprints are not loaded by load(), as they are only needed when
+     * local changes are detected by comparing item content
+     *
+     * @param aDbHandle Database handle to use
+     * @return True on success, otherwise false
+     */
+    bool loadFingerprints( QSqlDatabase& aDbHandle );
+
+    /*! \brief Returns the item fingerprints associated with this ChangeLog
+     *
+     * @return Fingerprints of the local items after previous successful sync
+     */
+    const QHash<SyncItemKey, QByteArray>& getFingerprints() const;
+
+    /*! \brief Sets the item fingerprints associated with this ChangeLog
+     *
+     * Fingerprints are saved by save() once they have been set
+     *
+     * @param aFingerprints Fingerprints of the local items
+     */
+    void setFingerprints( const QHash<SyncItemKey, QByteArray>& aFingerprints );
 
-    QString generateConnectionName();
+private:
 
     bool ensureAnchorDatabase( QSqlDatabase& aDbHandle );
     bool ensureMapsDatabase( QSqlDatabase& aDbHandle );
+    bool ensureFingerprintsDatabase( QSqlDatabase& aDbHandle );
 
     bool loadAnchors( QSqlDatabase& aDbHandle );
     bool saveAnchors( QSqlDatabase& aDbHandle );
@@ -173,6 +200,17 @@ private:
     bool saveMaps( QSqlDatabase& aDbHandle );
     bool removeMaps( QSqlDatabase& aDbHandle );
 
+    bool insertMaps( QSqlDatabase& aDbHandle, const QList<UIDMapping>& aMaps );
+
+    bool deleteMaps( QSqlDatabase& aDbHandle, const QList<UIDMapping>& aMaps );
+
+    bool saveFingerprints( QSqlDatabase& aDbHandle );
+    bool removeFingerprints( QSqlDatabase& aDbHandle );
+
+    bool insertFingerprints( QSqlDatabase& aDbHandle, const QList<SyncItemKey>& aKeys );
+
+    bool deleteFingerprints( QSqlDatabase& aDbHandle, const QList<SyncItemKey>& aKeys );
+
     QString             iRemoteDevice;
     QString             iSourceDbURI;
     SyncDirection       iSyncDirection;
@@ -182,6 +220,19 @@ private:
     QDateTime           iLastSyncTime;
     QList<UIDMapping>   iMaps;
 
+    // ID maps as they are currently stored in the database, as pairs of
+    // local and remote id. Used to save only the changes in the maps
+    QSet<QPair<QString, QString> > iStoredMaps;
+    bool                iStoredMapsKnown;
+
+    QHash<SyncItemKey, QByteArray> iFingerprints;
+    bool                iFingerprintsChanged;
+
+    // Fingerprints as they are currently stored in the database. Used to
+    // save only the changes in the fingerprints
+    QHash<SyncItemKey, QByteArray> iStoredFingerprints;
+    bool                iStoredFingerprintsKnown;
+
 
 };
 
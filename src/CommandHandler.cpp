@@ -181,7 +181,41 @@ void CommandHandler::handleStatus(StatusParams* aStatusParams )
     if ( aStatusParams->cmd == SYNCML_ELEMENT_ADD ||
          aStatusParams->cmd == SYNCML_ELEMENT_REPLACE ||
          aStatusParams->cmd == SYNCML_ELEMENT_DELETE ) {
-        emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef, aStatusParams->sourceRef );
+
+        if( aStatusParams->sourceRefs.isEmpty() && aStatusParams->targetRef.isEmpty() &&
+            aStatusParams->items.isEmpty() ) {
+            // Status without references applies to all items of the command
+            emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef, SyncItemKey(),
+                                   statusCode );
+        }
+        else {
+
+            if( !aStatusParams->sourceRefs.isEmpty() ) {
+                for( int i = 0; i < aStatusParams->sourceRefs.count(); ++i ) {
+                    emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef,
+                                           aStatusParams->sourceRefs[i], statusCode );
+                }
+            }
+            else if( !aStatusParams->targetRef.isEmpty() ) {
+                // Item was sent with only the remote key as its target
+                emit remoteItemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef,
+                                             aStatusParams->targetRef, statusCode );
+            }
+
+            // Status shared by several items of a command lists them as items
+            for( int i = 0; i < aStatusParams->items.count(); ++i ) {
+                const ItemParams& item = aStatusParams->items[i];
+
+                if( !item.source.isEmpty() ) {
+                    emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef,
+                                           item.source, statusCode );
+                }
+                else if( !item.target.isEmpty() ) {
+                    emit remoteItemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef,
+                                                 item.target, statusCode );
+                }
+            }
+        }
     }
 
 }
@@ -405,8 +439,9 @@ void CommandHandler::composeBatches( const SyncParams& aSyncParams, SyncTarget&
                         aResponses.insert( id, COMMAND_NOT_ALLOWED );
                     }
                     else if( aStorageHandler.appendLargeObjectData( item.data ) ) {
+                        bool sizeMatches = aStorageHandler.largeObjectSizeMatches();
                         if( !aStorageHandler.finishLargeObject( id ) ) {
-                            aResponses.insert( id, COMMAND_FAILED );
+                            aResponses.insert( id, sizeMatches ? COMMAND_FAILED : SIZE_MISMATCH );
                         }
                     }
                     else {
@@ -477,7 +512,7 @@ void CommandHandler::composeBatches( const SyncParams& aSyncParams, SyncTarget&
 
                     if( aStorageHandler.buildingLargeObject() ) {
 
-                        if( aStorageHandler.appendLargeObjectData( item.data.toUtf8() ) ) {
+                        if( aStorageHandler.appendLargeObjectData( item.data ) ) {
                             aResponseGenerator.addPackage( new AlertPackage( NEXT_MESSAGE,
                                                                              aTarget.getSourceDatabase(),
                                                                              aTarget.getTargetDatabase() ) );
@@ -501,8 +536,9 @@ void CommandHandler::composeBatches( const SyncParams& aSyncParams, SyncTarget&
                         aResponses.insert( id, COMMAND_NOT_ALLOWED );
                     }
                     else if( aStorageHandler.appendLargeObjectData( item.data ) ) {
+                        bool sizeMatches = aStorageHandler.largeObjectSizeMatches();
                         if( !aStorageHandler.finishLargeObject( id ) ) {
-                            aResponses.insert( id, COMMAND_FAILED );
+                            aResponses.insert( id, sizeMatches ? COMMAND_FAILED : SIZE_MISMATCH );
                         }
                     }
                     else {
@@ -570,12 +606,21 @@ void CommandHandler::commitBatches( StorageHandler& aStorageHandler, ConflictRes
         resolver = NULL;
     }
 
+    // Items matching existing local items are not added
+    if( aTarget.getItemMatcher() ) {
+        results.unite( aStorageHandler.matchAddedItems( *aTarget.getItemMatcher(), *aTarget.getPlugin(),
+                                                        resolver ) );
+    }
+
     results.unite( aStorageHandler.commitAddedItems( *aTarget.getPlugin(), resolver ) );
     results.unite( aStorageHandler.commitReplacedItems( *aTarget.getPlugin(), resolver ) );
     results.unite( aStorageHandler.commitDeletedItems( *aTarget.getPlugin(), resolver ) );
 
     // Process commit results and convert them to result codes
 
+    QSet<SyncItemKey> matchedItems;
+    QList<SyncItemKey> changedMatchedItems;
+
     for( int i = 0; i < aSyncParams.commands.count(); ++i ) {
 
         const CommandParams& data = aSyncParams.commands[i];
@@ -597,6 +642,12 @@ void CommandHandler::commitBatches( StorageHandler& aStorageHandler, ConflictRes
 
                     const CommitResult& result = results.value( id );
 
+                    if( result.iStatus == COMMIT_ADDED || result.iStatus == COMMIT_INIT_ADD ||
+                        result.iStatus == COMMIT_REPLACED || result.iStatus == COMMIT_INIT_REPLACE ||
+                        result.iStatus == COMMIT_DELETED || result.iStatus == COMMIT_INIT_DELETE ) {
+                        aTarget.addCommittedItem( result.iItemKey );
+                    }
+
                     if( result.iStatus == COMMIT_ADDED || result.iStatus == COMMIT_INIT_ADD) {
 
                         if( result.iConflict == CONFLICT_LOCAL_WIN ) {
@@ -680,6 +731,46 @@ void CommandHandler::commitBatches( StorageHandler& aStorageHandler, ConflictRes
                     else if( result.iStatus == COMMIT_DUPLICATE ) {
                         statusCode = ALREADY_EXISTS;
                     }
+                    else if( result.iStatus == COMMIT_MATCHED ) {
+
+                        if( result.iConflict == CONFLICT_LOCAL_WIN ) {
+
+                            if( iRole == ROLE_CLIENT ) {
+                                statusCode = RESOLVED_CLIENT_WINNING;
+                            }
+                            else {
+                                statusCode = RESOLVED_WITH_SERVER_DATA;
+                            }
+                        }
+                        else if( result.iConflict == CONFLICT_REMOTE_WIN ) {
+
+                            if( iRole == ROLE_CLIENT ) {
+                                statusCode = RESOLVED_WITH_SERVER_DATA;
+                            }
+                            else {
+                                statusCode = RESOLVED_CLIENT_WINNING;
+                            }
+                        }
+                        else {
+                            // Local item was kept as it is
+                            statusCode = ALREADY_EXISTS;
+                        }
+
+                        // Local item was replaced with the added data
+                        if( result.iConflict == CONFLICT_REMOTE_WIN ) {
+                            aTarget.addCommittedItem( result.iItemKey );
+                        }
+
+                        UIDMapping map;
+                        map.iRemoteUID = item.source;
+                        map.iLocalUID = result.iItemKey;
+                        aNewMappings.append( map );
+                        matchedItems.insert( result.iItemKey );
+
+                        if( result.iConflict == CONFLICT_LOCAL_WIN ) {
+                            changedMatchedItems.append( result.iItemKey );
+                        }
+                    }
                     else if( result.iStatus == COMMIT_NOT_DELETED ) {
                         statusCode = ITEM_NOT_DELETED;
                         aTarget.removeUIDMapping( result.iItemKey );
@@ -708,6 +799,27 @@ void CommandHandler::commitBatches( StorageHandler& aStorageHandler, ConflictRes
         }
 
     }
+
+    if( !matchedItems.isEmpty() ) {
+
+        // Matched items already exist on the remote device, so they are not
+        // sent as added. Local version replaces the remote one if they differ
+        QList<SyncItemKey>& added = aTarget.getLocalChanges()->added;
+        QList<SyncItemKey> remaining;
+        remaining.reserve( added.count() );
+
+        for( int j = 0; j < added.count(); ++j ) {
+            if( !matchedItems.contains( added[j] ) ) {
+                remaining.append( added[j] );
+            }
+        }
+
+        added.swap( remaining );
+
+        for( int j = 0; j < changedMatchedItems.count(); ++j ) {
+            aConflictResolver.addLocalModification( changedMatchedItems[j] );
+        }
+    }
 }
 
 void CommandHandler::processResults( const SyncParams& aSyncParams, const QMap<ItemId, ResponseStatusCode>& aResponses,
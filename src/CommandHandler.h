@@ -141,9 +141,24 @@ signals:
      *
      * @param aMsgRef Message reference to the item
      * @param aCmdRef Command reference to the item
-     * @param aSyncItemKey Key of the item
+     * @param aSyncItemKey Key of the item, empty if status applies to all items of the command
+     * @param aStatusCode Status code the remote device responded with
      */
-    void itemAcknowledged( int aMsgRef, int aCmdRef, SyncItemKey aSyncItemKey );
+    void itemAcknowledged( int aMsgRef, int aCmdRef, SyncItemKey aSyncItemKey, int aStatusCode );
+
+    /*! \brief Signal indicating that remote device has acknowledged an item we've sent
+     *         by referring to its remote key
+     *
+     * Items sent with only a Target, like Replaces and Deletes of a server,
+     * are acknowledged this way, whether referred to by TargetRef or by the
+     * Target of an Item in the status.
+     *
+     * @param aMsgRef Message reference to the item
+     * @param aCmdRef Command reference to the item
+     * @param aRemoteKey Key of the item in the remote device
+     * @param aStatusCode Status code the remote device responded with
+     */
+    void remoteItemAcknowledged( int aMsgRef, int aCmdRef, QString aRemoteKey, int aStatusCode );
 
     /*! \brief Signal indicating that remote device has acknowledged a map we've sent
      *
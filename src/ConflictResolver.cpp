@@ -45,11 +45,23 @@ ConflictResolver::ConflictResolver( LocalChanges& aLocalChanges,
  : iLocalChanges( aLocalChanges ), iPolicy( aPolicy )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iModifiedKeys.reserve( iLocalChanges.modified.count() );
+    foreach( const SyncItemKey& key, iLocalChanges.modified ) {
+        iModifiedKeys.insert( key );
+    }
+
+    iRemovedKeys.reserve( iLocalChanges.removed.count() );
+    foreach( const SyncItemKey& key, iLocalChanges.removed ) {
+        iRemovedKeys.insert( key );
+    }
 }
 
 ConflictResolver::~ConflictResolver()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    applyRevertedChanges();
 }
 
 
@@ -63,8 +75,8 @@ bool ConflictResolver::isConflict( const SyncItemKey& aKey,
     // If item can be found from modified list, it is always a conflict. If item can
     // be found from removed list, it is conflict only if command doesn't involve deleting the item
 
-    bool removalConflict = iLocalChanges.removed.contains( aKey ) && !aDelete;
-    bool modificationConflict = iLocalChanges.modified.contains( aKey );
+    bool removalConflict = iRemovedKeys.contains( aKey ) && !aDelete;
+    bool modificationConflict = iModifiedKeys.contains( aKey );
 
     return ( removalConflict || modificationConflict );
 }
@@ -90,11 +102,10 @@ void ConflictResolver::removeLocalChange( const SyncItemKey& aLocalKey )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool retval = false;
-    if (iLocalChanges.removed.contains( aLocalKey ))    
-        retval = iLocalChanges.removed.removeOne( aLocalKey );   
-    else
-        retval = iLocalChanges.modified.removeOne( aLocalKey );
+    if (iRemovedKeys.remove( aLocalKey ))
+        iRevertedRemovedKeys.insert( aLocalKey );
+    else if (iModifiedKeys.remove( aLocalKey ))
+        iRevertedModifiedKeys.insert( aLocalKey );
 }
     
 void ConflictResolver::changeLocalModifyToLocalAdd( const SyncItemKey& aLocalKey )
@@ -103,15 +114,40 @@ void ConflictResolver::changeLocalModifyToLocalAdd( const SyncItemKey& aLocalKey
 
     /* Reason for this is that in the case of a conflict scenario if the remote is delete and local is
      * modify and if remote wins the mapping is lost in remote side so a replace returns with an error*/	    
-    for (int i = 0; i < iLocalChanges.modified.size(); ++i) {
-        qCDebug(lcSyncML) << "Key :" << aLocalKey << "Remote" << iLocalChanges.modified.at(i);
-        if (iLocalChanges.modified.at(i) == aLocalKey){
-            qCDebug(lcSyncML) << "Change from replace to add ";
-	    iLocalChanges.modified.removeAt(i);
-	    iLocalChanges.added.append(aLocalKey);
-	    break;
+    if (iModifiedKeys.remove( aLocalKey )) {
+        qCDebug(lcSyncML) << "Change from replace to add:" << aLocalKey;
+        iRevertedModifiedKeys.insert( aLocalKey );
+        iLocalChanges.added.append( aLocalKey );
+    }
+}
+
+void ConflictResolver::applyRevertedChanges()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Remove first occurrence of each reverted key, preserving the order of
+    // the remaining changes
+    if( !iRevertedModifiedKeys.isEmpty() ) {
+        QList<SyncItemKey> modified;
+        modified.reserve( iLocalChanges.modified.count() - iRevertedModifiedKeys.count() );
+        foreach( const SyncItemKey& key, iLocalChanges.modified ) {
+            if( !iRevertedModifiedKeys.remove( key ) ) {
+                modified.append( key );
+            }
         }
-    }	  
+        iLocalChanges.modified = modified;
+    }
+
+    if( !iRevertedRemovedKeys.isEmpty() ) {
+        QList<SyncItemKey> removed;
+        removed.reserve( iLocalChanges.removed.count() - iRevertedRemovedKeys.count() );
+        foreach( const SyncItemKey& key, iLocalChanges.removed ) {
+            if( !iRevertedRemovedKeys.remove( key ) ) {
+                removed.append( key );
+            }
+        }
+        iLocalChanges.removed = removed;
+    }
 }
     
 void ConflictResolver::revertLocalChange( const SyncItemKey& aLocalKey, ConflictRevertPolicy policy ) 
@@ -129,3 +165,11 @@ void ConflictResolver::revertLocalChange( const SyncItemKey& aLocalKey, Conflict
 	break;
     }
 }
+
+void ConflictResolver::addLocalModification( const SyncItemKey& aLocalKey )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iModifiedKeys.insert( aLocalKey );
+    iLocalChanges.modified.append( aLocalKey );
+}
@@ -34,6 +34,8 @@
 #ifndef CONFLICTRESOLVER_H
 #define CONFLICTRESOLVER_H
 
+#include <QSet>
+
 #include "SyncAgentConsts.h"
 #include "SyncItemKey.h"
 
@@ -53,6 +55,11 @@ enum ConflictRevertPolicy {
  *
  *   This class resolves the conflicts of items based on the current conflict
  *   resolution policy.
+ *
+ *   Keys of locally modified and removed items are hashed when the resolver
+ *   is constructed, so conflict checks do not depend on the number of local
+ *   changes. Reverted local changes are removed from the ordered lists of
+ *   local changes in one pass by applyRevertedChanges().
  */
 class ConflictResolver {
 public:
@@ -67,6 +74,7 @@ public:
 
     /*! \brief Destructor
      *
+     * Applies reverted local changes to the local change lists
      */
     ~ConflictResolver();
 
@@ -92,6 +100,19 @@ public:
      * @param policy The conflict revert policy
      */
     void revertLocalChange( const SyncItemKey& aLocalKey, ConflictRevertPolicy policy ) ;
+
+    /*! \brief Removes reverted local changes from the local change lists
+     *
+     * Should be called after a batch of items has been resolved, before the
+     * local change lists are accessed. Called automatically on destruction.
+     */
+    void applyRevertedChanges();
+
+    /*! \brief Adds a local modification to the local changes
+     *
+     * @param aLocalKey Local UID of the modified item
+     */
+    void addLocalModification( const SyncItemKey& aLocalKey );
     
 private:
 
@@ -118,6 +139,13 @@ private:
     LocalChanges&    iLocalChanges;
     ConflictResolutionPolicy    iPolicy;
 
+    QSet<SyncItemKey>           iModifiedKeys;
+    QSet<SyncItemKey>           iRemovedKeys;
+
+    // Keys to remove from local change lists in applyRevertedChanges()
+    QSet<SyncItemKey>           iRevertedModifiedKeys;
+    QSet<SyncItemKey>           iRevertedRemovedKeys;
+
     friend class ConflictResolverTest;
 };
 
@@ -33,24 +33,88 @@
 
 #include "DatabaseHandler.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
 const QString CONNECTIONNAME( "dbhandler" );
 
-DatabaseHandler::DatabaseHandler( const QString& aDbFilePath )
+namespace DataSync {
+
+/*! \brief State of a pooled connection
+ *
+ * A connection is only used from the thread that opened it, so only the
+ * pool itself needs locking
+ */
+struct DatabaseConnection
+{
+    QString                 iKey;               ///< Database file, thread and pool key of the connection
+    int                     iRefCount;          ///< Number of handlers using the connection
+    int                     iTransactionDepth;  ///< Number of nested transactions
+    bool                    iRollback;          ///< Set when a nested transaction was rolled back
+    QHash<QString, QSqlQuery> iQueries;         ///< Prepared queries by statement
+    QSet<QString>           iSchema;            ///< Schema statements that have succeeded
+
+    DatabaseConnection() : iRefCount( 0 ), iTransactionDepth( 0 ), iRollback( false ) { }
+};
+
+}
+
+// Pooled connections by connection name, and connection names by database
+// file, thread and pool key
+static QMutex sPoolMutex;
+static QHash<QString, DatabaseConnection*> sConnections;
+static QHash<QString, QString> sConnectionNames;
+
+DatabaseHandler::DatabaseHandler( const QString& aDbFilePath, const QString& aPoolKey )
+ : iConnection( NULL )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     static unsigned connectionNumber = 0;
 
+    QMutexLocker locker( &sPoolMutex );
+
+    QString key = aDbFilePath + QLatin1Char( '/' ) +
+                  QString::number( reinterpret_cast<quintptr>( QThread::currentThread() ) ) +
+                  QLatin1Char( '/' ) + aPoolKey;
+
+    iConnectionName = sConnectionNames.value( key );
+
+    if( !iConnectionName.isEmpty() ) {
+        iConnection = sConnections.value( iConnectionName );
+        ++iConnection->iRefCount;
+        iDb = QSqlDatabase::database( iConnectionName, false );
+        return;
+    }
+
     iConnectionName = CONNECTIONNAME + QString::number( connectionNumber++ );
     iDb = QSqlDatabase::addDatabase( "QSQLITE", iConnectionName );
 
     iDb.setDatabaseName( aDbFilePath );
-    if(!iDb.open())
-	    qCCritical(lcSyncML) << "can not open database";
+    if( iDb.open() ) {
+        // Readers don't block the writer in WAL mode, and with WAL it is
+        // safe to sync only at checkpoints
+        QSqlQuery query( iDb );
+        if( !query.exec( "PRAGMA journal_mode=WAL" ) ||
+            !query.exec( "PRAGMA synchronous=NORMAL" ) ) {
+            qCWarning(lcSyncML) << "Could not enable WAL journal mode:" << query.lastError();
+        }
+    }
+    else {
+        qCCritical(lcSyncML) << "can not open database";
+    }
+
+    iConnection = new DatabaseConnection;
+    iConnection->iKey = key;
+    iConnection->iRefCount = 1;
+
+    sConnections.insert( iConnectionName, iConnection );
+    sConnectionNames.insert( key, iConnectionName );
 
 }
 
@@ -59,6 +123,26 @@ DatabaseHandler::~DatabaseHandler()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    QMutexLocker locker( &sPoolMutex );
+
+    if( --iConnection->iRefCount > 0 ) {
+        iDb = QSqlDatabase();
+        return;
+    }
+
+    if( iConnection->iTransactionDepth > 0 ) {
+        qCWarning(lcSyncML) << "Closing database with an active transaction, rolling back";
+        iDb.rollback();
+    }
+
+    sConnections.remove( iConnectionName );
+    sConnectionNames.remove( iConnection->iKey );
+
+    // Prepared queries must be released before the connection is removed
+    iConnection->iQueries.clear();
+    delete iConnection;
+    iConnection = NULL;
+
     iDb.close();
     iDb = QSqlDatabase();
     QSqlDatabase::removeDatabase( iConnectionName );
@@ -76,3 +160,136 @@ QSqlDatabase& DatabaseHandler::getDbHandle()
 {
     return iDb;
 }
+
+QSqlQuery DatabaseHandler::prepare( QSqlDatabase& aDbHandle, const QString& aQueryString )
+{
+    DatabaseConnection* connection = findConnection( aDbHandle );
+
+    if( connection ) {
+
+        QHash<QString, QSqlQuery>::iterator i = connection->iQueries.find( aQueryString );
+
+        if( i != connection->iQueries.end() ) {
+            // Release any results left from the previous use
+            i.value().finish();
+            return i.value();
+        }
+    }
+
+    QSqlQuery query( aDbHandle );
+
+    if( !query.prepare( aQueryString ) ) {
+        return query;
+    }
+
+    if( connection ) {
+        connection->iQueries.insert( aQueryString, query );
+    }
+
+    return query;
+}
+
+bool DatabaseHandler::ensureSchema( QSqlDatabase& aDbHandle, const QString& aQueryString )
+{
+    DatabaseConnection* connection = findConnection( aDbHandle );
+
+    if( connection && connection->iSchema.contains( aQueryString ) ) {
+        return true;
+    }
+
+    QSqlQuery query( aDbHandle );
+
+    if( !query.exec( aQueryString ) ) {
+        qCWarning(lcSyncML) << "Query failed:" << query.lastError();
+        return false;
+    }
+
+    if( connection ) {
+        connection->iSchema.insert( aQueryString );
+    }
+
+    return true;
+}
+
+bool DatabaseHandler::beginTransaction( QSqlDatabase& aDbHandle )
+{
+    DatabaseConnection* connection = findConnection( aDbHandle );
+
+    if( !connection ) {
+        return aDbHandle.transaction();
+    }
+
+    if( connection->iTransactionDepth == 0 ) {
+
+        if( !aDbHandle.transaction() ) {
+            qCWarning(lcSyncML) << "Could not begin transaction:" << aDbHandle.lastError();
+            return false;
+        }
+
+        connection->iRollback = false;
+    }
+
+    ++connection->iTransactionDepth;
+
+    return true;
+}
+
+bool DatabaseHandler::commitTransaction( QSqlDatabase& aDbHandle )
+{
+    DatabaseConnection* connection = findConnection( aDbHandle );
+
+    if( !connection ) {
+        return aDbHandle.commit();
+    }
+
+    if( connection->iTransactionDepth == 0 ) {
+        return false;
+    }
+
+    if( --connection->iTransactionDepth > 0 ) {
+        return true;
+    }
+
+    if( connection->iRollback ) {
+        connection->iRollback = false;
+        aDbHandle.rollback();
+        return false;
+    }
+
+    if( !aDbHandle.commit() ) {
+        qCWarning(lcSyncML) << "Could not commit transaction:" << aDbHandle.lastError();
+        aDbHandle.rollback();
+        return false;
+    }
+
+    return true;
+}
+
+void DatabaseHandler::rollbackTransaction( QSqlDatabase& aDbHandle )
+{
+    DatabaseConnection* connection = findConnection( aDbHandle );
+
+    if( !connection ) {
+        aDbHandle.rollback();
+        return;
+    }
+
+    if( connection->iTransactionDepth == 0 ) {
+        return;
+    }
+
+    if( --connection->iTransactionDepth > 0 ) {
+        connection->iRollback = true;
+        return;
+    }
+
+    connection->iRollback = false;
+    aDbHandle.rollback();
+}
+
+DatabaseConnection* DatabaseHandler::findConnection( const QSqlDatabase& aDbHandle )
+{
+    QMutexLocker locker( &sPoolMutex );
+
+    return sConnections.value( aDbHandle.connectionName() );
+}
@@ -39,19 +39,32 @@
 
 namespace DataSync {
 
+struct DatabaseConnection;
 
 /*! \brief Manages Qt's SQL database
  *
+ * Handlers of the same database file and pool key in the same thread share
+ * one pooled connection, which stays open as long as any of the handlers
+ * exists. The connection is put in WAL journal mode when it is opened.
+ *
+ * Statements run through prepare() are prepared once per connection and
+ * reused, and tables created with ensureSchema() are only checked once per
+ * connection. Transactions started with beginTransaction() can be nested,
+ * so that writes of several components can be grouped into one transaction.
  */
 class DatabaseHandler {
 public:
 
     /*! \brief Constructor
+     *
+     * Handlers with different pool keys never share a connection, so that
+     * for example concurrent sessions don't share transactions.
      *
      * @param aDbFile Path of database file to create and open
+     * @param aPoolKey Key of the pool to take the connection from
      *
      */
-    explicit DatabaseHandler( const QString& aDbFilePath );
+    explicit DatabaseHandler( const QString& aDbFilePath, const QString& aPoolKey = QString() );
 
     /*! \brief Destructor
      *
@@ -70,13 +83,69 @@ public:
      */
     QSqlDatabase& getDbHandle();
 
+    /*! \brief Returns a prepared query for a statement
+     *
+     * For pooled connections the prepared query is cached, and later calls with
+     * the same statement return the same query. Bound values of a reused query
+     * must be set again before executing it.
+     *
+     * @param aDbHandle Database handle to use
+     * @param aQueryString Statement to prepare
+     * @return Prepared query. If preparing failed, query is not valid and its
+     *         last error describes the failure
+     */
+    static QSqlQuery prepare( QSqlDatabase& aDbHandle, const QString& aQueryString );
+
+    /*! \brief Executes a schema statement such as CREATE TABLE IF NOT EXISTS
+     *
+     * For pooled connections a statement that has succeeded once is not
+     * executed again.
+     *
+     * @param aDbHandle Database handle to use
+     * @param aQueryString Statement to execute
+     * @return True on success, otherwise false
+     */
+    static bool ensureSchema( QSqlDatabase& aDbHandle, const QString& aQueryString );
+
+    /*! \brief Begins a transaction
+     *
+     * If a transaction is already active in a pooled connection, the
+     * transaction is nested in it and is committed with the outermost
+     * transaction.
+     *
+     * @param aDbHandle Database handle to use
+     * @return True on success, otherwise false
+     */
+    static bool beginTransaction( QSqlDatabase& aDbHandle );
+
+    /*! \brief Commits a transaction started with beginTransaction()
+     *
+     * Outermost transaction is rolled back instead if any of the transactions
+     * nested in it were rolled back.
+     *
+     * @param aDbHandle Database handle to use
+     * @return True on success, otherwise false
+     */
+    static bool commitTransaction( QSqlDatabase& aDbHandle );
+
+    /*! \brief Rolls back a transaction started with beginTransaction()
+     *
+     * Rolling back a nested transaction causes the outermost transaction to be
+     * rolled back too.
+     *
+     * @param aDbHandle Database handle to use
+     */
+    static void rollbackTransaction( QSqlDatabase& aDbHandle );
+
 private:
 
+    static DatabaseConnection* findConnection( const QSqlDatabase& aDbHandle );
 
 private: // data
 
     QSqlDatabase            iDb;                ///< Database object
     QString                 iConnectionName;    ///< Database connection name
+    DatabaseConnection*     iConnection;        ///< Pooled connection in use
 
 
 };
@@ -34,6 +34,8 @@
 #ifndef FRAGMENTS_H
 #define FRAGMENTS_H
 
+#include <QByteArray>
+
 #include "RemoteDeviceInfo.h"
 #include "datatypes.h"
 
@@ -76,7 +78,7 @@ struct ItemParams
     QString         sourceParent;
     QString         targetParent;
     MetaParams      meta;
-    QString         data;
+    QByteArray      data;       ///< Item data in UTF-8, as received
     bool            moreData;
 
     ItemParams() : moreData(false) {}
@@ -157,6 +159,7 @@ struct StatusParams : public Fragment
     QString             cmd;
     QString             targetRef;
     QString             sourceRef;
+    QList<QString>      sourceRefs;
     ResponseStatusCode  data;
     bool                hasChal;
     ChalParams          chal;
@@ -0,0 +1,350 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "ItemMatcher.h"
+
+#include <QPair>
+#include <QCryptographicHash>
+
+#include <algorithm>
+
+#include "StoragePlugin.h"
+#include "SyncItem.h"
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+typedef QPair<QByteArray, QByteArray> ContentLine;
+
+// Splits vCard and iCalendar data to content lines of upper case property
+// names and values. Parameters and groups are left out
+static QList<ContentLine> contentLines( const QByteArray& aData )
+{
+    QByteArray data( aData );
+    data.replace( "\r\n", "\n" );
+
+    // Unfold lines
+    data.replace( "\n ", "" );
+    data.replace( "\n\t", "" );
+
+    QList<ContentLine> lines;
+    QList<QByteArray> rawLines = data.split( '\n' );
+
+    for( int i = 0; i < rawLines.count(); ++i ) {
+        const QByteArray& line = rawLines[i];
+        int colon = line.indexOf( ':' );
+
+        if( colon <= 0 ) {
+            continue;
+        }
+
+        QByteArray name = line.left( colon );
+
+        int semicolon = name.indexOf( ';' );
+        if( semicolon >= 0 ) {
+            name.truncate( semicolon );
+        }
+
+        int dot = name.lastIndexOf( '.' );
+        if( dot >= 0 ) {
+            name = name.mid( dot + 1 );
+        }
+
+        lines.append( qMakePair( name.trimmed().toUpper(), line.mid( colon + 1 ).trimmed() ) );
+    }
+
+    return lines;
+}
+
+static bool readData( const SyncItem& aItem, QByteArray& aData )
+{
+    return aItem.read( 0, aItem.getSize(), aData );
+}
+
+ItemMatcher::ItemMatcher( StoragePlugin& aPlugin )
+ : iPlugin( aPlugin ), iIndexBuilt( false )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    setKeyExtractor( "text/x-vcard", vCardKeys );
+    setKeyExtractor( "text/vcard", vCardKeys );
+    setKeyExtractor( "text/x-vcalendar", iCalendarKeys );
+    setKeyExtractor( "text/calendar", iCalendarKeys );
+}
+
+ItemMatcher::~ItemMatcher()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+void ItemMatcher::setKeyExtractor( const QString& aMimeType, KeyExtractor aExtractor )
+{
+    iExtractors.insert( aMimeType.toLower(), aExtractor );
+}
+
+bool ItemMatcher::buildIndex()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iIndexBuilt ) {
+        return true;
+    }
+
+    QList<SyncItemKey> keys;
+
+    if( !iPlugin.getAll( keys ) ) {
+        qCWarning(lcSyncML) << "Could not get items of local database for matching";
+        return false;
+    }
+
+    // Fetch the items in batches to limit the number of items in memory
+    const int batchSize = 50;
+
+    for( int i = 0; i < keys.count(); i += batchSize ) {
+
+        QList<SyncItem*> items = iPlugin.getSyncItems( keys.mid( i, batchSize ) );
+
+        for( int j = 0; j < items.count(); ++j ) {
+            if( items[j] ) {
+                indexItem( *items[j] );
+            }
+        }
+
+        qDeleteAll( items );
+    }
+
+    qCDebug(lcSyncML) << "Indexed" << iItemKeys.count() << "local items with" << iIndex.count() << "match keys";
+
+    iIndexBuilt = true;
+
+    return true;
+}
+
+SyncItemKey ItemMatcher::match( const SyncItem& aItem, bool& aIdentical )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    aIdentical = false;
+
+    SyncItemKey localKey;
+    QList<QByteArray> itemKeys = keys( aItem );
+
+    for( int i = 0; i < itemKeys.count(); ++i ) {
+        QHash<QByteArray, QList<SyncItemKey> >::const_iterator match = iIndex.constFind( itemKeys[i] );
+
+        if( match != iIndex.constEnd() ) {
+            localKey = match.value().first();
+            break;
+        }
+    }
+
+    if( localKey.isEmpty() ) {
+        return localKey;
+    }
+
+    // Local item must not be matched to another incoming item. Entries are
+    // removed only when no other local item shares the key.
+    QList<QByteArray> indexed = iItemKeys.take( localKey );
+
+    for( int i = 0; i < indexed.count(); ++i ) {
+        QHash<QByteArray, QList<SyncItemKey> >::iterator entry = iIndex.find( indexed[i] );
+
+        if( entry != iIndex.end() ) {
+            entry.value().removeOne( localKey );
+
+            if( entry.value().isEmpty() ) {
+                iIndex.erase( entry );
+            }
+        }
+    }
+
+    QByteArray fingerprint = iFingerprints.take( localKey );
+    aIdentical = ( !fingerprint.isEmpty() && fingerprint == aItem.getFingerprint() );
+
+    qCDebug(lcSyncML) << "Item matched to local item" << localKey << ", identical:" << aIdentical;
+
+    return localKey;
+}
+
+QList<QByteArray> ItemMatcher::vCardKeys( const QByteArray& aData )
+{
+    QList<ContentLine> lines = contentLines( aData );
+
+    QByteArray uid;
+    QByteArray name;
+    QList<QByteArray> phones;
+
+    for( int i = 0; i < lines.count(); ++i ) {
+        const ContentLine& line = lines[i];
+
+        if( line.first == "UID" && uid.isEmpty() ) {
+            uid = line.second;
+        }
+        else if( line.first == "N" && name.isEmpty() ) {
+            QList<QByteArray> components = line.second.toLower().split( ';' );
+
+            for( int c = 0; c < components.count(); ++c ) {
+                components[c] = components[c].simplified();
+            }
+
+            name = components.join( ';' );
+
+            while( name.endsWith( ';' ) ) {
+                name.chop( 1 );
+            }
+        }
+        else if( line.first == "TEL" ) {
+            QByteArray phone;
+
+            for( int c = 0; c < line.second.size(); ++c ) {
+                if( line.second[c] >= '0' && line.second[c] <= '9' ) {
+                    phone.append( line.second[c] );
+                }
+            }
+
+            if( !phone.isEmpty() ) {
+                phones.append( phone );
+            }
+        }
+    }
+
+    QList<QByteArray> keys;
+
+    if( !uid.isEmpty() ) {
+        keys.append( "UID:" + uid );
+    }
+
+    if( !name.isEmpty() && !phones.isEmpty() ) {
+        std::sort( phones.begin(), phones.end() );
+        keys.append( "N+TEL:" + name + ':' + phones.join( ',' ) );
+    }
+
+    keys.append( contentKeys( aData ) );
+
+    return keys;
+}
+
+QList<QByteArray> ItemMatcher::iCalendarKeys( const QByteArray& aData )
+{
+    QList<ContentLine> lines = contentLines( aData );
+
+    QByteArray uid;
+    QByteArray recurrenceId;
+
+    for( int i = 0; i < lines.count(); ++i ) {
+        const ContentLine& line = lines[i];
+
+        if( line.first == "UID" && uid.isEmpty() ) {
+            uid = line.second;
+        }
+        else if( line.first == "RECURRENCE-ID" && recurrenceId.isEmpty() ) {
+            recurrenceId = line.second;
+        }
+    }
+
+    QList<QByteArray> keys;
+
+    if( !uid.isEmpty() ) {
+        keys.append( "UID:" + uid + ';' + recurrenceId );
+    }
+
+    keys.append( contentKeys( aData ) );
+
+    return keys;
+}
+
+QList<QByteArray> ItemMatcher::contentKeys( const QByteArray& aData )
+{
+    QByteArray data( aData );
+    data.replace( "\r\n", "\n" );
+
+    QList<QByteArray> lines = data.split( '\n' );
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+    for( int i = 0; i < lines.count(); ++i ) {
+        QByteArray line = lines[i];
+
+        while( !line.isEmpty() && ( line.endsWith( ' ' ) || line.endsWith( '\t' ) ) ) {
+            line.chop( 1 );
+        }
+
+        hash.addData( line );
+        hash.addData( "\n", 1 );
+    }
+
+    QList<QByteArray> keys;
+    keys.append( "CONTENT:" + hash.result() );
+
+    return keys;
+}
+
+QList<QByteArray> ItemMatcher::keys( const SyncItem& aItem ) const
+{
+    QByteArray data;
+
+    if( !readData( aItem, data ) ) {
+        qCWarning(lcSyncML) << "Could not read item data for matching";
+        return QList<QByteArray>();
+    }
+
+    QString type = aItem.getType().toLower();
+
+    if( type.isEmpty() ) {
+        type = iPlugin.getFormatInfo().getPreferredTx().iType.toLower();
+    }
+
+    KeyExtractor extractor = iExtractors.value( type, contentKeys );
+
+    return extractor( data );
+}
+
+void ItemMatcher::indexItem( const SyncItem& aItem )
+{
+    const SyncItemKey& localKey = *aItem.getKey();
+    QList<QByteArray> itemKeys = keys( aItem );
+    QList<QByteArray> indexed;
+
+    for( int i = 0; i < itemKeys.count(); ++i ) {
+
+        // If several local items share a key, they are matched in turn
+        QList<SyncItemKey>& entry = iIndex[itemKeys[i]];
+
+        if( entry.isEmpty() || entry.last() != localKey ) {
+            entry.append( localKey );
+            indexed.append( itemKeys[i] );
+        }
+    }
+
+    iItemKeys.insert( localKey, indexed );
+    iFingerprints.insert( localKey, aItem.getFingerprint() );
+}
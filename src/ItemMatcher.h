@@ -0,0 +1,160 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef ITEMMATCHER_H
+#define ITEMMATCHER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+
+#include "SyncItemKey.h"
+
+namespace DataSync {
+
+class StoragePlugin;
+class SyncItem;
+
+/*! \brief Matches incoming items to existing items in local database
+ *
+ * In slow sync the remote device sends all of its items, and most of them
+ * usually already exist in the local database. ItemMatcher builds an index of
+ * match keys over the items of the local database, so that incoming items
+ * can be mapped to the existing items instead of being added as duplicates.
+ *
+ * Match keys are extracted from item data by a key extractor selected by
+ * the MIME type of the item. Extractors for vCard and iCalendar items are
+ * registered by default. Items of other types are matched only if their
+ * content is identical.
+ */
+class ItemMatcher
+{
+
+public:
+
+    /*! \brief Function extracting match keys from item data
+     *
+     * Keys should be returned in order of preference. Two items match if
+     * they have any key in common.
+     *
+     * @param aData Item data
+     * @return Match keys of the item
+     */
+    typedef QList<QByteArray> (*KeyExtractor)( const QByteArray& aData );
+
+    /*! \brief Constructor
+     *
+     * @param aPlugin Storage plugin of the local database
+     */
+    explicit ItemMatcher( StoragePlugin& aPlugin );
+
+    /*! \brief Destructor
+     *
+     */
+    ~ItemMatcher();
+
+    /*! \brief Sets the key extractor to use for items of given MIME type
+     *
+     * @param aMimeType MIME type
+     * @param aExtractor Key extractor
+     */
+    void setKeyExtractor( const QString& aMimeType, KeyExtractor aExtractor );
+
+    /*! \brief Builds the index over the items of local database
+     *
+     * Does nothing if the index has already been built
+     *
+     * @return True on success, otherwise false
+     */
+    bool buildIndex();
+
+    /*! \brief Matches an item to an item of local database
+     *
+     * Each local item is matched at most once. If several local items share
+     * a match key, they are matched in the order they were indexed.
+     *
+     * @param aItem Item to match
+     * @param aIdentical Set to true if the content of the matched item is identical to aItem
+     * @return Key of the matching local item, or empty if no match was found
+     */
+    SyncItemKey match( const SyncItem& aItem, bool& aIdentical );
+
+    /*! \brief Extracts match keys from vCard data
+     *
+     * Keys are the UID of the contact, its name together with its phone
+     * numbers, and its content.
+     *
+     * @param aData vCard data
+     * @return Match keys
+     */
+    static QList<QByteArray> vCardKeys( const QByteArray& aData );
+
+    /*! \brief Extracts match keys from iCalendar data
+     *
+     * Keys are the UID and recurrence ID of the component, and its content.
+     *
+     * @param aData iCalendar data
+     * @return Match keys
+     */
+    static QList<QByteArray> iCalendarKeys( const QByteArray& aData );
+
+    /*! \brief Extracts match key from the content of item data
+     *
+     * Items match only if their content is identical, ignoring line ending
+     * style and trailing white space.
+     *
+     * @param aData Item data
+     * @return Match keys
+     */
+    static QList<QByteArray> contentKeys( const QByteArray& aData );
+
+private:
+
+    QList<QByteArray> keys( const SyncItem& aItem ) const;
+
+    void indexItem( const SyncItem& aItem );
+
+    StoragePlugin&                          iPlugin;
+    QHash<QString, KeyExtractor>            iExtractors;
+
+    QHash<QByteArray, QList<SyncItemKey> >  iIndex;
+    QHash<SyncItemKey, QList<QByteArray> >  iItemKeys;
+    QHash<SyncItemKey, QByteArray>          iFingerprints;
+    bool                                    iIndexBuilt;
+
+};
+
+}
+
+#endif  //  ITEMMATCHER_H
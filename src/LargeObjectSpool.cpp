@@ -0,0 +1,171 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "LargeObjectSpool.h"
+
+#include <QTemporaryFile>
+#include <QDir>
+
+#include "SyncItem.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+LargeObjectSpool::LargeObjectSpool( qint64 aThreshold ) :
+    iThreshold( aThreshold ),
+    iSize( 0 ),
+    iLineFeeds( 0 ),
+    iFile( NULL )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+LargeObjectSpool::~LargeObjectSpool()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    delete iFile;
+    iFile = NULL;
+}
+
+bool LargeObjectSpool::append( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iFile ) {
+        if( iFile->write( aData ) != aData.size() ) {
+            qCCritical(lcSyncML) << "Could not write to large object spool file:" << iFile->errorString();
+            return false;
+        }
+    }
+    else {
+        iBuffer.append( aData );
+
+        if( iBuffer.size() > iThreshold && !spool() ) {
+            return false;
+        }
+    }
+
+    iSize += aData.size();
+    iLineFeeds += aData.count( '\n' );
+
+    return true;
+}
+
+qint64 LargeObjectSpool::size() const
+{
+    return iSize;
+}
+
+qint64 LargeObjectSpool::lineFeeds() const
+{
+    return iLineFeeds;
+}
+
+bool LargeObjectSpool::spooledToDisk() const
+{
+    return iFile != NULL;
+}
+
+bool LargeObjectSpool::writeTo( SyncItem& aItem )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iFile ) {
+        return aItem.write( 0, iBuffer );
+    }
+
+    if( !iFile->flush() ) {
+        qCCritical(lcSyncML) << "Could not flush large object spool file:" << iFile->errorString();
+        return false;
+    }
+
+    // Prefer mapping the file to reading it through a buffer. Each chunk is
+    // copied out of the mapping, as the item may keep a reference to the
+    // data after the file has been unmapped
+    uchar* map = iFile->map( 0, iSize );
+
+    qint64 offset = 0;
+    bool success = true;
+
+    if( map ) {
+        while( success && offset < iSize ) {
+            int length = static_cast<int>( qMin( CHUNK_SIZE, iSize - offset ) );
+            QByteArray chunk( reinterpret_cast<const char*>( map + offset ), length );
+            success = aItem.write( offset, chunk );
+            offset += length;
+        }
+
+        iFile->unmap( map );
+    }
+    else if( iFile->seek( 0 ) ) {
+        while( success && offset < iSize ) {
+            QByteArray chunk = iFile->read( qMin( CHUNK_SIZE, iSize - offset ) );
+            if( chunk.isEmpty() ) {
+                qCCritical(lcSyncML) << "Could not read large object spool file:" << iFile->errorString();
+                success = false;
+            }
+            else {
+                success = aItem.write( offset, chunk );
+                offset += chunk.size();
+            }
+        }
+    }
+    else {
+        qCCritical(lcSyncML) << "Could not seek large object spool file:" << iFile->errorString();
+        success = false;
+    }
+
+    return success;
+}
+
+bool LargeObjectSpool::spool()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iFile = new QTemporaryFile( QDir::tempPath() + QDir::separator() + "buteosyncml-lo-XXXXXX" );
+
+    if( !iFile->open() || iFile->write( iBuffer ) != iBuffer.size() ) {
+        qCCritical(lcSyncML) << "Could not spool large object to disk:" << iFile->errorString();
+        delete iFile;
+        iFile = NULL;
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "Large object spooled to" << iFile->fileName();
+
+    iBuffer.clear();
+
+    return true;
+}
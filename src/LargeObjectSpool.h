@@ -0,0 +1,123 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef LARGEOBJECTSPOOL_H
+#define LARGEOBJECTSPOOL_H
+
+#include <QByteArray>
+
+class QTemporaryFile;
+
+namespace DataSync {
+
+class SyncItem;
+
+/*! \brief Buffer for data of a large object being received in chunks
+ *
+ * Data is kept in memory until its size exceeds the spool threshold, after
+ * which it is moved to a temporary file and further chunks are appended
+ * to the file. This keeps memory usage bounded regardless of the size of
+ * the incoming object.
+ */
+class LargeObjectSpool
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aThreshold Number of bytes kept in memory before spooling to disk
+     */
+    explicit LargeObjectSpool( qint64 aThreshold );
+
+    /*! \brief Destructor
+     *
+     * Removes the temporary file if one was created
+     */
+    ~LargeObjectSpool();
+
+    /*! \brief Appends data to the spool
+     *
+     * @param aData Data to append
+     * @return True on success, otherwise false
+     */
+    bool append( const QByteArray& aData );
+
+    /*! \brief Returns the number of bytes appended to the spool
+     *
+     * @return Size of spooled data
+     */
+    qint64 size() const;
+
+    /*! \brief Returns the number of line feeds appended to the spool
+     *
+     * @return Number of line feeds in spooled data
+     */
+    qint64 lineFeeds() const;
+
+    /*! \brief Returns true if data has been moved to a temporary file
+     *
+     * @return True if spooled to disk, otherwise false
+     */
+    bool spooledToDisk() const;
+
+    /*! \brief Writes spooled data to an item starting at offset 0
+     *
+     * Data on disk is written in chunks of CHUNK_SIZE bytes so that the
+     * whole object is never held in memory.
+     *
+     * @param aItem Item to write to
+     * @return True on success, otherwise false
+     */
+    bool writeTo( SyncItem& aItem );
+
+    /// Size of chunks used when writing spooled data to an item
+    static const qint64 CHUNK_SIZE = 64 * 1024;
+
+protected:
+
+private:
+
+    bool spool();
+
+    qint64          iThreshold;
+    qint64          iSize;
+    qint64          iLineFeeds;
+    QByteArray      iBuffer;
+    QTemporaryFile* iFile;
+
+};
+
+}
+
+#endif  //  LARGEOBJECTSPOOL_H
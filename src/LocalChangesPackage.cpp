@@ -33,8 +33,6 @@
 
 #include "LocalChangesPackage.h"
 
-#include <QTimer>
-
 #include "SyncTarget.h"
 #include "StoragePlugin.h"
 #include "SyncItem.h"
@@ -51,7 +49,7 @@ using namespace DataSync;
 
 
 
-LocalChangesPackage::LocalChangesPackage( const SyncTarget& aSyncTarget,
+LocalChangesPackage::LocalChangesPackage( SyncTarget& aSyncTarget,
                                           const LocalChanges& aLocalChanges,
                                           int aLargeObjectThreshold,
                                           const Role& aRole,
@@ -61,9 +59,12 @@ LocalChangesPackage::LocalChangesPackage( const SyncTarget& aSyncTarget,
     iLocalChanges( aLocalChanges ),
     iRole( aRole ),
     iMaxChangesPerMessage(aMaxChangesPerMessage),
+    iMultiItemCommands( false ),
     iPrefetcher( aLocalChanges.added + aLocalChanges.modified,
                  *aSyncTarget.getPlugin(),
-                 aMaxChangesPerMessage )
+                 aMaxChangesPerMessage ),
+    iReportedHits( 0 ),
+    iReportedMisses( 0 )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -81,12 +82,28 @@ LocalChangesPackage::~LocalChangesPackage()
     iLargeObjectState.iItem = 0;
 }
 
+void LocalChangesPackage::setPrefetchOptions( bool aAsynchronous, qint64 aMaxCacheSize )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iPrefetcher.setMaxCacheSize( aMaxCacheSize );
+    iPrefetcher.setAsynchronous( aAsynchronous );
+}
+
+void LocalChangesPackage::setMultiItemCommands( bool aEnabled )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iMultiItemCommands = aEnabled;
+}
+
 bool LocalChangesPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     bool allWritten = false;
 
     int remainingBytes = aSizeThreshold;
+    int messageSize = aSizeThreshold;
 
     SyncMLSync* sync = new SyncMLSync( aMessage.getNextCmdId(),
                                        iSyncTarget.getTargetDatabase(),
@@ -114,11 +131,22 @@ bool LocalChangesPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, b
     aMessage.addToBody( sync );
     aSizeThreshold = remainingBytes;
 
+    int hits = iPrefetcher.hits();
+    int misses = iPrefetcher.misses();
+
+    if( hits != iReportedHits || misses != iReportedMisses )
+    {
+        emit itemsPrefetched( hits - iReportedHits, misses - iReportedMisses );
+        iReportedHits = hits;
+        iReportedMisses = misses;
+    }
+
     if( !allWritten )
     {
-        // If we didn't finish writing everything, schedule idle-time prefetcher
-        iPrefetcher.setBatchSizeHint( iMaxChangesPerMessage - itemsThatCanBeSent );
-        QTimer::singleShot( 0, &iPrefetcher, SLOT(prefetch()) );
+        // If we didn't finish writing everything, schedule prefetching of enough
+        // items to fill the next message
+        iPrefetcher.setBatchSizeHint( iPrefetcher.estimateBatchSize( messageSize, iMaxChangesPerMessage ) );
+        iPrefetcher.schedulePrefetch();
     }
 
     return allWritten;
@@ -136,23 +164,51 @@ bool LocalChangesPackage::processAddedItems( SyncMLMessage& aMessage,
 
     int remainingBytes = aSizeThreshold;
 
+    // Command that following items of the same format can be added to
+    SyncMLAdd* add = 0;
+    int cmdId = -1;
+    QString commandFormat;
+
     while( iLocalChanges.added.count() > 0 &&
            aItemsThatCanBeSent > 0 &&
            remainingBytes > 0 )
     {
 
-        int cmdId = aMessage.getNextCmdId();
-        SyncMLAdd* add = new SyncMLAdd(cmdId);
         SyncItemKey key = iLocalChanges.added.first();
+        SyncItem* item = 0;
+        QString format;
+
+        if( iMultiItemCommands && !iLargeObjectState.iItem )
+        {
+            item = iPrefetcher.getItem( key );
+            format = sharedFormat( item );
+        }
+
+        bool append = ( add && !format.isEmpty() && format == commandFormat );
+
+        if( !append )
+        {
+            cmdId = aMessage.getNextCmdId();
+            add = new SyncMLAdd( cmdId );
+            commandFormat = format;
+        }
 
         QString mimeType;
-        bool processed = processItem( key, *add, remainingBytes, SYNCML_ADD, mimeType );
+        bool processed = processItem( key, *add, remainingBytes, SYNCML_ADD, mimeType,
+                                      item, QByteArray(), !append );
 
-        remainingBytes -= add->calculateSize(aWBXML, aVersion);
-        aSyncElement.addChild( add );
+        int size = append ? add->getChildren().last()->calculateSize(aWBXML, aVersion) :
+                            add->calculateSize(aWBXML, aVersion);
+        remainingBytes -= size;
+
+        if( !append )
+        {
+            aSyncElement.addChild( add );
+        }
 
         if (processed)
         {
+            iPrefetcher.addEncodedItemSize( size );
             emit newItemWritten( aMessage.getMsgId(), cmdId, key, MOD_ITEM_ADDED,
                                  iSyncTarget.getSourceDatabase(), iSyncTarget.getTargetDatabase(),
                                  mimeType );
@@ -191,22 +247,72 @@ bool LocalChangesPackage::processModifiedItems( SyncMLMessage& aMessage,
 
     int remainingBytes = aSizeThreshold;
 
+    // Command that following items of the same format can be added to
+    SyncMLReplace* replace = 0;
+    int cmdId = -1;
+    QString commandFormat;
+
     while( iLocalChanges.modified.count() > 0  &&
            aItemsThatCanBeSent  > 0 &&
            remainingBytes > 0 )
     {
-        int cmdId = aMessage.getNextCmdId();
-        SyncMLReplace* replace = new SyncMLReplace( cmdId );
         SyncItemKey key = iLocalChanges.modified.first();
+        SyncItem* item = 0;
+        QByteArray fingerprint;
+        QString format;
+
+        if( ( iSyncTarget.replaceSuppression() || iMultiItemCommands ) && !iLargeObjectState.iItem )
+        {
+            item = iPrefetcher.getItem( key );
+        }
+
+        if( item && iSyncTarget.replaceSuppression() )
+        {
+            // Plugins often report items as modified when only their metadata
+            // has changed, so leave out the items whose content is the same
+            // as in previous sync
+            fingerprint = item->getFingerprint();
+
+            if( iSyncTarget.isUnchanged( key, fingerprint ) )
+            {
+                qCDebug(lcSyncML) << "Content of item" << key << "has not changed, not sending it";
+                delete item;
+                iLocalChanges.modified.removeFirst();
+                emit itemSuppressed( key, iSyncTarget.getSourceDatabase() );
+                continue;
+            }
+        }
+
+        if( iMultiItemCommands )
+        {
+            format = sharedFormat( item );
+        }
+
+        bool append = ( replace && !format.isEmpty() && format == commandFormat );
+
+        if( !append )
+        {
+            cmdId = aMessage.getNextCmdId();
+            replace = new SyncMLReplace( cmdId );
+            commandFormat = format;
+        }
 
         QString mimeType;
-        bool processed = processItem( key, *replace, remainingBytes, SYNCML_REPLACE, mimeType );
+        bool processed = processItem( key, *replace, remainingBytes, SYNCML_REPLACE, mimeType,
+                                      item, fingerprint, !append );
 
-        remainingBytes -= replace->calculateSize(aWBXML, aVersion);
-        aSyncElement.addChild( replace );
+        int size = append ? replace->getChildren().last()->calculateSize(aWBXML, aVersion) :
+                            replace->calculateSize(aWBXML, aVersion);
+        remainingBytes -= size;
+
+        if( !append )
+        {
+            aSyncElement.addChild( replace );
+        }
 
         if (processed)
         {
+            iPrefetcher.addEncodedItemSize( size );
             emit newItemWritten( aMessage.getMsgId(), cmdId, key, MOD_ITEM_MODIFIED,
                                  iSyncTarget.getSourceDatabase(), iSyncTarget.getTargetDatabase(),
                                  mimeType );
@@ -244,22 +350,37 @@ bool LocalChangesPackage::processRemovedItems( SyncMLMessage& aMessage,
 
     int remainingBytes = aSizeThreshold;
 
+    // Delete commands do not carry meta, so all items can share a command
+    SyncMLDelete* del = 0;
+    int cmdId = -1;
+
     while( iLocalChanges.removed.count() > 0 &&
            aItemsThatCanBeSent > 0 &&
            remainingBytes > 0 )
     {
-        int cmdId = aMessage.getNextCmdId();
-        SyncMLDelete* del = new SyncMLDelete(cmdId);
         SyncItemKey key = iLocalChanges.removed.first();
 
+        bool append = ( iMultiItemCommands && del );
+
+        if( !append )
+        {
+            cmdId = aMessage.getNextCmdId();
+            del = new SyncMLDelete( cmdId );
+        }
+
         // @todo: we cannot know the mime type in the case of deleted items. In overall it's bad
         // that we're using mimetype here, we should be able to handle identification of used
         // storage purely on the db uri's.
         QString mimeType;
         bool processed = processItem( key, *del, remainingBytes, SYNCML_DELETE, mimeType );
 
-        remainingBytes -= del->calculateSize(aWBXML, aVersion);
-        aSyncElement.addChild( del );
+        remainingBytes -= append ? del->getChildren().last()->calculateSize(aWBXML, aVersion) :
+                                   del->calculateSize(aWBXML, aVersion);
+
+        if( !append )
+        {
+            aSyncElement.addChild( del );
+        }
 
         if (processed) {
             emit newItemWritten( aMessage.getMsgId(), cmdId, key, MOD_ITEM_DELETED,
@@ -286,11 +407,26 @@ bool LocalChangesPackage::processRemovedItems( SyncMLMessage& aMessage,
     return processed;
 }
 
+QString LocalChangesPackage::sharedFormat( const SyncItem* aItem ) const
+{
+    // Large objects need size meta of their own, so they are always sent
+    // in a command of their own
+    if( !aItem || aItem->getSize() > iLargeObjectThreshold )
+    {
+        return QString();
+    }
+
+    return aItem->getType() + QLatin1Char( ';' ) + aItem->getVersion();
+}
+
 bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                                        SyncMLLocalChange& aParent,
                                        int aSizeThreshold,
                                        SyncMLCommand aCommand,
-                                       QString& aMimeType )
+                                       QString& aMimeType,
+                                       SyncItem* aItem,
+                                       const QByteArray& aFingerprint,
+                                       bool aWriteMeta )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -324,6 +460,11 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
     if( aCommand == SYNCML_DELETE )
     {
         // Delete command does not include item data
+        if( iSyncTarget.recordsSentItems() )
+        {
+            iSyncTarget.addSentFingerprint( aItemKey, QByteArray() );
+        }
+
         processed = true;
     }
     else
@@ -338,21 +479,32 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
         else
         {
             // We're not sending a large object, so get the item from plugin
-            item = iPrefetcher.getItem( aItemKey );
+            // unless the caller already did
+            item = aItem ? aItem : iPrefetcher.getItem( aItemKey );
+
+            if( item && iSyncTarget.recordsSentItems() )
+            {
+                iSyncTarget.addSentFingerprint( aItemKey, aFingerprint.isEmpty() ?
+                                                          item->getFingerprint() : aFingerprint );
+            }
         }
 
         if (item)
         {
 
             aMimeType = item->getType();
-
-            aParent.addMimeMetadata( item->getType() );
             qint64 size = item->getSize();
 
-            QString version = item->getVersion();
+            // Items added to an existing command share its meta
+            if( aWriteMeta )
+            {
+                aParent.addMimeMetadata( item->getType() );
+
+                QString version = item->getVersion();
 
-            if ( !version.isEmpty()) {
-                aParent.addVersionMetadata(version);
+                if ( !version.isEmpty()) {
+                    aParent.addVersionMetadata(version);
+                }
             }
 
             if( !item->getParentKey()->isEmpty() )
@@ -70,7 +70,7 @@ public:
      * @param aRole The role of the session (client or server)
      * @param aMaxChangesPerMessage Maximum number of changes to write per one SyncML message
      */
-    LocalChangesPackage( const SyncTarget& aSyncTarget,
+    LocalChangesPackage( SyncTarget& aSyncTarget,
                          const LocalChanges& aLocalChanges,
                          int aLargeObjectThreshold,
                          const Role& aRole,
@@ -81,6 +81,23 @@ public:
      */
     virtual ~LocalChangesPackage();
 
+    /*! \brief Sets how items are prefetched from the storage plugin
+     *
+     * @param aAsynchronous True to fetch items in a worker thread
+     * @param aMaxCacheSize Maximum size in bytes of prefetched items, 0 for no limit
+     */
+    void setPrefetchOptions( bool aAsynchronous, qint64 aMaxCacheSize );
+
+    /*! \brief Sets whether consecutive items can be sent in a single command
+     *
+     * When enabled, consecutive items of the same type and version are written
+     * as items of one Add or Replace command with shared meta, and consecutive
+     * deletions as items of one Delete command.
+     *
+     * @param aEnabled True to write multiple items per command
+     */
+    void setMultiItemCommands( bool aEnabled );
+
     virtual bool write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion );
 
 signals:
@@ -102,6 +119,22 @@ signals:
                          QString aLocalDatabase, QString aRemoteDatabase,
                          QString aMimeType );
 
+    /*! \brief Signal that has been emitted when a modified item was left out
+     *         because its content has not changed since previous sync
+     *
+     * @param aKey Key of the item
+     * @param aLocalDatabase Local database where item exists
+     */
+    void itemSuppressed( SyncItemKey aKey, QString aLocalDatabase );
+
+    /*! \brief Signal that is emitted after a message has been written if
+     *         outgoing items were fetched from the storage plugin
+     *
+     * @param aHits Number of items found from prefetched items since previous signal
+     * @param aMisses Number of items fetched on demand since previous signal
+     */
+    void itemsPrefetched( int aHits, int aMisses );
+
 protected:
 
 private:
@@ -139,16 +172,24 @@ private:
                       SyncMLLocalChange& aParent,
                       int aSizeThreshold,
                       SyncMLCommand aCommand,
-                      QString& aMimeType );
+                      QString& aMimeType,
+                      SyncItem* aItem = 0,
+                      const QByteArray& aFingerprint = QByteArray(),
+                      bool aWriteMeta = true );
+
+    QString sharedFormat( const SyncItem* aItem ) const;
 
     int                     iLargeObjectThreshold;
     int                     iNumberOfChanges;
-    const SyncTarget&       iSyncTarget;
+    SyncTarget&             iSyncTarget;
     LocalChanges            iLocalChanges;
     LargeObjectState        iLargeObjectState;
     Role                    iRole;
     int 					iMaxChangesPerMessage;
+    bool                    iMultiItemCommands;
     SyncItemPrefetcher      iPrefetcher;
+    int                     iReportedHits;
+    int                     iReportedMisses;
 
     friend class ::LocalChangesPackageTest;
 
@@ -35,6 +35,7 @@
 
 #include <QtSql>
 
+#include "DatabaseHandler.h"
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
@@ -69,9 +70,8 @@ QByteArray NonceStorage::nonce()
     {
 
         const QString queryString( "SELECT nonce FROM nonces WHERE local_device = :local_device AND remote_device = :remote_device" );
-        QSqlQuery query( iDbHandle );
+        QSqlQuery query = DatabaseHandler::prepare( iDbHandle, queryString );
 
-        query.prepare( queryString );
         query.bindValue( ":local_device", iLocalDevice );
         query.bindValue( ":remote_device", iRemoteDevice );
         query.exec();
@@ -88,6 +88,8 @@ QByteArray NonceStorage::nonce()
                 nonce = query.value(0).toByteArray();
             }
 
+            query.finish();
+
         }
 
     }
@@ -104,13 +106,15 @@ void NonceStorage::setNonce( const QByteArray& aNonce )
         return;
     }
 
+    // Replace the nonce atomically
+    bool transaction = DatabaseHandler::beginTransaction( iDbHandle );
+
     clearNonce();
 
     const QString insertQuery( "INSERT INTO nonces(local_device, remote_device, nonce) values(:local_device, :remote_device, :nonce)" );
 
-    QSqlQuery query( iDbHandle );
+    QSqlQuery query = DatabaseHandler::prepare( iDbHandle, insertQuery );
 
-    query.prepare( insertQuery );
     query.bindValue( ":local_device", iLocalDevice );
     query.bindValue( ":remote_device", iRemoteDevice );
     query.bindValue( ":nonce", aNonce );
@@ -119,6 +123,15 @@ void NonceStorage::setNonce( const QByteArray& aNonce )
     if( query.lastError().isValid() )
     {
         qCWarning(lcSyncML) << "Query failed: " << query.lastError();
+
+        if( transaction )
+        {
+            DatabaseHandler::rollbackTransaction( iDbHandle );
+        }
+    }
+    else if( transaction )
+    {
+        DatabaseHandler::commitTransaction( iDbHandle );
     }
 
 }
@@ -135,9 +148,8 @@ void NonceStorage::clearNonce()
     // Clear existing mappings
     const QString deleteQuery( "DELETE FROM nonces WHERE local_device = :local_device AND remote_device = :remote_device" );
 
-    QSqlQuery query( iDbHandle );
+    QSqlQuery query = DatabaseHandler::prepare( iDbHandle, deleteQuery );
 
-    query.prepare( deleteQuery );
     query.bindValue( ":local_device", iLocalDevice );
     query.bindValue( ":remote_device", iRemoteDevice );
     query.exec();
@@ -152,18 +164,8 @@ bool NonceStorage::createNonceTable()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Only executed once per database connection
     const QString queryString = "CREATE TABLE IF NOT EXISTS nonces(id integer primary key autoincrement, local_device varchar(512), remote_device varchar(512), nonce varchar(512))";
-    QSqlQuery query( iDbHandle );
-
-    query.prepare( queryString );
-    query.exec();
-
-    bool success = true;
-
-    if (query.lastError().isValid()) {
-        success = false;
-        qCWarning(lcSyncML) << "Query failed: " << query.lastError();
-    }
 
-    return success;
+    return DatabaseHandler::ensureSchema( iDbHandle, queryString );
 }
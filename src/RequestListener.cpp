@@ -68,6 +68,9 @@ bool RequestListener::start( Transport* aTransport )
     connect( iTransport, SIGNAL(readXMLData(QIODevice *, bool)) ,
              &iParser, SLOT(parseResponse(QIODevice *, bool)) );
 
+    connect( iTransport, SIGNAL(readXMLDataPart(QByteArray, bool, bool)) ,
+             &iParser, SLOT(parseResponsePart(QByteArray, bool, bool)) );
+
     connect( &iParser, SIGNAL(parsingComplete(bool)),
              this, SLOT(parsingComplete(bool)) );
 
@@ -87,6 +90,8 @@ void RequestListener::stop()
     disconnect( &iParser, 0, this, 0 );
     disconnect( iTransport, SIGNAL(readXMLData(QIODevice *, bool)) ,
              &iParser, SLOT(parseResponse(QIODevice *, bool)) );
+    disconnect( iTransport, SIGNAL(readXMLDataPart(QByteArray, bool, bool)) ,
+             &iParser, SLOT(parseResponsePart(QByteArray, bool, bool)) );
     if( iTransport )
     {
         disconnect( iTransport, 0, this, 0 );
@@ -499,6 +499,25 @@ const QList<StatusParams*>& ResponseGenerator::getStatuses() const
     return iStatuses;
 }
 
+void ResponseGenerator::takeResponses( ResponseGenerator& aOther )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iIgnoreStatuses )
+    {
+        qDeleteAll( aOther.iStatuses );
+    }
+    else
+    {
+        iStatuses.append( aOther.iStatuses );
+    }
+
+    aOther.iStatuses.clear();
+
+    iPackages.append( aOther.iPackages );
+    aOther.iPackages.clear();
+}
+
 int ResponseGenerator::getNextMsgId()
 {
     return ++iMsgId;
@@ -94,6 +94,10 @@ public:
     int getRemoteMsgId() const;
 
     /*! \brief Generate next message
+     *
+     * MaxMsgSize applies to the SyncML message itself, so compression done by the
+     * transport (for example HTTP content encoding) must not be taken into account
+     * in aMaxSize
      *
      * @param aMaxSize Maximum size of the message
      * @param aVersion Protocol version to use
@@ -211,6 +215,15 @@ public:
      */
     const QList<StatusParams*>& getStatuses() const;
 
+    /*! \brief Moves statuses and packages of another response generator to this one
+     *
+     * Statuses and packages are appended in the order they were added to
+     * aOther. aOther is left empty.
+     *
+     * @param aOther Response generator to take responses from
+     */
+    void takeResponses( ResponseGenerator& aOther );
+
 protected:
 
     /*! \brief Retrieve id that should be used for next message
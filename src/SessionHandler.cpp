@@ -34,17 +34,20 @@
 #include "SessionHandler.h"
 
 #include "ChangeLog.h"
+#include "SuspendLog.h"
 #include "SyncAgentConfig.h"
 #include "SyncAgentConfigProperties.h"
 #include "CommandHandler.h"
 #include "AlertPackage.h"
 #include "SyncTarget.h"
 #include "LocalChangesPackage.h"
+#include "ItemMatcher.h"
 #include "FinalPackage.h"
 #include "StoragePlugin.h"
 #include "ConflictResolver.h"
 #include "AuthHelper.h"
 #include "StorageProvider.h"
+#include "SyncCommitJob.h"
 
 #include "SyncMLLogging.h"
 
@@ -54,7 +57,7 @@ SessionHandler::SessionHandler( const SyncAgentConfig* aConfig,
                                 const Role& aRole,
                                 QObject* aParent ) :
     QObject( aParent ),
-    iDatabaseHandler( aConfig->getDatabaseFilePath() ),
+    iDatabaseHandler( aConfig->getDatabaseFilePath(), aConfig->getDatabasePoolKey() ),
     iCommandHandler( aRole ),
     iDevInfHandler( aConfig->getDeviceInfo() ),
     iConfig(aConfig),
@@ -65,6 +68,8 @@ SessionHandler::SessionHandler( const SyncAgentConfig* aConfig,
     iProcessing( false ),
     iProtocolVersion( SYNCML_1_2 ),
     iRemoteReportedBusy(false),
+    iRemoteSuspended( false ),
+    iSessionSuspendable( false ),
     iRole( aRole )
 
 {
@@ -72,13 +77,7 @@ SessionHandler::SessionHandler( const SyncAgentConfig* aConfig,
 
     Q_ASSERT(iConfig != NULL);
 
-    // Set session handler for the storage provider, so that it can ask
-    // properties like protocol version from the session handler.
-    StorageProvider *storageProvider = iConfig->getStorageProvider();
-    if (storageProvider != 0)
-    {
-        storageProvider->setSessionHandler(this);
-    }
+    iStateTimer.start();
 
 }
 
@@ -143,8 +142,22 @@ bool SessionHandler::prepareSync()
 
     connect( &transport, SIGNAL(sendEvent(DataSync::TransportStatusEvent, QString )),
              this, SLOT(setTransportStatus(DataSync::TransportStatusEvent , QString )));
+
+    // Statistics slots must be connected before the parser, so that they
+    // see a received message before it is parsed
+    connect( &transport, SIGNAL(messageSent(qint64, qint64)),
+             this, SLOT(handleMessageSent(qint64, qint64)));
+    connect( &transport, SIGNAL(messageReceived(qint64)),
+             this, SLOT(handleMessageReceived(qint64)));
+    connect( &transport, SIGNAL(readXMLData(QIODevice *, bool)) ,
+             this, SLOT(handleIncomingMessage(QIODevice *, bool)));
+    connect( &transport, SIGNAL(readXMLDataPart(QByteArray, bool, bool)) ,
+             this, SLOT(handleIncomingMessagePart(QByteArray, bool, bool)));
+
     connect( &transport, SIGNAL(readXMLData(QIODevice *, bool)) ,
              &iParser, SLOT(parseResponse(QIODevice *, bool)));
+    connect( &transport, SIGNAL(readXMLDataPart(QByteArray, bool, bool)) ,
+             &iParser, SLOT(parseResponsePart(QByteArray, bool, bool)));
     connect( &transport, SIGNAL(readSANData(QIODevice *)) ,
              this, SLOT(SANPackageReceived(QIODevice *)));
     connect( this, SIGNAL(purgeAndResendBuffer()) ,
@@ -153,6 +166,9 @@ bool SessionHandler::prepareSync()
     setLocalNextAnchor( QString::number( QDateTime::currentDateTime().toTime_t() ) );
     connectSignals();
     iItemReferences.clear();
+    iItemReferenceTargets.clear();
+    iRemoteSuspended = false;
+    iSessionSuspendable = false;
     setSyncState( PREPARED );
 
     return true;
@@ -167,6 +183,7 @@ void SessionHandler::abortSync( SyncState aSyncState, const QString& aDescriptio
     {
         qCDebug(lcSyncML) << "Aborting sync with state" << aSyncState << ", Reason:" << aDescription;
 
+        recordStateTime();
         iSyncState = aSyncState;
         iSyncFinished = true;
         iSyncError = aDescription;
@@ -190,6 +207,7 @@ void SessionHandler::setSyncState( SyncState aSyncState )
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     if( iSyncState != aSyncState ) {
+        recordStateTime();
         iSyncState = aSyncState;
         qCDebug(lcSyncML) << "Sync state changed to " << iSyncState;
         emit syncStateChanged( iSyncState );
@@ -208,6 +226,7 @@ void SessionHandler::finishSync()
 
     qCDebug(lcSyncML) << "Finishing sync";
 
+    recordStateTime();
     iSyncState = SYNC_FINISHED;
     iSyncFinished = true;
 
@@ -274,12 +293,79 @@ void SessionHandler::handleParsingComplete( bool aLastMessageInPackage )
     processMessage( fragments, aLastMessageInPackage );
 }
 
+void SessionHandler::handleFragmentsAvailable()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<DataSync::Fragment*> fragments = iParser.takeFragments();
+
+    // Fragments are discarded if parsing of the message fails before they
+    // are taken
+    if( !fragments.isEmpty() ) {
+        qint64 commitTime = iIncomingMessage.iTimes.iStorageCommitTime;
+        QElapsedTimer processTimer;
+        processTimer.start();
+
+        processFragments( fragments );
+
+        iIncomingMessage.iTimes.iProcessTime += processTimer.nsecsElapsed() / 1000 -
+                                                ( iIncomingMessage.iTimes.iStorageCommitTime - commitTime );
+    }
+}
+
 void SessionHandler::processMessage( QList<Fragment*>& aFragments, bool aLastMessageInPackage )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    qCDebug(lcSyncML) << "Beginning to process received message...";
-    iProcessing = true;
+    // Time spent in the parser is what remains of the handling time so far
+    // after processing of fragments parsed before the end of the message
+    if( iParseTimer.isValid() ) {
+        iIncomingMessage.iTimes.iParseTime = iParseTimer.nsecsElapsed() / 1000 -
+                                             iIncomingMessage.iTimes.iProcessTime -
+                                             iIncomingMessage.iTimes.iStorageCommitTime;
+        iParseTimer.invalidate();
+    }
+
+    qint64 commitTime = iIncomingMessage.iTimes.iStorageCommitTime;
+    QElapsedTimer processTimer;
+    processTimer.start();
+
+    processFragments( aFragments );
+
+    if( aLastMessageInPackage )
+    {
+        handleFinal();
+    }
+
+    iIncomingMessage.iTimes.iProcessTime += processTimer.nsecsElapsed() / 1000 -
+                                            ( iIncomingMessage.iTimes.iStorageCommitTime - commitTime );
+
+    iProcessing = false;
+    qCDebug(lcSyncML) << "Received message processed";
+
+    finishIncomingMessage();
+
+    handleEndOfMessage();
+
+}
+
+void SessionHandler::processFragments( QList<Fragment*>& aFragments )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iProcessing ) {
+        qCDebug(lcSyncML) << "Beginning to process received message...";
+        iProcessing = true;
+    }
+
+    bool parallelCommit = false;
+
+    if( getConfig()->getAgentProperty( PARALLELCOMMITPROP ).toInt() > 0 )
+    {
+        parallelCommit = true;
+    }
+
+    QList<SyncParams*> syncs;
 
     while( !aFragments.isEmpty() )
     {
@@ -298,7 +384,22 @@ void SessionHandler::processMessage( QList<Fragment*>& aFragments, bool aLastMes
         else if( fragment->fragmentType == Fragment::FRAGMENT_SYNC )
         {
             SyncParams* sync = static_cast<SyncParams*>(fragment);
-            handleSyncElement(sync);
+
+            if( parallelCommit )
+            {
+                // Process consecutive sync elements together
+                syncs.append( sync );
+
+                if( aFragments.isEmpty() || aFragments.first()->fragmentType != Fragment::FRAGMENT_SYNC )
+                {
+                    handleSyncElements( syncs );
+                    syncs.clear();
+                }
+            }
+            else
+            {
+                handleSyncElement(sync);
+            }
         }
         else if( fragment->fragmentType == Fragment::FRAGMENT_MAP )
         {
@@ -340,23 +441,16 @@ void SessionHandler::processMessage( QList<Fragment*>& aFragments, bool aLastMes
             Q_ASSERT(0);
         }
     }
-
-    if( aLastMessageInPackage )
-    {
-        handleFinal();
-    }
-
-    iProcessing = false;
-    qCDebug(lcSyncML) << "Received message processed";
-
-    handleEndOfMessage();
-
 }
 
 void SessionHandler::handleParserErrors( DataSync::ParserError aError )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Part of a message that was received incrementally may have been
+    // processed already, but processing of the message can not be completed
+    iProcessing = false;
+
     switch (aError) {
         case PARSER_ERROR_INCOMPLETE_DATA:
         {
@@ -409,6 +503,7 @@ void SessionHandler::handleHeaderElement( DataSync::HeaderParams* aHeaderParams
 
     // Save message id of the remote party
     getResponseGenerator().setRemoteMsgId( aHeaderParams->msgID );
+    iIncomingMessage.iMsgId = aHeaderParams->msgID;
 
     // If remote party sent max message size, save it.
     // If remote partys max message size is smaller than ours, reduce our
@@ -515,16 +610,17 @@ void SessionHandler::handleStatusElement( StatusParams* aStatusParams )
         }
         else if( aStatusParams->cmd == SYNCML_ELEMENT_ALERT ){
 
-            // Reverting to slow sync occured
-            if( aStatusParams->data == REFRESH_REQUIRED ) {
-                QString sourceDb = aStatusParams->sourceRef;
-
-                SyncTarget* target = getSyncTarget( sourceDb );
+            SyncTarget* target = getSyncTarget( aStatusParams->sourceRef );
 
-                if( target ) {
-                    target->revertSyncMode();
-                }
+            // Remote side did not resume the suspended session, continue
+            // with a new one
+            if( target && target->resuming() && aStatusParams->data != SUCCESS ) {
+                target->cancelResume( getDatabaseHandler() );
+            }
 
+            // Reverting to slow sync occured
+            if( aStatusParams->data == REFRESH_REQUIRED && target ) {
+                target->revertSyncMode();
             }
 
         }
@@ -544,30 +640,133 @@ void SessionHandler::handleSyncElement( SyncParams* aSyncParams )
 
     QSharedPointer<SyncParams> params( aSyncParams );
 
+    SyncTarget* target = acceptSync( *aSyncParams, iResponseGenerator );
+
+    if( !target ) {
+        return;
+    }
+
+    ConflictResolver& conflictResolver = target->getConflictResolver( conflictResolutionPolicy() );
+
+    iStorageHandler.setLargeObjectSpoolThreshold( getConfig()->getAgentProperty( LARGEOBJECTSPOOLTHRESHOLDPROP ).toLongLong() );
+
+    QElapsedTimer commitTimer;
+    commitTimer.start();
+
+    iCommandHandler.handleSync( *aSyncParams, *target, iStorageHandler,
+                                iResponseGenerator, conflictResolver,
+                                fastMapsSend() );
+
+    iIncomingMessage.iTimes.iStorageCommitTime += commitTimer.nsecsElapsed() / 1000;
+
+}
+
+void SessionHandler::handleSyncElements( const QList<SyncParams*>& aSyncParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    ConflictResolutionPolicy policy = conflictResolutionPolicy();
+    bool fastMaps = fastMapsSend();
+
+    QList<ResponseGenerator*> responseGenerators;
+    QMap<SyncTarget*, SyncCommitJob*> jobs;
+
+    for( int i = 0; i < aSyncParams.count(); ++i ) {
+
+        ResponseGenerator* responseGenerator = new ResponseGenerator();
+        responseGenerator->setRemoteMsgId( iResponseGenerator.getRemoteMsgId() );
+        responseGenerators.append( responseGenerator );
+
+        SyncTarget* target = acceptSync( *aSyncParams[i], *responseGenerator );
+
+        if( !target ) {
+            continue;
+        }
+
+        // All sync elements of a target are processed by the same job, so that
+        // storage plugin is accessed from one thread only
+        SyncCommitJob*& job = jobs[target];
+
+        if( !job ) {
+            job = new SyncCommitJob( iCommandHandler, *target, targetStorageHandler( target ),
+                                     policy, fastMaps );
+        }
+
+        job->addSync( aSyncParams[i], responseGenerator );
+    }
+
+    // With several targets the commits overlap, so the wall time of the
+    // whole section is recorded as storage commit time
+    QElapsedTimer commitTimer;
+    commitTimer.start();
+
+    if( jobs.count() == 1 ) {
+        SyncCommitJob* job = jobs.begin().value();
+        job->run();
+        delete job;
+    }
+    else if( jobs.count() > 1 ) {
+        qCDebug(lcSyncML) << "Committing" << jobs.count() << "sync targets in parallel";
+
+        foreach( SyncCommitJob* job, jobs ) {
+            iCommitThreadPool.start( job );
+        }
+
+        iCommitThreadPool.waitForDone();
+    }
+
+    iIncomingMessage.iTimes.iStorageCommitTime += commitTimer.nsecsElapsed() / 1000;
+
+    // Merge responses in the order of the sync elements
+    for( int i = 0; i < responseGenerators.count(); ++i ) {
+        iResponseGenerator.takeResponses( *responseGenerators[i] );
+    }
+
+    qDeleteAll( responseGenerators );
+    qDeleteAll( aSyncParams );
+}
+
+SyncTarget* SessionHandler::acceptSync( const SyncParams& aSyncParams, ResponseGenerator& aResponseGenerator )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
     // Don't process Sync elements if remote device has not authenticated
     if( !authentication().remoteIsAuthed() ) {
-        iCommandHandler.rejectSync( *aSyncParams, iResponseGenerator, INVALID_CRED  );
-        return;
+        iCommandHandler.rejectSync( aSyncParams, aResponseGenerator, INVALID_CRED  );
+        return NULL;
     }
 
     if( !syncReceived() ) {
-        iCommandHandler.rejectSync( *aSyncParams, iResponseGenerator, COMMAND_NOT_ALLOWED );
-        return;
+        iCommandHandler.rejectSync( aSyncParams, aResponseGenerator, COMMAND_NOT_ALLOWED );
+        return NULL;
     }
 
-    SyncTarget* target = getSyncTarget( aSyncParams->target );
+    SyncTarget* target = getSyncTarget( aSyncParams.target );
 
     if( !target ) {
-        iCommandHandler.rejectSync( *aSyncParams, iResponseGenerator,NOT_FOUND );
-        return;
+        iCommandHandler.rejectSync( aSyncParams, aResponseGenerator, NOT_FOUND );
+        return NULL;
     }
 
     if( !target->discoverLocalChanges( iRole ) ) {
         qCCritical(lcSyncML) << "Failed to discover local changes for source db" << target->getSourceDatabase();
-        iCommandHandler.rejectSync( *aSyncParams, iResponseGenerator, COMMAND_FAILED );
-        return;
+        iCommandHandler.rejectSync( aSyncParams, aResponseGenerator, COMMAND_FAILED );
+        return NULL;
+    }
+
+    if( iRole == ROLE_SERVER && slowSyncMatching() && !target->getItemMatcher() &&
+        target->getSyncMode()->syncType() == TYPE_SLOW ) {
+        qCDebug(lcSyncML) << "Matching items added in slow sync to existing items of" << target->getSourceDatabase();
+        target->setItemMatcher( new ItemMatcher( *target->getPlugin() ) );
     }
 
+    return target;
+}
+
+ConflictResolutionPolicy SessionHandler::conflictResolutionPolicy() const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
     ConflictResolutionPolicy policy = PREFER_LOCAL_CHANGES;
 
     ConflictResolutionPolicy confValue = static_cast<ConflictResolutionPolicy>( getConfig()->getAgentProperty( CONFLICTRESOLUTIONPOLICYPROP ).toInt() );
@@ -577,8 +776,12 @@ void SessionHandler::handleSyncElement( SyncParams* aSyncParams )
         policy = confValue;
     }
 
-    ConflictResolver conflictResolver( *target->getLocalChanges(),
-                                       policy );
+    return policy;
+}
+
+bool SessionHandler::fastMapsSend() const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     bool fastMapsSend = false;
 
@@ -589,10 +792,26 @@ void SessionHandler::handleSyncElement( SyncParams* aSyncParams )
         fastMapsSend = true;
     }
 
-    iCommandHandler.handleSync( *aSyncParams, *target, iStorageHandler,
-                                iResponseGenerator, conflictResolver,
-                                fastMapsSend );
+    return fastMapsSend;
+}
+
+StorageHandler& SessionHandler::targetStorageHandler( SyncTarget* aTarget )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    StorageHandler* storageHandler = iTargetStorageHandlers.value( aTarget );
 
+    if( !storageHandler ) {
+        storageHandler = new StorageHandler();
+        storageHandler->setLargeObjectSpoolThreshold( getConfig()->getAgentProperty( LARGEOBJECTSPOOLTHRESHOLDPROP ).toLongLong() );
+
+        connect( storageHandler, SIGNAL( itemProcessed( DataSync::ModificationType, DataSync::ModifiedDatabase,QString ,QString, int ) ),
+                 this, SIGNAL( itemProcessed( DataSync::ModificationType, DataSync::ModifiedDatabase,QString ,QString, int) ) );
+
+        iTargetStorageHandlers.insert( aTarget, storageHandler );
+    }
+
+    return *storageHandler;
 }
 
 void SessionHandler::handleAlertElement( CommandParams* aAlertParams )
@@ -608,6 +827,9 @@ void SessionHandler::handleAlertElement( CommandParams* aAlertParams )
         if( syncMode.isValid() ) {
             status = syncAlertReceived( syncMode, *aAlertParams );
         }
+        else if( aAlertParams->data.toInt() == ALERT_RESUME ) {
+            status = resumeAlertReceived( *aAlertParams );
+        }
         else {
             status = handleInformativeAlert( *aAlertParams );
         }
@@ -758,6 +980,15 @@ void SessionHandler::handleEndOfMessage()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Store the progress once items are being exchanged, so that an interrupted
+    // session can be continued from the last processed message
+    if( resumableSessions() &&
+        ( iSyncState == SENDING_ITEMS || iSyncState == RECEIVING_ITEMS ||
+          iSyncState == SENDING_MAPPINGS || iSyncState == RECEIVING_MAPPINGS ) ) {
+        suspendSession();
+        iSessionSuspendable = true;
+    }
+
     messageParsed();
     if( iSyncFinished ) {
         exitSync();
@@ -786,14 +1017,30 @@ void SessionHandler::sendNextMessage()
 
     // @todo: what if message generation fails?
 
+    iOutgoingMessage = MessageStatistics();
+    iOutgoingMessage.iOutgoing = true;
+
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+
     SyncMLMessage* message = iResponseGenerator.generateNextMessage( params().remoteMaxMsgSize(),
                                                                      getProtocolVersion(),
                                                                      getTransport().usesWbXML() );
 
+    iOutgoingMessage.iTimes.iGenerateTime = generateTimer.nsecsElapsed() / 1000;
+
+    if( message ) {
+        iOutgoingMessage.iMsgId = message->getMsgId();
+    }
+
     // @todo: what if sending fails?
 
+    // Size and encoding time are filled in by handleMessageSent()
     getTransport().sendSyncML( message );
 
+    iStatistics.iTimes.iGenerateTime += iOutgoingMessage.iTimes.iGenerateTime;
+    iStatistics.iMessages.append( iOutgoingMessage );
+
     if( getConfig()->extensionEnabled( EMITAGSEXTENSION ) )
     {
         clearEMITags();
@@ -808,6 +1055,11 @@ ProtocolVersion SessionHandler::getProtocolVersion() const
     return iProtocolVersion;
 }
 
+const SessionStatistics& SessionHandler::getStatistics() const
+{
+    return iStatistics;
+}
+
 void SessionHandler::setProtocolVersion( const ProtocolVersion& aProtocolVersion )
 {
     iProtocolVersion = aProtocolVersion;
@@ -834,11 +1086,16 @@ void SessionHandler::exitSync()
         // Transport can be closed before doing cleaning
         getTransport().close();
 
-        // In case of successful session, save sync anchors
+        // In case of successful session, save sync anchors. Otherwise store
+        // the progress of the session so that it can be resumed
         if( iSyncState == SYNC_FINISHED )
         {
             saveSession();
         }
+        else if( iSessionSuspendable )
+        {
+            suspendSession();
+        }
 
         // Clear package queue in case we have active packages. For example
         // LocalChangesPackage might attempt to do item prefetching after storages are cleared
@@ -848,6 +1105,10 @@ void SessionHandler::exitSync()
         // Release storages
     	releaseStoragesAndTargets();
 
+        // Account time spent in the final state until now
+        recordStateTime();
+        iStateTimer.invalidate();
+
         emit syncFinished( params().remoteDeviceName(), iSyncState, iSyncError);
 
     }
@@ -866,13 +1127,16 @@ void SessionHandler::releaseStoragesAndTargets()
     if (provider != NULL) {
 
         for( int i = 0; i < iStorages.count(); ++i ) {
-            provider->releaseStorage( iStorages[i] );
+            provider->releaseSessionStorage( iStorages[i], this );
         }
 
         iStorages.clear();
     }
 
 
+    qDeleteAll( iTargetStorageHandlers );
+    iTargetStorageHandlers.clear();
+
     qDeleteAll( iSyncTargets );
     iSyncTargets.clear();
 }
@@ -885,17 +1149,103 @@ void DataSync::SessionHandler::connectSignals()
     connect( &iParser, SIGNAL(parsingComplete(bool)),
              this, SLOT(handleParsingComplete(bool)), Qt::QueuedConnection );
 
+    connect( &iParser, SIGNAL(fragmentsAvailable()),
+             this, SLOT(handleFragmentsAvailable()), Qt::QueuedConnection );
+
     connect( &iParser, SIGNAL( parsingError(DataSync::ParserError)),
             this, SLOT(handleParserErrors(DataSync::ParserError)));
 
-    connect( &iCommandHandler, SIGNAL( itemAcknowledged( int, int, SyncItemKey ) ),
-             this, SLOT( processItemStatus( int, int, SyncItemKey ) ) );
+    connect( &iCommandHandler, SIGNAL( itemAcknowledged( int, int, SyncItemKey, int ) ),
+             this, SLOT( processItemStatus( int, int, SyncItemKey, int ) ) );
+
+    connect( &iCommandHandler, SIGNAL( remoteItemAcknowledged( int, int, QString, int ) ),
+             this, SLOT( processRemoteItemStatus( int, int, QString, int ) ) );
 
     connect( &iStorageHandler, SIGNAL( itemProcessed( DataSync::ModificationType, DataSync::ModifiedDatabase,QString ,QString, int ) ),
              this, SIGNAL( itemProcessed( DataSync::ModificationType, DataSync::ModifiedDatabase,QString ,QString, int) ) );
 
 }
 
+void SessionHandler::recordStateTime()
+{
+    if( iStateTimer.isValid() ) {
+        iStatistics.iStateTimes[iSyncState] += iStateTimer.nsecsElapsed() / 1000;
+        iStateTimer.restart();
+    }
+}
+
+void SessionHandler::finishIncomingMessage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iStatistics.iTimes.iParseTime += iIncomingMessage.iTimes.iParseTime;
+    iStatistics.iTimes.iProcessTime += iIncomingMessage.iTimes.iProcessTime;
+    iStatistics.iTimes.iTransportWaitTime += iIncomingMessage.iTimes.iTransportWaitTime;
+    iStatistics.iTimes.iStorageCommitTime += iIncomingMessage.iTimes.iStorageCommitTime;
+    iStatistics.iMessages.append( iIncomingMessage );
+
+    iIncomingMessage = MessageStatistics();
+}
+
+void SessionHandler::handleIncomingMessage( QIODevice* aDevice, bool aIsNewPacket )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_UNUSED( aDevice );
+
+    // Purged messages are resent after the original failed to parse, keep
+    // measuring from the original
+    if( aIsNewPacket || !iParseTimer.isValid() ) {
+        handleIncomingMessagePart( QByteArray(), true, true );
+    }
+}
+
+void SessionHandler::handleIncomingMessagePart( const QByteArray& aData, bool aFirstPart, bool aLastPart )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_UNUSED( aData );
+    Q_UNUSED( aLastPart );
+
+    if( !aFirstPart ) {
+        return;
+    }
+
+    if( iWaitTimer.isValid() ) {
+        iIncomingMessage.iTimes.iTransportWaitTime = iWaitTimer.nsecsElapsed() / 1000;
+        iWaitTimer.invalidate();
+    }
+
+    iParseTimer.start();
+}
+
+void SessionHandler::handleMessageSent( qint64 aBytes, qint64 aEncodeTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iOutgoingMessage.iBytes = aBytes;
+    iOutgoingMessage.iTimes.iEncodeTime = aEncodeTime;
+
+    iStatistics.iBytesSent += aBytes;
+    iStatistics.iTimes.iEncodeTime += aEncodeTime;
+    ++iStatistics.iMessagesSent;
+
+    // Waiting for the response starts now
+    iWaitTimer.start();
+}
+
+void SessionHandler::handleMessageReceived( qint64 aBytes )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Emitted before the last part of the message reaches the parser, so
+    // the size is in place when the message is finished
+    iIncomingMessage.iBytes += aBytes;
+
+    iStatistics.iBytesReceived += aBytes;
+    ++iStatistics.iMessagesReceived;
+}
+
 ResponseStatusCode SessionHandler::handleInformativeAlert( const CommandParams& aAlertParams )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -903,7 +1253,7 @@ ResponseStatusCode SessionHandler::handleInformativeAlert( const CommandParams&
     ResponseStatusCode status;
 
     // Do not implement: RESULT_ALERT, DISPLAY
-    // @todo: implement NO_END_OF_DATA, ALERT_SUSPEND, ALERT_RESUME
+    // @todo: implement NO_END_OF_DATA
     qint32 alertCode = aAlertParams.data.toInt();
     switch( alertCode ) {
         case DISPLAY:
@@ -917,6 +1267,14 @@ ResponseStatusCode SessionHandler::handleInformativeAlert( const CommandParams&
             status = SUCCESS;
             break;
         }
+        case ALERT_SUSPEND:
+        {
+            // Session is ended once the rest of the message has been handled
+            qCDebug(lcSyncML) << "Remote side suspended the session";
+            iRemoteSuspended = true;
+            status = SUCCESS;
+            break;
+        }
         default:
         {
             status = NOT_IMPLEMENTED;
@@ -971,19 +1329,41 @@ void SessionHandler::composeLocalChanges()
 
     int largeObjectThreshold = qMax( static_cast<int>( MAXMSGOVERHEADRATIO * params().remoteMaxMsgSize()), MINMSGOVERHEADBYTES );
 
+    bool asyncPrefetch = false;
+
+    if( getConfig()->getAgentProperty( ASYNCPREFETCHPROP ).toInt() > 0 )
+    {
+        asyncPrefetch = true;
+    }
+
+    bool multiItemCommands = false;
+
+    if( getConfig()->getAgentProperty( MULTIITEMCOMMANDSPROP ).toInt() > 0 )
+    {
+        multiItemCommands = true;
+    }
+
     const QList<SyncTarget*>& targets = getSyncTargets();
-    foreach( const SyncTarget* syncTarget, targets ) {
+    foreach( SyncTarget* syncTarget, targets ) {
         const LocalChanges* localChanges = syncTarget->getLocalChanges();
         LocalChangesPackage* localChangesPackage = new LocalChangesPackage( *syncTarget,
                                                                             *localChanges,
                                                                             largeObjectThreshold,
                                                                             iRole,
                                                                             maxChangesPerMessage );
+        localChangesPackage->setPrefetchOptions( asyncPrefetch, params().remoteMaxMsgSize() );
+        localChangesPackage->setMultiItemCommands( multiItemCommands );
         iResponseGenerator.addPackage(localChangesPackage);
 
         connect( localChangesPackage, SIGNAL( newItemWritten( int, int, SyncItemKey, ModificationType, QString, QString, QString ) ),
                  this, SLOT( newItemReference( int, int, SyncItemKey, ModificationType, QString, QString, QString ) ) );
 
+        connect( localChangesPackage, SIGNAL( itemSuppressed( SyncItemKey, QString ) ),
+                 this, SLOT( handleItemSuppressed( SyncItemKey, QString ) ) );
+
+        connect( localChangesPackage, SIGNAL( itemsPrefetched( int, int ) ),
+                 this, SLOT( handleItemsPrefetched( int, int ) ) );
+
     }
 
 }
@@ -1112,12 +1492,54 @@ void SessionHandler::saveSession()
     time.setHMS( time.hour(), time.minute(), time.second() , 0 );
     dateTime.setTime( time );
 
+    // Each target is saved in its own transaction, so that a failure to save
+    // one target doesn't lose the state of the others
+    foreach( SyncTarget* syncTarget, getSyncTargets()) {
+        syncTarget->saveSession( getDatabaseHandler(), dateTime );
+    }
+
+}
+
+void SessionHandler::suspendSession()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
     DatabaseHandler& handler = getDatabaseHandler();
 
-    foreach( SyncTarget* syncTarget, getSyncTargets()) {
-        syncTarget->saveSession( handler, dateTime );
+    bool transaction = DatabaseHandler::beginTransaction( handler.getDbHandle() );
+
+    foreach( SyncTarget* syncTarget, getSyncTargets() ) {
+        syncTarget->suspendSession( handler );
+    }
+
+    if( transaction && !DatabaseHandler::commitTransaction( handler.getDbHandle() ) ) {
+        qCWarning(lcSyncML) << "Could not save suspend information to persistent storage!";
     }
+}
+
+bool SessionHandler::resumableSessions() const
+{
+    return ( getConfig()->getAgentProperty( RESUMABLESESSIONSPROP ).toInt() > 0 );
+}
+
+bool SessionHandler::fingerprintChanges() const
+{
+    return ( getConfig()->getAgentProperty( FINGERPRINTCHANGESPROP ).toInt() > 0 );
+}
+
+bool SessionHandler::suppressUnchangedReplaces() const
+{
+    return ( getConfig()->getAgentProperty( SUPPRESSUNCHANGEDREPLACESPROP ).toInt() > 0 );
+}
+
+bool SessionHandler::slowSyncMatching() const
+{
+    return ( getConfig()->getAgentProperty( SLOWSYNCMATCHINGPROP ).toInt() > 0 );
+}
 
+bool SessionHandler::remoteSuspended() const
+{
+    return iRemoteSuspended;
 }
 
 StoragePlugin* SessionHandler::createStorageByURI( const QString& aURI )
@@ -1142,7 +1564,9 @@ StoragePlugin* SessionHandler::createStorageByURI( const QString& aURI )
         }
 
         if (storageProvider != NULL) {
-            plugin = storageProvider->acquireStorageByURI( aURI );
+            // Pass this session, so that the provider can ask properties
+            // like protocol version from the session handler.
+            plugin = storageProvider->acquireSessionStorageByURI( aURI, this );
         }
 
         if (plugin != NULL) {
@@ -1169,7 +1593,7 @@ StoragePlugin* SessionHandler::createStorageByMIME( const QString& aMIME )
     }
 
     if( !plugin ) {
-        plugin = getConfig()->getStorageProvider()->acquireStorageByMIME( aMIME );
+        plugin = getConfig()->getStorageProvider()->acquireSessionStorageByMIME( aMIME, this );
         if (plugin) {
             iStorages.append( plugin );
 	    emit storageAccquired (aMIME);
@@ -1185,7 +1609,8 @@ const QList<StoragePlugin*>& SessionHandler::getStorages() const
     return iStorages;
 }
 
-SyncTarget* SessionHandler::createSyncTarget( StoragePlugin& aPlugin, const SyncMode& aSyncMode )
+SyncTarget* SessionHandler::createSyncTarget( StoragePlugin& aPlugin, const SyncMode& aSyncMode,
+                                              SuspendLog* aSuspendLog )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -1201,14 +1626,55 @@ SyncTarget* SessionHandler::createSyncTarget( StoragePlugin& aPlugin, const Sync
             qCWarning(lcSyncML) << "Could not load change log information";
         }
 
+        bool fingerprints = fingerprintChanges();
+        bool suppressReplaces = suppressUnchangedReplaces();
+
+        if( ( fingerprints || suppressReplaces ) &&
+            !changelog->loadFingerprints( getDatabaseHandler().getDbHandle() ) ) {
+            qCWarning(lcSyncML) << "Could not load item fingerprints";
+        }
+
         target = new SyncTarget( changelog, &aPlugin, aSyncMode, getLocalNextAnchor() );
 
+        if( fingerprints ) {
+            target->enableFingerprints();
+        }
+
+        if( suppressReplaces ) {
+            target->enableReplaceSuppression();
+        }
+
+        if( !aSuspendLog ) {
+            aSuspendLog = loadSuspendLog( aPlugin );
+        }
+
+    }
+
+    if( aSuspendLog ) {
+        target->setSuspendLog( aSuspendLog );
     }
 
     return target;
 
 }
 
+SuspendLog* SessionHandler::loadSuspendLog( StoragePlugin& aPlugin )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !resumableSessions() ) {
+        return NULL;
+    }
+
+    SuspendLog* suspendLog = new SuspendLog( params().remoteDeviceName(), aPlugin.getSourceURI() );
+
+    if( !suspendLog->load( getDatabaseHandler().getDbHandle() ) ) {
+        qCWarning(lcSyncML) << "Could not load suspend log information";
+    }
+
+    return suspendLog;
+}
+
 void SessionHandler::addSyncTarget( SyncTarget* aTarget )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -1294,47 +1760,159 @@ void SessionHandler::newItemReference( int aMsgId, int aCmdId, SyncItemKey aKey,
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    ItemReferenceKey key;
+
+    key.iMsgId = aMsgId;
+    key.iCmdId = aCmdId;
+    key.iKey = aKey;
+
     ItemReference reference;
 
-    reference.iMsgId = aMsgId;
-    reference.iCmdId = aCmdId;
-    reference.iKey = aKey;
     reference.iModificationType = aModificationType;
-    reference.iLocalDatabase = aLocalDatabase;
-    reference.iRemoteDatabase = aRemoteDatabase;
-    reference.iMimeType = aMimeType;
+    reference.iTarget = -1;
+
+    // There are only a few distinct targets per session, so a linear search is enough.
+    // Search from the end as consecutive items usually belong to the same target
+    for( int i = iItemReferenceTargets.count() - 1; i >= 0; --i ) {
+        const ItemReferenceTarget& target = iItemReferenceTargets[i];
+
+        if( target.iLocalDatabase == aLocalDatabase &&
+            target.iRemoteDatabase == aRemoteDatabase &&
+            target.iMimeType == aMimeType ) {
+            reference.iTarget = i;
+            break;
+        }
+    }
+
+    if( reference.iTarget < 0 ) {
+        ItemReferenceTarget target;
+        target.iLocalDatabase = aLocalDatabase;
+        target.iRemoteDatabase = aRemoteDatabase;
+        target.iMimeType = aMimeType;
 
-    iItemReferences.append( reference );
+        reference.iTarget = iItemReferenceTargets.count();
+        iItemReferenceTargets.append( target );
+    }
+
+    iItemReferences.insert( key, reference );
 
     qCDebug(lcSyncML) << "Adding reference to item:" << aKey;
 }
 
-void SessionHandler::processItemStatus( int aMsgRef, int aCmdRef, SyncItemKey aKey )
+void SessionHandler::processItemStatus( int aMsgRef, int aCmdRef, SyncItemKey aKey, int aStatusCode )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aKey.isEmpty() ) {
+
+        // Status applies to every item that was sent in the command
+        QList<ItemReferenceKey> keys;
+
+        QHash<ItemReferenceKey, ItemReference>::const_iterator i;
+        for( i = iItemReferences.constBegin(); i != iItemReferences.constEnd(); ++i ) {
+            if( i.key().iMsgId == aMsgRef && i.key().iCmdId == aCmdRef ) {
+                keys.append( i.key() );
+            }
+        }
+
+        for( int j = 0; j < keys.count(); ++j ) {
+            processItemReference( keys[j], aStatusCode );
+        }
+
+    }
+    else {
+
+        ItemReferenceKey key;
+
+        key.iMsgId = aMsgRef;
+        key.iCmdId = aCmdRef;
+        key.iKey = aKey;
+
+        processItemReference( key, aStatusCode );
+    }
+
+}
+
+void SessionHandler::processRemoteItemStatus( int aMsgRef, int aCmdRef, QString aRemoteKey,
+                                              int aStatusCode )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    ItemReferenceKey key;
+
+    key.iMsgId = aMsgRef;
+    key.iCmdId = aCmdRef;
+
+    // There are only a few distinct targets per session, so try the mappings
+    // of each until the item is found
+    for( int i = 0; i < iItemReferenceTargets.count(); ++i ) {
+
+        SyncTarget* syncTarget = getSyncTarget( iItemReferenceTargets[i].iLocalDatabase );
+
+        if( !syncTarget ) {
+            continue;
+        }
+
+        key.iKey = syncTarget->mapToLocalUID( aRemoteKey );
+
+        if( !key.iKey.isEmpty() && iItemReferences.contains( key ) ) {
+            processItemReference( key, aStatusCode );
+            return;
+        }
+    }
+
+    qCDebug(lcSyncML) << "No reference to item with remote key:" << aRemoteKey;
+}
+
+void SessionHandler::processItemReference( const ItemReferenceKey& aKey, int aStatusCode )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     quint32 count = iItemReferences.count();
 
-    for( int i = 0; i < iItemReferences.count(); ++i ) {
+    QHash<ItemReferenceKey, ItemReference>::iterator i = iItemReferences.find( aKey );
 
-        const ItemReference& reference = iItemReferences[i];
+    if( i != iItemReferences.end() ) {
 
-        if( reference.iMsgId == aMsgRef &&
-            reference.iCmdId == aCmdRef &&
-            reference.iKey == aKey ) {
+        ModificationType modificationType = i->iModificationType;
+        ItemReferenceTarget target = iItemReferenceTargets.at( i->iTarget );
 
-            emit itemProcessed( reference.iModificationType, MOD_REMOTE_DATABASE, reference.iLocalDatabase,
-                                reference.iMimeType, count );
-            iItemReferences.removeAt( i );
+        iItemReferences.erase( i );
 
-            break;
+        // Remote side has processed the item successfully, so it is not sent
+        // again if the session is resumed
+        SyncTarget* syncTarget = getSyncTarget( target.iLocalDatabase );
 
+        if( syncTarget && aStatusCode >= SUCCESS && aStatusCode < MULTIPLE_CHOICES ) {
+            syncTarget->addProcessedItem( aKey.iKey );
+            syncTarget->confirmSentItem( aKey.iKey );
         }
 
+        emit itemProcessed( modificationType, MOD_REMOTE_DATABASE, target.iLocalDatabase,
+                            target.iMimeType, count );
+
     }
 
 }
 
+void SessionHandler::handleItemSuppressed( SyncItemKey aKey, QString aLocalDatabase )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_UNUSED( aKey );
+    Q_UNUSED( aLocalDatabase );
+
+    ++iStatistics.iSuppressedReplaces;
+}
+
+void SessionHandler::handleItemsPrefetched( int aHits, int aMisses )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iStatistics.iPrefetchHits += aHits;
+    iStatistics.iPrefetchMisses += aMisses;
+}
+
 bool DataSync::SessionHandler::isRemoteBusyStatusSet() const
 {
 	return iRemoteReportedBusy;
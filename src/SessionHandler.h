@@ -35,6 +35,10 @@
 #define SESSIONHANDLER_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QThreadPool>
 
 #include "SyncAgentConsts.h"
 #include "Transport.h"
@@ -47,6 +51,7 @@
 #include "ResponseGenerator.h"
 #include "SyncMLMessageParser.h"
 #include "DevInfHandler.h"
+#include "SyncResults.h"
 
 class ServerSessionHandlerTest;
 class ClientSessionHandlerTest;
@@ -58,19 +63,42 @@ namespace DataSync
 class SyncAgentConfig;
 class SyncMode;
 class SyncTarget;
+class SuspendLog;
 
-/*! \brief Structure to hold reference to an item
+/*! \brief Structure to identify a sent item
  *
  */
-struct ItemReference {
+struct ItemReferenceKey {
     int iMsgId;                         /*!<Message ID related to the item*/
     int iCmdId;                         /*!<Command ID related to the item*/
     SyncItemKey iKey;                   /*!<Key of the item*/
-    ModificationType iModificationType; /*!<Type of modification related to the item*/
+
+    bool operator==( const ItemReferenceKey& aOther ) const
+    {
+        return iMsgId == aOther.iMsgId && iCmdId == aOther.iCmdId && iKey == aOther.iKey;
+    }
+};
+
+inline uint qHash( const ItemReferenceKey& aKey )
+{
+    return qHash( aKey.iKey ) ^ ( static_cast<uint>( aKey.iMsgId ) << 16 ) ^ static_cast<uint>( aKey.iCmdId );
+}
+
+/*! \brief Structure to hold databases and MIME type shared by item references
+ *
+ */
+struct ItemReferenceTarget {
     QString iLocalDatabase;             /*!<Local database related to the item*/
     QString iRemoteDatabase;            /*!<Remote database related to the item*/
     QString iMimeType;                  /*!<MIME type of the item*/
+};
 
+/*! \brief Structure to hold reference to an item
+ *
+ */
+struct ItemReference {
+    ModificationType iModificationType; /*!<Type of modification related to the item*/
+    int iTarget;                        /*!<Index of the databases and MIME type of the item*/
 };
 
 /*! \brief SessionHandler handles all control flow and session related tasks of SyncML protocol.
@@ -114,6 +142,12 @@ public:
      */
     ProtocolVersion getProtocolVersion() const;
 
+    /*! \brief Returns timing and byte statistics of this session
+     *
+     * @return Session statistics
+     */
+    const SessionStatistics& getStatistics() const;
+
 public slots:
 
     /*! \brief Initiate a synchronization session with remote device
@@ -193,6 +227,12 @@ protected slots:
      */
     void handleParsingComplete( bool aLastMessageInPackage );
 
+    /*! \brief Slot for handling processing of fragments that have been
+     *         parsed before the rest of the message has been received
+     *
+     */
+    void handleFragmentsAvailable();
+
     /*! \brief A slot handler for handling parser errors
      *
      *  @param aError Occurred error
@@ -224,6 +264,16 @@ protected slots:
      */
     void handleSyncElement(DataSync::SyncParams* aSyncParams);
 
+    /*! \brief Called with consecutive sync elements of a message when
+     *         parallel commit is enabled
+     *
+     * Sync elements of different sync targets are processed concurrently.
+     * Responses are written in the order of the sync elements.
+     *
+     * @param aSyncParams Parameters of the sync elements. Ownership is transferred
+     */
+    void handleSyncElements( const QList<DataSync::SyncParams*>& aSyncParams );
+
     /*! \brief Called when the parser finds an alert element in the message being parsed
      *
      * @param aAlertParams Parameters of the response message alert element
@@ -282,9 +332,67 @@ protected slots:
      *
      * @param aMsgRef Message reference of the item
      * @param aCmdRef Command reference of the item
+     * @param aKey Key of the item, empty to process all items of the command
+     * @param aStatusCode Status code the remote side responded with
+     */
+    void processItemStatus( int aMsgRef, int aCmdRef, SyncItemKey aKey, int aStatusCode = SUCCESS );
+
+    /*! \brief Should be called when remote side has responded to item reference
+     *         by the remote key of the item
+     *
+     * Remote key is mapped to the local key of the item with the UID mappings
+     * of the sync targets that have items referred to.
+     *
+     * @param aMsgRef Message reference of the item
+     * @param aCmdRef Command reference of the item
+     * @param aRemoteKey Remote key of the item
+     * @param aStatusCode Status code the remote side responded with
+     */
+    void processRemoteItemStatus( int aMsgRef, int aCmdRef, QString aRemoteKey, int aStatusCode );
+
+    /*! \brief Should be called when a modified item was left out because its
+     *         content had not changed
+     *
      * @param aKey Key of the item
+     * @param aLocalDatabase Local database where item exists
      */
-    void processItemStatus( int aMsgRef, int aCmdRef, SyncItemKey aKey );
+    void handleItemSuppressed( SyncItemKey aKey, QString aLocalDatabase );
+
+    /*! \brief Should be called when outgoing items have been fetched from
+     *         a storage plugin
+     *
+     * @param aHits Number of items found from prefetched items
+     * @param aMisses Number of items fetched on demand
+     */
+    void handleItemsPrefetched( int aHits, int aMisses );
+
+    /*! \brief Called when transport starts passing a received message to the parser
+     *
+     * @param aDevice IO device containing the message
+     * @param aIsNewPacket True if this is a newly received message
+     */
+    void handleIncomingMessage( QIODevice* aDevice, bool aIsNewPacket );
+
+    /*! \brief Called when transport passes part of a received message to the parser
+     *
+     * @param aData Part of the message
+     * @param aFirstPart True if this is the first part of the message
+     * @param aLastPart True if this is the last part of the message
+     */
+    void handleIncomingMessagePart( const QByteArray& aData, bool aFirstPart, bool aLastPart );
+
+    /*! \brief Called when transport has sent a message
+     *
+     * @param aBytes Size of the message
+     * @param aEncodeTime Time spent encoding the message, in microseconds
+     */
+    void handleMessageSent( qint64 aBytes, qint64 aEncodeTime );
+
+    /*! \brief Called when transport has received a message
+     *
+     * @param aBytes Size of the message
+     */
+    void handleMessageReceived( qint64 aBytes );
 
 protected:
 
@@ -302,6 +410,13 @@ protected:
      */
     virtual ResponseStatusCode syncAlertReceived( const SyncMode& aSyncMode, CommandParams& aAlertParams ) = 0;
 
+    /*! \brief Invoked when Alert to resume a suspended session has been received
+     *         from remote side
+     *
+     * @param aAlertParams Alert params
+     */
+    virtual ResponseStatusCode resumeAlertReceived( CommandParams& aAlertParams ) = 0;
+
     /*! \brief Invoked when Sync related to receiving items has been received from
      *         remote side
      *
@@ -340,6 +455,12 @@ protected:
      */
     void processMessage( QList<Fragment*>& aFragments, bool aLastMessageInPackage );
 
+    /*! \brief Process protocol fragments of a message sent by remote device
+     *
+     * @param aFragments Protocol fragments. Ownership is transferred.
+     */
+    void processFragments( QList<Fragment*>& aFragments );
+
     /*! \brief Sets current state of the sync
      *
      * @param aSyncState New status to set
@@ -442,8 +563,55 @@ protected:
      *
      * @param aPlugin Storage plugin representing local database
      * @param aSyncMode Sync mode to use
+     * @param aSuspendLog Suspend log to use. If NULL, it is loaded when
+     *                    sessions are resumable. Ownership is transferred.
+     */
+    SyncTarget* createSyncTarget( StoragePlugin& aPlugin, const SyncMode& aSyncMode,
+                                  SuspendLog* aSuspendLog = NULL );
+
+    /*! \brief Loads the suspend log of a local database
+     *
+     * @param aPlugin Storage plugin representing local database
+     * @return Suspend log if sessions are resumable, otherwise NULL. Ownership is transferred.
+     */
+    SuspendLog* loadSuspendLog( StoragePlugin& aPlugin );
+
+    /*! \brief Returns whether the progress of the session is stored so that it
+     *         can be resumed if interrupted
+     *
+     * @return True if sessions are resumable, otherwise false
      */
-    SyncTarget* createSyncTarget( StoragePlugin& aPlugin, const SyncMode& aSyncMode );
+    bool resumableSessions() const;
+
+    /*! \brief Returns whether local changes are detected by item fingerprints
+     *
+     * @return True if fingerprints are used, otherwise false
+     */
+    bool fingerprintChanges() const;
+
+    /*! \brief Returns whether Replace commands of unchanged items are left out
+     *
+     * @return True if Replace commands are left out, otherwise false
+     */
+    bool suppressUnchangedReplaces() const;
+
+    /*! \brief Returns whether items added in slow sync are matched to existing
+     *         local items
+     *
+     * @return True if items are matched, otherwise false
+     */
+    bool slowSyncMatching() const;
+
+    /*! \brief Saves the progress of the session to the suspend logs of sync targets
+     *
+     */
+    void suspendSession();
+
+    /*! \brief Returns whether remote side has suspended the session
+     *
+     * @return True if Alert to suspend the session has been received, otherwise false
+     */
+    bool remoteSuspended() const;
 
     /*! \brief Adds a new sync target to the list of available sync targets
      *
@@ -590,6 +758,20 @@ private: // functions
 
     ResponseStatusCode handleInformativeAlert( const CommandParams& aAlertParams );
 
+    SyncTarget* acceptSync( const SyncParams& aSyncParams, ResponseGenerator& aResponseGenerator );
+
+    ConflictResolutionPolicy conflictResolutionPolicy() const;
+
+    bool fastMapsSend() const;
+
+    StorageHandler& targetStorageHandler( SyncTarget* aTarget );
+
+    void recordStateTime();
+
+    void finishIncomingMessage();
+
+    void processItemReference( const ItemReferenceKey& aKey, int aStatusCode );
+
 private: // data
     DatabaseHandler                     iDatabaseHandler;           ///< Handler for database operations
     SessionAuthentication               iSessionAuth;               ///< Handles authentication of the session
@@ -606,13 +788,24 @@ private: // data
     QString                             iLocalNextAnchor;           ///< Local NEXT anchor of this session
     QString                             iSyncError;                 ///< Human-readable description upon sync abort
     bool                                iSyncWithoutInitPhase;      ///< Perform synchronization without init phase
-    QList<ItemReference>                iItemReferences;            ///< Keeps track which status refers to which item in which database
+    QHash<ItemReferenceKey, ItemReference> iItemReferences;         ///< Keeps track which status refers to which item in which database
+    QList<ItemReferenceTarget>          iItemReferenceTargets;      ///< Databases and MIME types referred to by item references
+    QMap<SyncTarget*, StorageHandler*>  iTargetStorageHandlers;     ///< Storage handlers of sync targets in parallel commit
+    QThreadPool                         iCommitThreadPool;          ///< Threads for parallel commit
     bool                                iSyncFinished;              ///< Set to true when sync has ended
     bool                                iSessionClosed;             ///< Set to true when Session tearing down started.
     bool                                iProcessing;                ///< Set to true when we are processing a message
     ProtocolVersion                     iProtocolVersion;           ///< Protocol version in use in current session
     bool                                iRemoteReportedBusy;        ///< indicates that server reported busy
+    bool                                iRemoteSuspended;           ///< Set to true when remote side suspends the session
+    bool                                iSessionSuspendable;        ///< Set to true when progress of the session has been stored
     Role                                iRole;                      ///< Role in use
+    SessionStatistics                   iStatistics;                ///< Timing and byte statistics of the session
+    QElapsedTimer                       iStateTimer;                ///< Measures time spent in current sync state
+    QElapsedTimer                       iWaitTimer;                 ///< Measures time waited for remote device
+    QElapsedTimer                       iParseTimer;                ///< Measures handling time of received message
+    MessageStatistics                   iIncomingMessage;           ///< Statistics of message being received
+    MessageStatistics                   iOutgoingMessage;           ///< Statistics of message being sent
     ///< A quick way to get the response a remote party sent to the last "cmd" command we sent
     QMap<QString, ResponseStatusCode>     cmdRespMap;
 
@@ -38,6 +38,8 @@
 #include "StoragePlugin.h"
 #include "SyncItem.h"
 #include "ConflictResolver.h"
+#include "ItemMatcher.h"
+#include "LargeObjectSpool.h"
 
 #include "SyncMLLogging.h"
 
@@ -45,7 +47,9 @@ using namespace DataSync;
 
 StorageHandler::StorageHandler() :
     iLargeObject( NULL ),
-    iLargeObjectSize(0)
+    iLargeObjectSize(0),
+    iLargeObjectSpool( NULL ),
+    iLargeObjectSpoolThreshold(0)
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -57,8 +61,7 @@ StorageHandler::~StorageHandler()
     qDeleteAll(iAddList);
     qDeleteAll(iReplaceList);
     
-    delete iLargeObject;
-    iLargeObject = NULL;
+    abortLargeObject();
 }
 
 bool StorageHandler::addItem( const ItemId& aItemId,
@@ -68,7 +71,7 @@ bool StorageHandler::addItem( const ItemId& aItemId,
                               const QString& aType,
                               const QString& aFormat,
                               const QString& aVersion,
-                              const QString& aData )
+                              const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -93,7 +96,7 @@ bool StorageHandler::addItem( const ItemId& aItemId,
     newItem->setFormat( aFormat );
     newItem->setVersion( aVersion );
 
-    if( !newItem->write( 0, aData.toUtf8() ) ) {
+    if( !newItem->write( 0, aData ) ) {
         delete newItem;
         qCCritical(lcSyncML) << "Could not write to item";
         return false;
@@ -112,7 +115,7 @@ bool StorageHandler::replaceItem( const ItemId& aItemId,
                                   const QString& aType,
                                   const QString& aFormat,
                                   const QString& aVersion,
-                                  const QString& aData )
+                                  const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -141,7 +144,7 @@ bool StorageHandler::replaceItem( const ItemId& aItemId,
     item->setFormat( aFormat );
     item->setVersion( aVersion );
 
-    if( !item->write( 0, aData.toUtf8() ) ) {
+    if( !item->write( 0, aData ) ) {
         delete item;
         qCCritical(lcSyncML) << "Could not write to item";
         return false;
@@ -171,6 +174,13 @@ bool StorageHandler::deleteItem( const ItemId& aItemId,
     return true;
 }
 
+void StorageHandler::setLargeObjectSpoolThreshold( qint64 aThreshold )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iLargeObjectSpoolThreshold = aThreshold;
+}
+
 bool StorageHandler::startLargeObjectAdd( StoragePlugin& aPlugin,
                                           const QString& aRemoteKey,
                                           const SyncItemKey& aParentKey,
@@ -200,9 +210,7 @@ bool StorageHandler::startLargeObjectAdd( StoragePlugin& aPlugin,
     newItem->setFormat( aFormat );
     newItem->setVersion( aVersion );
 
-    iLargeObject = newItem;
-    iLargeObjectSize = aSize;
-    iLargeObjectKey = aRemoteKey;
+    startLargeObject( newItem, aSize, aRemoteKey );
 
     qCDebug(lcSyncML) << "Large object created for addition";
 
@@ -242,9 +250,7 @@ bool StorageHandler::startLargeObjectReplace( StoragePlugin& aPlugin,
     item->setFormat( aFormat );
     item->setVersion( aVersion );
 
-    iLargeObject = item;
-    iLargeObjectSize = aSize;
-    iLargeObjectKey = aLocalKey;
+    startLargeObject( item, aSize, aLocalKey );
     if( !iLargeObject->resize(0) )
     {
         qCDebug(lcSyncML) << "Large object created for replace couldn't be resized";
@@ -275,16 +281,13 @@ bool StorageHandler::matchesLargeObject( const QString& aKey )
         return true;
     }
     else {
-        delete iLargeObject;
-        iLargeObject = NULL;
-        iLargeObjectSize = 0;
-        iLargeObjectKey.clear();
+        abortLargeObject();
         return false;
     }
 
 }
 
-bool StorageHandler::appendLargeObjectData( const QString& aData )
+bool StorageHandler::appendLargeObjectData( const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -293,20 +296,47 @@ bool StorageHandler::appendLargeObjectData( const QString& aData )
         return false;
     }
 
-    if( iLargeObject->write( iLargeObject->getSize(), aData.toUtf8() ) ) {
+    bool success = false;
+
+    if( iLargeObjectSpool ) {
+        success = iLargeObjectSpool->append( aData );
+    }
+    else {
+        success = iLargeObject->write( iLargeObject->getSize(), aData );
+    }
+
+    if( success ) {
         return true;
     }
     else {
-        delete iLargeObject;
-        iLargeObject = NULL;
-        iLargeObjectSize = 0;
-        iLargeObjectKey.clear();
+        abortLargeObject();
         qCCritical(lcSyncML) << "Could not write to large object";
         return false;
     }
 
 }
 
+bool StorageHandler::largeObjectSizeMatches() const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iLargeObject ) {
+        return false;
+    }
+
+    // Size is only checked for spooled data, as the spool knows how many
+    // bytes were received without asking the plugin
+    if( iLargeObjectSize <= 0 || !iLargeObjectSpool ) {
+        return true;
+    }
+
+    // XML parser normalizes CRLF line breaks to LF, so the received data
+    // can be shorter than the declared size by at most one byte per line
+    qint64 size = iLargeObjectSpool->size();
+
+    return size <= iLargeObjectSize && iLargeObjectSize <= size + iLargeObjectSpool->lineFeeds();
+}
+
 bool StorageHandler::finishLargeObject( const ItemId& aItemId )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -316,6 +346,18 @@ bool StorageHandler::finishLargeObject( const ItemId& aItemId )
         return false;
     }
 
+    if( !largeObjectSizeMatches() ) {
+        qCCritical(lcSyncML) << "Size of large object does not match declared size" << iLargeObjectSize;
+        abortLargeObject();
+        return false;
+    }
+
+    if( iLargeObjectSpool && !iLargeObjectSpool->writeTo( *iLargeObject ) ) {
+        qCCritical(lcSyncML) << "Could not write spooled data to large object";
+        abortLargeObject();
+        return false;
+    }
+
     if(iLargeObject->getKey()->isEmpty()) {
         qCDebug(lcSyncML) << "Queuing large object for addition";
 	iLargeObject->setKey(iLargeObjectKey);
@@ -330,6 +372,8 @@ bool StorageHandler::finishLargeObject( const ItemId& aItemId )
     iLargeObject = NULL;
     iLargeObjectSize = 0;
     iLargeObjectKey.clear();
+    delete iLargeObjectSpool;
+    iLargeObjectSpool = NULL;
 
     return true;
 
@@ -383,6 +427,11 @@ QMap<ItemId, CommitResult> StorageHandler::resolveConflicts( ConflictResolver* a
         results.insert( iId, result );
 
     }
+
+    if( aConflictResolver ) {
+        aConflictResolver->applyRevertedChanges();
+    }
+
     return results;
 }
 
@@ -434,6 +483,98 @@ QMap<ItemId, CommitResult> StorageHandler::resolveConflicts( ConflictResolver* a
         results.insert( iId, result );
 
     }
+
+    if( aConflictResolver ) {
+        aConflictResolver->applyRevertedChanges();
+    }
+
+    return results;
+}
+
+QMap<ItemId, CommitResult> StorageHandler::matchAddedItems( ItemMatcher& aMatcher, StoragePlugin& aPlugin,
+                                                            ConflictResolver* aConflictResolver )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMap<ItemId, CommitResult> results;
+
+    if( iAddList.isEmpty() ) {
+        return results;
+    }
+
+    if( !aMatcher.buildIndex() ) {
+        qCWarning(lcSyncML) << "Could not build index of local items, not matching added items";
+        return results;
+    }
+
+    // Matched items whose local version is replaced with the added data
+    QList<ItemId> replaceIds;
+    QList<SyncItem*> replaceItems;
+
+    QMutableMapIterator<ItemId, SyncItem*> i( iAddList );
+
+    while( i.hasNext() ) {
+
+        i.next();
+
+        bool identical = false;
+        SyncItemKey localKey = aMatcher.match( *i.value(), identical );
+
+        if( localKey.isEmpty() ) {
+            continue;
+        }
+
+        CommitResult result;
+        result.iItemKey = localKey;
+        result.iStatus = COMMIT_MATCHED;
+
+        if( identical || !aConflictResolver ) {
+            // Without conflict resolution the local item is kept as it is,
+            // and the remote device resolves the difference
+            result.iConflict = CONFLICT_NO_CONFLICT;
+            delete i.value();
+        }
+        else if( aConflictResolver->localSideWins() ) {
+            result.iConflict = CONFLICT_LOCAL_WIN;
+            delete i.value();
+        }
+        else {
+            result.iConflict = CONFLICT_REMOTE_WIN;
+            i.value()->setKey( localKey );
+            replaceIds.append( i.key() );
+            replaceItems.append( i.value() );
+        }
+
+        results.insert( i.key(), result );
+        i.remove();
+    }
+
+    qCDebug(lcSyncML) << "Matched" << results.count() << "added items to existing items";
+
+    if( !replaceItems.isEmpty() ) {
+
+        qCDebug(lcSyncML) << "Replacing" << replaceItems.count() << "matched items with added data";
+
+        QList<StoragePlugin::StoragePluginStatus> replaceStatus = aPlugin.replaceItems( replaceItems );
+
+        for( int j = 0; j < replaceStatus.count(); ++j ) {
+
+            CommitResult& result = results[replaceIds[j]];
+
+            if( replaceStatus[j] == StoragePlugin::STATUS_OK ) {
+                emit itemProcessed( MOD_ITEM_MODIFIED, MOD_LOCAL_DATABASE,
+                                    aPlugin.getSourceURI(), replaceItems[j]->getType(), replaceItems.count() );
+            }
+            else {
+                result.iStatus = generalStatus( replaceStatus[j] );
+                emit itemProcessed( MOD_ITEM_ERROR, MOD_LOCAL_DATABASE,
+                                    aPlugin.getSourceURI(), replaceItems[j]->getType(), replaceItems.count() );
+            }
+        }
+
+        qDeleteAll( replaceItems );
+    }
+
     return results;
 }
 
@@ -665,3 +806,29 @@ CommitStatus StorageHandler::generalStatus( StoragePlugin::StoragePluginStatus a
 
     return status;
 }
+
+void StorageHandler::startLargeObject( SyncItem* aItem, qint64 aSize, const QString& aKey )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iLargeObject = aItem;
+    iLargeObjectSize = aSize;
+    iLargeObjectKey = aKey;
+
+    if( iLargeObjectSpoolThreshold > 0 ) {
+        iLargeObjectSpool = new LargeObjectSpool( iLargeObjectSpoolThreshold );
+    }
+}
+
+void StorageHandler::abortLargeObject()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    delete iLargeObject;
+    iLargeObject = NULL;
+    iLargeObjectSize = 0;
+    iLargeObjectKey.clear();
+
+    delete iLargeObjectSpool;
+    iLargeObjectSpool = NULL;
+}
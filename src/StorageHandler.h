@@ -37,6 +37,7 @@
 #include <QObject>
 #include <QMap>
 #include <QString>
+#include <QByteArray>
 
 #include "SyncAgentConsts.h"
 #include "SyncItemKey.h"
@@ -46,6 +47,8 @@ namespace DataSync {
 
 class SyncItem;
 class ConflictResolver;
+class ItemMatcher;
+class LargeObjectSpool;
 
 
 /*! \brief Item commit status
@@ -64,7 +67,8 @@ enum CommitStatus
     COMMIT_GENERAL_ERROR,      /*!<Failed, unspecified error*/
     COMMIT_INIT_ADD,            /*!<Successful, Initial state before add*/
     COMMIT_INIT_REPLACE,       /*!<Successful, Initial state before modifications*/
-    COMMIT_INIT_DELETE         /*!<Successful, Initial state before deletions*/
+    COMMIT_INIT_DELETE,        /*!<Successful, Initial state before deletions*/
+    COMMIT_MATCHED             /*!<Successful, item matched an existing item so it was not added*/
 };
 
 /*! \brief Conflict status on item commit
@@ -149,7 +153,7 @@ public:
      * @param aType MIME type of the item
      * @param aFormat Format of the item
      * @param aVersion Version of the item
-     * @param aData Data of the item
+     * @param aData Data of the item in UTF-8
      *
      */
     bool addItem( const ItemId& aItemId,
@@ -159,7 +163,7 @@ public:
                   const QString& aType,
                   const QString& aFormat,
                   const QString& aVersion,
-                  const QString& aData);
+                  const QByteArray& aData);
 
     /*! \brief Replaces an existing item in local database
      *
@@ -170,7 +174,7 @@ public:
      * @param aType MIME type of the item
      * @param aFormat Format of the item
      * @param aVersion Version of the item
-     * @param aData Data of the item
+     * @param aData Data of the item in UTF-8
      */
     bool replaceItem( const ItemId& aItemId,
                       StoragePlugin& aPlugin,
@@ -179,7 +183,7 @@ public:
                       const QString& aType,
                       const QString& aFormat,
                       const QString& aVersion,
-                      const QString& aData);
+                      const QByteArray& aData);
 
     /*! \brief Deletes an existing item in local database
      *
@@ -189,6 +193,17 @@ public:
     bool deleteItem( const ItemId& aItemId,
                      const SyncItemKey& aLocalKey );
 
+    /*! \brief Sets the threshold for spooling large objects to disk
+     *
+     * Once the data of a large object being composed exceeds the threshold,
+     * it is kept in a temporary file instead of memory until the large
+     * object is finished.
+     *
+     * @param aThreshold Threshold in bytes. If 0, large objects are written
+     *                   directly to the item of the storage plugin
+     */
+    void setLargeObjectSpoolThreshold( qint64 aThreshold );
+
     /*! \brief Begin composing large object to add to local database
      *
      * @param aPlugin Local storage plugin
@@ -248,10 +263,24 @@ public:
      * @param aData Data to append
      * @return True if append was successful, otherwise false
      */
-    bool appendLargeObjectData( const QString& aData );
+    bool appendLargeObjectData( const QByteArray& aData );
+
+    /*! \brief Checks if the data received for the large object being composed
+     *         matches the size declared when it was started
+     *
+     * Size is checked only when data is spooled. Data may be shorter than
+     * the declared size by the number of line feeds in it, as CRLF line
+     * breaks are received as LF. If no size was declared, any amount of
+     * data is accepted
+     *
+     * @return True if size matches, otherwise false
+     */
+    bool largeObjectSizeMatches() const;
 
     /*! \brief Finishes the large object being composed
      *
+     * If data was spooled, it is written to the item of the storage plugin
+     * here. Fails if the size of spooled data does not match the declared size.
      * Automatically aborts large object if false is returned
      *
      * @param aItemId Item identification to assign to large object
@@ -276,6 +305,26 @@ public:
                                                  QMap<ItemId, SyncItemKey> &aList,
                                                  CommitStatus aStatus);
 
+    /*! \brief Matches added items to existing items in local database
+     *
+     * Matched items are removed from the items to add. If the content of the
+     * matched local item differs, the conflict is resolved with the policy of
+     * the conflict resolver. When local side wins, the result has conflict
+     * status CONFLICT_LOCAL_WIN and the local item is left as it is. When
+     * remote side wins, the local item is replaced with the added data and the
+     * result has conflict status CONFLICT_REMOTE_WIN. If conflicts are not
+     * resolved, the local item is left as it is and the result has conflict
+     * status CONFLICT_NO_CONFLICT, as for identical items.
+     *
+     * @param aMatcher Item matcher of the local database
+     * @param aPlugin Local storage plugin
+     * @param aConflictResolver If conflict resolution is to be done, conflict resolver.
+     *        Otherwise NULL
+     * @return Results of the matched items
+     */
+    QMap<ItemId, CommitResult> matchAddedItems( ItemMatcher& aMatcher, StoragePlugin& aPlugin,
+                                                ConflictResolver* aConflictResolver );
+
     /*! \brief Commits added items to local database
      *
      * @param aPlugin Local storage plugin
@@ -323,6 +372,10 @@ private:
 
     CommitStatus generalStatus( StoragePlugin::StoragePluginStatus aStatus ) const;
 
+    void startLargeObject( SyncItem* aItem, qint64 aSize, const QString& aKey );
+
+    void abortLargeObject();
+
     QMap<ItemId, SyncItem*>    iAddList;
     QMap<ItemId, SyncItem*>    iReplaceList;
     QMap<ItemId, SyncItemKey>  iDeleteList;
@@ -330,6 +383,8 @@ private:
     SyncItem*                  iLargeObject;
     qint64                     iLargeObjectSize;
     QString                    iLargeObjectKey;
+    LargeObjectSpool*          iLargeObjectSpool;
+    qint64                     iLargeObjectSpoolThreshold;
 
     friend class StorageHandlerTest;
 };
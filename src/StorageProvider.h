@@ -60,6 +60,11 @@ public:
     virtual ~StorageProvider() { }
 
     /*! \brief Sets session handler
+     *
+     * A provider shared by concurrent sessions must not rely on this. It is
+     * set to the session that calls the provider by the default
+     * implementations of the session aware functions below, but may refer
+     * to another session between those calls.
      *
      * \param aSessionHandler Pointer to session handler. Pointer should be valid
      *  as long as this object is alive.
@@ -100,6 +105,67 @@ public:
      */
     virtual void releaseStorage( StoragePlugin* aStorage ) = 0;
 
+    /*! \brief Provides content format information for a session
+     *
+     * Default implementation sets the session handler and calls
+     * getStorageContentFormatInfo().
+     *
+     * @param aURI Source URI of the storage
+     * @param aInfo Content information of the storage (if successful)
+     * @param aSessionHandler Session handler requesting the information
+     * @return True if the storage was found, otherwise false
+     */
+    virtual bool getSessionStorageContentFormatInfo( const QString& aURI,
+                                                     StorageContentFormatInfo& aInfo,
+                                                     const SessionHandler* aSessionHandler ) {
+        setSessionHandler( aSessionHandler );
+        return getStorageContentFormatInfo( aURI, aInfo );
+    }
+
+    /*! \brief Provides a storage based on URI for a session
+     *
+     * Default implementation sets the session handler and calls
+     * acquireStorageByURI().
+     *
+     * @param aURI Local URI of the storage to retrieve
+     * @param aSessionHandler Session handler acquiring the storage
+     * @return Storage plugin if success, otherwise NULL
+     */
+    virtual StoragePlugin* acquireSessionStorageByURI( const QString& aURI,
+                                                       const SessionHandler* aSessionHandler ) {
+        setSessionHandler( aSessionHandler );
+        return acquireStorageByURI( aURI );
+    }
+
+    /*! \brief Provides a storage based on MIME for a session
+     *
+     * Default implementation sets the session handler and calls
+     * acquireStorageByMIME().
+     *
+     * @param aMIME MIME of the storage to retrieve
+     * @param aSessionHandler Session handler acquiring the storage
+     * @return Storage plugin if success, otherwise NULL
+     */
+    virtual StoragePlugin* acquireSessionStorageByMIME( const QString& aMIME,
+                                                        const SessionHandler* aSessionHandler ) {
+        setSessionHandler( aSessionHandler );
+        return acquireStorageByMIME( aMIME );
+    }
+
+    /*! \brief Releases a storage acquired by a session
+     *
+     * Default implementation sets the session handler and calls
+     * releaseStorage().
+     *
+     * @param aStorage Storage to release
+     * @param aSessionHandler Session handler that acquired the storage
+     */
+    virtual void releaseSessionStorage( StoragePlugin* aStorage,
+                                        const SessionHandler* aSessionHandler ) {
+        setSessionHandler( aSessionHandler );
+        releaseStorage( aStorage );
+    }
+
 protected:
 
 
@@ -33,14 +33,16 @@
 
 #include "SuspendLog.h"
 
+#include <QtSql>
+
+#include "DatabaseHandler.h"
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
-SuspendLog::SuspendLog( QSqlDatabase& aDbHandle, const QString& aRemoteDevice,
-                        const QString& aSourceDbURI, const QString& aTargetDbURI )
- : iDbHandle( aDbHandle ), iRemoteDevice( aRemoteDevice ),
-   iSourceDbURI( aSourceDbURI ), iTargetDbURI( aTargetDbURI )
+SuspendLog::SuspendLog( const QString& aRemoteDevice, const QString& aSourceDbURI )
+ : iRemoteDevice( aRemoteDevice ), iSourceDbURI( aSourceDbURI ), iSuspended( false ),
+   iSyncMode( 0 ), iUnsavedMappings( 0 )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -50,274 +52,432 @@ SuspendLog::~SuspendLog()
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
 
-/*
-bool DataSync::ChangeLogHandler::createItemTrackingTable()
+bool SuspendLog::load( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString = "CREATE TABLE if not exists localchanges(id integer primary key autoincrement, remote_device varchar(512), local_database varchar(512), remote_database varchar(512), syncitemkey varchar(512), syncitemcmd integer)";
+    qCDebug(lcSyncML) << "Loading suspend log information:";
+    qCDebug(lcSyncML) << "Remote device:" << iRemoteDevice;
+    qCDebug(lcSyncML) << "Database URI:" << iSourceDbURI;
 
-    QSqlQuery query(queryString, iDbHandle);
-    query.exec();
+    if( !ensureSessionDatabase( aDbHandle ) || !ensureItemsDatabase( aDbHandle ) ||
+        !ensureMapsDatabase( aDbHandle ) )
+    {
+        return false;
+    }
 
-    bool success = true;
+    iSuspended = false;
+    iProcessedItems.clear();
+    iMappings.clear();
+    iUnsavedItems.clear();
+    iUnsavedMappings = 0;
 
-    if (query.lastError().isValid()) {
-        qCWarning(lcSyncML) << "Error found: " << query.lastError();
-        success = false;
+    if( !loadSession( aDbHandle ) )
+    {
+        return false;
     }
 
-    return success;
+    if( !iSuspended )
+    {
+        return true;
+    }
+
+    return ( loadItems( aDbHandle ) && loadMaps( aDbHandle ) );
 }
 
-bool DataSync::ChangeLogHandler::createMappingTrackingTable()
+bool SuspendLog::save( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString = "CREATE TABLE if not exists localmappings(id integer primary key autoincrement, remote_device varchar(512), local_database varchar(512), remote_database varchar(512), localkey varchar(512), remotekey varchar(512), msgref integer, cmdref  interger)";
+    if( !iSuspended )
+    {
+        return true;
+    }
+
+    if( !ensureSessionDatabase( aDbHandle ) || !ensureItemsDatabase( aDbHandle ) ||
+        !ensureMapsDatabase( aDbHandle ) )
+    {
+        return false;
+    }
+
+    // Nested in the transaction of the caller if there is one
+    bool transaction = DatabaseHandler::beginTransaction( aDbHandle );
+
+    bool success = ( saveSession( aDbHandle ) && saveItems( aDbHandle ) && saveMaps( aDbHandle ) );
 
-    QSqlQuery query(queryString, iDbHandle);
-    query.exec();
+    if( transaction ) {
+        if( !success ) {
+            DatabaseHandler::rollbackTransaction( aDbHandle );
+        }
+        else if( !DatabaseHandler::commitTransaction( aDbHandle ) ) {
+            success = false;
+        }
+    }
 
-    bool success = true;
+    if( success )
+    {
+        qCDebug(lcSyncML) << "Suspend log information saved:" << iUnsavedItems.count() << "items,"
+                          << iUnsavedMappings << "mapping changes";
 
-    if (query.lastError().isValid()) {
-        qCWarning(lcSyncML) << "Error found: " << query.lastError();
-        success = false;
+        iUnsavedItems.clear();
+        iUnsavedMappings = 0;
     }
 
     return success;
 }
-void DataSync::ChangeLog::addPendingSyncItem(QString aRemoteDevice,
-                                             QString aLocalDatabase,
-                                             QString aRemoteDatabase,
-                                             SyncItemKey aSyncItemKey,
-                                             SyncMLCommand aSyncCmd)
+
+bool SuspendLog::remove( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString = "INSERT INTO localchanges(remote_device, local_database, remote_database, syncitemkey, syncitemcmd) VALUES (:remote_device, :local_database, :remote_database, :syncitemkey, :syncitemcmd)";
-    QSqlQuery query(iDbHandle);
-    query.prepare( queryString );
-    query.bindValue(":remote_device", aRemoteDevice);
-    query.bindValue(":local_database", aLocalDatabase);
-    query.bindValue(":remote_database", aRemoteDatabase);
-    query.bindValue(":syncitemkey", aSyncItemKey);
-    query.bindValue(":syncitemcmd", aSyncCmd);
-    query.exec();
+    qCDebug(lcSyncML) << "Removing suspend log information:";
+    qCDebug(lcSyncML) << "Remote device:" << iRemoteDevice;
+    qCDebug(lcSyncML) << "Database URI:" << iSourceDbURI;
+
+    if( !ensureSessionDatabase( aDbHandle ) || !ensureItemsDatabase( aDbHandle ) ||
+        !ensureMapsDatabase( aDbHandle ) )
+    {
+        return false;
+    }
+
+    bool transaction = DatabaseHandler::beginTransaction( aDbHandle );
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << "Query Error" << query.lastError();
+    bool success = removeRows( aDbHandle, "suspend_logs" ) &&
+                   removeRows( aDbHandle, "suspend_items" ) &&
+                   removeRows( aDbHandle, "suspend_maps" );
+
+    if( transaction ) {
+        if( !success ) {
+            DatabaseHandler::rollbackTransaction( aDbHandle );
+        }
+        else if( !DatabaseHandler::commitTransaction( aDbHandle ) ) {
+            success = false;
+        }
     }
+
+    if( success )
+    {
+        iSuspended = false;
+        iProcessedItems.clear();
+        iMappings.clear();
+        iUnsavedItems.clear();
+        iUnsavedMappings = 0;
+    }
+
+    return success;
 }
 
-void DataSync::ChangeLog::removePendingSyncItem(QString aRemoteDevice,
-                                                QString aLocalDatabase,
-                                                QString aRemoteDatabase,
-                                                SyncItemKey aSyncItemKey)
+bool SuspendLog::isSuspended() const
 {
-    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    return iSuspended;
+}
 
-    const QString queryString = "DELETE FROM localchanges WHERE remote_device = :remote_device AND local_database = :local_database AND remote_database = :remote_database AND syncitemkey = :syncitemkey";
-    QSqlQuery query(iDbHandle);
-    query.prepare( queryString );
-    query.bindValue(":remote_device", aRemoteDevice);
-    query.bindValue(":local_database", aLocalDatabase);
-    query.bindValue(":remote_database", aRemoteDatabase);
-    query.bindValue(":syncitemkey", aSyncItemKey);
-    query.exec();
+void SuspendLog::setSession( const QString& aTargetDbURI, int aSyncMode,
+                             const QString& aLocalNextAnchor, const QString& aRemoteNextAnchor )
+{
+    iSuspended = true;
+    iTargetDbURI = aTargetDbURI;
+    iSyncMode = aSyncMode;
+    iLocalNextAnchor = aLocalNextAnchor;
+    iRemoteNextAnchor = aRemoteNextAnchor;
+}
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << "Query Error" << query.lastError();
-    }
+const QString& SuspendLog::getTargetDatabase() const
+{
+    return iTargetDbURI;
 }
 
-QList<SyncItemKey> DataSync::ChangeLog::getPendingLocalChanges(QString aRemoteDevice,
-                                                               QString aLocalDatabase,
-                                                               QString aRemoteDatabase,
-                                                               SyncMLCommand aSyncCmd)
+int SuspendLog::getSyncMode() const
 {
-    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    return iSyncMode;
+}
 
-    const QString queryString( "SELECT syncitemkey FROM localchanges WHERE remote_device = :remote_device AND local_database = :local_database AND remote_database = :remote_database AND syncitemcmd = :syncitemcmd" );
-    QSqlQuery query( iDbHandle );
-    query.bindValue(":remote_device", aRemoteDevice);
-    query.bindValue(":local_database", aLocalDatabase);
-    query.bindValue(":remote_database", aRemoteDatabase);
-    query.bindValue(":syncitemcmd", aSyncCmd);
-    query.prepare( queryString );
+const QString& SuspendLog::getLocalNextAnchor() const
+{
+    return iLocalNextAnchor;
+}
+
+const QString& SuspendLog::getRemoteNextAnchor() const
+{
+    return iRemoteNextAnchor;
+}
 
-    query.exec();
+void SuspendLog::addProcessedItem( const SyncItemKey& aKey, const QByteArray& aFingerprint )
+{
+    QHash<SyncItemKey, QByteArray>::iterator i = iProcessedItems.find( aKey );
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << query.lastError();
+    if( i == iProcessedItems.end() ) {
+        iProcessedItems.insert( aKey, aFingerprint );
+        iUnsavedItems.append( aKey );
     }
+    else if( i.value() != aFingerprint ) {
+        // Item was sent again with different content. Later rows override
+        // earlier ones when the log is loaded.
+        i.value() = aFingerprint;
 
-    SyncItemKey syncItemKey = "";
-    QList<SyncItemKey> changelist;
-
-    while(query.next()) {
-        syncItemKey = query.value(0).toString();
-        changelist.append(syncItemKey);
+        if( !iUnsavedItems.contains( aKey ) ) {
+            iUnsavedItems.append( aKey );
+        }
     }
+}
 
-    return changelist;
+const QHash<SyncItemKey, QByteArray>& SuspendLog::getProcessedItems() const
+{
+    return iProcessedItems;
 }
 
-int DataSync::ChangeLog::getLastSyncMode()
+void SuspendLog::addMapping( const UIDMapping& aMapping )
+{
+    iMappings.append( aMapping );
+    ++iUnsavedMappings;
+}
+
+const QList<UIDMapping>& SuspendLog::getMappings() const
+{
+    return iMappings;
+}
+
+bool SuspendLog::ensureSessionDatabase( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString( "SELECT sync_mode FROM change_logs WHERE id=:id" );
-    QSqlQuery query( iDbHandle );
+    const QString queryString( "CREATE TABLE IF NOT EXISTS suspend_logs(id integer primary key autoincrement, remote_device varchar(512), source_db_uri varchar(512), target_db_uri varchar(512), sync_mode INTEGER, local_next_anchor varchar(128), remote_next_anchor varchar(128))" );
+
+    if( DatabaseHandler::ensureSchema( aDbHandle, queryString ) ) {
+        return true;
+    }
+    else {
+        qCCritical(lcSyncML) << "Could not ensure suspend log database table";
+        return false;
+    }
+}
 
-    query.prepare( queryString );
-    query.bindValue(":id", iChangeLogId);
-    query.exec();
+bool SuspendLog::ensureItemsDatabase( QSqlDatabase& aDbHandle )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    int syncMode;
+    const QString queryString( "CREATE TABLE IF NOT EXISTS suspend_items(id integer primary key autoincrement, remote_device varchar(512), source_db_uri varchar(512), item_key varchar(128), fingerprint BLOB)" );
 
-    if( query.lastError().isValid()) {
-        qCDebug(lcSyncML) << "Query Error" << query.lastError();
-        syncMode = 0;
+    if( DatabaseHandler::ensureSchema( aDbHandle, queryString ) ) {
+        return true;
     }
-    else if (query.next()) {
-        syncMode = query.value(0).toInt();
+    else {
+        qCCritical(lcSyncML) << "Could not ensure suspended items database table";
+        return false;
+    }
+}
+
+bool SuspendLog::ensureMapsDatabase( QSqlDatabase& aDbHandle )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const QString queryString( "CREATE TABLE IF NOT EXISTS suspend_maps(id integer primary key autoincrement, remote_device varchar(512), source_db_uri varchar(512), local_id varchar(128), remote_id varchar(128))" );
+
+    if( DatabaseHandler::ensureSchema( aDbHandle, queryString ) ) {
+        return true;
     }
     else {
-        qCDebug(lcSyncML) << "Could not find sync mode";
-        syncMode = 0;
+        qCCritical(lcSyncML) << "Could not ensure suspended ID maps database table";
+        return false;
     }
+}
 
-    return syncMode;
+bool SuspendLog::loadSession( QSqlDatabase& aDbHandle )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const QString queryString( "SELECT target_db_uri, sync_mode, local_next_anchor, remote_next_anchor FROM suspend_logs WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+
+    if( !query.exec() ) {
+        qCWarning(lcSyncML) << "Could not load suspend log:" << query.lastError();
+        return false;
+    }
+
+    if( query.next() ) {
+        iSuspended = true;
+        iTargetDbURI = query.value(0).toString();
+        iSyncMode = query.value(1).toInt();
+        iLocalNextAnchor = query.value(2).toString();
+        iRemoteNextAnchor = query.value(3).toString();
+
+        qCDebug(lcSyncML) << "Found suspended session:";
+        qCDebug(lcSyncML) << "Target database:" << iTargetDbURI;
+        qCDebug(lcSyncML) << "Sync mode:" << iSyncMode;
+    }
+
+    query.finish();
+
+    return true;
 }
 
-void DataSync::ChangeLog::addPendingMapping(QString aRemoteDevice,
-                                            QString aLocalDatabase,
-                                            QString aRemoteDatabase,
-                                            SyncItemKey aLocalKey,
-                                            SyncItemKey aRemoteKey,
-                                            int aMsgRef,
-                                            int aCmdRef)
+bool SuspendLog::saveSession( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString = "INSERT INTO localmappings(remote_device, local_database, remote_database, localkey, remotekey, msgref, cmdref) VALUES (:remote_device, :local_database, :remote_database, :localkey, :remotekey, :msgref, :cmdref)";
-    QSqlQuery query(iDbHandle);
-    query.prepare( queryString );
-    query.bindValue(":remote_device", aRemoteDevice);
-    query.bindValue(":local_database", aLocalDatabase);
-    query.bindValue(":remote_database", aRemoteDatabase);
-    query.bindValue(":localkey", aLocalKey);
-    query.bindValue(":remotekey", aRemoteKey);
-    query.bindValue(":msgref", aMsgRef);
-    query.bindValue(":cmdref", aCmdRef);
-    query.exec();
-
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << "Query Error" << query.lastError();
+    if( !removeRows( aDbHandle, "suspend_logs" ) ) {
+        return false;
+    }
+
+    const QString queryString( "INSERT INTO suspend_logs(remote_device, source_db_uri, target_db_uri, sync_mode, local_next_anchor, remote_next_anchor) VALUES (:remote_device, :source_db_uri, :target_db_uri, :sync_mode, :local_next_anchor, :remote_next_anchor)" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+    query.bindValue( ":target_db_uri", iTargetDbURI );
+    query.bindValue( ":sync_mode", iSyncMode );
+    query.bindValue( ":local_next_anchor", iLocalNextAnchor );
+    query.bindValue( ":remote_next_anchor", iRemoteNextAnchor );
+
+    if( !query.exec() ) {
+        qCCritical(lcSyncML) << "Could not save suspend log:" << query.lastError();
+        return false;
     }
+
+    return true;
 }
 
-void DataSync::ChangeLog::removePendingMappings(QString aRemoteDevice,
-                                                QString aLocalDatabase,
-                                                QString aRemoteDatabase,
-                                                int aMsgRef,
-                                                int aCmdRef)
+bool SuspendLog::loadItems( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString = "DELETE FROM localmappings WHERE remote_device = :remote_device AND local_database = :local_database AND remote_database = :remote_database AND msgref = :msgref AND cmdref = :cmdref";
+    const QString queryString( "SELECT item_key, fingerprint FROM suspend_items WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri ORDER BY id" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
 
-    QSqlQuery query(iDbHandle);
-    query.prepare( queryString );
-    query.bindValue(":remote_device", aRemoteDevice);
-    query.bindValue(":local_database", aLocalDatabase);
-    query.bindValue(":remote_database", aRemoteDatabase);
-    query.bindValue(":msgref", aMsgRef);
-    query.bindValue(":cmdref", aCmdRef);
-    query.exec();
+    if( !query.exec() ) {
+        qCCritical(lcSyncML) << "Could not load suspended items:" << query.lastError();
+        return false;
+    }
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << "Query Error" << query.lastError();
+    while( query.next() ) {
+        iProcessedItems.insert( query.value(0).toString(), query.value(1).toByteArray() );
     }
+
+    qCDebug(lcSyncML) << "Found" << iProcessedItems.count() << "processed items";
+
+    return true;
 }
 
-QList<UIDMapping> DataSync::ChangeLog::getPendingLocalMappings(QString aRemoteDevice,
-                                                               QString aLocalDatabase,
-                                                               QString aRemoteDatabase)
+bool SuspendLog::saveItems( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString( "SELECT localkey, remotekey FROM localmappings WHERE remote_device = :remote_device AND local_database = :local_database AND remote_database = :remote_database" );
-    QSqlQuery query( iDbHandle );
-    query.bindValue(":remote_device", aRemoteDevice);
-    query.bindValue(":local_database", aLocalDatabase);
-    query.bindValue(":remote_database", aRemoteDatabase);
-    query.prepare( queryString );
+    if( iUnsavedItems.isEmpty() ) {
+        return true;
+    }
+
+    const QString queryString( "INSERT INTO suspend_items(remote_device, source_db_uri, item_key, fingerprint) VALUES (:remote_device, :source_db_uri, :item_key, :fingerprint)" );
 
-    query.exec();
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << query.lastError();
+    QVariantList device;
+    QVariantList sourceDbURI;
+    QVariantList itemKey;
+    QVariantList fingerprint;
+
+    for( int i = 0; i < iUnsavedItems.count(); ++i ) {
+        device << iRemoteDevice;
+        sourceDbURI << iSourceDbURI;
+        itemKey << iUnsavedItems[i];
+        fingerprint << iProcessedItems.value( iUnsavedItems[i] );
     }
 
-    SyncItemKey localKey;
-    SyncItemKey remoteKey;
-    QList<UIDMapping> mappingList;
+    query.bindValue( ":remote_device", device );
+    query.bindValue( ":source_db_uri", sourceDbURI );
+    query.bindValue( ":item_key", itemKey );
+    query.bindValue( ":fingerprint", fingerprint );
 
-    while(query.next()) {
-        localKey = query.value(0).toString();
-        remoteKey = query.value(1).toString();
-        UIDMapping mapping = {remoteKey, localKey};
-        mappingList.append( mapping );
+    if( !query.execBatch() ) {
+        qCWarning(lcSyncML) << "Could not save suspended items:" << query.lastError();
+        return false;
     }
 
-    return mappingList;
+    return true;
 }
 
-bool DataSync::ChangeLog::getIntentionallySuspended() const
+bool SuspendLog::loadMaps( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool intentionalSuspension = false;
-
-    const QString queryString( "SELECT intentional_suspension FROM change_logs WHERE id=:id" );
-    QSqlQuery query( iDbHandle );
+    const QString queryString( "SELECT local_id, remote_id FROM suspend_maps WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri ORDER BY id" );
 
-    query.prepare( queryString );
-    query.bindValue(":id", iChangeLogId);
-    query.exec();
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << "Query Error" << query.lastError();
+    if( !query.exec() ) {
+        qCCritical(lcSyncML) << "Could not load suspended ID maps:" << query.lastError();
+        return false;
     }
-    else {
-        if (query.next()) {
-            intentionalSuspension = query.value(0).toInt();
-        }
+
+    while( query.next() ) {
+        UIDMapping mapping;
+        mapping.iLocalUID = query.value(0).toString();
+        mapping.iRemoteUID = query.value(1).toString();
+        iMappings.append( mapping );
     }
 
-    return intentionalSuspension;
+    return true;
 }
 
-void ChangeLog::setIntentionallySuspended( bool aIntentionallySuspended)
+bool SuspendLog::saveMaps( QSqlDatabase& aDbHandle )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    const QString queryString( "UPDATE change_logs SET intentional_suspension=:intentional_suspension WHERE id =:id" );
+    if( iUnsavedMappings == 0 ) {
+        return true;
+    }
+
+    const QString queryString( "INSERT INTO suspend_maps(remote_device, source_db_uri, local_id, remote_id) VALUES (:remote_device, :source_db_uri, :local_id, :remote_id)" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
 
-    QSqlQuery query(iDbHandle);
+    QVariantList device;
+    QVariantList sourceDbURI;
+    QVariantList localId;
+    QVariantList remoteId;
 
-    query.prepare( queryString );
-    query.bindValue(":id", iChangeLogId);
-    query.bindValue(":intentional_suspension", aIntentionallySuspended);
-    query.exec();
+    for( int i = iMappings.count() - iUnsavedMappings; i < iMappings.count(); ++i ) {
+        device << iRemoteDevice;
+        sourceDbURI << iSourceDbURI;
+        localId << iMappings[i].iLocalUID;
+        remoteId << iMappings[i].iRemoteUID;
+    }
 
+    query.bindValue( ":remote_device", device );
+    query.bindValue( ":source_db_uri", sourceDbURI );
+    query.bindValue( ":local_id", localId );
+    query.bindValue( ":remote_id", remoteId );
 
-    if (query.lastError().isValid()) {
-        qCDebug(lcSyncML) << query.lastError();
+    if( !query.execBatch() ) {
+        qCWarning(lcSyncML) << "Could not save suspended ID maps:" << query.lastError();
+        return false;
     }
 
+    return true;
+}
+
+bool SuspendLog::removeRows( QSqlDatabase& aDbHandle, const QString& aTable )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Tables have been ensured by the caller
+    const QString queryString( "DELETE FROM " + aTable + " WHERE remote_device = :remote_device AND source_db_uri = :source_db_uri" );
+
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, queryString );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":source_db_uri", iSourceDbURI );
+
+    if( !query.exec() ) {
+        qCWarning(lcSyncML) << "Could not remove suspend log information from" << aTable << ":" << query.lastError();
+        return false;
+    }
+
+    return true;
 }
-*/
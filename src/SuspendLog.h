@@ -35,41 +35,164 @@
 #define SUSPENDLOG_H
 
 #include <QString>
+#include <QList>
+#include <QHash>
+
+#include "SyncMLGlobals.h"
 
 class QSqlDatabase;
 
-// @todo: properly implement this class in HSYML-380 task
 namespace DataSync {
 
-/*! \brief Stores the suspend-related information of different devices
+/*! \brief Stores the progress of an interrupted sync session with a remote
+ *         device, so that the session can be resumed later
  *
+ * The log records the parameters of the session (remote database, sync mode
+ * and anchors), the local items that the remote device has acknowledged with
+ * the fingerprints of their sent content, and the changes made to ID mappings
+ * during the session. Items and mapping
+ * changes are kept in memory until save() is called, and only the ones not
+ * yet saved are written to the database.
  */
-class SuspendLog {
+class SuspendLog
+{
 
 public:
 
     /*! \brief Constructor
      *
-     * @param aDbHandle Database handle to use
      * @param aRemoteDevice Remote device
      * @param aSourceDbURI URI of the local database
-     * @param aTargetDbURI URI of the remote database
      */
-    SuspendLog( QSqlDatabase& aDbHandle, const QString& aRemoteDevice,
-                const QString& aSourceDbURI, const QString& aTargetDbURI );
+    SuspendLog( const QString& aRemoteDevice, const QString& aSourceDbURI );
 
     /*! \brief Destructor
      *
      */
     ~SuspendLog();
 
+    /*! \brief Loads suspend log information from database
+     *
+     * @param aDbHandle Database handle to use
+     * @return True on success, otherwise false
+     */
+    bool load( QSqlDatabase& aDbHandle );
+
+    /*! \brief Saves suspend log information to database
+     *
+     * @param aDbHandle Database handle to use
+     * @return True on success, otherwise false
+     */
+    bool save( QSqlDatabase& aDbHandle );
+
+    /*! \brief Removes suspend log information from database
+     *
+     * @param aDbHandle Database handle to use
+     * @return True on success, otherwise false
+     */
+    bool remove( QSqlDatabase& aDbHandle );
+
+    /*! \brief Returns whether the log holds a suspended session
+     *
+     * @return True if a session has been loaded or set, otherwise false
+     */
+    bool isSuspended() const;
+
+    /*! \brief Sets the parameters of the session
+     *
+     * @param aTargetDbURI URI of the remote database
+     * @param aSyncMode SyncML code of the sync mode in use
+     * @param aLocalNextAnchor Next local anchor of the session
+     * @param aRemoteNextAnchor Next remote anchor of the session
+     */
+    void setSession( const QString& aTargetDbURI, int aSyncMode,
+                     const QString& aLocalNextAnchor, const QString& aRemoteNextAnchor );
+
+    /*! \brief Returns the URI of the remote database of the session
+     *
+     * @return
+     */
+    const QString& getTargetDatabase() const;
+
+    /*! \brief Returns the SyncML code of the sync mode of the session
+     *
+     * @return
+     */
+    int getSyncMode() const;
+
+    /*! \brief Returns the next local anchor of the session
+     *
+     * @return
+     */
+    const QString& getLocalNextAnchor() const;
+
+    /*! \brief Returns the next remote anchor of the session
+     *
+     * @return
+     */
+    const QString& getRemoteNextAnchor() const;
+
+    /*! \brief Records a local item as processed by the remote device
+     *
+     * @param aKey Key of the item
+     * @param aFingerprint Fingerprint of the sent item, or empty if the item was deleted
+     */
+    void addProcessedItem( const SyncItemKey& aKey, const QByteArray& aFingerprint );
+
+    /*! \brief Returns the local items processed by the remote device
+     *
+     * @return Fingerprints of the sent items by item key
+     */
+    const QHash<SyncItemKey, QByteArray>& getProcessedItems() const;
+
+    /*! \brief Records a change to ID mappings
+     *
+     * A mapping with an empty remote UID records the removal of the mapping
+     * of the local UID.
+     *
+     * @param aMapping Added mapping
+     */
+    void addMapping( const UIDMapping& aMapping );
+
+    /*! \brief Returns the changes made to ID mappings, in the order they were made
+     *
+     * @return
+     */
+    const QList<UIDMapping>& getMappings() const;
+
 private:
 
-    QSqlDatabase&   iDbHandle;
+    bool ensureSessionDatabase( QSqlDatabase& aDbHandle );
+    bool ensureItemsDatabase( QSqlDatabase& aDbHandle );
+    bool ensureMapsDatabase( QSqlDatabase& aDbHandle );
+
+    bool loadSession( QSqlDatabase& aDbHandle );
+    bool saveSession( QSqlDatabase& aDbHandle );
+
+    bool loadItems( QSqlDatabase& aDbHandle );
+    bool saveItems( QSqlDatabase& aDbHandle );
+
+    bool loadMaps( QSqlDatabase& aDbHandle );
+    bool saveMaps( QSqlDatabase& aDbHandle );
+
+    bool removeRows( QSqlDatabase& aDbHandle, const QString& aTable );
+
+    QString             iRemoteDevice;
+    QString             iSourceDbURI;
+
+    bool                iSuspended;
+    QString             iTargetDbURI;
+    int                 iSyncMode;
+    QString             iLocalNextAnchor;
+    QString             iRemoteNextAnchor;
+
+    QHash<SyncItemKey, QByteArray> iProcessedItems;
+    QList<UIDMapping>   iMappings;
 
-    QString         iRemoteDevice;
-    QString         iSourceDbURI;
-    QString         iTargetDbURI;
+    // Processed items that have not yet been written to the database, and
+    // the number of mapping changes at the end of iMappings that have not
+    QList<SyncItemKey>  iUnsavedItems;
+    int                 iUnsavedMappings;
 
 };
 
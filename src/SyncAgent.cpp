@@ -36,24 +36,27 @@
 #include <QMetaType>
 
 #include "ChangeLog.h"
+#include "DatabaseHandler.h"
 #include "SyncAgentConfig.h"
 #include "SyncResults.h"
 #include "ClientSessionHandler.h"
 #include "ServerSessionHandler.h"
 #include "RequestListener.h"
+#include "SessionDispatcher.h"
 
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
 SyncAgent::SyncAgent(QObject* aParent)
-: QObject(aParent), iListener(0), iHandler(0), iConfig(0)
+: QObject(aParent), iListener(0), iDispatcher(0), iHandler(0), iConfig(0)
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     // Register the struct as a type for the signals
     qRegisterMetaType<DataSync::SyncState>("DataSync::SyncState");
     qRegisterMetaType<DataSync::ModificationType>("DataSync::ModificationType");
     qRegisterMetaType<DataSync::ModifiedDatabase>("DataSync::ModifiedDatabase");
+    qRegisterMetaType<DataSync::SyncResults>("DataSync::SyncResults");
 }
 
 
@@ -63,6 +66,8 @@ SyncAgent::~SyncAgent()
 
     abortListen();
 
+    cleanDispatcher();
+
     cleanSession();
 
 }
@@ -87,7 +92,7 @@ bool SyncAgent::startSync( const SyncAgentConfig& aConfig )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    if( !iHandler && !iListener) {
+    if( !iHandler && !iListener && !iDispatcher ) {
         return initiateSession( aConfig );
     }
     else {
@@ -99,7 +104,7 @@ bool SyncAgent::startSync( const SyncAgentConfig& aConfig )
 
 bool SyncAgent::isSyncing() const
 {
-    if( iHandler ) {
+    if( iHandler || ( iDispatcher && iDispatcher->sessionCount() > 0 ) ) {
         return true;
     }
     else {
@@ -111,8 +116,13 @@ bool SyncAgent::listen( const SyncAgentConfig& aConfig )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    if( !iHandler && !iListener ) {
-        return initiateListen( aConfig );
+    if( !iHandler && !iListener && !iDispatcher ) {
+        if( aConfig.getTransportProvider() ) {
+            return initiateDispatch( aConfig );
+        }
+        else {
+            return initiateListen( aConfig );
+        }
     }
     else {
         qCCritical(lcSyncML) << "SyncAgent: Already listening for requests, or synchronization in progress";
@@ -122,7 +132,7 @@ bool SyncAgent::listen( const SyncAgentConfig& aConfig )
 
 bool SyncAgent::isListening() const
 {
-    if( iListener ) {
+    if( iListener || iDispatcher ) {
         return true;
     }
     else {
@@ -153,6 +163,10 @@ bool SyncAgent::resumeSync()
         QTimer::singleShot( 0, iHandler, SLOT(resumeSync()) );
         return true;
     }
+    else if( !iListener && !iDispatcher && iConfig && iResults.getState() == SUSPENDED ) {
+        // Suspended session has already ended, continue it in a new session
+        return initiateSession( *iConfig );
+    }
     else {
         qCCritical(lcSyncML) << "SyncAgent: Nothing to resume!";
         return false;
@@ -172,6 +186,14 @@ bool SyncAgent::abort(DataSync::SyncState aState)
         abortListen();
         return true;
     }
+    else if( iDispatcher ) {
+        iDispatcher->abort( aState );
+
+        if( iDispatcher->sessionCount() == 0 ) {
+            cleanDispatcher();
+        }
+        return true;
+    }
     else {
         qCCritical(lcSyncML) << "SyncAgent: Nothing to abort!";
         return false;
@@ -205,11 +227,19 @@ bool  SyncAgent::cleanUp(const SyncAgentConfig* aConfig)
     qCDebug(lcSyncML) << "SyncAgent: Sync Direction: " << iDirection;
 
 
+    // One connection for all the source databases
+    DatabaseHandler handler( dbPath );
+
+    if( !handler.isValid() ) {
+        qCWarning(lcSyncML) << "SyncAgent: Could not open database" << dbPath;
+        return false;
+    }
+
     bool success = true;
     for (int i = 0; i < sourceDBs.size(); ++i) {
 	   qCDebug(lcSyncML) << "SyncAgent: Removing anchors for source DB: " << sourceDBs.at(i);
 	   ChangeLog changeLog(remoteId, sourceDBs.at(i), iDirection);
-    	   success = changeLog.remove (dbPath);
+    	   success = changeLog.remove( handler.getDbHandle() );
 	   if (!success){
            qCWarning(lcSyncML) << "SyncAgent: Error Removing anchors for source DB: " << sourceDBs.at(i);
 	   }
@@ -237,6 +267,10 @@ void SyncAgent::receiveSyncFinished( const QString& aDevId,
 
     iResults.setRemoteDeviceId( aDevId );
 
+    if( iHandler ) {
+        iResults.setStatistics( iHandler->getStatistics() );
+    }
+
     cleanSession();
 
     finishSync( aState, aErrorString );
@@ -630,3 +664,71 @@ void SyncAgent::cleanListenLater()
     iListener->deleteLater();
     iListener = NULL;
 }
+
+bool SyncAgent::initiateDispatch( const SyncAgentConfig& aConfig )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_ASSERT( !iDispatcher );
+
+    qCDebug(lcSyncML) << "SyncAgent: Preparing for serving concurrent sessions...";
+
+    // * Validate critical configuration
+
+    if( !aConfig.getStorageProvider() ) {
+        qCCritical(lcSyncML) << "SyncAgent: Invalid configuration, storage provider is NULL";
+        return false;
+    }
+
+    // * Create & start session dispatcher object
+
+    SessionDispatcher* dispatcher = new SessionDispatcher( this );
+
+    connect( dispatcher, SIGNAL(sessionFinished(DataSync::SyncResults)),
+             this, SIGNAL(sessionFinished(DataSync::SyncResults)) );
+    connect( dispatcher, SIGNAL(finished(DataSync::SyncState,QString)),
+             this, SLOT(dispatcherFinished(DataSync::SyncState,QString)) );
+    connect( dispatcher, SIGNAL(error(DataSync::SyncState,QString)),
+             this, SLOT(dispatcherFinished(DataSync::SyncState,QString)) );
+    connect( dispatcher, SIGNAL(storageAccquired(QString)),
+             this, SLOT(accquiredStorage(QString)) );
+    connect( dispatcher, SIGNAL( itemProcessed( DataSync::ModificationType,
+             DataSync::ModifiedDatabase,QString,QString,int ) ),
+             this, SIGNAL( itemProcessed( DataSync::ModificationType,
+             DataSync::ModifiedDatabase,QString,QString,int ) ) );
+
+    if( dispatcher->start( aConfig ) )
+    {
+        qCDebug(lcSyncML) << "SyncAgent: Now listening for requests";
+        iDispatcher = dispatcher;
+        iConfig = &aConfig;
+        return true;
+    }
+    else
+    {
+        qCCritical(lcSyncML) << "SyncAgent: Could not start listening for requests";
+        delete dispatcher;
+        dispatcher = 0;
+        return false;
+    }
+}
+
+void SyncAgent::dispatcherFinished( DataSync::SyncState aState, QString aErrorString )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_ASSERT( iDispatcher );
+
+    iDispatcher->deleteLater();
+    iDispatcher = NULL;
+
+    finishSync( aState, aErrorString );
+}
+
+void SyncAgent::cleanDispatcher()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    delete iDispatcher;
+    iDispatcher = NULL;
+}
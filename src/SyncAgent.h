@@ -97,7 +97,8 @@
  *   for each type of data they wish to synchronize. Libbuteosyncml does not provide readymade
  *   StoragePlugin implementations, as these are highly dependant on the underlying storage
  *   backend.
- * - Transport. Libbuteosyncml includes readymade transport for HTTP. For OBEX, SyncML bindings
+ * - Transport. Libbuteosyncml includes readymade transports for HTTP, as client with
+ *   HTTPTransport and as server with HTTPServerTransport. For OBEX, SyncML bindings
  *   are provided. Users must provide an implementation for OBEXConnection interface to
  *   to use whatever transport layer is wanted ( for example Bluetooth, USB, IrDA, etc ). Creation
  *   of totally custom transports is also supported, they can be implemented by inheriting from
@@ -544,6 +545,7 @@ namespace DataSync {
 class SyncAgentConfig;
 class RequestListener;
 class SessionHandler;
+class SessionDispatcher;
 
 /*! \brief SyncAgent is the base API for using the synchronization library
  * An entity which provides the interface for synchronization to the application.
@@ -621,6 +623,13 @@ public:
      * finishes due to success or failure, syncFinished() signal is emitted. Listening
      * can be aborted by calling abort() function.
      *
+     * If configuration has a transport provider, several sessions are served
+     * concurrently, each of them with a transport acquired from the provider,
+     * and listening continues until abort() is called. Results of each session
+     * are reported with sessionFinished() signal, and syncFinished() is emitted
+     * only when listening is aborted while sessions are in progress, or when
+     * listening fails.
+     *
      * @param aConfig Configuration to use when initiating synchronization. Ownership is
      *                not transferred.
      * @return True if listening was successfully started and subsequent signals
@@ -657,7 +666,9 @@ public:
     *
     * This method resumes a suspended sync. The command will be
     * processed and the application will get a callback when the command
-    * has been executed successful or with an error.
+    * has been executed successful or with an error. If the suspended
+    * session has already finished, a new session that continues it is
+    * started. Requires resumable-sessions agent property.
     *
     * @return
     */
@@ -709,6 +720,15 @@ signals:    //  public signals
      */
     void storageAccquired (QString aMimeType);
 
+    /*! \brief Signal indicating that a session served concurrently with other
+     *         sessions has finished
+     *
+     * Emitted only when listening with a transport provider
+     *
+     * @param aResults Results of the session
+     */
+    void sessionFinished( const DataSync::SyncResults& aResults );
+
 private slots:
 
     void receiveStateChanged( DataSync::SyncState aState );
@@ -729,6 +749,8 @@ private slots:
 
     void listenError( DataSync::SyncState aState, QString aErrorString );
 
+    void dispatcherFinished( DataSync::SyncState aState, QString aErrorString );
+
 private:
 
     void finishSync( DataSync::SyncState aState, const QString& aErrorString );
@@ -747,7 +769,12 @@ private:
     void cleanListen();
     void cleanListenLater();
 
+    bool initiateDispatch( const SyncAgentConfig& aConfig );
+
+    void cleanDispatcher();
+
     RequestListener*        iListener;
+    SessionDispatcher*      iDispatcher;
     SessionHandler*         iHandler;
     const SyncAgentConfig*  iConfig;
     SyncResults             iResults;
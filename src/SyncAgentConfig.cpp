@@ -51,6 +51,7 @@ using namespace DataSync;
 
 SyncAgentConfig::SyncAgentConfig()
  : iTransport( NULL ),
+   iTransportProvider( NULL ),
    iStorageProvider( NULL ),
    iDatabaseFilePath( "/etc/buteo/syncml.db" ),
    iProtocolVersion( SYNCML_1_2 ),
@@ -138,6 +139,16 @@ Transport* SyncAgentConfig::getTransport() const
     return iTransport;
 }
 
+void SyncAgentConfig::setTransportProvider( TransportProvider* aProvider )
+{
+    iTransportProvider = aProvider;
+}
+
+TransportProvider* SyncAgentConfig::getTransportProvider() const
+{
+    return iTransportProvider;
+}
+
 void SyncAgentConfig::setStorageProvider( StorageProvider* aProvider )
 {
     iStorageProvider = aProvider;
@@ -168,6 +179,16 @@ const QString& SyncAgentConfig::getDatabaseFilePath() const
     return iDatabaseFilePath;
 }
 
+void SyncAgentConfig::setDatabasePoolKey( const QString& aPoolKey )
+{
+    iDatabasePoolKey = aPoolKey;
+}
+
+const QString& SyncAgentConfig::getDatabasePoolKey() const
+{
+    return iDatabasePoolKey;
+}
+
 void SyncAgentConfig::setLocalDeviceName ( const QString& aDeviceName )
 {
     iLocalDeviceName = aDeviceName;
@@ -489,6 +510,69 @@ bool SyncAgentConfig::parseAgentProps( QXmlStreamReader& aReader )
                 qCDebug(lcSyncML) << "Found agent property" << OMITDATAUPDATESTATUSPROP <<":" << omitDataUpdateStatus;
                 setAgentProperty( OMITDATAUPDATESTATUSPROP, omitDataUpdateStatus );
             }
+            else if( aReader.name() == LARGEOBJECTSPOOLTHRESHOLDPROP )
+            {
+                aReader.readNext();
+                QString largeObjectSpoolThreshold = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << LARGEOBJECTSPOOLTHRESHOLDPROP <<":" << largeObjectSpoolThreshold;
+                setAgentProperty( LARGEOBJECTSPOOLTHRESHOLDPROP, largeObjectSpoolThreshold );
+            }
+            else if( aReader.name() == ASYNCPREFETCHPROP )
+            {
+                aReader.readNext();
+                QString asyncPrefetch = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << ASYNCPREFETCHPROP <<":" << asyncPrefetch;
+                setAgentProperty( ASYNCPREFETCHPROP, asyncPrefetch );
+            }
+            else if( aReader.name() == PARALLELCOMMITPROP )
+            {
+                aReader.readNext();
+                QString parallelCommit = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << PARALLELCOMMITPROP <<":" << parallelCommit;
+                setAgentProperty( PARALLELCOMMITPROP, parallelCommit );
+            }
+            else if( aReader.name() == MAXCONCURRENTSESSIONSPROP )
+            {
+                aReader.readNext();
+                QString maxSessions = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << MAXCONCURRENTSESSIONSPROP <<":" << maxSessions;
+                setAgentProperty( MAXCONCURRENTSESSIONSPROP, maxSessions );
+            }
+            else if( aReader.name() == RESUMABLESESSIONSPROP )
+            {
+                aReader.readNext();
+                QString resumableSessions = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << RESUMABLESESSIONSPROP <<":" << resumableSessions;
+                setAgentProperty( RESUMABLESESSIONSPROP, resumableSessions );
+            }
+            else if( aReader.name() == FINGERPRINTCHANGESPROP )
+            {
+                aReader.readNext();
+                QString fingerprintChanges = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << FINGERPRINTCHANGESPROP <<":" << fingerprintChanges;
+                setAgentProperty( FINGERPRINTCHANGESPROP, fingerprintChanges );
+            }
+            else if( aReader.name() == SUPPRESSUNCHANGEDREPLACESPROP )
+            {
+                aReader.readNext();
+                QString suppressReplaces = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << SUPPRESSUNCHANGEDREPLACESPROP <<":" << suppressReplaces;
+                setAgentProperty( SUPPRESSUNCHANGEDREPLACESPROP, suppressReplaces );
+            }
+            else if( aReader.name() == SLOWSYNCMATCHINGPROP )
+            {
+                aReader.readNext();
+                QString slowSyncMatching = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << SLOWSYNCMATCHINGPROP <<":" << slowSyncMatching;
+                setAgentProperty( SLOWSYNCMATCHINGPROP, slowSyncMatching );
+            }
+            else if( aReader.name() == MULTIITEMCOMMANDSPROP )
+            {
+                aReader.readNext();
+                QString multiItemCommands = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << MULTIITEMCOMMANDSPROP <<":" << multiItemCommands;
+                setAgentProperty( MULTIITEMCOMMANDSPROP, multiItemCommands );
+            }
 
         }
         else if( aReader.tokenType() == QXmlStreamReader::EndElement &&
@@ -563,6 +647,48 @@ bool SyncAgentConfig::parseTransportProps( QXmlStreamReader& aReader )
                 qCDebug(lcSyncML) << "Found transport property" << HTTPPROXYPORTPROP <<":" << proxyPort;
                 setTransportProperty( HTTPPROXYPORTPROP, proxyPort );
             }
+            else if( aReader.name() == HTTPINCREMENTALRECEIVEPROP )
+            {
+                aReader.readNext();
+                QString incrementalReceive = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << HTTPINCREMENTALRECEIVEPROP <<":" << incrementalReceive;
+                setTransportProperty( HTTPINCREMENTALRECEIVEPROP, incrementalReceive );
+            }
+            else if( aReader.name() == HTTPCOMPRESSIONTHRESHOLDPROP )
+            {
+                aReader.readNext();
+                QString compressionThreshold = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << HTTPCOMPRESSIONTHRESHOLDPROP <<":" << compressionThreshold;
+                setTransportProperty( HTTPCOMPRESSIONTHRESHOLDPROP, compressionThreshold );
+            }
+            else if( aReader.name() == HTTPSERVERADDRESSPROP )
+            {
+                aReader.readNext();
+                QString serverAddress = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << HTTPSERVERADDRESSPROP <<":" << serverAddress;
+                setTransportProperty( HTTPSERVERADDRESSPROP, serverAddress );
+            }
+            else if( aReader.name() == HTTPSERVERPORTPROP )
+            {
+                aReader.readNext();
+                QString serverPort = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << HTTPSERVERPORTPROP <<":" << serverPort;
+                setTransportProperty( HTTPSERVERPORTPROP, serverPort );
+            }
+            else if( aReader.name() == HTTPSERVERIDLETIMEOUTPROP )
+            {
+                aReader.readNext();
+                QString idleTimeout = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << HTTPSERVERIDLETIMEOUTPROP <<":" << idleTimeout;
+                setTransportProperty( HTTPSERVERIDLETIMEOUTPROP, idleTimeout );
+            }
+            else if( aReader.name() == EAGERXMLSANITIZINGPROP )
+            {
+                aReader.readNext();
+                QString eagerSanitizing = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << EAGERXMLSANITIZINGPROP <<":" << eagerSanitizing;
+                setTransportProperty( EAGERXMLSANITIZINGPROP, eagerSanitizing );
+            }
 
         }
         else if( aReader.tokenType() == QXmlStreamReader::EndElement &&
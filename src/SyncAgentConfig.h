@@ -48,6 +48,7 @@ namespace DataSync {
 
 class StorageProvider;
 class Transport;
+class TransportProvider;
 class SyncAgentConfigTest;
 
 
@@ -109,6 +110,25 @@ public:
      */
     Transport* getTransport() const;
 
+    /*! \brief Sets the transport provider to use when listening for requests
+     *
+     * Ownership is NOT transferred. If transport provider is set, SyncAgent
+     * serves several sessions concurrently, each of them with a transport
+     * acquired from the provider, and transport set with setTransport()
+     * is not used when listening.
+     *
+     * @param aProvider Transport provider to use, or NULL
+     */
+    void setTransportProvider( TransportProvider* aProvider );
+
+    /*! \brief Returns the transport provider to use when listening for requests
+     *
+     * Ownership is NOT transferred
+     *
+     * @return
+     */
+    TransportProvider* getTransportProvider() const;
+
     /*! \brief Sets the storage provider to use in sync
      *
      * Ownership is NOT transferred. It is MANDATORY to set transport when
@@ -150,6 +170,21 @@ public:
      */
     const QString& getDatabaseFilePath() const;
 
+    /*! \brief Sets the key of the database connection pool to use
+     *
+     * Sessions with different pool keys use separate database connections.
+     * If not set, the default pool is used.
+     *
+     * @param aPoolKey Pool key
+     */
+    void setDatabasePoolKey( const QString& aPoolKey );
+
+    /*! \brief Returns the key of the database connection pool to use
+     *
+     * @return Pool key
+     */
+    const QString& getDatabasePoolKey() const;
+
     /*! \brief Sets the local device name to be used in sync
      *
      * If not set, defaults to device ID specified in device info
@@ -400,9 +435,11 @@ private:
                               QStringList& aMappings );
 
     Transport*                      iTransport;
+    TransportProvider*              iTransportProvider;
     StorageProvider*                iStorageProvider;
 
     QString                         iDatabaseFilePath;
+    QString                         iDatabasePoolKey;
     QString                         iLocalDeviceName;
     DeviceInfo                      iDeviceInfo;
 
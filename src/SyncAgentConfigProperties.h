@@ -52,6 +52,51 @@ const QString FASTMAPSSENDPROP( "fast-maps-send" );
 // (as client) when there are no changes on the server side
 const QString OMITDATAUPDATESTATUSPROP( "omit-data-update-status" );
 
+// Property to control the size in bytes after which incoming large objects
+// are spooled to a temporary file instead of memory. 0 disables spooling
+const QString LARGEOBJECTSPOOLTHRESHOLDPROP( "large-object-spool-threshold" );
+
+// Property to control whether outgoing items are prefetched from storage
+// plugins in a worker thread. Storage plugins must support this
+const QString ASYNCPREFETCHPROP( "async-prefetch" );
+
+// Property to control whether Sync elements of different sync targets in a
+// message are committed concurrently in a thread pool. Storage plugins must
+// support being used from other threads than the one they were created in
+const QString PARALLELCOMMITPROP( "parallel-commit" );
+
+// Property to control the maximum number of sessions that are served
+// concurrently when listening with a transport provider
+const QString MAXCONCURRENTSESSIONSPROP( "max-concurrent-sessions" );
+
+// Property to control whether the progress of interrupted sessions is stored,
+// so that the next session with the same remote device resumes them instead
+// of starting over
+const QString RESUMABLESESSIONSPROP( "resumable-sessions" );
+
+// Property to control whether local changes are detected by comparing the
+// content of the items to fingerprints stored after the previous sync,
+// instead of relying on the modification tracking of storage plugins
+const QString FINGERPRINTCHANGESPROP( "fingerprint-changes" );
+
+// Property to control whether Replace commands are left out for modified
+// items whose content has not changed since it was last exchanged with the
+// remote device
+const QString SUPPRESSUNCHANGEDREPLACESPROP( "suppress-unchanged-replaces" );
+
+// Property to control whether items received in slow sync are matched to
+// existing local items before they are added, when acting as server
+const QString SLOWSYNCMATCHINGPROP( "slow-sync-matching" );
+
+// Property to control whether consecutive local changes of the same type are
+// sent as items of a single Add, Replace or Delete command
+const QString MULTIITEMCOMMANDSPROP( "multi-item-commands" );
+
+// Property to control whether invalid XML characters are removed from
+// incoming XML messages before parsing them, instead of only after parsing
+// has failed because of them
+const QString EAGERXMLSANITIZINGPROP( "eager-xml-sanitizing" );
+
 // Property to control the maximum transfer unit of OBEX over BT
 const QString OBEXMTUBTPROP( "obex-mtu-bt" );
 
@@ -75,6 +120,24 @@ const QString HTTPPROXYHOSTPROP( "http-proxy-host" );
 // Property to control the port of http proxy
 const QString HTTPPROXYPORTPROP( "http-proxy-port" );
 
+// Property to control whether incoming messages are parsed incrementally
+// as they are received over http
+const QString HTTPINCREMENTALRECEIVEPROP( "http-incremental-receive" );
+
+// Property to control the minimum size in bytes of outgoing http message
+// bodies that are compressed. 0 disables compression of outgoing messages
+const QString HTTPCOMPRESSIONTHRESHOLDPROP( "http-compression-threshold" );
+
+// Property to control the address http server listens on
+const QString HTTPSERVERADDRESSPROP( "http-server-address" );
+
+// Property to control the port http server listens on
+const QString HTTPSERVERPORTPROP( "http-server-port" );
+
+// Property to control the time in milliseconds after which idle connections
+// to http server are closed
+const QString HTTPSERVERIDLETIMEOUTPROP( "http-server-idle-timeout" );
+
 // Property to control EMI tags extension
 const QString EMITAGSEXTENSION( "emi-tags" );
 
@@ -0,0 +1,97 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SyncCommitJob.h"
+
+#include <QThread>
+
+#include "CommandHandler.h"
+#include "ConflictResolver.h"
+#include "ResponseGenerator.h"
+#include "SyncTarget.h"
+#include "Package.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+SyncCommitJob::SyncCommitJob( CommandHandler& aCommandHandler,
+                              SyncTarget& aTarget,
+                              StorageHandler& aStorageHandler,
+                              ConflictResolutionPolicy aPolicy,
+                              bool aFastMapsSend )
+ : iCommandHandler( aCommandHandler ),
+   iTarget( aTarget ),
+   iStorageHandler( aStorageHandler ),
+   iPolicy( aPolicy ),
+   iFastMapsSend( aFastMapsSend ),
+   iOwnerThread( QThread::currentThread() )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+SyncCommitJob::~SyncCommitJob()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+void SyncCommitJob::addSync( const SyncParams* aSyncParams, ResponseGenerator* aResponseGenerator )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iSyncs.append( qMakePair( aSyncParams, aResponseGenerator ) );
+}
+
+void SyncCommitJob::run()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qCDebug(lcSyncML) << "Processing" << iSyncs.count() << "Sync elements for" << iTarget.getSourceDatabase();
+
+    for( int i = 0; i < iSyncs.count(); ++i ) {
+
+        ResponseGenerator& responseGenerator = *iSyncs[i].second;
+
+        ConflictResolver& conflictResolver = iTarget.getConflictResolver( iPolicy );
+
+        iCommandHandler.handleSync( *iSyncs[i].first, iTarget, iStorageHandler,
+                                    responseGenerator, conflictResolver, iFastMapsSend );
+
+        // Packages are sent from the thread that created the job
+        foreach( Package* package, responseGenerator.getPackages() ) {
+            package->moveToThread( iOwnerThread );
+        }
+
+    }
+
+}
@@ -0,0 +1,110 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef SYNCCOMMITJOB_H
+#define SYNCCOMMITJOB_H
+
+#include <QRunnable>
+#include <QList>
+#include <QPair>
+
+#include "SyncAgentConsts.h"
+
+class QThread;
+
+namespace DataSync {
+
+class CommandHandler;
+class SyncTarget;
+class StorageHandler;
+class ResponseGenerator;
+struct SyncParams;
+
+/*! \brief Job that processes Sync elements of a single sync target
+ *
+ * Sync elements are processed in the order they were added. Responses to
+ * each Sync element are written to a separate response generator so that
+ * they can be merged to the session response in command order once the
+ * job has finished. Job can be run in a thread pool: the storage plugin of
+ * the sync target is only accessed from the thread running the job.
+ */
+class SyncCommitJob : public QRunnable
+{
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aCommandHandler Command handler to process Sync elements with
+     * @param aTarget Sync target of the Sync elements
+     * @param aStorageHandler Storage handler dedicated to aTarget
+     * @param aPolicy Conflict resolution policy
+     * @param aFastMapsSend True if mappings should be sent fast
+     */
+    SyncCommitJob( CommandHandler& aCommandHandler,
+                   SyncTarget& aTarget,
+                   StorageHandler& aStorageHandler,
+                   ConflictResolutionPolicy aPolicy,
+                   bool aFastMapsSend );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~SyncCommitJob();
+
+    /*! \brief Adds a Sync element to process
+     *
+     * @param aSyncParams Sync element. Not owned
+     * @param aResponseGenerator Response generator for responses to the Sync element. Not owned
+     */
+    void addSync( const SyncParams* aSyncParams, ResponseGenerator* aResponseGenerator );
+
+    /*! \brief Processes the Sync elements
+     *
+     */
+    virtual void run();
+
+private:
+
+    CommandHandler&                                             iCommandHandler;
+    SyncTarget&                                                 iTarget;
+    StorageHandler&                                             iStorageHandler;
+    ConflictResolutionPolicy                                    iPolicy;
+    bool                                                        iFastMapsSend;
+    QThread*                                                    iOwnerThread;
+    QList<QPair<const SyncParams*, ResponseGenerator*> >        iSyncs;
+
+};
+
+}
+
+#endif  //  SYNCCOMMITJOB_H
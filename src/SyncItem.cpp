@@ -31,6 +31,9 @@
 * 
 */
 #include "SyncItem.h"
+
+#include <QCryptographicHash>
+
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
@@ -95,3 +98,27 @@ void SyncItem::setVersion( const QString& aVersion )
     iVersion = aVersion;
 }
 
+QByteArray SyncItem::getFingerprint() const
+{
+    // Read the data in chunks so that large items need not be held in
+    // memory as a whole
+    const qint64 chunkSize = 64 * 1024;
+
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    qint64 size = getSize();
+    qint64 offset = 0;
+
+    while( offset < size ) {
+        QByteArray data;
+
+        if( !read( offset, qMin( chunkSize, size - offset ), data ) || data.isEmpty() ) {
+            qCWarning(lcSyncML) << "Could not read item data for fingerprint";
+            return QByteArray();
+        }
+
+        hash.addData( data );
+        offset += data.size();
+    }
+
+    return hash.result();
+}
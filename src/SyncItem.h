@@ -150,6 +150,17 @@ public:
      */
     virtual bool write( qint64 aOffset, const QByteArray& aData ) = 0;
 
+    /*! \brief Returns a fingerprint of the item data
+     *
+     * Two items with equal data have equal fingerprints. Default
+     * implementation calculates a SHA-1 hash over the data of the item.
+     * Implementations that can provide the fingerprint without reading all
+     * the data may reimplement this method.
+     *
+     * @return Fingerprint of the item data, or empty if data could not be read
+     */
+    virtual QByteArray getFingerprint() const;
+
 private:
     SyncItemKey iKey;
     SyncItemKey iParentKey;
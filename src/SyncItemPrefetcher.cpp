@@ -33,17 +33,144 @@
 
 #include "SyncItemPrefetcher.h"
 
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QTimer>
+
 #include "SyncItem.h"
 #include "StoragePlugin.h"
 
 #include "SyncMLLogging.h"
 
+#include <math.h>
+
+namespace DataSync {
+
+// Weight of the latest sample in the running average of encoded item size
+const double ITEMSIZEWEIGHT = 0.25;
+
+/*! \brief Thread that fetches batches of items from storage plugin
+ *
+ * Only one batch can be requested at a time. Items of the batch must be
+ * collected with takeItems() before next batch is requested.
+ */
+class SyncItemPrefetchWorker : public QThread
+{
+public:
+
+    SyncItemPrefetchWorker( StoragePlugin& aStoragePlugin );
+
+    virtual ~SyncItemPrefetchWorker();
+
+    void request( const QList<SyncItemKey>& aItemIds );
+
+    QList<SyncItem*> takeItems();
+
+    void stop();
+
+protected:
+
+    virtual void run();
+
+private:
+
+    StoragePlugin&      iStoragePlugin;
+    QMutex              iMutex;
+    QWaitCondition      iCondition;
+    QList<SyncItemKey>  iItemIds;
+    QList<SyncItem*>    iItems;
+    bool                iRequested;
+    bool                iStopped;
+
+};
+
+}
+
 using namespace DataSync;
 
+SyncItemPrefetchWorker::SyncItemPrefetchWorker( StoragePlugin& aStoragePlugin )
+ : iStoragePlugin( aStoragePlugin ), iRequested( false ), iStopped( false )
+{
+}
+
+SyncItemPrefetchWorker::~SyncItemPrefetchWorker()
+{
+    stop();
+}
+
+void SyncItemPrefetchWorker::request( const QList<SyncItemKey>& aItemIds )
+{
+    QMutexLocker locker( &iMutex );
+
+    iItemIds = aItemIds;
+    iRequested = true;
+    iCondition.wakeAll();
+}
+
+QList<SyncItem*> SyncItemPrefetchWorker::takeItems()
+{
+    QMutexLocker locker( &iMutex );
+
+    while( iRequested )
+    {
+        iCondition.wait( &iMutex );
+    }
+
+    QList<SyncItem*> items = iItems;
+    iItems.clear();
+
+    return items;
+}
+
+void SyncItemPrefetchWorker::stop()
+{
+    {
+        QMutexLocker locker( &iMutex );
+        iStopped = true;
+        iCondition.wakeAll();
+    }
+
+    wait();
+
+    qDeleteAll( iItems );
+    iItems.clear();
+}
+
+void SyncItemPrefetchWorker::run()
+{
+    qCDebug(lcSyncML) << "Starting item prefetch thread...";
+
+    QMutexLocker locker( &iMutex );
+
+    while( !iStopped )
+    {
+        if( !iRequested )
+        {
+            iCondition.wait( &iMutex );
+            continue;
+        }
+
+        QList<SyncItemKey> itemIds = iItemIds;
+
+        locker.unlock();
+        QList<SyncItem*> items = iStoragePlugin.getSyncItems( itemIds );
+        locker.relock();
+
+        iItems = items;
+        iRequested = false;
+        iCondition.wakeAll();
+    }
+
+    qCDebug(lcSyncML) << "Stopping item prefetch thread...";
+}
+
 SyncItemPrefetcher::SyncItemPrefetcher( const QList<SyncItemKey>& aItemIds,
                                         StoragePlugin& aStoragePlugin,
                                         int aInitialBatchSizeHint )
- : iStoragePlugin( aStoragePlugin ), iItemIdList( aItemIds )
+ : iStoragePlugin( aStoragePlugin ), iItemIdList( aItemIds ), iFetchedSize( 0 ),
+   iMaxCacheSize( 0 ), iAverageItemSize( 0 ), iHits( 0 ), iMisses( 0 ), iWorker( NULL )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     iDefaultBatchSizeHint = aInitialBatchSizeHint;
@@ -54,6 +181,13 @@ SyncItemPrefetcher::~SyncItemPrefetcher()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Worker must be stopped before the storage plugin can be released
+    delete iWorker;
+    iWorker = NULL;
+
+    qCDebug(lcSyncML) << "Item prefetcher statistics:" << iHits << "hits," << iMisses << "misses,"
+                      << "average item size" << iAverageItemSize << "bytes";
+
     qDeleteAll( iFetchedItems.values() );
     iFetchedItems.clear();
 }
@@ -64,6 +198,92 @@ void SyncItemPrefetcher::setBatchSizeHint( int aBatchSizeHint )
     iBatchSizeHint = aBatchSizeHint;
 }
 
+void SyncItemPrefetcher::setMaxCacheSize( qint64 aMaxCacheSize )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    iMaxCacheSize = aMaxCacheSize;
+}
+
+void SyncItemPrefetcher::setAsynchronous( bool aAsynchronous )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aAsynchronous && !iWorker )
+    {
+        iWorker = new SyncItemPrefetchWorker( iStoragePlugin );
+        iWorker->start();
+    }
+    else if( !aAsynchronous && iWorker )
+    {
+        collectPendingItems();
+        delete iWorker;
+        iWorker = NULL;
+    }
+}
+
+void SyncItemPrefetcher::addEncodedItemSize( qint64 aSize )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aSize <= 0 )
+    {
+        return;
+    }
+
+    if( iAverageItemSize <= 0 )
+    {
+        iAverageItemSize = aSize;
+    }
+    else
+    {
+        iAverageItemSize += ITEMSIZEWEIGHT * ( aSize - iAverageItemSize );
+    }
+}
+
+int SyncItemPrefetcher::estimateBatchSize( qint64 aMessageSize, int aMaxItems ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iAverageItemSize <= 0 || aMessageSize <= 0 )
+    {
+        return aMaxItems;
+    }
+
+    // Items are written until message is full, so the last item can overflow it
+    double items = ceil( aMessageSize / iAverageItemSize );
+
+    if( items >= aMaxItems )
+    {
+        return aMaxItems;
+    }
+
+    return qMax( 1, static_cast<int>( items ) );
+}
+
+int SyncItemPrefetcher::hits() const
+{
+    return iHits;
+}
+
+int SyncItemPrefetcher::misses() const
+{
+    return iMisses;
+}
+
+void SyncItemPrefetcher::schedulePrefetch()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iWorker )
+    {
+        prefetch();
+    }
+    else
+    {
+        QTimer::singleShot( 0, this, SLOT(prefetch()) );
+    }
+}
+
 SyncItem* SyncItemPrefetcher::getItem( const SyncItemKey& aItemId )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -73,18 +293,38 @@ SyncItem* SyncItemPrefetcher::getItem( const SyncItemKey& aItemId )
         iBatchSizeHint = iDefaultBatchSizeHint - iFetchedItems.count();
     }
 
+    if( !iFetchedItems.contains( aItemId ) )
+    {
+        // Item might be in the batch that is still being fetched
+        collectPendingItems();
+    }
+
     if( iFetchedItems.contains( aItemId ) )
     {
         // Prefetch hit: return item immediately
         qCDebug(lcSyncML) << "Item" << aItemId << "found from prefetched items";
-        return iFetchedItems.take( aItemId );
+        ++iHits;
+        return takeItem( aItemId );
     }
     else
     {
         // Prefetch miss: fetch more items
         qCDebug(lcSyncML) << "Item" << aItemId << "not found from prefetched items";
+        ++iMisses;
         prefetch();
-        return iFetchedItems.take( aItemId );
+        collectPendingItems();
+
+        if( iFetchedItems.contains( aItemId ) )
+        {
+            return takeItem( aItemId );
+        }
+
+        // Nothing was prefetched because cache is full or item was not
+        // next in the list, so fetch the item regardless of cache size.
+        // Item is removed from the list so that it is not fetched twice
+        qCDebug(lcSyncML) << "Fetching item" << aItemId << "directly from storage";
+        iItemIdList.removeOne( aItemId );
+        return iStoragePlugin.getSyncItem( aItemId );
     }
 }
 
@@ -94,7 +334,12 @@ void SyncItemPrefetcher::prefetch()
 
     qCDebug(lcSyncML) << "Item prefetcher waking...";
 
-    if( iFetchedItems.count() < iBatchSizeHint )
+    if( !iPendingItemIds.isEmpty() )
+    {
+        qCDebug(lcSyncML) << "Previous batch is still being fetched";
+    }
+    else if( iFetchedItems.count() < iBatchSizeHint &&
+             ( iMaxCacheSize <= 0 || iFetchedSize < iMaxCacheSize ) )
     {
 
         qCDebug(lcSyncML) << "Prefetch cache not full";
@@ -104,35 +349,17 @@ void SyncItemPrefetcher::prefetch()
         {
             qCDebug(lcSyncML) << "Requesting" << batchSize << "items";
             QList<SyncItemKey> nextItemIds = iItemIdList.mid( 0, batchSize );
-            QList<SyncItem*> nextItems = iStoragePlugin.getSyncItems( nextItemIds );
+            iItemIdList = iItemIdList.mid( batchSize );
 
-            if( nextItems.count() != nextItemIds.count() )
+            if( iWorker )
             {
-                // We cannot trust the ordering nor the integrity of the items returned by the backend, so just
-                // free them
-                qCWarning(lcSyncML) << "Asked for" << nextItemIds.count() << "items, got" << nextItems.count() << "items";
-                qDeleteAll( nextItems );
-                nextItems.clear();
+                iPendingItemIds = nextItemIds;
+                iWorker->request( nextItemIds );
             }
-
-            for ( int i = 0; i < nextItemIds.count(); ++i )
+            else
             {
-                SyncItem* item = 0;
-
-                for( int a = 0; a < nextItems.count(); ++a )
-                {
-                    if( nextItems[a] && nextItems[a]->getKey() == nextItemIds[i] )
-                    {
-                        item = nextItems[a];
-                        nextItems.removeAt( a );
-                    }
-                }
-
-                iFetchedItems.insert( nextItemIds[i], item );
-
+                storeItems( nextItemIds, iStoragePlugin.getSyncItems( nextItemIds ) );
             }
-
-            iItemIdList = iItemIdList.mid( batchSize );
         }
         else
         {
@@ -148,3 +375,77 @@ void SyncItemPrefetcher::prefetch()
 
     qCDebug(lcSyncML) << "Item prefetcher going to sleep...";
 }
+
+void SyncItemPrefetcher::collectPendingItems()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iWorker && !iPendingItemIds.isEmpty() )
+    {
+        QList<SyncItemKey> itemIds = iPendingItemIds;
+        iPendingItemIds.clear();
+        storeItems( itemIds, iWorker->takeItems() );
+    }
+}
+
+void SyncItemPrefetcher::storeItems( const QList<SyncItemKey>& aItemIds, QList<SyncItem*> aItems )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aItems.count() != aItemIds.count() )
+    {
+        // We cannot trust the ordering nor the integrity of the items returned by the backend, so just
+        // free them
+        qCWarning(lcSyncML) << "Asked for" << aItemIds.count() << "items, got" << aItems.count() << "items";
+        qDeleteAll( aItems );
+        aItems.clear();
+    }
+
+    QHash<SyncItemKey, SyncItem*> itemsByKey;
+    itemsByKey.reserve( aItems.count() );
+
+    foreach( SyncItem* item, aItems )
+    {
+        if( !item )
+        {
+            continue;
+        }
+
+        if( itemsByKey.contains( *item->getKey() ) )
+        {
+            qCWarning(lcSyncML) << "Duplicate item" << *item->getKey() << "returned by backend";
+            delete item;
+        }
+        else
+        {
+            itemsByKey.insert( *item->getKey(), item );
+        }
+    }
+
+    foreach( const SyncItemKey& itemId, aItemIds )
+    {
+        SyncItem* item = itemsByKey.take( itemId );
+
+        if( item )
+        {
+            iFetchedSize += item->getSize();
+        }
+
+        iFetchedItems.insert( itemId, item );
+    }
+
+    // Items that were not asked for
+    qDeleteAll( itemsByKey );
+}
+
+SyncItem* SyncItemPrefetcher::takeItem( const SyncItemKey& aItemId )
+{
+    SyncItem* item = iFetchedItems.take( aItemId );
+
+    if( item )
+    {
+        iFetchedSize -= item->getSize();
+    }
+
+    return item;
+}
@@ -46,6 +46,7 @@ namespace DataSync
 
 class StoragePlugin;
 class SyncItem;
+class SyncItemPrefetchWorker;
 
 /*! \brief Class that prefetches items from storage plugin based on
  *         batch size hint to increase performance when sending items
@@ -53,6 +54,12 @@ class SyncItem;
  * This class takes advantage on that the order of items requested from
  * storage plugin is known (aItemIds). Items are fetched in advance based
  * on current batch size hint.
+ *
+ * In asynchronous mode items are fetched in a worker thread, so that the
+ * next batch can be loaded while the current message is encoded and sent.
+ * At most one batch is being fetched at a time, and no new batch is
+ * requested while the prefetched items fill the batch size hint or the
+ * maximum cache size.
  */
 class SyncItemPrefetcher : public QObject
 {
@@ -80,13 +87,70 @@ public:
      */
     void setBatchSizeHint( int aBatchSizeHint );
 
+    /*! \brief Sets the maximum size of prefetched items
+     *
+     * No more items are prefetched while the total size of prefetched
+     * items exceeds this limit.
+     *
+     * @param aMaxCacheSize Maximum size in bytes. If 0, size is not limited
+     */
+    void setMaxCacheSize( qint64 aMaxCacheSize );
+
+    /*! \brief Sets whether items are fetched in a worker thread
+     *
+     * Storage plugin must allow getSyncItems() to be called from other
+     * threads than the one it was created in for asynchronous mode to be used.
+     *
+     * @param aAsynchronous True to fetch items in a worker thread
+     */
+    void setAsynchronous( bool aAsynchronous );
+
+    /*! \brief Records the encoded size of an item that was sent
+     *
+     * Recorded sizes are used to maintain a running estimate of the
+     * encoded size of items of this storage.
+     *
+     * @param aSize Encoded size of the item in bytes
+     */
+    void addEncodedItemSize( qint64 aSize );
+
+    /*! \brief Estimates how many items are needed to fill a message
+     *
+     * @param aMessageSize Bytes available for items in the message
+     * @param aMaxItems Maximum number of items allowed in the message
+     * @return Estimated number of items, between 1 and aMaxItems. If no item
+     *         sizes have been recorded, aMaxItems
+     */
+    int estimateBatchSize( qint64 aMessageSize, int aMaxItems ) const;
+
+    /*! \brief Returns the number of items that were found from prefetched items
+     *
+     * @return Number of prefetch hits
+     */
+    int hits() const;
+
+    /*! \brief Returns the number of items that had to be fetched on demand
+     *
+     * @return Number of prefetch misses
+     */
+    int misses() const;
+
+    /*! \brief Schedules prefetching of the next batch
+     *
+     * In asynchronous mode the batch is requested immediately, otherwise
+     * prefetch() is invoked when control returns to the event loop.
+     */
+    void schedulePrefetch();
+
     /*! \brief Retrieve next item
      *
      * If item is not prefetched, next prefetch round is done and item
-     * is returned after that
+     * is returned after that. If that does not bring the item, it is
+     * fetched from storage plugin directly, regardless of the maximum
+     * cache size
      *
      * @param aItemId Id of the item to retrieve
-     * @return
+     * @return Item, or NULL if storage plugin could not provide it
      */
     SyncItem* getItem( const SyncItemKey& aItemId );
 
@@ -94,16 +158,34 @@ public slots:
 
     /*! \brief Slot that should be invoked when prefetching can be done
      *
+     * In asynchronous mode this only requests the next batch from the
+     * worker thread and returns without waiting for it.
      */
     void prefetch();
 
 private:
 
+    void collectPendingItems();
+
+    void storeItems( const QList<SyncItemKey>& aItemIds, QList<SyncItem*> aItems );
+
+    SyncItem* takeItem( const SyncItemKey& aItemId );
+
     StoragePlugin&                  iStoragePlugin;
     int                             iBatchSizeHint;
     int                             iDefaultBatchSizeHint;
     QList<SyncItemKey>              iItemIdList;
     QHash<SyncItemKey, SyncItem*>   iFetchedItems;
+    qint64                          iFetchedSize;
+    qint64                          iMaxCacheSize;
+
+    // Running average of encoded item size, 0 if not known yet
+    double                          iAverageItemSize;
+    int                             iHits;
+    int                             iMisses;
+
+    SyncItemPrefetchWorker*         iWorker;
+    QList<SyncItemKey>              iPendingItemIds;
 
 
     friend class ::SyncItemPrefetcherTest;
@@ -44,7 +44,8 @@ using namespace DataSync;
 SyncMLMessageParser::SyncMLMessageParser()
  : iLastMessageInPackage( false ), iError( PARSER_ERROR_LAST ),
    iSyncHdrFound( false ), iSyncBodyFound( false ),
-   iIsNewPacket( false )
+   iIsNewPacket( false ), iParsingParts( false ), iMessageRead( false ),
+   iDepth( 0 ), iPartDepth( 0 ), iFragmentsTaken( 0 )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -71,6 +72,7 @@ QList<DataSync::Fragment*> SyncMLMessageParser::takeFragments()
 
     QList<DataSync::Fragment*> fragments = iFragments;
     iFragments.clear();
+    iFragmentsTaken += fragments.count();
     return fragments;
 }
 
@@ -80,6 +82,12 @@ void SyncMLMessageParser::parseResponse( QIODevice *aDevice, bool aIsNewPacket )
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     iIsNewPacket = aIsNewPacket;
+    iParsingParts = false;
+
+    if( aIsNewPacket ) {
+        iFragmentsTaken = 0;
+    }
+
     if( aDevice->bytesAvailable() == 0 ) {
         qCCritical(lcSyncML) << "Zero-sized message detected, aborting parsing";
         emit parsingError( PARSER_ERROR_INVALID_DATA );
@@ -98,19 +106,60 @@ void SyncMLMessageParser::parseResponse( QIODevice *aDevice, bool aIsNewPacket )
 
 }
 
-void SyncMLMessageParser::startParsing()
+void SyncMLMessageParser::parseResponsePart( const QByteArray& aData, bool aFirstPart, bool aLastPart )
 {
-
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    qDeleteAll(iFragments);
-    iFragments.clear();
-    iLastMessageInPackage = false;
+    if( !aFirstPart && !iParsingParts ) {
+        qCWarning(lcSyncML) << "Ignoring part of a message whose beginning was not received";
+        return;
+    }
 
-    iSyncHdrFound = false;
-    iSyncBodyFound = false;
+    if( aFirstPart ) {
 
-    iError = PARSER_ERROR_LAST;
+        qCDebug(lcSyncML) << "Beginning to parse incoming message part by part...";
+
+        iIsNewPacket = true;
+        iParsingParts = true;
+        iFragmentsTaken = 0;
+
+        iReader.clear();
+        iReader.setNamespaceProcessing( false );
+        resetParsing();
+    }
+
+    int fragments = iFragments.count();
+
+    if( iError == PARSER_ERROR_LAST ) {
+        iReader.addData( aData );
+        readAvailableParts();
+    }
+
+    if( aLastPart ) {
+
+        iParsingParts = false;
+
+        if( iError == PARSER_ERROR_LAST && !iMessageRead ) {
+            qCCritical(lcSyncML) << "Incomplete SyncML message";
+            iError = PARSER_ERROR_INCOMPLETE_DATA;
+        }
+
+        finishParsing();
+
+        qCDebug(lcSyncML) << "Incoming message parsed";
+    }
+    else if( iError == PARSER_ERROR_LAST && iFragments.count() > fragments ) {
+        emit fragmentsAvailable();
+    }
+
+}
+
+void SyncMLMessageParser::startParsing()
+{
+
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    resetParsing();
 
     while( shouldContinue() ) {
 
@@ -160,6 +209,134 @@ void SyncMLMessageParser::startParsing()
         }
     }
 
+    if( iError == PARSER_ERROR_LAST && !iIsNewPacket )
+    {
+        // When retrying a message that was parsed part by part, fragments
+        // that were already taken before the error must not be processed again
+        int skip = qMin( iFragmentsTaken, iFragments.count() );
+
+        for( int i = 0; i < skip; ++i ) {
+            delete iFragments.takeFirst();
+        }
+    }
+
+    finishParsing();
+
+}
+
+void SyncMLMessageParser::resetParsing()
+{
+    qDeleteAll(iFragments);
+    iFragments.clear();
+    iLastMessageInPackage = false;
+
+    iSyncHdrFound = false;
+    iSyncBodyFound = false;
+
+    iMessageRead = false;
+    iDepth = 0;
+    iPartName.clear();
+    iPartDepth = 0;
+
+    iError = PARSER_ERROR_LAST;
+}
+
+void SyncMLMessageParser::readAvailableParts()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Tokens of a header or body element are recorded until the element has
+    // been received completely, and then replayed through the same functions
+    // that are used when parsing the whole message at once
+    while( iError == PARSER_ERROR_LAST && !iMessageRead ) {
+
+        QXmlStreamReader::TokenType token = iReader.readNext();
+
+        if( token == QXmlStreamReader::StartElement ) {
+            ++iDepth;
+
+            if( iPartName.isEmpty() ) {
+                readPart();
+            }
+        }
+        else if( token == QXmlStreamReader::EndElement ) {
+
+            if( !iPartName.isEmpty() && iDepth == iPartDepth ) {
+
+                iReader.startReplay();
+
+                if( iPartName == SYNCML_ELEMENT_SYNCHDR ) {
+                    readHeader();
+                }
+                else {
+                    readBodyElement( QStringRef( &iPartName ) );
+                }
+
+                iReader.stopReplay();
+                iPartName.clear();
+            }
+
+            --iDepth;
+
+            if( iDepth == 0 ) {
+                iMessageRead = true;
+            }
+        }
+        else if( token == QXmlStreamReader::Invalid ) {
+
+            if( !iReader.needsMoreData() ) {
+                qCCritical(lcSyncML) << "Unexpected token in SyncML message" << token;
+                iError = PARSER_ERROR_UNEXPECTED_DATA;
+            }
+
+            break;
+        }
+        else if( token == QXmlStreamReader::EndDocument ) {
+            break;
+        }
+        else if( token == QXmlStreamReader::NoToken ||
+                 token == QXmlStreamReader::EntityReference ||
+                 token == QXmlStreamReader::ProcessingInstruction ) {
+            qCCritical(lcSyncML) << "Unexpected token in SyncML message" << token;
+            iError = PARSER_ERROR_UNEXPECTED_DATA;
+        }
+    }
+}
+
+void SyncMLMessageParser::readPart()
+{
+    QStringRef name = iReader.name();
+
+    if( iDepth == 1 && name == SYNCML_ELEMENT_SYNCML ) {
+        return;
+    }
+    else if( iDepth == 2 && name == SYNCML_ELEMENT_SYNCHDR ) {
+        iPartName = name.toString();
+        iPartDepth = iDepth;
+        iReader.startRecording();
+    }
+    else if( iDepth == 2 && name == SYNCML_ELEMENT_SYNCBODY ) {
+
+        if( iSyncBodyFound ) {
+            qCCritical(lcSyncML) << "Invalid SyncML message, multiple SyncBody elements found";
+            iError = PARSER_ERROR_INVALID_DATA;
+        }
+
+        iSyncBodyFound = true;
+    }
+    else if( iDepth == 3 && iSyncBodyFound ) {
+        iPartName = name.toString();
+        iPartDepth = iDepth;
+        iReader.startRecording();
+    }
+    else {
+        qCCritical(lcSyncML) << "Unexpected element in SyncML message:" << name;
+        iError = PARSER_ERROR_UNEXPECTED_DATA;
+    }
+}
+
+void SyncMLMessageParser::finishParsing()
+{
     if( iError != PARSER_ERROR_LAST )
     {
         qCCritical(lcSyncML) << "Error while parsing SyncML document:" << iError;
@@ -172,6 +349,10 @@ void SyncMLMessageParser::startParsing()
             // characters
             iError = PARSER_ERROR_INVALID_CHARS;
         }
+
+        qDeleteAll(iFragments);
+        iFragments.clear();
+
         emit parsingError( iError );
     }
     else if( !iSyncHdrFound || !iSyncBodyFound )
@@ -183,7 +364,6 @@ void SyncMLMessageParser::startParsing()
     {
         emit parsingComplete(iLastMessageInPackage);
     }
-
 }
 
 void SyncMLMessageParser::readBody()
@@ -210,32 +390,7 @@ void SyncMLMessageParser::readBody()
         }
 
         if( iReader.isStartElement() ) {
-            if( name == SYNCML_ELEMENT_STATUS) {
-                readStatus();
-            } else if (name == SYNCML_ELEMENT_SYNC) {
-                readSync();
-            } else if (name == SYNCML_ELEMENT_PUT) {
-                readPut();
-            } else if (name == SYNCML_ELEMENT_RESULTS) {
-                readResults();
-            } else if (name == SYNCML_ELEMENT_MAP ) {
-                readMap();
-            }else if (name == SYNCML_ELEMENT_FINAL) {
-                iLastMessageInPackage = true;
-            } else {
-                CommandParams* command = new CommandParams();
-
-                if( readCommand( name, *command ) ) {
-                    iFragments.append( command );
-                }
-                else {
-                    delete command;
-                    command = 0;
-                    qCWarning(lcSyncML) << "UNKNOWN  TOKEN TYPE in BODY:NOT HANDLED BY PARSER" << name;
-                }
-
-            }
-
+            readBodyElement( name );
         }
 
     }
@@ -247,6 +402,35 @@ void SyncMLMessageParser::readBody()
 
 }
 
+void SyncMLMessageParser::readBodyElement( const QStringRef& aName )
+{
+    if( aName == SYNCML_ELEMENT_STATUS) {
+        readStatus();
+    } else if (aName == SYNCML_ELEMENT_SYNC) {
+        readSync();
+    } else if (aName == SYNCML_ELEMENT_PUT) {
+        readPut();
+    } else if (aName == SYNCML_ELEMENT_RESULTS) {
+        readResults();
+    } else if (aName == SYNCML_ELEMENT_MAP ) {
+        readMap();
+    }else if (aName == SYNCML_ELEMENT_FINAL) {
+        iLastMessageInPackage = true;
+    } else {
+        CommandParams* command = new CommandParams();
+
+        if( readCommand( aName, *command ) ) {
+            iFragments.append( command );
+        }
+        else {
+            delete command;
+            command = 0;
+            qCWarning(lcSyncML) << "UNKNOWN  TOKEN TYPE in BODY:NOT HANDLED BY PARSER" << aName;
+        }
+
+    }
+}
+
 void SyncMLMessageParser::readHeader()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -376,7 +560,10 @@ void SyncMLMessageParser::readStatus()
                 status->targetRef = readString();
             }
             else if (name == SYNCML_ELEMENT_SOURCEREF) {
+                // Status of a command with multiple items can refer to
+                // several of them
                 status->sourceRef = readString();
+                status->sourceRefs.append( status->sourceRef );
             }
             else if (name == SYNCML_ELEMENT_DATA) {
                 status->data = (ResponseStatusCode)readInt();
@@ -1579,11 +1766,15 @@ QString SyncMLMessageParser::readString()
     return string;
 }
 
-QString SyncMLMessageParser::readMixed()
+QByteArray SyncMLMessageParser::readMixed()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
-    QString text;
-    QString xml;
+
+    // Item data is stored as UTF-8 as that is what storages expect. Convert
+    // each piece of text right away so that we don't need to hold the whole
+    // data also in UTF-16.
+    QByteArray text;
+    QByteArray xml;
 
     while( shouldContinue() )
     {
@@ -1594,25 +1785,22 @@ QString SyncMLMessageParser::readMixed()
         {
             QString elementName = iReader.name().toString();
 
-            QByteArray buffer;
-            QXmlStreamWriter writer( &buffer );
+            QXmlStreamWriter writer( &xml );
             writer.setAutoFormatting( false );
 
             while( !(iReader.isEndElement() && iReader.name() == elementName ) )
             {
-                writer.writeCurrentToken( iReader );
+                iReader.writeCurrentToken( writer );
                 iReader.readNext();
             }
 
-            writer.writeCurrentToken( iReader );
-
-            xml = QString::fromUtf8( buffer.constData() );
+            iReader.writeCurrentToken( writer );
             break;
 
         }
         else if( iReader.isCharacters() )
         {
-            text.append( iReader.text().toString() );
+            text.append( iReader.text().toUtf8() );
         }
         else if( iReader.isEndElement() )
         {
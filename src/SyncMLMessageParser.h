@@ -34,10 +34,10 @@
 #ifndef SYNCMLMESSAGEPARSER_H
 #define SYNCMLMESSAGEPARSER_H
 
-#include <QXmlStreamReader>
 #include <QHash>
 
 #include "Fragments.h"
+#include "SyncMLReader.h"
 
 class SyncMLMessageParserTest;
 
@@ -59,6 +59,11 @@ enum ParserError {
  * This Class reads the XML data from the incoming stream and builds
  * individual structs for the SyncML commands received in the SyncML
  * Message.
+ *
+ * Messages can be parsed either as a whole with parseResponse(), or part by
+ * part as they are received with parseResponsePart(). When parsing part by
+ * part, header and each command of the body are made available with
+ * fragmentsAvailable() as soon as they have been received completely.
  */
 class SyncMLMessageParser : public QObject
 {
@@ -92,8 +97,26 @@ public slots:
 	 */
     void parseResponse( QIODevice *aDevice, bool aIsNewPacket );
 
+    /*! \brief Parse part of incoming data
+     *
+     * Errors are reported when the last part has been parsed, so that the
+     * whole message is available for retrying with parseResponse().
+     *
+     * @param aData Next part of the message
+     * @param aFirstPart True if this is the first part of a new message
+     * @param aLastPart True if this is the last part of the message
+     */
+    void parseResponsePart( const QByteArray& aData, bool aFirstPart, bool aLastPart );
+
 signals:
 
+    /*! \brief Emitted when fragments of a message that is parsed part by part
+     *          are available before parsing of the message has been completed
+     *
+     * Fragments can be retrieved with takeFragments()
+     */
+    void fragmentsAvailable();
+
     /*! \brief Emitted when parsing of a message has been completed
      *
      * @param aLastMessageInPackage True if the parsed message contained
@@ -110,10 +133,20 @@ signals:
 private:
     void startParsing();
 
+    void resetParsing();
+
+    void readAvailableParts();
+
+    void readPart();
+
+    void finishParsing();
+
 	void readHeader();
 
 	void readBody();
 
+    void readBodyElement( const QStringRef& aName );
+
 	void readStatus();
 
 	void readSync();
@@ -166,13 +199,13 @@ private:
 
 	QString readString();
 
-    QString readMixed();
+    QByteArray readMixed();
 
     bool shouldContinue() const;
 
 	void initMaps();
 
-    QXmlStreamReader            iReader;
+    SyncMLReader                iReader;
     QList<DataSync::Fragment*>  iFragments;
     bool                        iLastMessageInPackage;
     ParserError                 iError;
@@ -181,6 +214,12 @@ private:
     bool                        iSyncHdrFound;
     bool                        iSyncBodyFound;
     bool                        iIsNewPacket;
+    bool                        iParsingParts;
+    bool                        iMessageRead;
+    int                         iDepth;
+    QString                     iPartName;
+    int                         iPartDepth;
+    int                         iFragmentsTaken;
 
 
     friend class ::SyncMLMessageParserTest;
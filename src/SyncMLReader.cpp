@@ -0,0 +1,390 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SyncMLReader.h"
+
+#include <QBuffer>
+
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+// Reader is called for every token of every incoming message, so function
+// tracing is intentionally not enabled here.
+
+using namespace DataSync;
+
+SyncMLReader::SyncMLReader()
+ : iWbXML( false ), iFormatDetected( false ), iRecording( false ),
+   iReplaying( false ), iReplayIndex( -1 )
+{
+}
+
+SyncMLReader::~SyncMLReader()
+{
+}
+
+void SyncMLReader::setDevice( QIODevice* aDevice )
+{
+    iRecording = false;
+    iReplaying = false;
+    iRecordedTokens.clear();
+
+    detectFormat( aDevice->peek( 1 ) );
+
+    if( iWbXML ) {
+
+        // Share the buffer of in-memory devices instead of copying it
+        QBuffer* buffer = qobject_cast<QBuffer*>( aDevice );
+
+        if( buffer && buffer->pos() == 0 ) {
+            iWbXMLReader.setData( buffer->data() );
+        }
+        else {
+            iWbXMLReader.setData( aDevice->readAll() );
+        }
+
+        iXmlReader.clear();
+    }
+    else {
+        iWbXMLReader.setData( QByteArray() );
+        iXmlReader.setDevice( aDevice );
+    }
+}
+
+void SyncMLReader::clear()
+{
+    iWbXML = false;
+    iFormatDetected = false;
+    iRecording = false;
+    iReplaying = false;
+    iRecordedTokens.clear();
+
+    iWbXMLReader.setData( QByteArray() );
+    iXmlReader.clear();
+}
+
+void SyncMLReader::addData( const QByteArray& aData )
+{
+    if( aData.isEmpty() ) {
+        return;
+    }
+
+    if( !iFormatDetected ) {
+
+        detectFormat( aData );
+
+        if( iWbXML ) {
+            iWbXMLReader.setData( aData );
+            return;
+        }
+    }
+
+    if( iWbXML ) {
+        iWbXMLReader.addData( aData );
+    }
+    else {
+        iXmlReader.addData( aData );
+    }
+}
+
+bool SyncMLReader::needsMoreData() const
+{
+    if( !iFormatDetected ) {
+        return true;
+    }
+    else if( iWbXML ) {
+        return iWbXMLReader.error() == WbXMLReader::PrematureEndOfDocumentError;
+    }
+    else {
+        return iXmlReader.error() == QXmlStreamReader::PrematureEndOfDocumentError;
+    }
+}
+
+void SyncMLReader::startRecording()
+{
+    iRecordedTokens.clear();
+    iRecording = true;
+}
+
+void SyncMLReader::startReplay()
+{
+    iRecording = false;
+    iReplaying = true;
+    iReplayIndex = -1;
+}
+
+void SyncMLReader::stopReplay()
+{
+    iReplaying = false;
+    iRecordedTokens.clear();
+}
+
+void SyncMLReader::setNamespaceProcessing( bool aEnabled )
+{
+    iXmlReader.setNamespaceProcessing( aEnabled );
+}
+
+bool SyncMLReader::isWbXML() const
+{
+    return iWbXML;
+}
+
+QXmlStreamReader::TokenType SyncMLReader::readNext()
+{
+    if( iReplaying ) {
+
+        if( iReplayIndex < iRecordedTokens.count() ) {
+            ++iReplayIndex;
+        }
+
+        return tokenType();
+    }
+
+    QXmlStreamReader::TokenType token = iWbXML ? iWbXMLReader.readNext() : iXmlReader.readNext();
+
+    if( iRecording && token != QXmlStreamReader::Invalid ) {
+        recordCurrentToken();
+    }
+
+    return token;
+}
+
+QXmlStreamReader::TokenType SyncMLReader::tokenType() const
+{
+    if( iReplaying ) {
+
+        const Token* token = replayedToken();
+
+        if( token ) {
+            return token->iType;
+        }
+        else {
+            return iReplayIndex < 0 ? QXmlStreamReader::NoToken : QXmlStreamReader::Invalid;
+        }
+    }
+
+    return iWbXML ? iWbXMLReader.tokenType() : iXmlReader.tokenType();
+}
+
+QStringRef SyncMLReader::name() const
+{
+    if( iReplaying ) {
+        const Token* token = replayedToken();
+        return token ? QStringRef( &token->iName ) : QStringRef();
+    }
+    else if( iWbXML ) {
+        return iWbXMLReader.tokenType() == QXmlStreamReader::StartElement ||
+               iWbXMLReader.tokenType() == QXmlStreamReader::EndElement ?
+               QStringRef( &iWbXMLReader.name() ) : QStringRef();
+    }
+    else {
+        return iXmlReader.name();
+    }
+}
+
+QStringRef SyncMLReader::text() const
+{
+    if( iReplaying ) {
+        const Token* token = replayedToken();
+        return token ? QStringRef( &token->iText ) : QStringRef();
+    }
+    else if( iWbXML ) {
+        return iWbXMLReader.tokenType() == QXmlStreamReader::Characters ?
+               QStringRef( &iWbXMLReader.text() ) : QStringRef();
+    }
+    else {
+        return iXmlReader.text();
+    }
+}
+
+bool SyncMLReader::isStartElement() const
+{
+    return tokenType() == QXmlStreamReader::StartElement;
+}
+
+bool SyncMLReader::isEndElement() const
+{
+    return tokenType() == QXmlStreamReader::EndElement;
+}
+
+bool SyncMLReader::isCharacters() const
+{
+    return tokenType() == QXmlStreamReader::Characters;
+}
+
+bool SyncMLReader::atEnd() const
+{
+    if( iReplaying ) {
+        return iReplayIndex >= iRecordedTokens.count();
+    }
+
+    return iWbXML ? iWbXMLReader.atEnd() : iXmlReader.atEnd();
+}
+
+QXmlStreamReader::Error SyncMLReader::error() const
+{
+    if( iReplaying ) {
+        // Reading past the recording means that recorded element was not
+        // complete
+        return atEnd() ? QXmlStreamReader::PrematureEndOfDocumentError : QXmlStreamReader::NoError;
+    }
+    else if( iWbXML ) {
+        return iWbXMLReader.error() == WbXMLReader::NoError ?
+               QXmlStreamReader::NoError : QXmlStreamReader::CustomError;
+    }
+    else {
+        return iXmlReader.error();
+    }
+}
+
+void SyncMLReader::writeCurrentToken( QXmlStreamWriter& aWriter ) const
+{
+    if( iReplaying ) {
+
+        const Token* token = replayedToken();
+
+        if( !token ) {
+            return;
+        }
+
+        if( token->iType == QXmlStreamReader::StartElement ) {
+            aWriter.writeStartElement( token->iName );
+            aWriter.writeAttributes( token->iAttributes );
+        }
+        else if( token->iType == QXmlStreamReader::EndElement ) {
+            aWriter.writeEndElement();
+        }
+        else if( token->iType == QXmlStreamReader::Characters && token->iCDATA ) {
+            aWriter.writeCDATA( token->iText );
+        }
+        else if( token->iType == QXmlStreamReader::Characters ) {
+            aWriter.writeCharacters( token->iText );
+        }
+
+        return;
+    }
+
+    if( !iWbXML ) {
+        aWriter.writeCurrentToken( iXmlReader );
+        return;
+    }
+
+    switch( iWbXMLReader.tokenType() )
+    {
+        case QXmlStreamReader::StartElement:
+        {
+            aWriter.writeStartElement( iWbXMLReader.name() );
+
+            if( !iWbXMLReader.namespaceDeclaration().isEmpty() ) {
+                aWriter.writeAttribute( XML_NAMESPACE, iWbXMLReader.namespaceDeclaration() );
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement:
+        {
+            aWriter.writeEndElement();
+            break;
+        }
+        case QXmlStreamReader::Characters:
+        {
+            aWriter.writeCharacters( iWbXMLReader.text() );
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+void SyncMLReader::detectFormat( const QByteArray& aStart )
+{
+    // XML documents start with a BOM, whitespace or '<', WbXML documents
+    // with the WbXML version number
+    iWbXML = !aStart.isEmpty() && static_cast<quint8>( aStart.at( 0 ) ) <= 0x03;
+    iFormatDetected = !aStart.isEmpty();
+
+    if( iWbXML ) {
+        qCDebug(lcSyncML) << "Reading message as WbXML";
+    }
+}
+
+void SyncMLReader::recordCurrentToken()
+{
+    Token token;
+    token.iType = tokenType();
+    token.iCDATA = false;
+
+    if( token.iType == QXmlStreamReader::StartElement ) {
+
+        token.iName = name().toString();
+
+        if( !iWbXML ) {
+            token.iAttributes = iXmlReader.attributes();
+        }
+        else if( !iWbXMLReader.namespaceDeclaration().isEmpty() ) {
+            token.iAttributes.append( XML_NAMESPACE, iWbXMLReader.namespaceDeclaration() );
+        }
+    }
+    else if( token.iType == QXmlStreamReader::EndElement ) {
+        token.iName = name().toString();
+    }
+    else if( token.iType == QXmlStreamReader::Characters ) {
+
+        token.iCDATA = !iWbXML && iXmlReader.isCDATA();
+
+        // Text that was split between parts of the message is replayed as
+        // a single token, as it is read when the whole message is available
+        if( !iRecordedTokens.isEmpty() &&
+            iRecordedTokens.last().iType == QXmlStreamReader::Characters &&
+            iRecordedTokens.last().iCDATA == token.iCDATA ) {
+            iRecordedTokens.last().iText.append( text() );
+            return;
+        }
+
+        token.iText = text().toString();
+    }
+
+    iRecordedTokens.append( token );
+}
+
+const SyncMLReader::Token* SyncMLReader::replayedToken() const
+{
+    if( iReplayIndex >= 0 && iReplayIndex < iRecordedTokens.count() ) {
+        return &iRecordedTokens.at( iReplayIndex );
+    }
+    else {
+        return 0;
+    }
+}
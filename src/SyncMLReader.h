@@ -0,0 +1,221 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef SYNCMLREADER_H
+#define SYNCMLREADER_H
+
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "WbXMLReader.h"
+
+class QIODevice;
+
+namespace DataSync {
+
+/*! \brief Token reader for SyncML messages in XML or WbXML format
+ *
+ * Offers the subset of the QXmlStreamReader interface used by
+ * SyncMLMessageParser. WbXML messages are read natively with WbXMLReader,
+ * XML messages with QXmlStreamReader.
+ *
+ * Messages can also be read incrementally with addData(). Tokens read can
+ * be recorded and replayed later, which allows reading an element only
+ * after all of its data has been received.
+ */
+class SyncMLReader
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    SyncMLReader();
+
+    /*! \brief Destructor
+     *
+     */
+    ~SyncMLReader();
+
+    /*! \brief Sets the device to read the message from
+     *
+     * Format of the message is detected from its first byte
+     *
+     * @param aDevice Device
+     */
+    void setDevice( QIODevice* aDevice );
+
+    /*! \brief Resets the reader for reading a message incrementally
+     *
+     */
+    void clear();
+
+    /*! \brief Adds data of a message that is read incrementally
+     *
+     * Format of the message is detected from the first byte added
+     *
+     * @param aData Data to add
+     */
+    void addData( const QByteArray& aData );
+
+    /*! \brief Checks if reading stopped because all added data has been read
+     *
+     * @return True if more data is needed to continue reading
+     */
+    bool needsMoreData() const;
+
+    /*! \brief Starts recording tokens that are read
+     *
+     * Any previous recording is discarded
+     */
+    void startRecording();
+
+    /*! \brief Starts replaying recorded tokens
+     *
+     * Recording is stopped, and tokens are returned from the recording
+     * until stopReplay() is called.
+     */
+    void startReplay();
+
+    /*! \brief Stops replaying and discards the recording
+     *
+     * Reading continues from where it was when replay was started.
+     */
+    void stopReplay();
+
+    /*! \brief Sets namespace processing of XML messages
+     *
+     * @param aEnabled True to enable namespace processing
+     */
+    void setNamespaceProcessing( bool aEnabled );
+
+    /*! \brief Checks if current message is in WbXML format
+     *
+     * @return True if message is WbXML
+     */
+    bool isWbXML() const;
+
+    /*! \brief Reads the next token
+     *
+     * @return Type of the token
+     */
+    QXmlStreamReader::TokenType readNext();
+
+    /*! \brief Returns the type of the current token
+     *
+     * @return Token type
+     */
+    QXmlStreamReader::TokenType tokenType() const;
+
+    /*! \brief Returns the name of the current element
+     *
+     * @return Element name
+     */
+    QStringRef name() const;
+
+    /*! \brief Returns the text of the current characters token
+     *
+     * @return Text
+     */
+    QStringRef text() const;
+
+    /*! \brief Checks if current token is a start element
+     *
+     * @return True if token is a start element
+     */
+    bool isStartElement() const;
+
+    /*! \brief Checks if current token is an end element
+     *
+     * @return True if token is an end element
+     */
+    bool isEndElement() const;
+
+    /*! \brief Checks if current token is characters
+     *
+     * @return True if token is characters
+     */
+    bool isCharacters() const;
+
+    /*! \brief Checks if reading has ended
+     *
+     * @return True if end of message has been reached or an error has occurred
+     */
+    bool atEnd() const;
+
+    /*! \brief Returns the error that stopped reading
+     *
+     * WbXML errors are reported as QXmlStreamReader::CustomError, as they can
+     * not be recovered from by removing invalid XML characters
+     *
+     * @return Error
+     */
+    QXmlStreamReader::Error error() const;
+
+    /*! \brief Writes the current token to a writer
+     *
+     * @param aWriter Writer to use
+     */
+    void writeCurrentToken( QXmlStreamWriter& aWriter ) const;
+
+private:
+
+    struct Token
+    {
+        QXmlStreamReader::TokenType iType;
+        QString                     iName;
+        QString                     iText;
+        QXmlStreamAttributes        iAttributes;
+        bool                        iCDATA;
+    };
+
+    void detectFormat( const QByteArray& aStart );
+
+    void recordCurrentToken();
+
+    const Token* replayedToken() const;
+
+    QXmlStreamReader    iXmlReader;
+    WbXMLReader         iWbXMLReader;
+    bool                iWbXML;
+    bool                iFormatDetected;
+    bool                iRecording;
+    bool                iReplaying;
+    QList<Token>        iRecordedTokens;
+    int                 iReplayIndex;
+
+};
+
+}
+
+#endif  //  SYNCMLREADER_H
@@ -51,6 +51,7 @@ void SyncResults::reset()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     iResults.clear();
+    iStatistics = SessionStatistics();
 }
 
 SyncState SyncResults::getState() const
@@ -131,3 +132,15 @@ void SyncResults::addProcessedItem( DataSync::ModificationType aModificationType
     }
 
 }
+
+const SessionStatistics& SyncResults::getStatistics() const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    return iStatistics;
+}
+
+void SyncResults::setStatistics( const SessionStatistics& aStatistics )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    iStatistics = aStatistics;
+}
@@ -35,6 +35,7 @@
 #define SYNCRESULTS_H
 
 #include "SyncAgentConsts.h"
+#include <QList>
 #include <QMap>
 #include <QString>
 
@@ -58,6 +59,60 @@ struct DatabaseResults {
 
 };
 
+/*! \brief Describes time spent in each phase of message handling
+ *
+ * Times are measured with a monotonic clock and are in microseconds
+ */
+struct PhaseTimes {
+
+    qint64  iParseTime;         /*!<Time spent parsing received messages*/
+    qint64  iProcessTime;       /*!<Time spent processing received messages, excluding storage commits*/
+    qint64  iGenerateTime;      /*!<Time spent generating messages to send*/
+    qint64  iEncodeTime;        /*!<Time spent encoding messages to XML or WbXML*/
+    qint64  iTransportWaitTime; /*!<Time spent waiting for messages from remote device*/
+    qint64  iStorageCommitTime; /*!<Time spent committing received items to storages*/
+
+    PhaseTimes() : iParseTime( 0 ), iProcessTime( 0 ), iGenerateTime( 0 ), iEncodeTime( 0 ),
+                   iTransportWaitTime( 0 ), iStorageCommitTime( 0 ) { }
+
+};
+
+/*! \brief Describes a single message sent or received during sync session
+ *
+ */
+struct MessageStatistics {
+
+    int         iMsgId;     /*!<Message ID*/
+    bool        iOutgoing;  /*!<True if message was sent, false if it was received*/
+    qint64      iBytes;     /*!<Size of the message as passed to or from transport*/
+    PhaseTimes  iTimes;     /*!<Time spent handling the message*/
+
+    MessageStatistics() : iMsgId( -1 ), iOutgoing( false ), iBytes( 0 ) { }
+
+};
+
+/*! \brief Describes where time and bandwidth were spent during sync session
+ *
+ */
+struct SessionStatistics {
+
+    PhaseTimes                  iTimes;             /*!<Total time spent in each phase*/
+    QMap<SyncState, qint64>     iStateTimes;        /*!<Time spent in each sync state, in microseconds*/
+    qint64                      iBytesSent;         /*!<Number of bytes sent*/
+    qint64                      iBytesReceived;     /*!<Number of bytes received*/
+    int                         iMessagesSent;      /*!<Number of messages sent*/
+    int                         iMessagesReceived;  /*!<Number of messages received*/
+    int                         iSuppressedReplaces;/*!<Number of Replace commands left out as item content had not changed*/
+    int                         iPrefetchHits;      /*!<Number of outgoing items that were found from prefetched items*/
+    int                         iPrefetchMisses;    /*!<Number of outgoing items that had to be fetched on demand*/
+    QList<MessageStatistics>    iMessages;          /*!<Messages in the order they were handled*/
+
+    SessionStatistics() : iBytesSent( 0 ), iBytesReceived( 0 ), iMessagesSent( 0 ),
+                          iMessagesReceived( 0 ), iSuppressedReplaces( 0 ),
+                          iPrefetchHits( 0 ), iPrefetchMisses( 0 ) { }
+
+};
+
 /*! \brief Class for retrieving results of sync session
  *
  */
@@ -132,12 +187,25 @@ public:
                            DataSync::ModifiedDatabase aModifiedDatabase,
                            const QString& aDatabase );
 
+    /*! \brief Returns timing and byte statistics of the sync session
+     *
+     * @return Session statistics
+     */
+    const SessionStatistics& getStatistics() const;
+
+    /*! \brief Sets timing and byte statistics of the sync session
+     *
+     * @param aStatistics Session statistics
+     */
+    void setStatistics( const SessionStatistics& aStatistics );
+
 private:
 
     SyncState                       iState;
     QString                         iErrorString;
     QString                         iRemoteId;
     QMap<QString, DatabaseResults>  iResults;
+    SessionStatistics               iStatistics;
 
 };
 
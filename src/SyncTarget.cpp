@@ -34,9 +34,12 @@
 #include "SyncTarget.h"
 
 #include "ChangeLog.h"
+#include "SuspendLog.h"
+#include "ItemMatcher.h"
 #include "StoragePlugin.h"
 #include "SyncItem.h"
 #include "DatabaseHandler.h"
+#include "ConflictResolver.h"
 
 #include "SyncMLLogging.h"
 
@@ -45,11 +48,18 @@ using namespace DataSync;
 SyncTarget::SyncTarget( ChangeLog* aChangeLog, StoragePlugin* aPlugin,
                         const SyncMode& aSyncMode, const QString& aLocalNextAnchor ) :
     iChangeLog( aChangeLog ),
+    iSuspendLog( NULL ),
+    iItemMatcher( NULL ),
+    iConflictResolver( NULL ),
     iPlugin( aPlugin ),
     iSyncMode( aSyncMode ),
     iLocalNextAnchor( aLocalNextAnchor ),
     iReverted( false ),
-    iLocalChangesDiscovered( false )
+    iLocalChangesDiscovered( false ),
+    iResuming( false ),
+    iFingerprintsEnabled( false ),
+    iFingerprintsCalculated( false ),
+    iReplaceSuppression( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -58,9 +68,18 @@ SyncTarget::~SyncTarget()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    delete iConflictResolver;
+    iConflictResolver = NULL;
+
     delete iChangeLog;
     iChangeLog = NULL;
 
+    delete iSuspendLog;
+    iSuspendLog = NULL;
+
+    delete iItemMatcher;
+    iItemMatcher = NULL;
+
 }
 
 QString SyncTarget::getSourceDatabase() const
@@ -167,6 +186,10 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
 
     bool success = false;
 
+    // Resolver refers to the previous changes
+    delete iConflictResolver;
+    iConflictResolver = NULL;
+
     iLocalChanges.added.clear();
     iLocalChanges.modified.clear();
     iLocalChanges.removed.clear();
@@ -176,6 +199,12 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
 
     SyncDirection direction = iSyncMode.syncDirection();
 
+    if( iReplaceSuppression && !iFingerprintsEnabled && iSyncMode.syncType() != TYPE_FAST ) {
+        // Mappings are not kept over slow and refresh syncs, so neither are
+        // the fingerprints of the exchanged items
+        iFingerprints.clear();
+    }
+
     if( direction == DIRECTION_TWO_WAY ||
         ( aRole == ROLE_CLIENT && direction == DIRECTION_FROM_CLIENT ) ||
         ( aRole == ROLE_SERVER && direction == DIRECTION_FROM_SERVER ) ) {
@@ -206,7 +235,12 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
             qCDebug(lcSyncML) << "Getting modifications after: " << time;
 
             if (iPlugin != NULL) {
-                if( time.toString().isEmpty() )
+                if( iFingerprintsEnabled && !iChangeLog->getFingerprints().isEmpty() )
+                {
+                    qCDebug(lcSyncML) << "Detecting modifications by item fingerprints";
+                    success = discoverChangesByFingerprints();
+                }
+                else if( time.toString().isEmpty() )
                 {
                     qCDebug(lcSyncML) << "Getting All modifications for a 1st time fast sync req";
                     success = iPlugin->getAll( iLocalChanges.added );
@@ -228,6 +262,11 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
         success = true;
     }
 
+    if( success && iResuming ) {
+        qCDebug(lcSyncML) << "Resuming session, leaving out items already processed by remote device";
+        removeProcessedItems();
+    }
+
     qCDebug(lcSyncML) << "Number of items added: " << iLocalChanges.added.count();
     qCDebug(lcSyncML) << "Number of items modified: " << iLocalChanges.modified.count();
     qCDebug(lcSyncML) << "Number of items deleted: " << iLocalChanges.removed.count();
@@ -255,7 +294,11 @@ StoragePlugin* SyncTarget::getPlugin() const
 
 void SyncTarget::addUIDMapping( const UIDMapping& aMapping )
 {
-    iUIDMappings.append( aMapping );
+    iUIDMappings.add( aMapping );
+
+    if( iSuspendLog ) {
+        iSuspendLog->addMapping( aMapping );
+    }
 }
 
 
@@ -263,11 +306,10 @@ void SyncTarget::removeUIDMapping( const SyncItemKey& aLocalKey )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    for( int i = 0; i < iUIDMappings.count(); ++i ) {
-        if( iUIDMappings[i].iLocalUID == aLocalKey ) {
-            iUIDMappings.removeAt( i );
-            break;
-        }
+    if( iUIDMappings.removeByLocalUID( aLocalKey ) && iSuspendLog ) {
+        UIDMapping mapping;
+        mapping.iLocalUID = aLocalKey;
+        iSuspendLog->addMapping( mapping );
     }
 }
 
@@ -275,14 +317,7 @@ SyncItemKey SyncTarget::mapToLocalUID( const QString& aRemoteKey ) const
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    SyncItemKey localUID;
-
-    for( int i = 0; i < iUIDMappings.count(); ++i ) {
-        if( iUIDMappings[i].iRemoteUID == aRemoteKey ) {
-            localUID = iUIDMappings[i].iLocalUID;
-            break;
-        }
-    }
+    SyncItemKey localUID = iUIDMappings.localUID( aRemoteKey );
 
     if( localUID.isEmpty() ) {
         qCDebug(lcSyncML) << "Warning: no existing mapping found for remote key" << aRemoteKey;
@@ -295,25 +330,17 @@ QString SyncTarget::mapToRemoteUID( const SyncItemKey& aLocalUID ) const
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    QString remoteUID;
-
-    for( int i = 0; i < iUIDMappings.count(); ++i ) {
-        if( iUIDMappings[i].iLocalUID == aLocalUID ) {
-            remoteUID = iUIDMappings[i].iRemoteUID;
-            break;
-        }
-    }
-    return remoteUID;
+    return iUIDMappings.remoteUID( aLocalUID );
 }
 
 void SyncTarget::loadUIDMappings()
 {
-    iUIDMappings = iChangeLog->getMaps();
+    iUIDMappings.set( iChangeLog->getMaps() );
 }
 
 const QList<UIDMapping>& SyncTarget::getUIDMappings() const
 {
-    return iUIDMappings;
+    return iUIDMappings.mappings();
 }
 
 void SyncTarget::clearUIDMappings()
@@ -328,11 +355,398 @@ void SyncTarget::saveSession( DatabaseHandler& aDbHandler, const QDateTime& aSyn
     iChangeLog->setLastLocalAnchor( iLocalNextAnchor );
     iChangeLog->setLastRemoteAnchor( iRemoteNextAnchor );
     iChangeLog->setLastSyncTime( aSyncEndTime );
-    iChangeLog->setMaps( iUIDMappings );
+    iChangeLog->setMaps( iUIDMappings.mappings() );
+
+    if( iFingerprintsEnabled || iReplaceSuppression ) {
+        updateFingerprints();
+        iChangeLog->setFingerprints( iFingerprints );
+    }
+
+    // Change log and suspend log of the target are written in one transaction
+    bool transaction = DatabaseHandler::beginTransaction( aDbHandler.getDbHandle() );
 
     if( !iChangeLog->save( aDbHandler.getDbHandle() ) ) {
         qCWarning(lcSyncML) << "Could not save information to persistent storage!";
     }
 
+    // Session completed, so there is nothing left to resume
+    if( iSuspendLog && !iSuspendLog->remove( aDbHandler.getDbHandle() ) ) {
+        qCWarning(lcSyncML) << "Could not remove suspend log from persistent storage!";
+    }
+
+    if( transaction && !DatabaseHandler::commitTransaction( aDbHandler.getDbHandle() ) ) {
+        qCWarning(lcSyncML) << "Could not save session information of" << getSourceDatabase()
+                            << "to persistent storage!";
+    }
+
+}
+
+void SyncTarget::setSuspendLog( SuspendLog* aSuspendLog )
+{
+    delete iSuspendLog;
+    iSuspendLog = aSuspendLog;
 }
 
+bool SyncTarget::resumeSession()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iSuspendLog || !iSuspendLog->isSuspended() ) {
+        return false;
+    }
+
+    if( iSuspendLog->getTargetDatabase() != iTargetDatabase ) {
+        qCDebug(lcSyncML) << "Suspended session was with database" << iSuspendLog->getTargetDatabase()
+                          << ", not resuming";
+        return false;
+    }
+
+    SyncMode syncMode( iSuspendLog->getSyncMode() );
+
+    if( !syncMode.isValid() ) {
+        qCWarning(lcSyncML) << "Invalid sync mode in suspend log:" << iSuspendLog->getSyncMode();
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "Resuming suspended session of database" << getSourceDatabase();
+
+    iSyncMode = syncMode;
+    iLocalNextAnchor = iSuspendLog->getLocalNextAnchor();
+    iRemoteNextAnchor = iSuspendLog->getRemoteNextAnchor();
+
+    // Mappings of the suspended session are the mappings it started with and
+    // the changes made to them during the session
+    if( iSyncMode.syncType() == TYPE_FAST ) {
+        loadUIDMappings();
+    }
+    else {
+        clearUIDMappings();
+    }
+
+    const QList<UIDMapping>& mappings = iSuspendLog->getMappings();
+
+    for( int i = 0; i < mappings.count(); ++i ) {
+        if( mappings[i].iRemoteUID.isEmpty() ) {
+            iUIDMappings.removeByLocalUID( mappings[i].iLocalUID );
+        }
+        else {
+            iUIDMappings.add( mappings[i] );
+        }
+    }
+
+    iResuming = true;
+
+    return true;
+}
+
+bool SyncTarget::resuming() const
+{
+    return iResuming;
+}
+
+void SyncTarget::cancelResume( DatabaseHandler& aDbHandler )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iResuming ) {
+        qCDebug(lcSyncML) << "Cancelling resume of database" << getSourceDatabase();
+        iResuming = false;
+
+        if( !iSuspendLog->remove( aDbHandler.getDbHandle() ) ) {
+            qCWarning(lcSyncML) << "Could not remove suspend log from persistent storage!";
+        }
+    }
+}
+
+void SyncTarget::addProcessedItem( const SyncItemKey& aKey )
+{
+    if( iSuspendLog ) {
+        iSuspendLog->addProcessedItem( aKey, iSentFingerprints.value( aKey ) );
+    }
+}
+
+void SyncTarget::suspendSession( DatabaseHandler& aDbHandler )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iSuspendLog ) {
+        return;
+    }
+
+    iSuspendLog->setSession( iTargetDatabase, iSyncMode.toSyncMLCode(),
+                             iLocalNextAnchor, iRemoteNextAnchor );
+
+    if( !iSuspendLog->save( aDbHandler.getDbHandle() ) ) {
+        qCWarning(lcSyncML) << "Could not save suspend log to persistent storage!";
+    }
+}
+
+void SyncTarget::removeProcessedItems()
+{
+    const QHash<SyncItemKey, QByteArray>& processed = iSuspendLog->getProcessedItems();
+
+    // Items changed after the remote device processed them must be sent
+    // again, so compare the sent content to the current one
+    QList<SyncItemKey> keys;
+
+    for( int i = 0; i < iLocalChanges.added.count(); ++i ) {
+        if( processed.contains( iLocalChanges.added[i] ) ) {
+            keys.append( iLocalChanges.added[i] );
+        }
+    }
+
+    for( int i = 0; i < iLocalChanges.modified.count(); ++i ) {
+        if( processed.contains( iLocalChanges.modified[i] ) ) {
+            keys.append( iLocalChanges.modified[i] );
+        }
+    }
+
+    QHash<SyncItemKey, QByteArray> current;
+
+    if( iFingerprintsCalculated ) {
+        for( int i = 0; i < keys.count(); ++i ) {
+            current.insert( keys[i], iFingerprints.value( keys[i] ) );
+        }
+    }
+    else {
+        calculateFingerprints( keys, current );
+    }
+
+    removeUnchangedItems( iLocalChanges.added, current );
+    removeUnchangedItems( iLocalChanges.modified, current );
+
+    // Deleted item was processed if it was deleted when sent, otherwise it
+    // was deleted after the remote device processed it
+    QList<SyncItemKey> removed;
+    removed.reserve( iLocalChanges.removed.count() );
+
+    for( int i = 0; i < iLocalChanges.removed.count(); ++i ) {
+        QHash<SyncItemKey, QByteArray>::const_iterator fingerprint =
+            processed.constFind( iLocalChanges.removed[i] );
+
+        if( fingerprint == processed.constEnd() || !fingerprint.value().isEmpty() ) {
+            removed.append( iLocalChanges.removed[i] );
+        }
+    }
+
+    iLocalChanges.removed.swap( removed );
+}
+
+void SyncTarget::removeUnchangedItems( QList<SyncItemKey>& aItems,
+                                       const QHash<SyncItemKey, QByteArray>& aFingerprints ) const
+{
+    const QHash<SyncItemKey, QByteArray>& processed = iSuspendLog->getProcessedItems();
+
+    QList<SyncItemKey> remaining;
+    remaining.reserve( aItems.count() );
+
+    for( int i = 0; i < aItems.count(); ++i ) {
+        QHash<SyncItemKey, QByteArray>::const_iterator fingerprint = processed.constFind( aItems[i] );
+
+        // Items without a known fingerprint are sent again
+        if( fingerprint == processed.constEnd() || fingerprint.value().isEmpty() ||
+            fingerprint.value() != aFingerprints.value( aItems[i] ) ) {
+            remaining.append( aItems[i] );
+        }
+    }
+
+    aItems.swap( remaining );
+}
+
+void SyncTarget::enableFingerprints()
+{
+    iFingerprintsEnabled = true;
+}
+
+void SyncTarget::addCommittedItem( const SyncItemKey& aKey )
+{
+    if( iFingerprintsEnabled || iReplaceSuppression ) {
+        iCommittedItems.insert( aKey );
+    }
+}
+
+void SyncTarget::enableReplaceSuppression()
+{
+    iReplaceSuppression = true;
+
+    if( !iFingerprintsCalculated ) {
+        iFingerprints = iChangeLog->getFingerprints();
+    }
+}
+
+bool SyncTarget::replaceSuppression() const
+{
+    return iReplaceSuppression;
+}
+
+bool SyncTarget::isUnchanged( const SyncItemKey& aKey, const QByteArray& aFingerprint ) const
+{
+    if( aFingerprint.isEmpty() ) {
+        return false;
+    }
+
+    // Compared to the fingerprints of previous sync, as the fingerprints of
+    // this session are updated as items are exchanged
+    return ( iChangeLog->getFingerprints().value( aKey ) == aFingerprint );
+}
+
+bool SyncTarget::recordsSentItems() const
+{
+    return ( iReplaceSuppression || iSuspendLog != NULL );
+}
+
+void SyncTarget::addSentFingerprint( const SyncItemKey& aKey, const QByteArray& aFingerprint )
+{
+    iSentFingerprints.insert( aKey, aFingerprint );
+}
+
+void SyncTarget::confirmSentItem( const SyncItemKey& aKey )
+{
+    QHash<SyncItemKey, QByteArray>::iterator i = iSentFingerprints.find( aKey );
+
+    if( i == iSentFingerprints.end() ) {
+        return;
+    }
+
+    if( i.value().isEmpty() ) {
+        iFingerprints.remove( aKey );
+    }
+    else {
+        iFingerprints.insert( aKey, i.value() );
+    }
+
+    iSentFingerprints.erase( i );
+}
+
+void SyncTarget::setItemMatcher( ItemMatcher* aItemMatcher )
+{
+    delete iItemMatcher;
+    iItemMatcher = aItemMatcher;
+}
+
+ItemMatcher* SyncTarget::getItemMatcher() const
+{
+    return iItemMatcher;
+}
+
+ConflictResolver& SyncTarget::getConflictResolver( ConflictResolutionPolicy aPolicy )
+{
+    if( !iConflictResolver ) {
+        iConflictResolver = new ConflictResolver( iLocalChanges, aPolicy );
+    }
+
+    return *iConflictResolver;
+}
+
+bool SyncTarget::discoverChangesByFingerprints()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<SyncItemKey> keys;
+
+    if( !iPlugin->getAll( keys ) ) {
+        return false;
+    }
+
+    iFingerprints.clear();
+    calculateFingerprints( keys, iFingerprints );
+
+    const QHash<SyncItemKey, QByteArray>& previous = iChangeLog->getFingerprints();
+    QSet<SyncItemKey> current;
+    current.reserve( keys.count() );
+
+    for( int i = 0; i < keys.count(); ++i ) {
+        QHash<SyncItemKey, QByteArray>::const_iterator fingerprint = previous.constFind( keys[i] );
+
+        // Items whose fingerprint could not be calculated are reported as changed
+        if( fingerprint == previous.constEnd() ) {
+            iLocalChanges.added.append( keys[i] );
+        }
+        else if( fingerprint.value() != iFingerprints.value( keys[i] ) ) {
+            iLocalChanges.modified.append( keys[i] );
+        }
+
+        current.insert( keys[i] );
+    }
+
+    QHashIterator<SyncItemKey, QByteArray> i( previous );
+    while( i.hasNext() ) {
+        i.next();
+
+        if( !current.contains( i.key() ) ) {
+            iLocalChanges.removed.append( i.key() );
+        }
+    }
+
+    iFingerprintsCalculated = true;
+
+    return true;
+}
+
+void SyncTarget::updateFingerprints()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iPlugin ) {
+        return;
+    }
+
+    if( iFingerprintsCalculated || !iFingerprintsEnabled ) {
+        // Fingerprints are up to date apart from the items changed by the
+        // remote device during the session
+        QList<SyncItemKey> keys = iCommittedItems.toList();
+
+        for( int i = 0; i < keys.count(); ++i ) {
+            iFingerprints.remove( keys[i] );
+        }
+
+        calculateFingerprints( keys, iFingerprints );
+    }
+    else {
+        QList<SyncItemKey> keys;
+
+        iFingerprints.clear();
+
+        if( iPlugin->getAll( keys ) ) {
+            calculateFingerprints( keys, iFingerprints );
+        }
+    }
+
+    iCommittedItems.clear();
+    iSentFingerprints.clear();
+    iFingerprintsCalculated = true;
+}
+
+void SyncTarget::calculateFingerprints( const QList<SyncItemKey>& aKeys,
+                                        QHash<SyncItemKey, QByteArray>& aFingerprints )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Fetch the items in batches to limit the number of items in memory
+    const int batchSize = 50;
+
+    for( int i = 0; i < aKeys.count(); i += batchSize ) {
+
+        QList<SyncItem*> items = iPlugin->getSyncItems( aKeys.mid( i, batchSize ) );
+
+        for( int j = 0; j < items.count(); ++j ) {
+
+            // Deleted items are not returned, so they are left without
+            // a fingerprint
+            if( !items[j] ) {
+                continue;
+            }
+
+            QByteArray fingerprint = items[j]->getFingerprint();
+
+            if( !fingerprint.isEmpty() ) {
+                aFingerprints.insert( *items[j]->getKey(), fingerprint );
+            }
+
+        }
+
+        qDeleteAll( items );
+    }
+
+    qCDebug(lcSyncML) << "Calculated fingerprints of" << aFingerprints.count() << "items";
+}
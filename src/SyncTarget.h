@@ -34,10 +34,14 @@
 #ifndef SYNCTARGET_H
 #define SYNCTARGET_H
 
+#include <QHash>
+#include <QSet>
+
 #include "SyncMode.h"
 #include "SyncAgentConsts.h"
 #include "SyncMLGlobals.h"
 #include "LocalChanges.h"
+#include "UIDMappingStore.h"
 #include "datatypes.h"
 
 
@@ -45,6 +49,9 @@ namespace DataSync {
 
 class StoragePlugin;
 class ChangeLog;
+class SuspendLog;
+class ItemMatcher;
+class ConflictResolver;
 class DatabaseHandler;
 class SyncTargetTest;
 
@@ -235,12 +242,161 @@ public:
      * @param aSyncEndTime Time of the end of sync
      */
     void saveSession( DatabaseHandler& aDbHandler, const QDateTime& aSyncEndTime );
-    
+
+    /*! \brief Sets the suspend log to record the progress of the session to
+     *
+     * Without a suspend log the session of the target cannot be resumed.
+     *
+     * @param aSuspendLog Suspend log. SyncTarget takes ownership.
+     */
+    void setSuspendLog( SuspendLog* aSuspendLog );
+
+    /*! \brief Resumes the session stored in the suspend log
+     *
+     * Restores the sync mode, anchors and ID mappings of the suspended
+     * session. Items already processed by the remote device are left out
+     * when local changes are discovered, unless they have changed since.
+     *
+     * @return True if a suspended session with the target database was found, otherwise false
+     */
+    bool resumeSession();
+
+    /*! \brief Returns whether the target is resuming a suspended session
+     *
+     * @return True if resuming, otherwise false
+     */
+    bool resuming() const;
+
+    /*! \brief Cancels resuming of the suspended session
+     *
+     * The suspended session is removed from persistent storage, and the
+     * session continues as a new one.
+     *
+     * @param aDbHandler Database handler
+     */
+    void cancelResume( DatabaseHandler& aDbHandler );
+
+    /*! \brief Records a local item as processed by the remote device
+     *
+     * @param aKey Key of the item
+     */
+    void addProcessedItem( const SyncItemKey& aKey );
+
+    /*! \brief Saves the progress of the session to the suspend log
+     *
+     * @param aDbHandler Database handler
+     */
+    void suspendSession( DatabaseHandler& aDbHandler );
+
+    /*! \brief Enables detection of local changes by item fingerprints
+     *
+     * In fast sync, local changes are detected by comparing the fingerprints
+     * of the items to the fingerprints stored in the change log after the
+     * previous successful sync. Fingerprints must have been loaded to the
+     * change log. If there are no stored fingerprints, modifications are
+     * queried from the storage plugin as usual.
+     */
+    void enableFingerprints();
+
+    /*! \brief Records a local item as changed by the remote device
+     *
+     * Fingerprints of the changed items are updated when the session is saved
+     *
+     * @param aKey Key of the item
+     */
+    void addCommittedItem( const SyncItemKey& aKey );
+
+    /*! \brief Enables leaving out Replace commands of unchanged items
+     *
+     * Fingerprints of the items exchanged with the remote device are kept in
+     * the change log, and modified items whose fingerprint has not changed
+     * since are not sent. Fingerprints must have been loaded to the change
+     * log.
+     */
+    void enableReplaceSuppression();
+
+    /*! \brief Returns whether Replace commands of unchanged items are left out
+     *
+     * @return True if Replace commands are left out, otherwise false
+     */
+    bool replaceSuppression() const;
+
+    /*! \brief Checks whether the content of an item is unchanged since previous sync
+     *
+     * @param aKey Key of the item
+     * @param aFingerprint Current fingerprint of the item
+     * @return True if the fingerprint matches the one stored after previous sync, otherwise false
+     */
+    bool isUnchanged( const SyncItemKey& aKey, const QByteArray& aFingerprint ) const;
+
+    /*! \brief Returns whether fingerprints of sent items need to be recorded
+     *
+     * Fingerprints are needed for leaving out unchanged items, and for
+     * recording the content of processed items in the suspend log.
+     *
+     * @return True if sent items should be recorded with addSentFingerprint(), otherwise false
+     */
+    bool recordsSentItems() const;
+
+    /*! \brief Records the fingerprint of an item sent to the remote device
+     *
+     * Fingerprint is taken into use when the remote device acknowledges
+     * the item with confirmSentItem().
+     *
+     * @param aKey Key of the item
+     * @param aFingerprint Fingerprint of the item, or empty if the item was deleted
+     */
+    void addSentFingerprint( const SyncItemKey& aKey, const QByteArray& aFingerprint );
+
+    /*! \brief Records a sent item as successfully processed by the remote device
+     *
+     * @param aKey Key of the item
+     */
+    void confirmSentItem( const SyncItemKey& aKey );
+
+    /*! \brief Sets the matcher to match items added by the remote device to
+     *         existing local items
+     *
+     * @param aItemMatcher Item matcher. SyncTarget takes ownership.
+     */
+    void setItemMatcher( ItemMatcher* aItemMatcher );
+
+    /*! \brief Returns the matcher of items added by the remote device
+     *
+     * @return Item matcher, or NULL if items are not matched
+     */
+    ItemMatcher* getItemMatcher() const;
+
+    /*! \brief Returns the conflict resolver of the local changes
+     *
+     * Resolver is created on first call and kept until local changes are
+     * discovered again, so the local changes are hashed once per sync
+     *
+     * @param aPolicy Conflict resolution policy
+     * @return Conflict resolver
+     */
+    ConflictResolver& getConflictResolver( ConflictResolutionPolicy aPolicy );
+
 protected:
 
 private:
 
+    void removeProcessedItems();
+
+    void removeUnchangedItems( QList<SyncItemKey>& aItems,
+                               const QHash<SyncItemKey, QByteArray>& aFingerprints ) const;
+
+    bool discoverChangesByFingerprints();
+
+    void updateFingerprints();
+
+    void calculateFingerprints( const QList<SyncItemKey>& aKeys,
+                                QHash<SyncItemKey, QByteArray>& aFingerprints );
+
     ChangeLog*          iChangeLog;
+    SuspendLog*         iSuspendLog;
+    ItemMatcher*        iItemMatcher;
+    ConflictResolver*   iConflictResolver;
 
     StoragePlugin*      iPlugin;
     QString             iTargetDatabase;
@@ -251,10 +407,18 @@ private:
     QString             iRemoteNextAnchor;
 
     LocalChanges        iLocalChanges;
-    QList<UIDMapping>   iUIDMappings;
+    UIDMappingStore     iUIDMappings;
 
     bool                iReverted;
     bool                iLocalChangesDiscovered;
+    bool                iResuming;
+
+    bool                iFingerprintsEnabled;
+    bool                iFingerprintsCalculated;
+    bool                iReplaceSuppression;
+    QHash<SyncItemKey, QByteArray> iFingerprints;
+    QSet<SyncItemKey>   iCommittedItems;
+    QHash<SyncItemKey, QByteArray> iSentFingerprints;
 
     friend class SyncTargetTest;
 
@@ -0,0 +1,230 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "UIDMappingStore.h"
+
+using namespace DataSync;
+
+UIDMappingStore::UIDMappingStore()
+ : iUnusedCount( 0 )
+{
+}
+
+UIDMappingStore::~UIDMappingStore()
+{
+}
+
+void UIDMappingStore::add( const UIDMapping& aMapping )
+{
+    iMappings.append( aMapping );
+    iUsed.append( true );
+    index( iMappings.count() - 1 );
+}
+
+bool UIDMappingStore::removeByLocalUID( const SyncItemKey& aLocalUID )
+{
+    QHash<SyncItemKey, int>::iterator i = iLocalIndex.find( aLocalUID );
+
+    if( i == iLocalIndex.end() ) {
+        return false;
+    }
+
+    int slot = i.value();
+    iLocalIndex.erase( i );
+    iUsed[slot] = false;
+    ++iUnusedCount;
+
+    // Another mapping with the same UID might need to become visible
+    int duplicate = takeDuplicate( iLocalDuplicates, aLocalUID );
+    if( duplicate >= 0 ) {
+        iLocalIndex.insert( aLocalUID, duplicate );
+    }
+
+    const QString& remoteUID = iMappings[slot].iRemoteUID;
+    QHash<QString, int>::iterator j = iRemoteIndex.find( remoteUID );
+    if( j != iRemoteIndex.end() && j.value() == slot ) {
+
+        duplicate = takeDuplicate( iRemoteDuplicates, remoteUID );
+
+        if( duplicate >= 0 ) {
+            j.value() = duplicate;
+        }
+        else {
+            iRemoteIndex.erase( j );
+        }
+    }
+
+    if( iUnusedCount > iMappings.count() / 2 ) {
+        compact();
+    }
+
+    return true;
+}
+
+SyncItemKey UIDMappingStore::localUID( const QString& aRemoteUID ) const
+{
+    int slot = iRemoteIndex.value( aRemoteUID, -1 );
+
+    if( slot >= 0 ) {
+        return iMappings[slot].iLocalUID;
+    }
+    else {
+        return SyncItemKey();
+    }
+}
+
+QString UIDMappingStore::remoteUID( const SyncItemKey& aLocalUID ) const
+{
+    int slot = iLocalIndex.value( aLocalUID, -1 );
+
+    if( slot >= 0 ) {
+        return iMappings[slot].iRemoteUID;
+    }
+    else {
+        return QString();
+    }
+}
+
+void UIDMappingStore::set( const QList<UIDMapping>& aMappings )
+{
+    iMappings = aMappings;
+    iUsed.fill( true, iMappings.count() );
+    iUnusedCount = 0;
+    reindex();
+}
+
+const QList<UIDMapping>& UIDMappingStore::mappings() const
+{
+    compact();
+    return iMappings;
+}
+
+int UIDMappingStore::count() const
+{
+    return iMappings.count() - iUnusedCount;
+}
+
+void UIDMappingStore::clear()
+{
+    iMappings.clear();
+    iUsed.clear();
+    iUnusedCount = 0;
+    iRemoteIndex.clear();
+    iLocalIndex.clear();
+    iRemoteDuplicates.clear();
+    iLocalDuplicates.clear();
+}
+
+void UIDMappingStore::index( int aSlot ) const
+{
+    const UIDMapping& mapping = iMappings[aSlot];
+
+    // Earlier mappings take precedence
+    if( iRemoteIndex.contains( mapping.iRemoteUID ) ) {
+        iRemoteDuplicates[mapping.iRemoteUID].append( aSlot );
+    }
+    else {
+        iRemoteIndex.insert( mapping.iRemoteUID, aSlot );
+    }
+
+    if( iLocalIndex.contains( mapping.iLocalUID ) ) {
+        iLocalDuplicates[mapping.iLocalUID].append( aSlot );
+    }
+    else {
+        iLocalIndex.insert( mapping.iLocalUID, aSlot );
+    }
+}
+
+template<typename Key>
+int UIDMappingStore::takeDuplicate( QHash<Key, QList<int> >& aDuplicates, const Key& aUID ) const
+{
+    typename QHash<Key, QList<int> >::iterator i = aDuplicates.find( aUID );
+
+    if( i == aDuplicates.end() ) {
+        return -1;
+    }
+
+    int slot = -1;
+
+    while( slot < 0 && !i.value().isEmpty() ) {
+        int candidate = i.value().takeFirst();
+
+        if( iUsed[candidate] ) {
+            slot = candidate;
+        }
+    }
+
+    if( i.value().isEmpty() ) {
+        aDuplicates.erase( i );
+    }
+
+    return slot;
+}
+
+void UIDMappingStore::reindex() const
+{
+    iRemoteIndex.clear();
+    iLocalIndex.clear();
+    iRemoteDuplicates.clear();
+    iLocalDuplicates.clear();
+
+    iRemoteIndex.reserve( iMappings.count() );
+    iLocalIndex.reserve( iMappings.count() );
+
+    for( int i = 0; i < iMappings.count(); ++i ) {
+        if( iUsed[i] ) {
+            index( i );
+        }
+    }
+}
+
+void UIDMappingStore::compact() const
+{
+    if( iUnusedCount == 0 ) {
+        return;
+    }
+
+    QList<UIDMapping> mappings;
+    mappings.reserve( iMappings.count() - iUnusedCount );
+
+    for( int i = 0; i < iMappings.count(); ++i ) {
+        if( iUsed[i] ) {
+            mappings.append( iMappings[i] );
+        }
+    }
+
+    iMappings = mappings;
+    iUsed.fill( true, iMappings.count() );
+    iUnusedCount = 0;
+    reindex();
+}
@@ -0,0 +1,148 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef UIDMAPPINGSTORE_H
+#define UIDMAPPINGSTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "SyncMLGlobals.h"
+
+namespace DataSync {
+
+/*! \brief Container for UID mappings of a sync target
+ *
+ * Mappings are indexed both by remote and local UID so that lookups and
+ * removals do not depend on the number of mappings. Insertion order of the
+ * mappings is preserved. If the same UID is mapped more than once, lookups
+ * return the mapping that was added first.
+ */
+class UIDMappingStore
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    UIDMappingStore();
+
+    /*! \brief Destructor
+     *
+     */
+    ~UIDMappingStore();
+
+    /*! \brief Adds a mapping
+     *
+     * @param aMapping Mapping to add
+     */
+    void add( const UIDMapping& aMapping );
+
+    /*! \brief Removes a mapping
+     *
+     * @param aLocalUID Local UID of the mapping to remove
+     * @return True if mapping was found and removed, otherwise false
+     */
+    bool removeByLocalUID( const SyncItemKey& aLocalUID );
+
+    /*! \brief Maps a remote UID to local UID
+     *
+     * @param aRemoteUID Remote UID
+     * @return Local UID if found, otherwise empty
+     */
+    SyncItemKey localUID( const QString& aRemoteUID ) const;
+
+    /*! \brief Maps a local UID to remote UID
+     *
+     * @param aLocalUID Local UID
+     * @return Remote UID if found, otherwise empty
+     */
+    QString remoteUID( const SyncItemKey& aLocalUID ) const;
+
+    /*! \brief Replaces all mappings
+     *
+     * @param aMappings New mappings
+     */
+    void set( const QList<UIDMapping>& aMappings );
+
+    /*! \brief Returns all mappings in insertion order
+     *
+     * @return Mappings
+     */
+    const QList<UIDMapping>& mappings() const;
+
+    /*! \brief Returns the number of mappings
+     *
+     * @return Number of mappings
+     */
+    int count() const;
+
+    /*! \brief Removes all mappings
+     *
+     */
+    void clear();
+
+protected:
+
+private:
+
+    void index( int aSlot ) const;
+
+    void reindex() const;
+
+    template<typename Key>
+    int takeDuplicate( QHash<Key, QList<int> >& aDuplicates, const Key& aUID ) const;
+
+    void compact() const;
+
+    // Removed mappings are left in place as unused slots so that indices
+    // stored in the hashes stay valid. Slots are reclaimed in compact()
+    mutable QList<UIDMapping>       iMappings;
+    mutable QVector<bool>           iUsed;
+    mutable int                     iUnusedCount;
+
+    mutable QHash<QString, int>     iRemoteIndex;
+    mutable QHash<SyncItemKey, int> iLocalIndex;
+
+    // Slots of mappings hidden by an earlier mapping of the same UID, in
+    // insertion order. Removed slots are skipped when a hidden mapping is
+    // made visible
+    mutable QHash<QString, QList<int> >     iRemoteDuplicates;
+    mutable QHash<SyncItemKey, QList<int> > iLocalDuplicates;
+
+};
+
+}
+
+#endif  //  UIDMAPPINGSTORE_H
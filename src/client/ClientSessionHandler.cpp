@@ -50,7 +50,8 @@ using namespace DataSync;
 
 ClientSessionHandler::ClientSessionHandler( const SyncAgentConfig* aConfig, QObject* aParent )
  : SessionHandler(aConfig, ROLE_CLIENT, aParent),
-   iConfig(aConfig)
+   iConfig(aConfig),
+   iSuspendRequested(false)
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -257,21 +258,34 @@ void ClientSessionHandler::handleNotificationPackage( const SANDS& aData )
 
 void ClientSessionHandler::suspendSync()
 {
-	FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    SyncState syncState = getSyncState();
 
-	// @todo: existing implementation was considered flawed, reimplement to be working
-	// as soon as possible
-	Q_ASSERT( 0 );
+    // Only sessions that are exchanging items have progress worth storing
+    if( !resumableSessions() ||
+        ( syncState != SENDING_ITEMS && syncState != RECEIVING_ITEMS ) ) {
+        qCWarning(lcSyncML) << "Session cannot be suspended in state" << syncState;
+        return;
+    }
 
+    // We are waiting for a response from server, suspend alerts are sent
+    // in the next message
+    qCDebug(lcSyncML) << "Suspending session";
+    iSuspendRequested = true;
 }
 
 void ClientSessionHandler::resumeSync()
 {
-	FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-	// @todo: existing implementation was considered flawed, reimplement to be working
-	// as soon as possible
-	Q_ASSERT( 0 );
+    if( iSuspendRequested ) {
+        qCDebug(lcSyncML) << "Session not yet suspended, continuing";
+        iSuspendRequested = false;
+    }
+    else {
+        qCWarning(lcSyncML) << "Session is not suspended";
+    }
 }
 
 void ClientSessionHandler::messageReceived( HeaderParams& aHeaderParams )
@@ -348,6 +362,14 @@ ResponseStatusCode ClientSessionHandler::syncAlertReceived( const SyncMode& aSyn
 
 }
 
+ResponseStatusCode ClientSessionHandler::resumeAlertReceived( CommandParams& /*aAlertParams*/ )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Only client can resume a session
+    return COMMAND_NOT_ALLOWED;
+}
+
 bool ClientSessionHandler::syncReceived()
 {
 
@@ -422,6 +444,10 @@ void ClientSessionHandler::finalReceived()
             setSyncState( FINALIZING );
             break;
         }
+        case SUSPENDING:
+        {
+            break;
+        }
         default:
         {
             QString errorMsg;
@@ -436,6 +462,11 @@ void ClientSessionHandler::messageParsed()
 {
 	FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+	if( remoteSuspended() ) {
+		abortSync( SUSPENDED, "Session suspended by server" );
+		return;
+	}
+
 	// if we have 101 for SyncHdr Status in SyncBody
 	// send a result Alert
 	if( isRemoteBusyStatusSet()) {
@@ -445,6 +476,16 @@ void ClientSessionHandler::messageParsed()
 
 	SyncState syncState = getSyncState();
 
+	if( iSuspendRequested &&
+	    ( syncState == SENDING_ITEMS || syncState == RECEIVING_ITEMS ) ) {
+		iSuspendRequested = false;
+		composeSuspendPackage();
+		setSyncState( SUSPENDING );
+		sendNextMessage();
+		getTransport().receive();
+		return;
+	}
+
 	switch( syncState )
 	{
         case PREPARED:
@@ -478,6 +519,12 @@ void ClientSessionHandler::messageParsed()
             finishSync();
             break;
         }
+        case SUSPENDING:
+        {
+            // Server has acknowledged the suspension
+            abortSync( SUSPENDED, "Session suspended" );
+            break;
+        }
         default:
         {
             break;
@@ -646,10 +693,19 @@ ResponseStatusCode ClientSessionHandler::acknowledgeTarget( const SyncMode& aSyn
 	// client SHOULD follow sync mode given by server even if it is different than the
 	// sync mode sent by client.
 
+	// Server may decide to continue the suspended session with another sync mode,
+	// in which case progress of the suspended session is no longer valid
+	if( target->resuming() &&
+	    ( syncMode.syncType() != target->getSyncMode()->syncType() ||
+	      syncMode.syncDirection() != target->getSyncMode()->syncDirection() ) )
+	{
+	    target->cancelResume( getDatabaseHandler() );
+	}
+
 	// Explicitly order sync target to revert in case of slow sync, it is not enough
 	// to just set a new sync mode. Also we need to clear all mappings as they are now
-	// invalid
-	if( syncMode.syncType() != TYPE_FAST )
+	// invalid. Mappings of a resumed session are still valid
+	if( syncMode.syncType() != TYPE_FAST && !target->resuming() )
 	{
 	    qCDebug(lcSyncML) << "Server requested revertion to slow sync for database"
 	                << target->getSourceDatabase() <<", complying and clearing mappings";
@@ -686,8 +742,12 @@ void ClientSessionHandler::setupSyncTargets()
         if (target != NULL) {
             QString targetDb = iConfig->getTarget( sourceDb );
             target->setTargetDatabase( targetDb );
-            // Use slow sync if this is the preferred mode or if we don't have a last anchor
-            if (iConfig->getSyncMode().syncType() == TYPE_SLOW || target->getRemoteLastAnchor().isEmpty()) {
+            // Continue suspended session if there is one, otherwise use slow sync if this
+            // is the preferred mode or if we don't have a last anchor
+            if( target->resumeSession() ) {
+                qCDebug(lcSyncML) << "Found suspended session, resuming";
+            }
+            else if (iConfig->getSyncMode().syncType() == TYPE_SLOW || target->getRemoteLastAnchor().isEmpty()) {
                 qCDebug(lcSyncML) << "Did not find last remote anchor, forcing slow sync";
                 SyncMode* mode = target->getSyncMode();
                 mode->toSlowSync();
@@ -794,7 +854,8 @@ void ClientSessionHandler::composeClientInitialization()
     foreach( const SyncTarget* target, targets) {
 
         if (target != NULL) {
-            AlertPackage* package = new AlertPackage(  target->getSyncMode()->toSyncMLCode(),
+            qint32 alertCode = target->resuming() ? ALERT_RESUME : target->getSyncMode()->toSyncMLCode();
+            AlertPackage* package = new AlertPackage(  alertCode,
                                                        target->getSourceDatabase(),
                                                        target->getTargetDatabase(),
                                                        target->getLocalLastAnchor(),
@@ -818,6 +879,23 @@ void ClientSessionHandler::composeResultAlert()
 
 }
 
+void ClientSessionHandler::composeSuspendPackage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Items not yet sent are left for the resumed session
+    getResponseGenerator().clearPackageQueue();
+
+    const QList<SyncTarget*>& targets = getSyncTargets();
+
+    foreach( const SyncTarget* target, targets ) {
+        AlertPackage* package = new AlertPackage( ALERT_SUSPEND,
+                                                  target->getSourceDatabase(),
+                                                  target->getTargetDatabase() );
+        getResponseGenerator().addPackage( package );
+    }
+}
+
 void ClientSessionHandler::discoverClientLocalChanges()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -91,6 +91,8 @@ protected:
 
     virtual ResponseStatusCode syncAlertReceived( const SyncMode& aSyncMode, CommandParams& aAlertParams );
 
+    virtual ResponseStatusCode resumeAlertReceived( CommandParams& aAlertParams );
+
     virtual bool syncReceived();
 
     virtual bool mapReceived();
@@ -122,6 +124,8 @@ private:  // functions
 
     void composeResultAlert();
 
+    void composeSuspendPackage();
+
     QString convertSANURItoMIME( const QString& aServerURI );
 
     bool shouldSendDataUpdateStatus();
@@ -129,6 +133,7 @@ private:  // functions
 private: // data
 
     const DataSync::SyncAgentConfig*    iConfig;            ///< A pointer to configuration
+    bool                                iSuspendRequested;  ///< Set to true when session should be suspended
 
     friend class ::SessionHandlerTest;
     friend class ::ClientSessionHandlerTest;
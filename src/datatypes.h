@@ -307,6 +307,18 @@ namespace DataSync
     #define HTTP_UA_VALUE "libmeegosyncml"
     #define HTTP_HDRSTR_ACCEPT "Accept"
     #define HTTP_ACCEPT_VALUE  "*/*"
+    #define HTTP_HDRSTR_CONTENT_ENCODING "Content-Encoding"
+    #define HTTP_HDRSTR_ACCEPT_ENCODING "Accept-Encoding"
+    #define HTTP_CONTENT_ENCODING_GZIP "gzip"
+    #define HTTP_HDRSTR_CONTENT_LENGTH "Content-Length"
+    #define HTTP_HDRSTR_CONNECTION "Connection"
+    #define HTTP_STATUS_OK 200
+    #define HTTP_STATUS_BAD_REQUEST 400
+    #define HTTP_STATUS_METHOD_NOT_ALLOWED 405
+    #define HTTP_STATUS_LENGTH_REQUIRED 411
+    #define HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE 413
+    #define HTTP_STATUS_UNSUPPORTED_MEDIA_TYPE 415
+    #define HTTP_STATUS_SERVICE_UNAVAILABLE 503
 
     #define DEFAULT_MAX_CHANGES_TO_SEND 22
     #define DEFAULT_MAX_MESSAGESIZE     16384
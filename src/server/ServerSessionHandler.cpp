@@ -35,6 +35,7 @@
 #include "SyncAgentConfig.h"
 #include "StoragePlugin.h"
 #include "SyncTarget.h"
+#include "SuspendLog.h"
 #include "AlertPackage.h"
 #include "FinalPackage.h"
 #include "DevInfPackage.h"
@@ -83,8 +84,8 @@ void ServerSessionHandler::initiateSync()
     {
         const QString& sourceURI = sourceDbs[i];
         StorageContentFormatInfo info;
-        if( iConfig->getStorageProvider()->getStorageContentFormatInfo( sourceURI,
-                                                                        info ) )
+        if( iConfig->getStorageProvider()->getSessionStorageContentFormatInfo( sourceURI,
+                                                                               info, this ) )
         {
             QPair<QString, QString> storage;
             storage.first = sourceURI;
@@ -198,6 +199,31 @@ ResponseStatusCode ServerSessionHandler::syncAlertReceived( const SyncMode& aSyn
 
 }
 
+ResponseStatusCode ServerSessionHandler::resumeAlertReceived( CommandParams& aAlertParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    ResponseStatusCode status;
+
+    SyncState syncState = getSyncState();
+
+    if( syncState == PREPARED || syncState == REMOTE_INIT ) {
+
+        // Client is resuming a suspended session
+        status = resumeTargetByClient( aAlertParams );
+        setSyncState( REMOTE_INIT );
+
+    }
+    else {
+
+        // Don't allow sync related alerts outside init phase
+        status = COMMAND_NOT_ALLOWED;
+
+    }
+
+    return status;
+}
+
 bool ServerSessionHandler::syncReceived()
 {
 
@@ -350,6 +376,17 @@ void ServerSessionHandler::messageParsed()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    if( remoteSuspended() ) {
+
+        // Acknowledge the suspension, items not yet sent are left for the
+        // resumed session
+        getResponseGenerator().clearPackageQueue();
+        getResponseGenerator().addPackage( new FinalPackage() );
+        sendNextMessage();
+        abortSync( SUSPENDED, "Session suspended by client" );
+        return;
+    }
+
     SyncState syncState = getSyncState();
 
     switch( syncState )
@@ -536,6 +573,82 @@ ResponseStatusCode ServerSessionHandler::setupTargetByClient( const SyncMode& aS
 
 }
 
+ResponseStatusCode ServerSessionHandler::resumeTargetByClient( CommandParams& aAlertParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aAlertParams.items.isEmpty() )
+    {
+        qCWarning(lcSyncML) << "Received alert without any items! Cmd Id:" << aAlertParams.cmdId;
+        return INCOMPLETE_COMMAND;
+    }
+
+    const ItemParams& item = aAlertParams.items.first();
+    const MetaParams& meta = item.meta;
+    const AnchorParams& anchors = meta.anchor;
+    if( item.source.isEmpty() ||
+        anchors.next.isEmpty() ||
+        ( item.target.isEmpty() && meta.type.isEmpty() ) )
+    {
+        qCWarning(lcSyncML) << "Received alert that did not pass validation! Cmd Id:" << aAlertParams.cmdId;
+        return INCOMPLETE_COMMAND;
+    }
+
+    StoragePlugin* source = 0;
+
+    if( !item.target.isEmpty() ) {
+        source = createStorageByURI( item.target );
+    }
+    else if( !meta.type.isEmpty() ){
+        source = createStorageByMIME( meta.type );
+    }
+
+    if( !source ) {
+        return NOT_FOUND;
+    }
+
+    // Sync mode of the suspended session determines which change log the
+    // target uses, so it must be known before creating the target
+    SuspendLog* suspendLog = loadSuspendLog( *source );
+    SyncMode syncMode;
+
+    if( suspendLog && suspendLog->isSuspended() && SyncMode( suspendLog->getSyncMode() ).isValid() ) {
+        syncMode = SyncMode( suspendLog->getSyncMode() );
+    }
+
+    SyncTarget* target = createSyncTarget( *source, syncMode, suspendLog );
+
+    if( !target ) {
+        return COMMAND_FAILED;
+    }
+
+    target->setTargetDatabase( item.source );
+
+    if( target->resumeSession() &&
+        target->getRemoteNextAnchor() == anchors.next &&
+        !anchorMismatch( *target->getSyncMode(), *target, anchors.last ) )
+    {
+        qCDebug(lcSyncML) << "Resuming suspended session with database" << item.source;
+        addSyncTarget( target );
+        return SUCCESS;
+    }
+
+    // Suspended session does not match the one client is resuming, continue
+    // with a slow sync instead
+    qCDebug(lcSyncML) << "Could not resume session with database" << item.source << ", refresh required";
+    target->cancelResume( getDatabaseHandler() );
+
+    // Slow sync is set up with a target of its own. Release this one along
+    // with its change log and suspend log, unless the session already owns it
+    if( !getSyncTargets().contains( target ) ) {
+        delete target;
+    }
+
+    syncMode.toSlowSync();
+
+    return setupTargetByClient( syncMode, aAlertParams );
+
+}
 
 ResponseStatusCode ServerSessionHandler::acknowledgeTarget( const SyncMode& /*aSyncMode*/,
                                                             CommandParams& aAlertParams )
@@ -86,6 +86,8 @@ protected:
 
     virtual ResponseStatusCode syncAlertReceived( const SyncMode& aSyncMode, CommandParams& aAlertParams );
 
+    virtual ResponseStatusCode resumeAlertReceived( CommandParams& aAlertParams );
+
     virtual bool syncReceived();
 
     virtual bool mapReceived();
@@ -101,6 +103,8 @@ private:
 
     ResponseStatusCode setupTargetByClient( const SyncMode& aSyncMode, CommandParams& aAlertParams );
 
+    ResponseStatusCode resumeTargetByClient( CommandParams& aAlertParams );
+
     ResponseStatusCode acknowledgeTarget( const SyncMode& aSyncMode, CommandParams& aAlertParams );
 
     void composeSyncML11ServerAlertedSyncPackage( const QList< QPair<QString, QString> >& aStorages );
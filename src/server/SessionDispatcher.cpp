@@ -0,0 +1,405 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SessionDispatcher.h"
+
+#include "ServerSessionHandler.h"
+#include "RequestListener.h"
+#include "SyncAgentConfig.h"
+#include "SyncAgentConfigProperties.h"
+#include "TransportProvider.h"
+#include "Transport.h"
+#include "Fragments.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+// Default maximum number of sessions served concurrently
+static const int DEFAULT_MAX_SESSIONS = 16;
+
+SessionDispatcher::SessionDispatcher( QObject* aParent )
+ : QObject( aParent ), iConfig( 0 ), iProvider( 0 ), iListener( 0 ), iListenTransport( 0 ),
+   iMaxSessions( DEFAULT_MAX_SESSIONS ), iAborting( false ), iAbortState( ABORTED )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+SessionDispatcher::~SessionDispatcher()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    stopListener();
+
+    while( !iSessions.isEmpty() ) {
+        cleanSession( iSessions.first() );
+    }
+}
+
+bool SessionDispatcher::start( const SyncAgentConfig& aConfig )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !aConfig.getTransportProvider() ) {
+        qCCritical(lcSyncML) << "SessionDispatcher: Transport provider is NULL";
+        return false;
+    }
+
+    iConfig = &aConfig;
+    iProvider = aConfig.getTransportProvider();
+    iAborting = false;
+
+    iMaxSessions = DEFAULT_MAX_SESSIONS;
+
+    QString maxSessions = aConfig.getAgentProperty( MAXCONCURRENTSESSIONSPROP );
+    if( !maxSessions.isEmpty() && maxSessions.toInt() > 0 ) {
+        iMaxSessions = maxSessions.toInt();
+    }
+
+    qCDebug(lcSyncML) << "SessionDispatcher: Serving at most" << iMaxSessions << "concurrent sessions";
+
+    return startListener();
+}
+
+void SessionDispatcher::abort( DataSync::SyncState aState )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    stopListener();
+
+    iAborting = true;
+    iAbortState = aState;
+
+    for( int i = 0; i < iSessions.count(); ++i ) {
+        QMetaObject::invokeMethod( iSessions[i]->iHandler, "abortSync",
+                                   Q_ARG( DataSync::SyncState, aState ),
+                                   Q_ARG( QString, "User aborted synchronization" ) );
+    }
+}
+
+bool SessionDispatcher::isListening() const
+{
+    return iListener != NULL;
+}
+
+int SessionDispatcher::sessionCount() const
+{
+    return iSessions.count();
+}
+
+int SessionDispatcher::maxSessions() const
+{
+    return iMaxSessions;
+}
+
+void SessionDispatcher::listenEvent()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iListener ) {
+        return;
+    }
+
+    RequestListener::RequestData data = iListener->takeRequestData();
+    Transport* transport = iListenTransport;
+
+    iListener->stop();
+    iListener->deleteLater();
+    iListener = NULL;
+    iListenTransport = NULL;
+
+    if( data.iType != RequestListener::REQUEST_CLIENT ) {
+        qCWarning(lcSyncML) << "SessionDispatcher: Ignoring notification, only client requests are served";
+        qDeleteAll( data.iFragments );
+        transport->close();
+        startListener( transport );
+        return;
+    }
+
+    QString remoteDevice;
+
+    for( int i = 0; i < data.iFragments.count(); ++i ) {
+        if( data.iFragments[i]->fragmentType == Fragment::FRAGMENT_HEADER ) {
+            remoteDevice = static_cast<HeaderParams*>( data.iFragments[i] )->sourceDevice;
+            break;
+        }
+    }
+
+    if( isServing( remoteDevice ) ) {
+        qCWarning(lcSyncML) << "SessionDispatcher: Rejecting request, already serving a session for"
+                            << remoteDevice;
+        qDeleteAll( data.iFragments );
+        transport->close();
+        startListener( transport );
+        return;
+    }
+
+    startSession( transport, remoteDevice, data.iFragments );
+
+    if( iSessions.count() < iMaxSessions ) {
+        startListener();
+    }
+    else {
+        qCDebug(lcSyncML) << "SessionDispatcher: Maximum number of concurrent sessions reached";
+    }
+}
+
+void SessionDispatcher::listenError( DataSync::SyncState aState, QString aErrorString )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qCWarning(lcSyncML) << "SessionDispatcher: Error while listening for requests:" << aState << aErrorString;
+
+    if( iListenTransport ) {
+        iListenTransport->close();
+    }
+
+    stopListener();
+
+    if( !startListener() && iSessions.isEmpty() ) {
+        emit error( aState, aErrorString );
+    }
+}
+
+void SessionDispatcher::receiveStateChanged( DataSync::SyncState aState )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Session* session = findSession( sender() );
+
+    if( session ) {
+        session->iResults.setState( aState );
+    }
+}
+
+void SessionDispatcher::receiveSyncFinished( QString aRemoteDeviceId, DataSync::SyncState aState,
+                                             QString aErrorString )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Session* session = findSession( sender() );
+
+    if( !session ) {
+        return;
+    }
+
+    qCDebug(lcSyncML) << "SessionDispatcher: Session with" << aRemoteDeviceId << "finished with state:" << aState;
+
+    session->iResults.setRemoteDeviceId( aRemoteDeviceId );
+    session->iResults.setState( aState );
+    session->iResults.setErrorString( aErrorString );
+    session->iResults.setStatistics( session->iHandler->getStatistics() );
+
+    SyncResults results = session->iResults;
+
+    // Handler signals are queued, so it's safe to delete the handler here
+    cleanSession( session );
+
+    emit sessionFinished( results );
+
+    if( iAborting ) {
+        if( iSessions.isEmpty() ) {
+            emit finished( iAbortState, "User aborted synchronization" );
+        }
+    }
+    else if( !iListener && !startListener() && iSessions.isEmpty() ) {
+        emit error( INTERNAL_ERROR, "Could not listen for requests" );
+    }
+}
+
+void SessionDispatcher::receiveItemProcessed( DataSync::ModificationType aModificationType,
+                                              DataSync::ModifiedDatabase aModifiedDatabase,
+                                              QString aLocalDatabase,
+                                              QString aMimeType, int aCommittedItems )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Session* session = findSession( sender() );
+
+    if( session ) {
+        session->iResults.addProcessedItem( aModificationType, aModifiedDatabase, aLocalDatabase );
+    }
+
+    emit itemProcessed( aModificationType, aModifiedDatabase, aLocalDatabase, aMimeType, aCommittedItems );
+}
+
+bool SessionDispatcher::startListener( Transport* aTransport )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_ASSERT( !iListener );
+
+    Transport* transport = aTransport;
+
+    if( !transport ) {
+        transport = iProvider->acquireTransport();
+    }
+
+    if( !transport ) {
+        qCWarning(lcSyncML) << "SessionDispatcher: No transport available for listening";
+        return false;
+    }
+
+    if( !transport->init() ) {
+        qCCritical(lcSyncML) << "SessionDispatcher: Could not initiate transport";
+        iProvider->releaseTransport( transport );
+        return false;
+    }
+
+    RequestListener* listener = new RequestListener( this );
+
+    // Listener signals are queued so that transport can be released in the slots
+    connect( listener, SIGNAL(newPendingRequest()),
+             this, SLOT(listenEvent()), Qt::QueuedConnection );
+    connect( listener, SIGNAL(error(DataSync::SyncState,QString)),
+             this, SLOT(listenError(DataSync::SyncState,QString)), Qt::QueuedConnection );
+
+    if( !listener->start( transport ) ) {
+        qCCritical(lcSyncML) << "SessionDispatcher: Could not start listening for requests";
+        delete listener;
+        iProvider->releaseTransport( transport );
+        return false;
+    }
+
+    iListener = listener;
+    iListenTransport = transport;
+
+    return true;
+}
+
+void SessionDispatcher::stopListener()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iListener ) {
+        iListener->stop();
+        iListener->deleteLater();
+        iListener = NULL;
+    }
+
+    if( iListenTransport ) {
+        iProvider->releaseTransport( iListenTransport );
+        iListenTransport = NULL;
+    }
+}
+
+void SessionDispatcher::startSession( Transport* aTransport, const QString& aRemoteDevice,
+                                      QList<Fragment*>& aFragments )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    static unsigned sessionNumber = 0;
+
+    Session* session = new Session;
+
+    // Each session has its own copy of the configuration, so that handlers
+    // can use their own transports and database connections
+    session->iConfig = new SyncAgentConfig( *iConfig );
+    session->iConfig->setTransport( aTransport );
+    session->iConfig->setDatabasePoolKey( QString( "session%1" ).arg( sessionNumber++ ) );
+    session->iTransport = aTransport;
+    session->iRemoteDevice = aRemoteDevice;
+
+    ServerSessionHandler* handler = new ServerSessionHandler( session->iConfig, this );
+
+    connect( handler, SIGNAL(syncStateChanged(DataSync::SyncState )),
+             this, SLOT(receiveStateChanged(DataSync::SyncState)),
+             Qt::QueuedConnection );
+
+    connect( handler, SIGNAL(syncFinished(QString, DataSync::SyncState, QString )),
+             this, SLOT(receiveSyncFinished(QString, DataSync::SyncState, QString)),
+             Qt::QueuedConnection );
+
+    connect( handler, SIGNAL(storageAccquired(QString )),
+             this, SIGNAL(storageAccquired(QString)),
+             Qt::QueuedConnection );
+
+    connect( handler, SIGNAL( itemProcessed( DataSync::ModificationType,
+             DataSync::ModifiedDatabase,QString,QString,int ) ),
+             this, SLOT( receiveItemProcessed( DataSync::ModificationType,
+             DataSync::ModifiedDatabase,QString,QString,int ) ),
+             Qt::QueuedConnection );
+
+    session->iHandler = handler;
+    iSessions.append( session );
+
+    qCDebug(lcSyncML) << "SessionDispatcher: Starting session" << iSessions.count() << "with"
+                      << session->iRemoteDevice;
+
+    handler->serveRequest( aFragments );
+}
+
+void SessionDispatcher::cleanSession( Session* aSession )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iSessions.removeAll( aSession );
+
+    delete aSession->iHandler;
+    aSession->iHandler = NULL;
+
+    aSession->iTransport->close();
+    iProvider->releaseTransport( aSession->iTransport );
+    aSession->iTransport = NULL;
+
+    delete aSession->iConfig;
+    aSession->iConfig = NULL;
+
+    delete aSession;
+}
+
+SessionDispatcher::Session* SessionDispatcher::findSession( QObject* aHandler ) const
+{
+    for( int i = 0; i < iSessions.count(); ++i ) {
+        if( iSessions[i]->iHandler == aHandler ) {
+            return iSessions[i];
+        }
+    }
+
+    return NULL;
+}
+
+bool SessionDispatcher::isServing( const QString& aRemoteDevice ) const
+{
+    if( aRemoteDevice.isEmpty() ) {
+        return false;
+    }
+
+    for( int i = 0; i < iSessions.count(); ++i ) {
+        if( iSessions[i]->iRemoteDevice == aRemoteDevice ) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,211 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef SESSIONDISPATCHER_H
+#define SESSIONDISPATCHER_H
+
+#include <QObject>
+#include <QList>
+
+#include "SyncAgentConsts.h"
+#include "SyncResults.h"
+
+class SessionDispatcherTest;
+
+namespace DataSync {
+
+class SyncAgentConfig;
+class Transport;
+class TransportProvider;
+class RequestListener;
+class ServerSessionHandler;
+struct Fragment;
+
+/*! \brief Serves several server sessions concurrently
+ *
+ * Dispatcher listens for requests with transports acquired from the
+ * transport provider of the configuration. Each request that starts a new
+ * session is served by its own ServerSessionHandler, with its own copy of
+ * the configuration and its own database connection, and dispatcher then
+ * continues listening with a new transport. Routing of subsequent messages
+ * to the session they belong to is done by the transport provider.
+ *
+ * Only one session at a time is served for each remote device, so that
+ * anchors, mappings and nonces of a device are never modified by two
+ * sessions at once. When the maximum number of concurrent sessions is
+ * reached, dispatcher stops acquiring transports until a session finishes.
+ */
+class SessionDispatcher : public QObject
+{
+    Q_OBJECT;
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aParent Parent of this object
+     */
+    SessionDispatcher( QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~SessionDispatcher();
+
+    /*! \brief Starts listening for requests
+     *
+     * @param aConfig Configuration to use. Must have a transport provider.
+     *                Ownership is not transferred
+     * @return True on success, otherwise false
+     */
+    bool start( const SyncAgentConfig& aConfig );
+
+    /*! \brief Stops listening and aborts all sessions
+     *
+     * finished() is emitted when all sessions have finished. If there are
+     * no sessions, it is not emitted.
+     *
+     * @param aState State to abort sessions with
+     */
+    void abort( DataSync::SyncState aState );
+
+    /*! \brief Checks if dispatcher is listening for new sessions
+     *
+     * @return True if listening, otherwise false
+     */
+    bool isListening() const;
+
+    /*! \brief Returns the number of sessions being served
+     *
+     * @return Number of sessions
+     */
+    int sessionCount() const;
+
+    /*! \brief Returns the maximum number of sessions served concurrently
+     *
+     * @return Maximum number of sessions
+     */
+    int maxSessions() const;
+
+signals:
+
+    /*! \brief Signal emitted when a session has finished
+     *
+     * @param aResults Results of the session
+     */
+    void sessionFinished( const DataSync::SyncResults& aResults );
+
+    /*! \brief Signal emitted when all sessions have finished after abort()
+     *
+     * @param aState State sessions were aborted with
+     * @param aErrorString Description of the reason
+     */
+    void finished( DataSync::SyncState aState, QString aErrorString );
+
+    /*! \brief Signal emitted when listening fails and no sessions remain
+     *
+     * @param aState Error state
+     * @param aErrorString Description of the error
+     */
+    void error( DataSync::SyncState aState, QString aErrorString );
+
+    /*! \brief Signal emitted when an item has been processed in a session
+     *
+     */
+    void itemProcessed( DataSync::ModificationType aModificationType,
+                        DataSync::ModifiedDatabase aModifiedDatabase,
+                        QString aLocalDatabase,
+                        QString aMimeType, int aCommittedItems );
+
+    /*! \brief Signal emitted when a storage has been acquired in a session
+     *
+     */
+    void storageAccquired( QString aMimeType );
+
+private slots:
+
+    void listenEvent();
+
+    void listenError( DataSync::SyncState aState, QString aErrorString );
+
+    void receiveStateChanged( DataSync::SyncState aState );
+
+    void receiveSyncFinished( QString aRemoteDeviceId, DataSync::SyncState aState,
+                              QString aErrorString );
+
+    void receiveItemProcessed( DataSync::ModificationType aModificationType,
+                               DataSync::ModifiedDatabase aModifiedDatabase,
+                               QString aLocalDatabase,
+                               QString aMimeType, int aCommittedItems );
+
+private:
+
+    struct Session
+    {
+        ServerSessionHandler*   iHandler;
+        SyncAgentConfig*        iConfig;
+        Transport*              iTransport;
+        QString                 iRemoteDevice;
+        SyncResults             iResults;
+
+        Session() : iHandler( 0 ), iConfig( 0 ), iTransport( 0 ) { }
+    };
+
+    bool startListener( Transport* aTransport = 0 );
+
+    void stopListener();
+
+    void startSession( Transport* aTransport, const QString& aRemoteDevice,
+                       QList<Fragment*>& aFragments );
+
+    void cleanSession( Session* aSession );
+
+    Session* findSession( QObject* aHandler ) const;
+
+    bool isServing( const QString& aRemoteDevice ) const;
+
+    const SyncAgentConfig*  iConfig;
+    TransportProvider*      iProvider;
+    RequestListener*        iListener;
+    Transport*              iListenTransport;
+    QList<Session*>         iSessions;
+    int                     iMaxSessions;
+    bool                    iAborting;
+    SyncState               iAbortState;
+
+    friend class ::SessionDispatcherTest;
+};
+
+}
+
+#endif  //  SESSIONDISPATCHER_H
@@ -1,3 +1,5 @@
-SOURCES += ServerSessionHandler.cpp
+SOURCES += ServerSessionHandler.cpp \
+    SessionDispatcher.cpp
 
-HEADERS += ServerSessionHandler.h
+HEADERS += ServerSessionHandler.h \
+    SessionDispatcher.h
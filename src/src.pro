@@ -17,7 +17,8 @@ CONFIG += dll \
     link_pkgconfig
 
 PKGCONFIG = buteosyncfw5 \
-    libwbxml2
+    libwbxml2 \
+    zlib
 
 INCLUDEPATH += . \
         syncelements \
@@ -37,6 +38,7 @@ SOURCES += SyncItem.cpp \
         SyncAgent.cpp \
         SyncAgentConfig.cpp \
         SyncMLMessageParser.cpp \
+        SyncMLReader.cpp \
         AuthenticationPackage.cpp \
         LocalChangesPackage.cpp \
         LocalMappingsPackage.cpp \
@@ -65,7 +67,11 @@ SOURCES += SyncItem.cpp \
     DataStore.cpp \
     StorageContentFormatInfo.cpp \
     SessionAuthentication.cpp \
-    SessionParams.cpp
+    SessionParams.cpp \
+    UIDMappingStore.cpp \
+    LargeObjectSpool.cpp \
+    SyncCommitJob.cpp \
+    ItemMatcher.cpp
 
 HEADERS += SyncItem.h \
         StoragePlugin.h \
@@ -77,6 +83,7 @@ HEADERS += SyncItem.h \
     Fragments.h \
         SyncAgentConfig.h \
         SyncMLMessageParser.h \
+        SyncMLReader.h \
         AuthenticationPackage.h \
         LocalChangesPackage.h \
         LocalMappingsPackage.h \
@@ -112,7 +119,11 @@ HEADERS += SyncItem.h \
     StorageContentFormatInfo.h \
     LocalChanges.h \
     SessionAuthentication.h \
-    SessionParams.h
+    SessionParams.h \
+    UIDMappingStore.h \
+    LargeObjectSpool.h \
+    SyncCommitJob.h \
+    ItemMatcher.h
 
 OTHER_FILES += config/meego-syncml-conf.xsd \
                config/meego-syncml-conf.xml
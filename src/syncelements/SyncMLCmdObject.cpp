@@ -33,8 +33,6 @@
 
 #include "SyncMLCmdObject.h"
 #include "SyncMLLogging.h"
-#include "LibWbXML2Encoder.h"
-#include "QtEncoder.h"
 #include "datatypes.h"
 
 // As this base class is extensively used in SyncML generation, please do not
@@ -44,7 +42,9 @@
 using namespace DataSync;
 
 SyncMLCmdObject::SyncMLCmdObject( const QString& aName, const QString& aValue )
-: iName( aName ), iValue( aValue ), iIsCDATA( false )
+: iName( aName ), iValue( aValue ), iIsCDATA( false ), iParent( NULL ),
+  iWbXMLSize( -1 ), iWbXMLCodeSpace( WbXMLSizeEstimator::CODESPACE_INHERIT ),
+  iWbXMLExitCodeSpace( WbXMLSizeEstimator::CODESPACE_INHERIT )
 
 {
 
@@ -64,6 +64,7 @@ const QString& SyncMLCmdObject::getName() const
 void SyncMLCmdObject::setName( const QString& aName )
 {
     iName = aName;
+    invalidateSize();
 }
 
 const QString& SyncMLCmdObject::getValue() const
@@ -74,6 +75,7 @@ const QString& SyncMLCmdObject::getValue() const
 void SyncMLCmdObject::setValue( const QString& aValue )
 {
     iValue = aValue;
+    invalidateSize();
 }
 
 bool SyncMLCmdObject::getCDATA() const
@@ -84,11 +86,13 @@ bool SyncMLCmdObject::getCDATA() const
 void SyncMLCmdObject::setCDATA( bool aCDATA )
 {
     iIsCDATA = aCDATA;
+    invalidateSize();
 }
 
 void SyncMLCmdObject::addAttribute( const QString& aName, const QString& aValue )
 {
     iAttributes.insert( aName, aValue );
+    invalidateSize();
 }
 
 const QMap<QString, QString>& SyncMLCmdObject::getAttributes() const
@@ -100,7 +104,9 @@ void SyncMLCmdObject::addChild( SyncMLCmdObject* aChild )
 {
 
     Q_ASSERT( aChild );
+    aChild->iParent = this;
     iChildren.append( aChild );
+    invalidateSize();
 
 }
 
@@ -117,25 +123,26 @@ int SyncMLCmdObject::calculateSize(bool aWBXML, const ProtocolVersion& aVersion)
     // not need to be byte-accurate. We gain lots of performance when we don't have
     // to serialize to XML to check the current size
 
-    if (aWBXML) {
-        LibWbXML2Encoder encoder;
+    // Public identifiers of both SyncML versions have equal encoded sizes, so
+    // version does not affect the estimation
+    Q_UNUSED( aVersion );
 
-        QByteArray aData;
+    if( aWBXML ) {
 
-        if( aVersion == SYNCML_1_1 ) {
-            addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_SYNCML11 );
+        WbXMLSizeEstimator::CodeSpace codeSpace = WbXMLSizeEstimator::codeSpace( *this );
+        int size = 0;
+
+        if( codeSpace == WbXMLSizeEstimator::CODESPACE_INHERIT ) {
+            codeSpace = WbXMLSizeEstimator::CODESPACE_SYNCML;
         }
-        else if( aVersion == SYNCML_1_2 ) {
-            addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_SYNCML12 );
+        else if( !iParent && codeSpace != WbXMLSizeEstimator::CODESPACE_METINF ) {
+            // Root of a document
+            size += WbXMLSizeEstimator::HEADER_SIZE;
         }
 
+        size += calculateWbXMLSize( codeSpace );
 
-        if( encoder.encodeToWbXML( *this,
-                                   aVersion,
-                                   aData ) )
-        {
-            return aData.size();
-        }
+        return size;
     }
 
     int size = 0;
@@ -181,3 +188,76 @@ int SyncMLCmdObject::calculateSize(bool aWBXML, const ProtocolVersion& aVersion)
 
     return size;
 }
+
+int SyncMLCmdObject::calculateWbXMLSize( WbXMLSizeEstimator::CodeSpace aCodeSpace )
+{
+    if( iWbXMLSize >= 0 && iWbXMLCodeSpace == aCodeSpace ) {
+        return iWbXMLSize;
+    }
+
+    int contentSize = 0;
+
+    if( !iValue.isEmpty() ) {
+
+        if( iIsCDATA ) {
+            contentSize += WbXMLSizeEstimator::opaqueSize( WbXMLSizeEstimator::utf8Size( iValue ) );
+        }
+        else {
+            contentSize += WbXMLSizeEstimator::inlineStringSize( iValue );
+        }
+
+    }
+
+    // Track the active code page in the same way as the encoder does: a page
+    // switch is needed whenever a child is in another page than the previous
+    // element that was written
+    WbXMLSizeEstimator::CodeSpace currentCodeSpace = aCodeSpace;
+
+    for( int i = 0; i < iChildren.count(); ++i ) {
+
+        SyncMLCmdObject* child = iChildren[i];
+        WbXMLSizeEstimator::CodeSpace childCodeSpace = WbXMLSizeEstimator::codeSpace( *child );
+
+        if( childCodeSpace == WbXMLSizeEstimator::CODESPACE_INHERIT ) {
+            childCodeSpace = aCodeSpace;
+        }
+
+        if( !WbXMLSizeEstimator::sameLanguage( childCodeSpace, aCodeSpace ) ) {
+            // Child is written as a separate WbXML document inside opaque data
+            int documentSize = WbXMLSizeEstimator::HEADER_SIZE +
+                               child->calculateWbXMLSize( childCodeSpace );
+            contentSize += WbXMLSizeEstimator::opaqueSize( documentSize );
+        }
+        else {
+
+            if( childCodeSpace != currentCodeSpace ) {
+                contentSize += WbXMLSizeEstimator::SWITCH_PAGE_SIZE;
+            }
+
+            contentSize += child->calculateWbXMLSize( childCodeSpace );
+            currentCodeSpace = child->iWbXMLExitCodeSpace;
+        }
+
+    }
+
+    // Attributes other than namespace declarations are not used by SyncML,
+    // so they are not accounted for
+
+    iWbXMLSize = WbXMLSizeEstimator::elementSize( contentSize );
+    iWbXMLCodeSpace = aCodeSpace;
+    iWbXMLExitCodeSpace = currentCodeSpace;
+
+    return iWbXMLSize;
+}
+
+void SyncMLCmdObject::invalidateSize()
+{
+    // If an object has a valid size, so does every object below it. So we can
+    // stop as soon as we find an ancestor that is already invalid
+    SyncMLCmdObject* object = this;
+
+    while( object && object->iWbXMLSize >= 0 ) {
+        object->iWbXMLSize = -1;
+        object = object->iParent;
+    }
+}
@@ -38,6 +38,7 @@
 #include <QMap>
 
 #include "SyncAgentConsts.h"
+#include "WbXMLSizeEstimator.h"
 
 namespace DataSync {
 
@@ -123,6 +124,10 @@ public:
 	const QList<SyncMLCmdObject*>& getChildren() const;
 
 	/*! \brief Estimate the size of the present object when formatted as XML object
+	 *
+	 * WbXML size is calculated with WbXMLSizeEstimator and cached per object, so
+	 * repeated calls only re-estimate the parts of the tree that have changed
+	 * since the previous call.
 	 *
 	 * @return Estimated size of the object, including all child objects
 	 */
@@ -132,6 +137,10 @@ protected:
 
 private:
 
+    int calculateWbXMLSize( WbXMLSizeEstimator::CodeSpace aCodeSpace );
+
+    void invalidateSize();
+
     QString                 iName;
 
     QString                 iValue;
@@ -141,6 +150,11 @@ private:
 
     QList<SyncMLCmdObject*> iChildren;
 
+    SyncMLCmdObject*        iParent;
+
+    int                     iWbXMLSize;
+    WbXMLSizeEstimator::CodeSpace iWbXMLCodeSpace;
+    WbXMLSizeEstimator::CodeSpace iWbXMLExitCodeSpace;
 
 };
 
@@ -106,7 +106,7 @@ SyncMLStatus::SyncMLStatus(const StatusParams& aParams)
 
         if( !aParams.items[i].data.isEmpty() )
         {
-            itemObject->insertData( aParams.items[i].data.toUtf8() );
+            itemObject->insertData( aParams.items[i].data );
         }
 
         addChild( itemObject );
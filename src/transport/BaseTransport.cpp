@@ -33,13 +33,18 @@
 
 #include "BaseTransport.h"
 
+#include <QElapsedTimer>
 #include <QFile>
-#include <QRegExp>
+
+#include <cstring>
 
 #include "SyncMLMessage.h"
 #include "LibWbXML2Encoder.h"
+#include "WbXMLEncoder.h"
+#include "WbXMLReader.h"
 #include "QtEncoder.h"
 #include "datatypes.h"
+#include "SyncAgentConfigProperties.h"
 
 #include "SyncMLLogging.h"
 
@@ -47,7 +52,8 @@ using namespace DataSync;
 
 BaseTransport::BaseTransport( const ProtocolContext& aContext, QObject* aParent )
  : Transport( aParent ), iContext( aContext ), iHandleIncomingData( false ),
-   iWbXml( false )
+   iWbXml( false ), iIncrementalReceive( false ), iEagerXMLSanitizing( false ),
+   iPartsXML( false ), iPartReceived( false ), iReceivingParts( false ), iPartsSize( 0 )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -84,10 +90,15 @@ bool BaseTransport::sendSyncML( SyncMLMessage* aMessage )
 
     QByteArray data;
 
+    QElapsedTimer encodeTimer;
+    encodeTimer.start();
+
     if( !encodeMessage(*aMessage, data ) ) {
         return false;
     }
 
+    qint64 encodeTime = encodeTimer.nsecsElapsed() / 1000;
+
     delete aMessage;
     aMessage = NULL;
 
@@ -115,7 +126,12 @@ bool BaseTransport::sendSyncML( SyncMLMessage* aMessage )
         }
     }
 
-    return doSend( data, contentType );
+    if( !doSend( data, contentType ) ) {
+        return false;
+    }
+
+    emit messageSent( data.size(), encodeTime );
+    return true;
 
 }
 
@@ -127,7 +143,12 @@ bool BaseTransport::sendSAN( const QByteArray& aMessage )
     qCDebug(lcSyncMLProtocol) << "\nSending SAN message:\n=========\n" << aMessage.toHex() << "\n=========";
 #endif  //  QT_NO_DEBUG
 
-    return doSend( aMessage, SYNCML_CONTTYPE_SAN_DS );
+    if( !doSend( aMessage, SYNCML_CONTTYPE_SAN_DS ) ) {
+        return false;
+    }
+
+    emit messageSent( aMessage.size(), 0 );
+    return true;
 }
 
 bool BaseTransport::receive()
@@ -184,10 +205,13 @@ void BaseTransport::receive( const QByteArray& aData, const QString& aContentTyp
     iIODevice.close();
 
     if( aData.isEmpty() ) {
+        discardParts();
         emit sendEvent( TRANSPORT_DATA_INVALID_CONTENT, "" );
         return;
     }
 
+    emit messageReceived( aData.size() );
+
     if( aContentType.contains( SYNCML_CONTTYPE_DS_WBXML ) ||
         aContentType.contains( SYNCML_CONTTYPE_DM_WBXML ) ) {
         receiveWbXMLData( aData );
@@ -201,6 +225,7 @@ void BaseTransport::receive( const QByteArray& aData, const QString& aContentTyp
     }
     else {
         iIncomingData.clear();
+        discardParts();
         emit sendEvent( TRANSPORT_DATA_INVALID_CONTENT_TYPE, "" );
         return;
     }
@@ -211,6 +236,64 @@ void BaseTransport::receive( const QByteArray& aData, const QString& aContentTyp
         emitReadSignal();
 
     }
+
+    discardParts();
+}
+
+void BaseTransport::receivePart( const QByteArray& aData, const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aData.isEmpty() ) {
+        return;
+    }
+
+    bool firstPart = !iPartReceived;
+
+    if( firstPart ) {
+
+        iPartReceived = true;
+        iPartsSize = 0;
+
+        // Only messages that the parser can read without converting them
+        // first are passed on in parts
+        if( !iIncrementalReceive || !iHandleIncomingData ) {
+            iReceivingParts = false;
+        }
+        else if( aContentType.contains( SYNCML_CONTTYPE_DS_WBXML ) ) {
+            iReceivingParts = iContext != CONTEXT_DM && WbXMLReader::isSyncMLDocument( aData );
+        }
+        else {
+            iReceivingParts = aContentType.contains( SYNCML_CONTTYPE_DS_XML ) ||
+                              aContentType.contains( SYNCML_CONTTYPE_DM_XML );
+        }
+
+        iPartsXML = iReceivingParts && !aContentType.contains( SYNCML_CONTTYPE_DS_WBXML );
+    }
+
+    if( iReceivingParts ) {
+
+        iPartsSize += aData.size();
+
+        if( iPartsXML && iEagerXMLSanitizing ) {
+            QByteArray part( aData );
+            sanitizeXMLData( part );
+            emit readXMLDataPart( part, firstPart, false );
+        }
+        else {
+            emit readXMLDataPart( aData, firstPart, false );
+        }
+    }
+}
+
+void BaseTransport::discardParts()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Next part starts a new message in the parser
+    iPartReceived = false;
+    iReceivingParts = false;
+    iPartsSize = 0;
 }
 
 const QString& BaseTransport::getRemoteLocURI() const
@@ -227,9 +310,14 @@ bool BaseTransport::encodeMessage( const SyncMLMessage& aMessage, QByteArray& aD
     if( useWbXml() )
     {
 
+        WbXMLEncoder wbxmlEncoder;
         LibWbXML2Encoder encoder;
 
-        if( encoder.encodeToWbXML( aMessage,
+        // Encode directly when possible, libwbxml2 handles the rest
+        if( wbxmlEncoder.encodeToWbXML( aMessage,
+                                        aMessage.getProtocolVersion(),
+                                        aData ) ||
+            encoder.encodeToWbXML( aMessage,
                                    aMessage.getProtocolVersion(),
                                    aData ) )
         {
@@ -301,11 +389,39 @@ void BaseTransport::emitReadSignal()
     iIODevice.setBuffer( &iIODeviceData );
     iIODevice.open( QIODevice::ReadOnly );
 
+    // Device data is kept also for messages received in parts, so that it
+    // can be purged and parsed again as a whole
+    bool receivingParts = iReceivingParts;
+    int partsSize = iPartsSize;
+    discardParts();
+
     if( iContentType == SYNCML_CONTTYPE_SAN_DS ) {
         emit readSANData( &iIODevice );
     }
+    else if( receivingParts &&
+             ( iContentType == SYNCML_CONTTYPE_DM_XML ||
+               iContentType == SYNCML_CONTTYPE_DS_XML ||
+               iContentType == SYNCML_CONTTYPE_DS_WBXML ) ) {
+
+        QByteArray part = iIODeviceData.mid( partsSize );
+
+        if( iContentType != SYNCML_CONTTYPE_DS_WBXML && iEagerXMLSanitizing ) {
+            sanitizeXMLData( part );
+        }
+
+        emit readXMLDataPart( part, false, true );
+    }
     else if( iContentType == SYNCML_CONTTYPE_DM_XML ||
-             iContentType == SYNCML_CONTTYPE_DS_XML ) {
+             iContentType == SYNCML_CONTTYPE_DS_XML ||
+             iContentType == SYNCML_CONTTYPE_DS_WBXML ) {
+
+        if( iContentType != SYNCML_CONTTYPE_DS_WBXML && iEagerXMLSanitizing ) {
+            iIODevice.close();
+            sanitizeXMLData( iIODeviceData );
+            iIODevice.setBuffer( &iIODeviceData );
+            iIODevice.open( QIODevice::ReadOnly );
+        }
+
         emit readXMLData( &iIODevice, true );
     }
     else {
@@ -319,6 +435,96 @@ void BaseTransport::setWbXml( bool aUse )
     iWbXml = aUse;
 }
 
+void BaseTransport::setProperty( const QString& aProperty, const QString& aValue )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aProperty == EAGERXMLSANITIZINGPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        setEagerXMLSanitizing( aValue.toInt() > 0 );
+    }
+}
+
+void BaseTransport::setIncrementalReceive( bool aUse )
+{
+    iIncrementalReceive = aUse;
+}
+
+void BaseTransport::setEagerXMLSanitizing( bool aUse )
+{
+    iEagerXMLSanitizing = aUse;
+}
+
+int BaseTransport::removeInvalidXMLChars( QByteArray& aData )
+{
+    // Bytes 0x00-0x1F other than tab, line feed and carriage return
+    static const quint32 INVALID_CHARS = ~( ( 1u << 0x09 ) | ( 1u << 0x0A ) | ( 1u << 0x0D ) );
+
+    // Detects if any byte of a word is below 0x20
+    static const quint64 ONES = Q_UINT64_C( 0x0101010101010101 );
+    static const quint64 HIGH_BITS = Q_UINT64_C( 0x8080808080808080 );
+    static const quint64 CONTROL_LIMIT = ONES * 0x20;
+
+    const char* data = aData.constData();
+    char* out = 0;
+    const int size = aData.size();
+    int read = 0;
+    int write = 0;
+
+    // Words without control characters are skipped, and moved only after
+    // the first invalid character has been found
+    while( read < size ) {
+
+        while( read + static_cast<int>( sizeof( quint64 ) ) <= size ) {
+
+            quint64 word;
+            memcpy( &word, data + read, sizeof( word ) );
+
+            if( ( word - CONTROL_LIMIT ) & ~word & HIGH_BITS ) {
+                break;
+            }
+
+            if( out ) {
+                memmove( out + write, data + read, sizeof( word ) );
+                write += sizeof( word );
+            }
+
+            read += sizeof( word );
+        }
+
+        int end = qMin( read + static_cast<int>( sizeof( quint64 ) ), size );
+
+        for( ; read < end; ++read ) {
+
+            quint8 byte = static_cast<quint8>( data[read] );
+            bool invalid = byte < 0x20 && ( INVALID_CHARS & ( 1u << byte ) );
+
+            if( invalid && !out ) {
+                // Detach only when something needs to be removed
+                out = aData.data();
+                data = out;
+                write = read;
+            }
+            else if( !invalid && out ) {
+                out[write++] = data[read];
+            }
+        }
+    }
+
+    if( !out ) {
+        return 0;
+    }
+
+    aData.truncate( write );
+    return size - write;
+}
+
+bool BaseTransport::useIncrementalReceive() const
+{
+    return iIncrementalReceive;
+}
+
 bool BaseTransport::useWbXml() const
 {
     return iWbXml;
@@ -330,6 +536,27 @@ void BaseTransport::receiveWbXMLData( const QByteArray& aData )
 
     setWbXml( true );
 
+    // SyncML DS messages are read natively by the parser, without converting
+    // them to XML first
+    if( iContext != CONTEXT_DM && WbXMLReader::isSyncMLDocument( aData ) ) {
+
+        iContentType = SYNCML_CONTTYPE_DS_WBXML;
+        iIncomingData = aData;
+
+#ifndef QT_NO_DEBUG
+        if( lcSyncMLProtocol().isDebugEnabled() ) {
+            LibWbXML2Encoder encoder;
+            QByteArray xmlData;
+
+            if( encoder.decodeFromWbXML( aData, xmlData, true ) ) {
+                qCDebug(lcSyncMLProtocol) << "\nReceived WbXML message:\n=========\n" << xmlData << "\n=========";
+            }
+        }
+#endif  //  QT_NO_DEBUG
+
+        return;
+    }
+
     bool prettyPrint = false;
 
 #ifndef QT_NO_DEBUG
@@ -390,20 +617,16 @@ void BaseTransport::purgeAndResendBuffer()
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     if(iIODeviceData.size() > 0)
     {
-        QString dataString = QString::fromUtf8(iIODeviceData, iIODeviceData.size());
-        // Strip illegal XML characters
-        dataString.remove(QChar(0x00));
-        dataString.remove(QRegExp("[\x0001-\x0008,\x000B-\x000C,\x000E-\x001F]"));
+        iIODevice.close();
 
-        iIODeviceData = dataString.toUtf8();
+        // Strip illegal XML characters
+        sanitizeXMLData( iIODeviceData );
 
 #ifndef QT_NO_DEBUG
         qCDebug(lcSyncMLProtocol) << "\nPurged XML message:\n=========\n" << iIODeviceData << "\n=========";
 #endif  //  QT_NO_DEBUG
 
         // Put the new buffer into the IO device
-        iIODevice.close();
-
         iIODevice.setBuffer( &iIODeviceData );
         iIODevice.open( QIODevice::ReadOnly );
 
@@ -411,3 +634,13 @@ void BaseTransport::purgeAndResendBuffer()
     }
 }
 
+void BaseTransport::sanitizeXMLData( QByteArray& aData ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    int removed = removeInvalidXMLChars( aData );
+
+    if( removed > 0 ) {
+        qCWarning(lcSyncML) << "Removed" << removed << "bytes of invalid XML characters from incoming message";
+    }
+}
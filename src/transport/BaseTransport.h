@@ -72,16 +72,58 @@ public:
 
     virtual bool receive();
 
+    /*! \brief Sets properties common to all transports
+     *
+     * Transports should pass properties they do not handle themselves to
+     * this function
+     *
+     * @param aProperty Property name
+     * @param aValue Property value
+     */
+    virtual void setProperty( const QString& aProperty, const QString& aValue );
+
     /*! \brief Enable/disable WbXML
      *
      * @param aUse True/false to enable/disable WbXML encoding
      */
     void setWbXml( bool aUse );
 
+    /*! \brief Enable/disable incremental receiving
+     *
+     * When enabled, parts of incoming messages that are received with
+     * receivePart() are passed on with readXMLDataPart() as they arrive
+     *
+     * @param aUse True/false to enable/disable incremental receiving
+     */
+    void setIncrementalReceive( bool aUse );
+
+    /*! \brief Enable/disable eager removal of invalid XML characters
+     *
+     * When enabled, invalid XML characters are removed from incoming XML
+     * messages before they are parsed. Otherwise they are removed only if
+     * parsing fails.
+     *
+     * @param aUse True/false to enable/disable eager removal
+     */
+    void setEagerXMLSanitizing( bool aUse );
+
+    /*! \brief Removes characters that are not allowed in XML from UTF-8 data
+     *
+     * Removes NULLs and control characters other than tab, line feed and
+     * carriage return. As bytes below 0x20 never appear inside multi-byte
+     * UTF-8 sequences, data is processed byte by byte without decoding it.
+     * Data is modified in place, and not detached if nothing is removed.
+     *
+     * @param aData Data to process
+     * @return Number of bytes removed
+     */
+    static int removeInvalidXMLChars( QByteArray& aData );
+
 private slots:
     /*! \brief Remove any illegal XML characters from the previous message
      *
-     * Removes illegal XML characters (NULLs and control characters)
+     * Removes illegal XML characters (NULLs and control characters) with
+     * removeInvalidXMLChars()
      */
     void purgeAndResendBuffer();
 
@@ -124,6 +166,28 @@ protected:
      */
     void receive( const QByteArray& aData, const QString& aContentType );
 
+    /*! \brief Receive part of incoming data
+     *
+     * Transports that support incremental receiving can pass data to this
+     * function as it arrives. The whole data must still be passed to
+     * receive() when it has been received.
+     *
+     * @param aData Part of content data
+     * @param aContentType Content type
+     */
+    void receivePart( const QByteArray& aData, const QString& aContentType );
+
+    /*! \brief Discards the parts of a message that will not be completed
+     *
+     */
+    void discardParts();
+
+    /*! \brief Checks if incremental receiving is enabled
+     *
+     * @return True if enabled, otherwise false
+     */
+    bool useIncrementalReceive() const;
+
     /*! \brief Retrieves remote location URI
      *
      * @return Remote URI
@@ -144,6 +208,8 @@ private:
 
     void emitReadSignal();
 
+    void sanitizeXMLData( QByteArray& aData ) const;
+
     bool useWbXml() const;
 
     void receiveWbXMLData( const QByteArray& aData );
@@ -158,6 +224,12 @@ private:
     QBuffer             iIODevice;
     bool                iHandleIncomingData;
     bool                iWbXml;
+    bool                iIncrementalReceive;
+    bool                iEagerXMLSanitizing;
+    bool                iPartsXML;
+    bool                iPartReceived;
+    bool                iReceivingParts;
+    int                 iPartsSize;
 
 };
 
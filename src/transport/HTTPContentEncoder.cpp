@@ -0,0 +1,220 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "HTTPContentEncoder.h"
+
+#include <QStringList>
+
+#include <zlib.h>
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+// Window bits for zlib to use gzip format
+static const int GZIP_WINDOW_BITS = MAX_WBITS + 16;
+
+// Window bits for zlib to detect gzip or zlib format automatically
+static const int AUTODETECT_WINDOW_BITS = MAX_WBITS + 32;
+
+// Window bits for zlib to use raw deflate data without zlib header
+static const int RAW_WINDOW_BITS = -MAX_WBITS;
+
+static const int DECODE_CHUNK_SIZE = 16 * 1024;
+
+static bool inflateData( const QByteArray& aData, int aWindowBits, int aMaxSize,
+                         QByteArray& aDecoded, bool& aTooLarge )
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( aData.constData() ) );
+    stream.avail_in = aData.size();
+
+    if( inflateInit2( &stream, aWindowBits ) != Z_OK ) {
+        return false;
+    }
+
+    QByteArray decoded;
+    int result = Z_OK;
+
+    while( result == Z_OK ) {
+
+        int size = decoded.size();
+        decoded.resize( size + DECODE_CHUNK_SIZE );
+
+        stream.next_out = reinterpret_cast<Bytef*>( decoded.data() + size );
+        stream.avail_out = DECODE_CHUNK_SIZE;
+
+        result = inflate( &stream, Z_NO_FLUSH );
+
+        decoded.resize( size + DECODE_CHUNK_SIZE - stream.avail_out );
+
+        // Stop before a small body can inflate to exhaust memory
+        if( aMaxSize > 0 && decoded.size() > aMaxSize ) {
+            aTooLarge = true;
+            break;
+        }
+    }
+
+    inflateEnd( &stream );
+
+    if( aTooLarge || result != Z_STREAM_END ) {
+        return false;
+    }
+
+    aDecoded = decoded;
+    return true;
+}
+
+HTTPContentEncoder::HTTPContentEncoder()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+HTTPContentEncoder::~HTTPContentEncoder()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+bool HTTPContentEncoder::encode( const QByteArray& aData, QByteArray& aEncoded ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS,
+                      MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY ) != Z_OK ) {
+        qCWarning(lcSyncML) << "Could not initialize gzip compression";
+        return false;
+    }
+
+    QByteArray encoded;
+    encoded.resize( deflateBound( &stream, aData.size() ) );
+
+    stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( aData.constData() ) );
+    stream.avail_in = aData.size();
+    stream.next_out = reinterpret_cast<Bytef*>( encoded.data() );
+    stream.avail_out = encoded.size();
+
+    int result = deflate( &stream, Z_FINISH );
+
+    encoded.resize( stream.total_out );
+    deflateEnd( &stream );
+
+    if( result != Z_STREAM_END ) {
+        qCWarning(lcSyncML) << "gzip compression failed:" << result;
+        return false;
+    }
+
+    aEncoded = encoded;
+    return true;
+}
+
+bool HTTPContentEncoder::decode( const QByteArray& aData, QByteArray& aDecoded ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    bool tooLarge = false;
+    return decode( aData, aDecoded, 0, tooLarge );
+}
+
+bool HTTPContentEncoder::decode( const QByteArray& aData, QByteArray& aDecoded,
+                                 int aMaxSize, bool& aTooLarge ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    aTooLarge = false;
+
+    if( inflateData( aData, AUTODETECT_WINDOW_BITS, aMaxSize, aDecoded, aTooLarge ) ) {
+        return true;
+    }
+
+    // Some servers send raw deflate data instead of zlib format with deflate
+    // content coding
+    if( !aTooLarge && inflateData( aData, RAW_WINDOW_BITS, aMaxSize, aDecoded, aTooLarge ) ) {
+        return true;
+    }
+
+    if( aTooLarge ) {
+        qCWarning(lcSyncML) << "Decompressed data exceeds" << aMaxSize << "bytes";
+    }
+    else {
+        qCWarning(lcSyncML) << "Could not decompress data";
+    }
+
+    return false;
+}
+
+bool HTTPContentEncoder::canDecode( const QString& aCoding )
+{
+    QString coding = aCoding.trimmed().toLower();
+
+    return coding == "gzip" || coding == "x-gzip" || coding == "deflate";
+}
+
+bool HTTPContentEncoder::acceptsGZip( const QString& aAcceptEncoding )
+{
+    QStringList codings = aAcceptEncoding.split( ',', QString::SkipEmptyParts );
+
+    foreach( const QString& value, codings ) {
+
+        QStringList params = value.split( ';' );
+        QString coding = params.takeFirst().trimmed().toLower();
+
+        if( coding != "gzip" && coding != "x-gzip" && coding != "*" ) {
+            continue;
+        }
+
+        // Coding with zero quality is not acceptable
+        bool accepted = true;
+
+        foreach( const QString& param, params ) {
+            QString trimmed = param.trimmed().toLower();
+
+            if( trimmed.startsWith( "q=" ) && trimmed.mid( 2 ).toDouble() <= 0 ) {
+                accepted = false;
+            }
+        }
+
+        if( accepted ) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,114 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef HTTPCONTENTENCODER_H
+#define HTTPCONTENTENCODER_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace DataSync {
+
+/*! \brief Default maximum size of an HTTP message body, after decoding */
+const int HTTP_DEFAULT_MAX_MESSAGE_SIZE = 4 * 1024 * 1024;
+
+/*! \brief Encoder for HTTP content codings
+ *
+ * Compresses message bodies with gzip, and decompresses bodies that are
+ * compressed with either gzip or deflate
+ */
+class HTTPContentEncoder
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    HTTPContentEncoder();
+
+    /*! \brief Destructor
+     *
+     */
+    ~HTTPContentEncoder();
+
+    /*! \brief Compress data with gzip content coding
+     *
+     * @param aData Data to compress
+     * @param aEncoded Compressed data
+     * @return True on success, otherwise false
+     */
+    bool encode( const QByteArray& aData, QByteArray& aEncoded ) const;
+
+    /*! \brief Decompress data compressed with gzip or deflate content coding
+     *
+     * @param aData Data to decompress
+     * @param aDecoded Decompressed data
+     * @return True on success, otherwise false
+     */
+    bool decode( const QByteArray& aData, QByteArray& aDecoded ) const;
+
+    /*! \brief Decompress data with a limit on decompressed size
+     *
+     * Decompression is aborted as soon as the output exceeds the limit
+     *
+     * @param aData Data to decompress
+     * @param aDecoded Decompressed data
+     * @param aMaxSize Maximum size of decompressed data in bytes, 0 for no limit
+     * @param aTooLarge Set to true if decompression was aborted because of the limit
+     * @return True on success, otherwise false
+     */
+    bool decode( const QByteArray& aData, QByteArray& aDecoded, int aMaxSize, bool& aTooLarge ) const;
+
+    /*! \brief Checks if a content coding can be decoded
+     *
+     * @param aCoding Value of Content-Encoding header
+     * @return True if coding is gzip or deflate
+     */
+    static bool canDecode( const QString& aCoding );
+
+    /*! \brief Checks if a list of accepted codings includes gzip
+     *
+     * @param aAcceptEncoding Value of Accept-Encoding header
+     * @return True if gzip is accepted
+     */
+    static bool acceptsGZip( const QString& aAcceptEncoding );
+
+protected:
+
+private:
+
+};
+
+}
+
+#endif  //  HTTPCONTENTENCODER_H
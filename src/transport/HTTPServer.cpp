@@ -0,0 +1,769 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "HTTPServer.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QBuffer>
+#include <QStringList>
+
+#include "HTTPServerTransport.h"
+#include "SyncMLReader.h"
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+// Maximum size of request line and headers
+static const int MAX_HEADER_SIZE = 16 * 1024;
+
+// Default time in milliseconds after which idle connections are closed
+static const int DEFAULT_IDLE_TIMEOUT = 60000;
+
+// Time in seconds after which clients are asked to retry when no transport is available
+static const int RETRY_AFTER = 5;
+
+HTTPServer::HTTPServer( QObject* aParent )
+ : QObject( aParent ), iServer( 0 ), iIdleTimer( 0 ), iMaxRequestSize( HTTP_DEFAULT_MAX_MESSAGE_SIZE ),
+   iCompressionThreshold( 0 ), iIdleTimeout( DEFAULT_IDLE_TIMEOUT )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iServer = new QTcpServer( this );
+    connect( iServer, SIGNAL(newConnection()), this, SLOT(newConnection()) );
+
+    iIdleTimer = new QTimer( this );
+    connect( iIdleTimer, SIGNAL(timeout()), this, SLOT(closeIdleConnections()) );
+}
+
+HTTPServer::~HTTPServer()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    close();
+
+    qDeleteAll( iProvidedTransports );
+    iProvidedTransports.clear();
+}
+
+bool HTTPServer::listen( const QHostAddress& aAddress, quint16 aPort )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iServer->listen( aAddress, aPort ) ) {
+        qCCritical(lcSyncML) << "Could not listen on" << aAddress.toString() << aPort << ":"
+                             << iServer->errorString();
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "HTTP server listening on" << aAddress.toString() << iServer->serverPort();
+
+    if( iIdleTimeout > 0 ) {
+        iIdleTimer->start( qMax( iIdleTimeout / 2, 1 ) );
+    }
+
+    return true;
+}
+
+bool HTTPServer::isListening() const
+{
+    return iServer->isListening();
+}
+
+quint16 HTTPServer::serverPort() const
+{
+    return iServer->serverPort();
+}
+
+void HTTPServer::close()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iIdleTimer->stop();
+    iServer->close();
+
+    QList<QTcpSocket*> connections = iConnections.keys();
+
+    foreach( QTcpSocket* connection, connections ) {
+        connection->disconnect( this );
+        removeRequests( connection );
+        connection->abort();
+        connection->deleteLater();
+    }
+
+    iConnections.clear();
+}
+
+void HTTPServer::setMaxRequestSize( int aSize )
+{
+    iMaxRequestSize = aSize;
+}
+
+void HTTPServer::setCompressionThreshold( int aThreshold )
+{
+    iCompressionThreshold = aThreshold;
+}
+
+void HTTPServer::setIdleTimeout( int aTimeout )
+{
+    iIdleTimeout = aTimeout;
+
+    if( iIdleTimeout > 0 && iServer->isListening() ) {
+        iIdleTimer->start( qMax( iIdleTimeout / 2, 1 ) );
+    }
+    else {
+        iIdleTimer->stop();
+    }
+}
+
+void HTTPServer::attach( HTTPServerTransport* aTransport )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !aTransport || iTransports.contains( aTransport ) ) {
+        return;
+    }
+
+    iTransports.append( aTransport );
+    iSessions.insert( aTransport, Session() );
+}
+
+void HTTPServer::detach( HTTPServerTransport* aTransport )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    endSession( aTransport );
+
+    iTransports.removeAll( aTransport );
+    iSessions.remove( aTransport );
+}
+
+void HTTPServer::endSession( HTTPServerTransport* aTransport )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iSessions.contains( aTransport ) ) {
+        return;
+    }
+
+    Session& session = iSessions[aTransport];
+
+    if( !session.iSessionKey.isEmpty() ) {
+        qCDebug(lcSyncML) << "Ending HTTP session" << session.iSessionKey;
+    }
+
+    QList<Request> requests = session.iRequests;
+
+    session.iSessionKey.clear();
+    session.iRequests.clear();
+    session.iServing = false;
+
+    // Requests that were not answered are left without response, so their
+    // connections are closed
+    foreach( const Request& request, requests ) {
+        if( iConnections.contains( request.iConnection ) ) {
+            sendError( request.iConnection, HTTP_STATUS_SERVICE_UNAVAILABLE );
+        }
+    }
+}
+
+bool HTTPServer::respond( HTTPServerTransport* aTransport, const QByteArray& aData,
+                          const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !hasPendingRequest( aTransport ) ) {
+        qCWarning(lcSyncML) << "No HTTP request to respond to";
+        return false;
+    }
+
+    Session& session = iSessions[aTransport];
+    Request request = session.iRequests.takeFirst();
+    session.iServing = false;
+
+    QByteArray body = aData;
+    QByteArray coding;
+
+    if( request.iAcceptsGZip && iCompressionThreshold > 0 && aData.size() >= iCompressionThreshold ) {
+
+        QByteArray encoded;
+
+        if( iEncoder.encode( aData, encoded ) ) {
+            qCDebug(lcSyncML) << "Compressed response from" << aData.size() << "to" << encoded.size() << "bytes";
+            body = encoded;
+            coding = HTTP_CONTENT_ENCODING_GZIP;
+        }
+    }
+
+    sendResponse( request.iConnection, HTTP_STATUS_OK, body, aContentType.toLatin1(), coding,
+                  request.iKeepAlive );
+
+    if( request.iKeepAlive && iConnections.contains( request.iConnection ) ) {
+        iConnections[request.iConnection].iBusy = false;
+        iConnections[request.iConnection].iLastActivity.start();
+    }
+
+    // Requests that are already waiting are processed only after returning, so
+    // that they are not delivered while the transport is still sending
+    QTimer::singleShot( 0, this, SLOT(processPendingRequests()) );
+
+    return true;
+}
+
+bool HTTPServer::hasPendingRequest( HTTPServerTransport* aTransport ) const
+{
+    if( !iSessions.contains( aTransport ) ) {
+        return false;
+    }
+
+    const Session& session = iSessions[aTransport];
+
+    return session.iServing && !session.iRequests.isEmpty();
+}
+
+Transport* HTTPServer::acquireTransport()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Transport attaches itself to the server
+    HTTPServerTransport* transport = new HTTPServerTransport( *this );
+    iProvidedTransports.append( transport );
+
+    return transport;
+}
+
+void HTTPServer::releaseTransport( Transport* aTransport )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    HTTPServerTransport* transport = qobject_cast<HTTPServerTransport*>( aTransport );
+
+    if( transport && iProvidedTransports.removeAll( transport ) > 0 ) {
+        delete transport;
+    }
+}
+
+QString HTTPServer::sessionKey( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QBuffer buffer;
+    buffer.setData( aData );
+
+    if( !buffer.open( QIODevice::ReadOnly ) ) {
+        return QString();
+    }
+
+    SyncMLReader reader;
+    reader.setDevice( &buffer );
+
+    QStringList path;
+    QString sessionId;
+    QString source;
+
+    while( !reader.atEnd() ) {
+
+        reader.readNext();
+
+        if( reader.isStartElement() ) {
+
+            if( reader.name() == SYNCML_ELEMENT_SYNCBODY ) {
+                break;
+            }
+
+            path.append( reader.name().toString() );
+        }
+        else if( reader.isEndElement() ) {
+
+            if( reader.name() == SYNCML_ELEMENT_SYNCHDR ) {
+                break;
+            }
+
+            if( !path.isEmpty() ) {
+                path.removeLast();
+            }
+        }
+        else if( reader.isCharacters() ) {
+
+            int depth = path.count();
+
+            if( depth >= 2 && path[depth - 2] == SYNCML_ELEMENT_SYNCHDR &&
+                path[depth - 1] == SYNCML_ELEMENT_SESSIONID ) {
+                sessionId.append( reader.text() );
+            }
+            else if( depth >= 3 && path[depth - 3] == SYNCML_ELEMENT_SYNCHDR &&
+                     path[depth - 2] == SYNCML_ELEMENT_SOURCE &&
+                     path[depth - 1] == SYNCML_ELEMENT_LOCURI ) {
+                source.append( reader.text() );
+            }
+        }
+    }
+
+    sessionId = sessionId.trimmed();
+    source = source.trimmed();
+
+    if( sessionId.isEmpty() || source.isEmpty() ) {
+        return QString();
+    }
+
+    return source + QLatin1Char( '#' ) + sessionId;
+}
+
+void HTTPServer::newConnection()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( iServer->hasPendingConnections() ) {
+
+        QTcpSocket* connection = iServer->nextPendingConnection();
+
+        Connection state;
+        state.iLastActivity.start();
+
+        iConnections.insert( connection, state );
+
+        connect( connection, SIGNAL(readyRead()), this, SLOT(readRequest()) );
+        connect( connection, SIGNAL(disconnected()), this, SLOT(connectionClosed()) );
+
+        qCDebug(lcSyncML) << "New HTTP connection from" << connection->peerAddress().toString();
+    }
+}
+
+void HTTPServer::readRequest()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QTcpSocket* connection = qobject_cast<QTcpSocket*>( sender() );
+
+    if( !connection || !iConnections.contains( connection ) ) {
+        return;
+    }
+
+    Connection& state = iConnections[connection];
+    state.iBuffer.append( connection->readAll() );
+    state.iLastActivity.start();
+
+    // Pipelined requests wait in the buffer while a request is served, so
+    // limit the buffer to the largest request that is accepted
+    if( state.iBuffer.size() > static_cast<qint64>( MAX_HEADER_SIZE ) + iMaxRequestSize ) {
+        qCWarning(lcSyncML) << "HTTP connection buffer too large:" << state.iBuffer.size();
+        state.iBuffer.clear();
+
+        if( state.iBusy ) {
+            // Response to the request being served is still due, so the
+            // connection cannot be answered with an error
+            connection->abort();
+        }
+        else {
+            state.iBusy = true;
+            sendError( connection, HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE );
+        }
+
+        return;
+    }
+
+    processBuffer( connection );
+}
+
+void HTTPServer::connectionClosed()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QTcpSocket* connection = qobject_cast<QTcpSocket*>( sender() );
+
+    if( !connection ) {
+        return;
+    }
+
+    removeRequests( connection );
+    iConnections.remove( connection );
+    connection->deleteLater();
+}
+
+void HTTPServer::closeIdleConnections()
+{
+    QList<QTcpSocket*> idle;
+
+    QMap<QTcpSocket*, Connection>::const_iterator i;
+    for( i = iConnections.constBegin(); i != iConnections.constEnd(); ++i ) {
+        if( !i.value().iBusy && i.value().iLastActivity.elapsed() > iIdleTimeout ) {
+            idle.append( i.key() );
+        }
+    }
+
+    foreach( QTcpSocket* connection, idle ) {
+        qCDebug(lcSyncML) << "Closing idle HTTP connection";
+        connection->disconnectFromHost();
+    }
+}
+
+void HTTPServer::processPendingRequests()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<QTcpSocket*> connections = iConnections.keys();
+
+    foreach( QTcpSocket* connection, connections ) {
+        if( iConnections.contains( connection ) && !iConnections[connection].iBuffer.isEmpty() ) {
+            processBuffer( connection );
+        }
+    }
+
+    QList<HTTPServerTransport*> transports = iTransports;
+
+    foreach( HTTPServerTransport* transport, transports ) {
+        if( iSessions.contains( transport ) ) {
+            deliverNext( transport );
+        }
+    }
+}
+
+void HTTPServer::processBuffer( QTcpSocket* aConnection )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Connection& state = iConnections[aConnection];
+
+    // Only one request of a connection is served at a time. Pipelined
+    // requests wait in the buffer until the previous one has been answered
+    if( state.iBusy ) {
+        return;
+    }
+
+    Request request;
+    int status = parseRequest( aConnection, state, request );
+
+    if( status == 0 ) {
+        return;
+    }
+    else if( status != HTTP_STATUS_OK ) {
+        // Connection is closed after an error, so nothing more is read from it
+        state.iBusy = true;
+        sendError( aConnection, status );
+        return;
+    }
+
+    state.iBusy = true;
+    routeRequest( request );
+}
+
+int HTTPServer::parseRequest( QTcpSocket* aConnection, Connection& aState, Request& aRequest )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    int headerEnd = aState.iBuffer.indexOf( "\r\n\r\n" );
+
+    if( headerEnd < 0 ) {
+        return aState.iBuffer.size() > MAX_HEADER_SIZE ? HTTP_STATUS_BAD_REQUEST : 0;
+    }
+
+    QList<QByteArray> lines = aState.iBuffer.left( headerEnd ).split( '\n' );
+    QList<QByteArray> requestLine = lines.takeFirst().trimmed().split( ' ' );
+
+    if( requestLine.count() != 3 || !requestLine[2].startsWith( "HTTP/1." ) ) {
+        qCWarning(lcSyncML) << "Invalid HTTP request line";
+        return HTTP_STATUS_BAD_REQUEST;
+    }
+
+    QMap<QByteArray, QByteArray> headers;
+
+    foreach( const QByteArray& line, lines ) {
+
+        int colon = line.indexOf( ':' );
+
+        if( colon <= 0 ) {
+            qCWarning(lcSyncML) << "Invalid HTTP header line";
+            return HTTP_STATUS_BAD_REQUEST;
+        }
+
+        headers.insert( line.left( colon ).trimmed().toLower(), line.mid( colon + 1 ).trimmed() );
+    }
+
+    if( requestLine[0] != HTTP_HDRSTR_POST ) {
+        qCWarning(lcSyncML) << "Unsupported HTTP method" << requestLine[0];
+        return HTTP_STATUS_METHOD_NOT_ALLOWED;
+    }
+
+    // Bodies are accepted only with explicit length
+    if( headers.contains( "transfer-encoding" ) || !headers.contains( "content-length" ) ) {
+        return HTTP_STATUS_LENGTH_REQUIRED;
+    }
+
+    bool ok = false;
+    int length = headers.value( "content-length" ).toInt( &ok );
+
+    if( !ok || length < 0 ) {
+        return HTTP_STATUS_BAD_REQUEST;
+    }
+
+    if( length > iMaxRequestSize ) {
+        qCWarning(lcSyncML) << "HTTP request too large:" << length;
+        return HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    int bodyStart = headerEnd + 4;
+
+    if( aState.iBuffer.size() < bodyStart + length ) {
+
+        if( !aState.iContinueSent && headers.value( "expect" ).toLower() == "100-continue" ) {
+            aConnection->write( "HTTP/1.1 100 Continue\r\n\r\n" );
+            aState.iContinueSent = true;
+        }
+
+        return 0;
+    }
+
+    QByteArray body = aState.iBuffer.mid( bodyStart, length );
+    aState.iBuffer.remove( 0, bodyStart + length );
+    aState.iContinueSent = false;
+
+    QByteArray connection = headers.value( "connection" ).toLower();
+
+    if( requestLine[2] == "HTTP/1.0" ) {
+        aRequest.iKeepAlive = connection.contains( "keep-alive" );
+    }
+    else {
+        aRequest.iKeepAlive = !connection.contains( "close" );
+    }
+
+    aRequest.iContentType = QString::fromLatin1( headers.value( "content-type" ) );
+
+    if( !aRequest.iContentType.contains( SYNCML_CONTTYPE_DS_XML ) &&
+        !aRequest.iContentType.contains( SYNCML_CONTTYPE_DS_WBXML ) &&
+        !aRequest.iContentType.contains( SYNCML_CONTTYPE_DM_XML ) &&
+        !aRequest.iContentType.contains( SYNCML_CONTTYPE_DM_WBXML ) ) {
+        qCWarning(lcSyncML) << "Unsupported content type in HTTP request:" << aRequest.iContentType;
+        return HTTP_STATUS_UNSUPPORTED_MEDIA_TYPE;
+    }
+
+    QString coding = QString::fromLatin1( headers.value( "content-encoding" ) );
+
+    if( !coding.isEmpty() && coding.compare( "identity", Qt::CaseInsensitive ) != 0 ) {
+
+        if( !HTTPContentEncoder::canDecode( coding ) ) {
+            qCWarning(lcSyncML) << "Unsupported content encoding in HTTP request:" << coding;
+            return HTTP_STATUS_UNSUPPORTED_MEDIA_TYPE;
+        }
+
+        QByteArray decoded;
+        bool tooLarge = false;
+
+        // Decoded body is subject to the same limit as the received one
+        if( !iEncoder.decode( body, decoded, iMaxRequestSize, tooLarge ) ) {
+            return tooLarge ? HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE : HTTP_STATUS_BAD_REQUEST;
+        }
+
+        body = decoded;
+    }
+
+    aRequest.iSessionKey = sessionKey( body );
+
+    if( aRequest.iSessionKey.isEmpty() ) {
+        qCWarning(lcSyncML) << "Could not find session of HTTP request";
+        return HTTP_STATUS_BAD_REQUEST;
+    }
+
+    aRequest.iConnection = aConnection;
+    aRequest.iBody = body;
+    aRequest.iAcceptsGZip = HTTPContentEncoder::acceptsGZip( QString::fromLatin1( headers.value( "accept-encoding" ) ) );
+
+    return HTTP_STATUS_OK;
+}
+
+void HTTPServer::routeRequest( const Request& aRequest )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    HTTPServerTransport* transport = 0;
+
+    foreach( HTTPServerTransport* candidate, iTransports ) {
+        if( iSessions[candidate].iSessionKey == aRequest.iSessionKey ) {
+            transport = candidate;
+            break;
+        }
+    }
+
+    // Request of a new session is given to the first transport that is not
+    // serving a session
+    if( !transport ) {
+
+        foreach( HTTPServerTransport* candidate, iTransports ) {
+            if( iSessions[candidate].iSessionKey.isEmpty() ) {
+                transport = candidate;
+                iSessions[candidate].iSessionKey = aRequest.iSessionKey;
+                qCDebug(lcSyncML) << "Starting HTTP session" << aRequest.iSessionKey;
+                break;
+            }
+        }
+    }
+
+    if( !transport ) {
+        qCWarning(lcSyncML) << "No transport available for HTTP session" << aRequest.iSessionKey;
+        sendError( aRequest.iConnection, HTTP_STATUS_SERVICE_UNAVAILABLE );
+        return;
+    }
+
+    iSessions[transport].iRequests.append( aRequest );
+    deliverNext( transport );
+}
+
+void HTTPServer::deliverNext( HTTPServerTransport* aTransport )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Session& session = iSessions[aTransport];
+
+    if( session.iServing || session.iRequests.isEmpty() ) {
+        return;
+    }
+
+    session.iServing = true;
+
+    // Transport may respond before returning, so copy the request
+    QByteArray body = session.iRequests.first().iBody;
+    QString contentType = session.iRequests.first().iContentType;
+
+    aTransport->requestReceived( body, contentType );
+}
+
+void HTTPServer::sendResponse( QTcpSocket* aConnection, int aStatus, const QByteArray& aBody,
+                               const QByteArray& aContentType, const QByteArray& aContentEncoding,
+                               bool aKeepAlive )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iConnections.contains( aConnection ) ) {
+        qCWarning(lcSyncML) << "HTTP connection was closed before response";
+        return;
+    }
+
+    QByteArray response = "HTTP/1.1 " + QByteArray::number( aStatus ) + " " + reasonPhrase( aStatus ) + "\r\n";
+
+    if( !aContentType.isEmpty() ) {
+        response += QByteArray( HTTP_HDRSTR_CONTENT_TYPE ) + ": " + aContentType + "\r\n";
+    }
+
+    response += QByteArray( HTTP_HDRSTR_CONTENT_LENGTH ) + ": " + QByteArray::number( aBody.size() ) + "\r\n";
+
+    if( !aContentEncoding.isEmpty() ) {
+        response += QByteArray( HTTP_HDRSTR_CONTENT_ENCODING ) + ": " + aContentEncoding + "\r\n";
+    }
+
+    // Announce the codings that are accepted in requests (RFC 7694)
+    response += QByteArray( HTTP_HDRSTR_ACCEPT_ENCODING ) + ": gzip, deflate\r\n";
+
+    if( aStatus == HTTP_STATUS_METHOD_NOT_ALLOWED ) {
+        response += "Allow: POST\r\n";
+    }
+    else if( aStatus == HTTP_STATUS_SERVICE_UNAVAILABLE ) {
+        response += "Retry-After: " + QByteArray::number( RETRY_AFTER ) + "\r\n";
+    }
+
+    response += QByteArray( HTTP_HDRSTR_CONNECTION ) + ": " + ( aKeepAlive ? "keep-alive" : "close" ) + "\r\n";
+    response += "\r\n";
+    response += aBody;
+
+    aConnection->write( response );
+
+    if( !aKeepAlive ) {
+        aConnection->disconnectFromHost();
+    }
+}
+
+void HTTPServer::sendError( QTcpSocket* aConnection, int aStatus )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qCDebug(lcSyncML) << "Responding to HTTP request with status" << aStatus;
+
+    // State of the connection is unknown after an error, so it is not kept alive
+    sendResponse( aConnection, aStatus, QByteArray(), QByteArray(), QByteArray(), false );
+}
+
+void HTTPServer::removeRequests( QTcpSocket* aConnection )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<HTTPServerTransport*> lostTransports;
+
+    QMap<HTTPServerTransport*, Session>::iterator i;
+    for( i = iSessions.begin(); i != iSessions.end(); ++i ) {
+
+        Session& session = i.value();
+
+        for( int r = session.iRequests.count() - 1; r >= 0; --r ) {
+
+            if( session.iRequests[r].iConnection != aConnection ) {
+                continue;
+            }
+
+            session.iRequests.removeAt( r );
+
+            if( r == 0 && session.iServing ) {
+                session.iServing = false;
+                lostTransports.append( i.key() );
+            }
+        }
+    }
+
+    foreach( HTTPServerTransport* transport, lostTransports ) {
+        qCWarning(lcSyncML) << "HTTP connection closed before request was answered";
+        transport->connectionLost();
+    }
+}
+
+QByteArray HTTPServer::reasonPhrase( int aStatus )
+{
+    switch( aStatus )
+    {
+        case HTTP_STATUS_OK:
+            return "OK";
+        case HTTP_STATUS_BAD_REQUEST:
+            return "Bad Request";
+        case HTTP_STATUS_METHOD_NOT_ALLOWED:
+            return "Method Not Allowed";
+        case HTTP_STATUS_LENGTH_REQUIRED:
+            return "Length Required";
+        case HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE:
+            return "Request Entity Too Large";
+        case HTTP_STATUS_UNSUPPORTED_MEDIA_TYPE:
+            return "Unsupported Media Type";
+        case HTTP_STATUS_SERVICE_UNAVAILABLE:
+            return "Service Unavailable";
+        default:
+            return "Unknown";
+    }
+}
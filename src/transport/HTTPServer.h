@@ -0,0 +1,278 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <QObject>
+#include <QMap>
+#include <QList>
+#include <QHostAddress>
+#include <QElapsedTimer>
+
+#include "HTTPContentEncoder.h"
+#include "TransportProvider.h"
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+namespace DataSync {
+
+class HTTPServerTransport;
+
+/*! \brief Embedded HTTP/1.1 server for SyncML server sessions
+ *
+ * Accepts connections, reads SyncML POST requests from them and routes each
+ * request to the HTTPServerTransport that serves the session of the request.
+ * Sessions are identified by SessionID and source LocURI of the SyncML
+ * header. A request of a new session is given to an attached transport that
+ * is not serving any session yet. If there is none, the request is answered
+ * with 503 Service Unavailable.
+ *
+ * Response to a request is written on the same connection the request came
+ * from, and connections are kept alive between requests unless client asks
+ * otherwise. Requests and responses can be compressed with gzip or deflate
+ * content coding.
+ *
+ * As a TransportProvider, server creates a new attached transport for each
+ * session SyncAgent serves concurrently.
+ */
+class HTTPServer : public QObject, public TransportProvider
+{
+    Q_OBJECT;
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aParent Parent of this object
+     */
+    HTTPServer( QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~HTTPServer();
+
+    /*! \brief Starts listening for connections
+     *
+     * @param aAddress Address to listen on
+     * @param aPort Port to listen on. If 0, a port is chosen automatically
+     * @return True on success, otherwise false
+     */
+    bool listen( const QHostAddress& aAddress = QHostAddress::Any, quint16 aPort = 0 );
+
+    /*! \brief Checks if server is listening for connections
+     *
+     * @return True if listening, otherwise false
+     */
+    bool isListening() const;
+
+    /*! \brief Returns the port server is listening on
+     *
+     * @return Port, or 0 if not listening
+     */
+    quint16 serverPort() const;
+
+    /*! \brief Stops listening and closes all connections
+     *
+     */
+    void close();
+
+    /*! \brief Sets the maximum size of request bodies that are accepted
+     *
+     * Larger requests are answered with 413 Request Entity Too Large
+     *
+     * @param aSize Maximum size in bytes
+     */
+    void setMaxRequestSize( int aSize );
+
+    /*! \brief Sets the minimum size of response bodies that are compressed
+     *
+     * Responses are compressed only if client has announced that it
+     * accepts gzip
+     *
+     * @param aThreshold Minimum size in bytes. 0 disables compression
+     */
+    void setCompressionThreshold( int aThreshold );
+
+    /*! \brief Sets the time after which idle connections are closed
+     *
+     * @param aTimeout Timeout in milliseconds. 0 disables the timeout
+     */
+    void setIdleTimeout( int aTimeout );
+
+    /*! \brief Attaches a transport to receive requests
+     *
+     * @param aTransport Transport to attach
+     */
+    void attach( HTTPServerTransport* aTransport );
+
+    /*! \brief Detaches a transport
+     *
+     * Ends the session served by the transport
+     *
+     * @param aTransport Transport to detach
+     */
+    void detach( HTTPServerTransport* aTransport );
+
+    /*! \brief Ends the session served by a transport
+     *
+     * Transport remains attached and can serve a new session. Connections
+     * of requests that have not been answered are closed.
+     *
+     * @param aTransport Transport whose session to end
+     */
+    void endSession( HTTPServerTransport* aTransport );
+
+    /*! \brief Sends response to the request a transport is serving
+     *
+     * @param aTransport Transport that is responding
+     * @param aData Response body
+     * @param aContentType Content type of the response
+     * @return True on success, false if there is no request to respond to
+     */
+    bool respond( HTTPServerTransport* aTransport, const QByteArray& aData,
+                  const QString& aContentType );
+
+    /*! \brief Checks if a transport is serving a request
+     *
+     * @param aTransport Transport to check
+     * @return True if transport has a request that has not been answered
+     */
+    bool hasPendingRequest( HTTPServerTransport* aTransport ) const;
+
+    /*! \brief Creates a new transport attached to this server
+     *
+     * Transport is owned by the server until it is released
+     *
+     * @return Transport
+     */
+    virtual Transport* acquireTransport();
+
+    /*! \brief Detaches and deletes a transport created by acquireTransport()
+     *
+     * Must not be called from a signal emitted by the transport
+     *
+     * @param aTransport Transport to release
+     */
+    virtual void releaseTransport( Transport* aTransport );
+
+    /*! \brief Returns the key of the session a SyncML message belongs to
+     *
+     * @param aData SyncML message as XML or WbXML
+     * @return Session key, or empty string if message has no SessionID
+     *         or source LocURI
+     */
+    static QString sessionKey( const QByteArray& aData );
+
+private slots:
+
+    void newConnection();
+
+    void readRequest();
+
+    void connectionClosed();
+
+    void closeIdleConnections();
+
+    void processPendingRequests();
+
+private:
+
+    struct Request
+    {
+        QTcpSocket* iConnection;
+        QByteArray  iBody;
+        QString     iContentType;
+        QString     iSessionKey;
+        bool        iAcceptsGZip;
+        bool        iKeepAlive;
+
+        Request() : iConnection( 0 ), iAcceptsGZip( false ), iKeepAlive( false ) { }
+    };
+
+    struct Connection
+    {
+        QByteArray      iBuffer;
+        QElapsedTimer   iLastActivity;
+        bool            iBusy;
+        bool            iContinueSent;
+
+        Connection() : iBusy( false ), iContinueSent( false ) { }
+    };
+
+    struct Session
+    {
+        QString         iSessionKey;
+        QList<Request>  iRequests;
+        bool            iServing;
+
+        Session() : iServing( false ) { }
+    };
+
+    void processBuffer( QTcpSocket* aConnection );
+
+    int parseRequest( QTcpSocket* aConnection, Connection& aState, Request& aRequest );
+
+    void routeRequest( const Request& aRequest );
+
+    void deliverNext( HTTPServerTransport* aTransport );
+
+    void sendResponse( QTcpSocket* aConnection, int aStatus, const QByteArray& aBody,
+                       const QByteArray& aContentType, const QByteArray& aContentEncoding,
+                       bool aKeepAlive );
+
+    void sendError( QTcpSocket* aConnection, int aStatus );
+
+    void removeRequests( QTcpSocket* aConnection );
+
+    static QByteArray reasonPhrase( int aStatus );
+
+    QTcpServer*                             iServer;
+    QTimer*                                 iIdleTimer;
+    HTTPContentEncoder                      iEncoder;
+    int                                     iMaxRequestSize;
+    int                                     iCompressionThreshold;
+    int                                     iIdleTimeout;
+    QMap<QTcpSocket*, Connection>           iConnections;
+    QMap<HTTPServerTransport*, Session>     iSessions;
+    QList<HTTPServerTransport*>             iTransports;
+    QList<HTTPServerTransport*>             iProvidedTransports;
+
+};
+
+}
+
+#endif  //  HTTPSERVER_H
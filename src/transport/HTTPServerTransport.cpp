@@ -0,0 +1,178 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "HTTPServerTransport.h"
+
+#include "HTTPServer.h"
+#include "SyncAgentConfigProperties.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+HTTPServerTransport::HTTPServerTransport( const ProtocolContext& aContext, QObject* aParent )
+ : BaseTransport( aContext, aParent ), iServer( 0 ), iOwnsServer( true ),
+   iAddress( QHostAddress::Any ), iPort( 0 )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iServer = new HTTPServer;
+    iServer->attach( this );
+}
+
+HTTPServerTransport::HTTPServerTransport( HTTPServer& aServer, const ProtocolContext& aContext,
+                                          QObject* aParent )
+ : BaseTransport( aContext, aParent ), iServer( &aServer ), iOwnsServer( false ),
+   iAddress( QHostAddress::Any ), iPort( 0 )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iServer->attach( this );
+}
+
+HTTPServerTransport::~HTTPServerTransport()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iServer->detach( this );
+
+    if( iOwnsServer ) {
+        delete iServer;
+    }
+
+    iServer = NULL;
+}
+
+void HTTPServerTransport::setProperty( const QString& aProperty, const QString& aValue )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aProperty == HTTPSERVERADDRESSPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        iAddress = QHostAddress( aValue );
+    }
+    else if( aProperty == HTTPSERVERPORTPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        iPort = aValue.toUShort();
+    }
+    else if( aProperty == HTTPSERVERIDLETIMEOUTPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        iServer->setIdleTimeout( aValue.toInt() );
+    }
+    else if( aProperty == HTTPCOMPRESSIONTHRESHOLDPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        iServer->setCompressionThreshold( aValue.toInt() );
+    }
+    else
+    {
+        BaseTransport::setProperty( aProperty, aValue );
+    }
+}
+
+bool HTTPServerTransport::init()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Shared server is started by its owner. Listening is kept up between
+    // sessions, so init() can be called for each session
+    if( iOwnsServer && !iServer->isListening() ) {
+        return iServer->listen( iAddress, iPort );
+    }
+
+    return true;
+}
+
+void HTTPServerTransport::close()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iServer->endSession( this );
+}
+
+HTTPServer& HTTPServerTransport::server()
+{
+    return *iServer;
+}
+
+bool HTTPServerTransport::prepareSend()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Server can only send responses to requests
+    if( !iServer->hasPendingRequest( this ) ) {
+        qCCritical(lcSyncML) << "No HTTP request to respond to";
+        emit sendEvent( TRANSPORT_CONNECTION_FAILED, "No request to respond to" );
+        return false;
+    }
+
+    return true;
+}
+
+bool HTTPServerTransport::doSend( const QByteArray& aData, const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iServer->respond( this, aData, aContentType ) ) {
+        emit sendEvent( TRANSPORT_CONNECTION_ABORTED, "Could not respond to request" );
+        return false;
+    }
+
+    return true;
+}
+
+bool HTTPServerTransport::doReceive( const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    Q_UNUSED( aContentType );
+
+    // Requests are passed to receive() as they arrive
+    return true;
+}
+
+void HTTPServerTransport::requestReceived( const QByteArray& aData, const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    receive( aData, aContentType );
+}
+
+void HTTPServerTransport::connectionLost()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    emit sendEvent( TRANSPORT_CONNECTION_ABORTED, "Client closed connection" );
+}
@@ -0,0 +1,123 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef HTTPSERVERTRANSPORT_H
+#define HTTPSERVERTRANSPORT_H
+
+#include <QHostAddress>
+
+#include "BaseTransport.h"
+
+namespace DataSync {
+
+class HTTPServer;
+
+/*! \brief HTTP server implementation of the Transport class
+ *
+ * Serves one SyncML session at a time over HTTP. Requests are read by
+ * HTTPServer, which can either be owned by the transport or shared between
+ * several transports that serve concurrent sessions. Each message sent with
+ * the transport is the response to the latest request received.
+ */
+class HTTPServerTransport : public BaseTransport
+{
+    Q_OBJECT
+
+public:
+
+    /*! \brief Constructor
+     *
+     * Transport owns a server that starts listening in init(), on the
+     * address and port set with properties
+     *
+     * @param aContext Protocol context
+     * @param aParent Parent of this object
+     */
+    HTTPServerTransport( const ProtocolContext& aContext = CONTEXT_DS, QObject* aParent = 0 );
+
+    /*! \brief Constructor
+     *
+     * Transport uses a server that is shared with other transports. The
+     * server must outlive the transport, and listening must be started
+     * separately
+     *
+     * @param aServer Server to use
+     * @param aContext Protocol context
+     * @param aParent Parent of this object
+     */
+    HTTPServerTransport( HTTPServer& aServer, const ProtocolContext& aContext = CONTEXT_DS,
+                         QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~HTTPServerTransport();
+
+    virtual void setProperty( const QString& aProperty, const QString& aValue );
+
+    virtual bool init();
+
+    virtual void close();
+
+    /*! \brief Returns the server used by the transport
+     *
+     * @return Server
+     */
+    HTTPServer& server();
+
+protected:
+
+    virtual bool prepareSend();
+
+    virtual bool doSend( const QByteArray& aData, const QString& aContentType );
+
+    virtual bool doReceive( const QString& aContentType );
+
+private:
+
+    void requestReceived( const QByteArray& aData, const QString& aContentType );
+
+    void connectionLost();
+
+    HTTPServer*     iServer;
+    bool            iOwnsServer;
+    QHostAddress    iAddress;
+    quint16         iPort;
+
+    friend class HTTPServer;
+
+};
+
+}
+
+#endif  //  HTTPSERVERTRANSPORT_H
@@ -44,7 +44,8 @@ using namespace DataSync;
 
 HTTPTransport::HTTPTransport( const ProtocolContext& aContext, QObject* aParent )
 : BaseTransport( aContext, aParent), iManager( 0 ), iFirstMessageSent( false ),
-  iMaxNumberOfResendAttempts( 0 ), iNumberOfResendAttempts( 0 )
+  iMaxNumberOfResendAttempts( 0 ), iNumberOfResendAttempts( 0 ), iCompressionThreshold( 0 ),
+  iRemoteAcceptsGZip( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -87,6 +88,20 @@ void HTTPTransport::setProperty( const QString& aProperty, const QString& aValue
         proxy.setPort( aValue.toInt() );
         iManager->setProxy(proxy);
     }
+    else if( aProperty == HTTPINCREMENTALRECEIVEPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        setIncrementalReceive( aValue.toInt() > 0 );
+    }
+    else if( aProperty == HTTPCOMPRESSIONTHRESHOLDPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        iCompressionThreshold = aValue.toInt();
+    }
+    else
+    {
+        BaseTransport::setProperty( aProperty, aValue );
+    }
 
 }
 
@@ -106,6 +121,7 @@ bool HTTPTransport::init()
 #endif
 
     iFirstMessageSent = false;
+    iRemoteAcceptsGZip = false;
 
     return true;
 }
@@ -185,6 +201,9 @@ void HTTPTransport::prepareRequest( QNetworkRequest& aRequest, const QByteArray&
     aRequest.setRawHeader( HTTP_HDRSTR_UA, HTTP_UA_VALUE);
     aRequest.setRawHeader( HTTP_HDRSTR_CONTENT_TYPE, aContentType );
     aRequest.setRawHeader( HTTP_HDRSTR_ACCEPT,HTTP_ACCEPT_VALUE );
+    // Accept-Encoding is deliberately not set here: QNetworkAccessManager advertises
+    // gzip and deflate by itself, and decodes the reply transparently only when the
+    // header has not been set explicitly
     aRequest.setHeader( QNetworkRequest::ContentLengthHeader, QVariant( aContentLength ) );
     QMap<QString, QString>::const_iterator i;
     for (i = iXheaders.constBegin(); i != iXheaders.constEnd(); i++) {
@@ -214,8 +233,30 @@ bool HTTPTransport::sendRequest( const QByteArray& aData, const QString& aConten
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     // build the message, and send it
+    QByteArray body = aData;
+    QByteArray encoded;
+    bool compressed = shouldCompress( aData ) && iEncoder.encode( aData, encoded );
+
+    if( compressed ) {
+        qCDebug(lcSyncML) << "Compressed message from" << aData.size() << "to" << encoded.size() << "bytes";
+        body = encoded;
+
+        // Keep the message so that it can be re-sent uncompressed if remote side
+        // rejects the compressed one
+        iCompressedMessageData = aData;
+        iCompressedMessageContentType = aContentType;
+    }
+    else {
+        iCompressedMessageData.clear();
+        iCompressedMessageContentType.clear();
+    }
+
     QNetworkRequest request;
-    prepareRequest( request, aContentType.toLatin1(), aData.size() );
+    prepareRequest( request, aContentType.toLatin1(), body.size() );
+
+    if( compressed ) {
+        request.setRawHeader( HTTP_HDRSTR_CONTENT_ENCODING, HTTP_CONTENT_ENCODING_GZIP );
+    }
 
 #ifndef QT_NO_DEBUG
     // Print the message
@@ -227,7 +268,16 @@ bool HTTPTransport::sendRequest( const QByteArray& aData, const QString& aConten
     }
 #endif  //  QT_NO_DEBUG
 
-    if( iManager->post(request, aData) ) {
+    QNetworkReply* reply = iManager->post( request, body );
+
+    if( reply ) {
+
+        iReplyData.clear();
+
+        if( useIncrementalReceive() ) {
+            connect( reply, SIGNAL(readyRead()), this, SLOT(httpReadyRead()) );
+        }
+
         // send succeeded
         return true;
     }
@@ -237,6 +287,93 @@ bool HTTPTransport::sendRequest( const QByteArray& aData, const QString& aConten
     }
 }
 
+bool HTTPTransport::shouldCompress( const QByteArray& aData ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Outgoing messages are compressed only after remote side has announced with
+    // Accept-Encoding in a response that it accepts gzip encoded requests. Thus the
+    // first message of a session is always sent uncompressed
+    if( iCompressionThreshold > 0 && iRemoteAcceptsGZip && aData.size() >= iCompressionThreshold ) {
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+bool HTTPTransport::decodeReply( QNetworkReply* aReply, QByteArray& aData ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // QNetworkAccessManager decodes gzip and deflate encoded replies transparently and
+    // removes Content-Encoding header when it does so. If the header is still present,
+    // the body has not been decoded yet
+    QString coding = QString::fromLatin1( aReply->rawHeader( HTTP_HDRSTR_CONTENT_ENCODING ) ).trimmed();
+
+    if( coding.isEmpty() || coding.compare( "identity", Qt::CaseInsensitive ) == 0 ) {
+        return true;
+    }
+
+    if( !HTTPContentEncoder::canDecode( coding ) ) {
+        qCWarning(lcSyncML) << "Unsupported content encoding in response:" << coding;
+        return false;
+    }
+
+    QByteArray decoded;
+    bool tooLarge = false;
+
+    // Decoded responses are limited like the requests of the HTTP server
+    if( !iEncoder.decode( aData, decoded, HTTP_DEFAULT_MAX_MESSAGE_SIZE, tooLarge ) ) {
+        qCWarning(lcSyncML) << "Could not decode response with content encoding" << coding;
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "Decoded response from" << aData.size() << "to" << decoded.size() << "bytes";
+    aData = decoded;
+
+    return true;
+}
+
+void HTTPTransport::updateRemoteEncodings( QNetworkReply* aReply )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Remote side announces the codings it accepts in requests with Accept-Encoding
+    // header of a response (RFC 7694). If the header is missing, keep what was
+    // learned from earlier responses
+    if( !aReply->hasRawHeader( HTTP_HDRSTR_ACCEPT_ENCODING ) ) {
+        return;
+    }
+
+    bool acceptsGZip = HTTPContentEncoder::acceptsGZip( QString::fromLatin1( aReply->rawHeader( HTTP_HDRSTR_ACCEPT_ENCODING ) ) );
+
+    if( acceptsGZip != iRemoteAcceptsGZip ) {
+        qCDebug(lcSyncML) << "Remote side accepts gzip encoded messages:" << acceptsGZip;
+        iRemoteAcceptsGZip = acceptsGZip;
+    }
+}
+
+bool HTTPTransport::resendUncompressed( QNetworkReply* aReply )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    int status = aReply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+
+    if( status != HTTP_STATUS_UNSUPPORTED_MEDIA_TYPE || iCompressedMessageData.isEmpty() ) {
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "Remote side rejected compressed message, re-sending it uncompressed";
+
+    iRemoteAcceptsGZip = false;
+
+    QByteArray data = iCompressedMessageData;
+    QString contentType = iCompressedMessageContentType;
+
+    return sendRequest( data, contentType );
+}
+
 bool HTTPTransport::shouldResend() const
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -293,6 +430,9 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
                 // In case the remote side times out, possibly try to re-send the message.
                 // If message should not be re-sent, or the re-send fails, handle as
                 // an error
+                discardParts();
+                iReplyData.clear();
+
                 if( !shouldResend() || !resend() ) {
                     qCDebug(lcSyncML) << "Connection timeout:" << aReply->errorString();
                     emit sendEvent(TRANSPORT_CONNECTION_TIMEOUT, aReply->errorString());
@@ -301,8 +441,15 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
             }
             default:
             {
-                qCDebug(lcSyncML) << "TRANSPORT ERROR REASON:" << aReply->errorString();
-                emit sendEvent(TRANSPORT_CONNECTION_FAILED, aReply->errorString());
+                discardParts();
+                iReplyData.clear();
+
+                // Remote side might not support compressed requests after all. In that case
+                // try to re-send the message uncompressed
+                if( !resendUncompressed( aReply ) ) {
+                    qCDebug(lcSyncML) << "TRANSPORT ERROR REASON:" << aReply->errorString();
+                    emit sendEvent(TRANSPORT_CONNECTION_FAILED, aReply->errorString());
+                }
                 break;
             }
         };
@@ -319,7 +466,20 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
         }
 #endif  //  QT_NO_DEBUG
 
-        QByteArray data = aReply->readAll();
+        updateRemoteEncodings( aReply );
+        iCompressedMessageData.clear();
+        iCompressedMessageContentType.clear();
+
+        // Parts of the data may have been read already as they arrived
+        QByteArray data = iReplyData + aReply->readAll();
+        iReplyData.clear();
+
+        if( !decodeReply( aReply, data ) ) {
+            discardParts();
+            emit sendEvent( TRANSPORT_DATA_INVALID_CONTENT, "Could not decode response" );
+            aReply->deleteLater();
+            return;
+        }
 
         // In case of zero-length response, possibly try to re-send the message. If the message
         // should not be re-sent, or if re-send fails, let the zero-length response through.
@@ -344,6 +504,28 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
 
 }
 
+void HTTPTransport::httpReadyRead()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>( sender() );
+
+    if( !reply || reply->error() != QNetworkReply::NoError ) {
+        return;
+    }
+
+    QByteArray data = reply->readAll();
+    iReplyData.append( data );
+
+    // Encoded data that was not decoded by QNetworkAccessManager is decoded only
+    // when the whole reply has been received
+    if( reply->hasRawHeader( HTTP_HDRSTR_CONTENT_ENCODING ) ) {
+        return;
+    }
+
+    receivePart( data, reply->header( QNetworkRequest::ContentTypeHeader ).toString() );
+}
+
 void HTTPTransport::authRequired(QNetworkReply* /*aReply*/, QAuthenticator* /*aAuth*/ ) {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     qCDebug(lcSyncML) << "Network Connection needs authentication";
@@ -37,6 +37,7 @@
 #include <QMap>
 
 #include "BaseTransport.h"
+#include "HTTPContentEncoder.h"
 #include <QNetworkAccessManager>
 
 class QNetworkProxy;
@@ -103,6 +104,8 @@ private slots:
 
     void httpRequestFinished( QNetworkReply* aReply );
 
+    void httpReadyRead();
+
     void slotNetworkStateChanged(bool aState);
 
     void handleProxyAuthentication( QNetworkProxy& aProxy, QAuthenticator* aAuth );
@@ -121,6 +124,14 @@ private:
 
     bool sendRequest( const QByteArray& aData, const QString& aContentType );
 
+    bool shouldCompress( const QByteArray& aData ) const;
+
+    bool decodeReply( QNetworkReply* aReply, QByteArray& aData ) const;
+
+    void updateRemoteEncodings( QNetworkReply* aReply );
+
+    bool resendUncompressed( QNetworkReply* aReply );
+
     bool shouldResend() const;
     bool resend();
 
@@ -134,6 +145,12 @@ private:
     int                     iMaxNumberOfResendAttempts;
     int                     iNumberOfResendAttempts;
     QMap<QString, QString>  iXheaders;
+    QByteArray              iReplyData;
+    HTTPContentEncoder      iEncoder;
+    int                     iCompressionThreshold;
+    bool                    iRemoteAcceptsGZip;
+    QByteArray              iCompressedMessageData;
+    QString                 iCompressedMessageContentType;
 };
 
 }
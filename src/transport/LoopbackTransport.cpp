@@ -0,0 +1,149 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "LoopbackTransport.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+LoopbackTransport::LoopbackTransport( const ProtocolContext& aContext, QObject* aParent )
+ : BaseTransport( aContext, aParent ), iPeer( 0 ), iMessagesSent( 0 ), iBytesSent( 0 )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+LoopbackTransport::~LoopbackTransport()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    setPeer( NULL );
+}
+
+void LoopbackTransport::setPeer( LoopbackTransport* aPeer )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aPeer == iPeer ) {
+        return;
+    }
+
+    if( iPeer ) {
+        iPeer->iPeer = NULL;
+    }
+
+    iPeer = aPeer;
+
+    if( iPeer ) {
+        iPeer->setPeer( NULL );
+        iPeer->iPeer = this;
+    }
+}
+
+LoopbackTransport* LoopbackTransport::peer() const
+{
+    return iPeer;
+}
+
+bool LoopbackTransport::init()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    return iPeer != NULL;
+}
+
+void LoopbackTransport::close()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+int LoopbackTransport::messagesSent() const
+{
+    return iMessagesSent;
+}
+
+qint64 LoopbackTransport::bytesSent() const
+{
+    return iBytesSent;
+}
+
+void LoopbackTransport::resetStatistics()
+{
+    iMessagesSent = 0;
+    iBytesSent = 0;
+}
+
+bool LoopbackTransport::prepareSend()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iPeer ) {
+        qCCritical(lcSyncML) << "Loopback transport is not connected";
+        emit sendEvent( TRANSPORT_CONNECTION_FAILED, "Transport is not connected" );
+        return false;
+    }
+
+    return true;
+}
+
+bool LoopbackTransport::doSend( const QByteArray& aData, const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    ++iMessagesSent;
+    iBytesSent += aData.size();
+
+    // Deliver through the event loop, so that sender has finished processing
+    // the message before receiver starts processing it
+    QMetaObject::invokeMethod( iPeer, "deliver", Qt::QueuedConnection,
+                               Q_ARG( QByteArray, aData ),
+                               Q_ARG( QString, aContentType ) );
+
+    return true;
+}
+
+bool LoopbackTransport::doReceive( const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+    Q_UNUSED( aContentType );
+
+    // Messages are passed to receive() as they are delivered
+    return true;
+}
+
+void LoopbackTransport::deliver( const QByteArray& aData, const QString& aContentType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    receive( aData, aContentType );
+}
@@ -0,0 +1,125 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef LOOPBACKTRANSPORT_H
+#define LOOPBACKTRANSPORT_H
+
+#include "BaseTransport.h"
+
+namespace DataSync {
+
+/*! \brief In-process implementation of the Transport class
+ *
+ * Connects two parties of a SyncML session inside one process, usually a
+ * client and a server SyncAgent. Messages sent with a transport are passed
+ * to its peer through the event loop, so no network is involved. Transport
+ * keeps count of messages and bytes it has sent.
+ */
+class LoopbackTransport : public BaseTransport
+{
+    Q_OBJECT
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aContext Protocol context
+     * @param aParent Parent of this object
+     */
+    LoopbackTransport( const ProtocolContext& aContext = CONTEXT_DS, QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     * Disconnects the transport from its peer
+     */
+    virtual ~LoopbackTransport();
+
+    /*! \brief Connects the transport with a peer
+     *
+     * Connection is two-way, so peer is also connected with this transport.
+     * Previous peers of both transports are disconnected
+     *
+     * @param aPeer Transport to connect with, or NULL to disconnect
+     */
+    void setPeer( LoopbackTransport* aPeer );
+
+    /*! \brief Returns the peer of the transport
+     *
+     * @return Peer, or NULL if not connected
+     */
+    LoopbackTransport* peer() const;
+
+    virtual bool init();
+
+    virtual void close();
+
+    /*! \brief Returns the number of messages sent with the transport
+     *
+     * @return Number of messages
+     */
+    int messagesSent() const;
+
+    /*! \brief Returns the number of bytes sent with the transport
+     *
+     * @return Number of bytes
+     */
+    qint64 bytesSent() const;
+
+    /*! \brief Resets message and byte counts
+     *
+     */
+    void resetStatistics();
+
+protected:
+
+    virtual bool prepareSend();
+
+    virtual bool doSend( const QByteArray& aData, const QString& aContentType );
+
+    virtual bool doReceive( const QString& aContentType );
+
+private slots:
+
+    void deliver( const QByteArray& aData, const QString& aContentType );
+
+private:
+
+    LoopbackTransport*  iPeer;
+    int                 iMessagesSent;
+    qint64              iBytesSent;
+
+};
+
+}
+
+#endif  //  LOOPBACKTRANSPORT_H
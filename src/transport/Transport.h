@@ -170,6 +170,9 @@ signals:
     void sendEvent( DataSync::TransportStatusEvent aEvent, const QString& aDescription );
 
     /*! \brief Signal that is emitted when new XML data is available
+     *
+     * SyncML DS messages received as WbXML are passed as is, the parser
+     * detects the format of the data.
      *
      * @param aDevice QIODevice that can be used to read data
      * @param aIsNewPacket bool To indicate if this is a newly received packet
@@ -177,12 +180,43 @@ signals:
      */
     void readXMLData( QIODevice* aDevice, bool aIsNewPacket );
 
+    /*! \brief Signal that is emitted when part of new XML data is available
+     *
+     * Transports that receive messages incrementally emit the parts of a
+     * message as they arrive, instead of emitting readXMLData() for the
+     * whole message. Purged messages are still passed with readXMLData().
+     *
+     * @param aData Next part of the message
+     * @param aFirstPart True if this is the first part of a new message
+     * @param aLastPart True if this is the last part of the message
+     */
+    void readXMLDataPart( const QByteArray& aData, bool aFirstPart, bool aLastPart );
+
     /*! \brief Signal that is emitted when new SAN data is available
      *
      * @param aDevice QIODevice that can be used to read data
      */
     void readSANData( QIODevice* aDevice );
 
+    /*! \brief Signal that is emitted when a message has been sent
+     *
+     * Size is that of the encoded message before any content coding
+     * applied by the transport, such as HTTP compression.
+     *
+     * @param aBytes Size of the sent message
+     * @param aEncodeTime Time spent encoding the message, in microseconds
+     */
+    void messageSent( qint64 aBytes, qint64 aEncodeTime );
+
+    /*! \brief Signal that is emitted when a message has been received
+     *
+     * Size is that of the message after any content coding applied by the
+     * transport has been removed.
+     *
+     * @param aBytes Size of the received message
+     */
+    void messageReceived( qint64 aBytes );
+
 private slots:
 
     /*! \brief Remove any illegal XML characters from the previous message
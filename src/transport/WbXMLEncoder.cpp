@@ -0,0 +1,264 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "WbXMLEncoder.h"
+
+#include "WbXMLTokens.h"
+#include "SyncMLCmdObject.h"
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+WbXMLEncoder::WbXMLEncoder()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+WbXMLEncoder::~WbXMLEncoder()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+bool WbXMLEncoder::encodeToWbXML( const SyncMLCmdObject& aRootObject,
+                                  ProtocolVersion aVersion,
+                                  QByteArray& aWbXMLDocument ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    WbXMLSizeEstimator::CodeSpace codeSpace = WbXMLSizeEstimator::codeSpace( aRootObject );
+
+    if( aVersion == SYNCML_UNKNOWN ||
+        codeSpace == WbXMLSizeEstimator::CODESPACE_INHERIT ||
+        codeSpace == WbXMLSizeEstimator::CODESPACE_DMDDF ) {
+        qCDebug(lcSyncML) << "Document language not supported by WbXML encoder";
+        return false;
+    }
+
+    int start = aWbXMLDocument.size();
+
+    if( !encodeDocument( aRootObject, codeSpace, aVersion, aWbXMLDocument ) ) {
+        aWbXMLDocument.truncate( start );
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "wbXML buffer size:" << aWbXMLDocument.size() - start;
+
+    return true;
+}
+
+bool WbXMLEncoder::encodeDocument( const SyncMLCmdObject& aRootObject,
+                                   WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                                   ProtocolVersion aVersion, QByteArray& aData ) const
+{
+    // MetInf is a code page of the SyncML language
+    WbXMLSizeEstimator::CodeSpace language = aCodeSpace;
+
+    if( language == WbXMLSizeEstimator::CODESPACE_METINF ) {
+        language = WbXMLSizeEstimator::CODESPACE_SYNCML;
+    }
+
+    aData.append( char( WbXMLTokens::WBXML_VERSION ) );
+    appendMbUInt32( aData, WbXMLTokens::publicId( language, aVersion ) );
+    appendMbUInt32( aData, WbXMLTokens::CHARSET_UTF8 );
+
+    // String table is not used
+    aData.append( char( 0 ) );
+
+    quint8 page = 0;
+
+    return encodeElement( aRootObject, aCodeSpace, aVersion, page, aData );
+}
+
+bool WbXMLEncoder::encodeElement( const SyncMLCmdObject& aObject,
+                                  WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                                  ProtocolVersion aVersion, quint8& aPage,
+                                  QByteArray& aData ) const
+{
+    const QMap<QString, QString>& attributes = aObject.getAttributes();
+
+    if( !attributes.isEmpty() &&
+        ( attributes.count() > 1 || attributes.constBegin().key() != QLatin1String( XML_NAMESPACE ) ) ) {
+        qCDebug(lcSyncML) << "Attributes of element" << aObject.getName() << "not supported by WbXML encoder";
+        return false;
+    }
+
+    int token = WbXMLTokens::tagToken( aCodeSpace, aVersion, aObject.getName() );
+
+    if( token < 0 ) {
+        qCDebug(lcSyncML) << "Element" << aObject.getName() << "not supported by WbXML encoder";
+        return false;
+    }
+
+    quint8 page = WbXMLTokens::PAGE_SYNCML;
+
+    if( aCodeSpace == WbXMLSizeEstimator::CODESPACE_METINF ) {
+        page = WbXMLTokens::PAGE_METINF;
+    }
+
+    if( page != aPage ) {
+        aData.append( char( WbXMLTokens::SWITCH_PAGE ) );
+        aData.append( char( page ) );
+        aPage = page;
+    }
+
+    int tagPos = aData.size();
+    bool content = false;
+
+    aData.append( char( token ) );
+
+    const QString& value = aObject.getValue();
+
+    if( !value.isEmpty() ) {
+
+        int size = WbXMLSizeEstimator::utf8Size( value );
+
+        if( aObject.getCDATA() ) {
+            aData.append( char( WbXMLTokens::OPAQUE ) );
+            appendMbUInt32( aData, size );
+            appendUtf8( aData, value, size );
+        }
+        else {
+            aData.append( char( WbXMLTokens::STR_I ) );
+            appendUtf8( aData, value, size );
+            aData.append( char( 0 ) );
+        }
+
+        content = true;
+    }
+
+    const QList<SyncMLCmdObject*>& children = aObject.getChildren();
+
+    for( int i = 0; i < children.count(); ++i ) {
+
+        const SyncMLCmdObject& child = *children[i];
+        WbXMLSizeEstimator::CodeSpace childCodeSpace = WbXMLSizeEstimator::codeSpace( child );
+
+        if( childCodeSpace == WbXMLSizeEstimator::CODESPACE_INHERIT ) {
+            childCodeSpace = aCodeSpace;
+        }
+
+        if( !WbXMLSizeEstimator::sameLanguage( childCodeSpace, aCodeSpace ) ) {
+
+            if( childCodeSpace == WbXMLSizeEstimator::CODESPACE_DMDDF ) {
+                qCDebug(lcSyncML) << "Element" << child.getName() << "not supported by WbXML encoder";
+                return false;
+            }
+
+            // Child is written as a separate document inside opaque data. The
+            // length is only known afterwards, so it is inserted in front
+            aData.append( char( WbXMLTokens::OPAQUE ) );
+            int documentPos = aData.size();
+
+            if( !encodeDocument( child, childCodeSpace, aVersion, aData ) ) {
+                return false;
+            }
+
+            QByteArray length;
+            appendMbUInt32( length, aData.size() - documentPos );
+            aData.insert( documentPos, length );
+        }
+        else if( !encodeElement( child, childCodeSpace, aVersion, aPage, aData ) ) {
+            return false;
+        }
+
+        content = true;
+    }
+
+    if( content ) {
+        aData[tagPos] = char( token | WbXMLTokens::TAG_CONTENT );
+        aData.append( char( WbXMLTokens::END ) );
+    }
+
+    return true;
+}
+
+void WbXMLEncoder::appendMbUInt32( QByteArray& aData, quint32 aValue )
+{
+    // 7 bits per byte, most significant first, continuation bit in all but last
+    char bytes[5];
+    int count = 0;
+
+    do {
+        bytes[4 - count] = char( ( aValue & 0x7F ) | ( count > 0 ? 0x80 : 0x00 ) );
+        aValue >>= 7;
+        ++count;
+    } while( aValue > 0 );
+
+    aData.append( bytes + 5 - count, count );
+}
+
+void WbXMLEncoder::appendUtf8( QByteArray& aData, const QString& aString, int aSize )
+{
+    // Write straight into the output buffer instead of converting with
+    // QString::toUtf8() first. aSize is the size from WbXMLSizeEstimator::utf8Size().
+    int pos = aData.size();
+    aData.resize( pos + aSize );
+
+    uchar* out = reinterpret_cast<uchar*>( aData.data() ) + pos;
+    const QChar* data = aString.constData();
+    const int length = aString.length();
+
+    for( int i = 0; i < length; ++i ) {
+
+        uint c = data[i].unicode();
+
+        if( c < 0x80 ) {
+            *out++ = uchar( c );
+        }
+        else if( c < 0x800 ) {
+            *out++ = uchar( 0xC0 | ( c >> 6 ) );
+            *out++ = uchar( 0x80 | ( c & 0x3F ) );
+        }
+        else if( data[i].isHighSurrogate() && i + 1 < length && data[i + 1].isLowSurrogate() ) {
+            c = QChar::surrogateToUcs4( data[i], data[i + 1] );
+            ++i;
+            *out++ = uchar( 0xF0 | ( c >> 18 ) );
+            *out++ = uchar( 0x80 | ( ( c >> 12 ) & 0x3F ) );
+            *out++ = uchar( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+            *out++ = uchar( 0x80 | ( c & 0x3F ) );
+        }
+        else {
+
+            if( data[i].isSurrogate() ) {
+                // Unpaired surrogate, written as replacement character like QString::toUtf8()
+                c = QChar::ReplacementCharacter;
+            }
+
+            *out++ = uchar( 0xE0 | ( c >> 12 ) );
+            *out++ = uchar( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+            *out++ = uchar( 0x80 | ( c & 0x3F ) );
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef WBXMLENCODER_H
+#define WBXMLENCODER_H
+
+#include <QByteArray>
+
+#include "SyncAgentConsts.h"
+#include "WbXMLSizeEstimator.h"
+
+namespace DataSync {
+
+class SyncMLCmdObject;
+
+/*! \brief WbXML encoder that writes SyncML object trees directly to bytes
+ *
+ * Produces the same output as LibWbXML2Encoder for SyncML, MetInf and DevInf
+ * elements, following the encoding rules described in WbXMLSizeEstimator,
+ * but without building an intermediate libwbxml2 tree. Documents that use
+ * other languages or attributes are not supported, LibWbXML2Encoder should
+ * be used for them.
+ */
+class WbXMLEncoder
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    WbXMLEncoder();
+
+    /*! \brief Destructor
+     *
+     */
+    ~WbXMLEncoder();
+
+    /*! \brief Encode a SyncML message to WbXML document
+     *
+     * Document is appended to aWbXMLDocument. If encoding fails,
+     * aWbXMLDocument is left unchanged.
+     *
+     * @param aRootObject Root object of the document
+     * @param aVersion SyncML version
+     * @param aWbXMLDocument Output WbXML document
+     * @return True on success, otherwise false
+     */
+    bool encodeToWbXML( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion,
+                        QByteArray& aWbXMLDocument ) const;
+
+protected:
+
+private:
+
+    bool encodeDocument( const SyncMLCmdObject& aRootObject, WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                         ProtocolVersion aVersion, QByteArray& aData ) const;
+
+    bool encodeElement( const SyncMLCmdObject& aObject, WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                        ProtocolVersion aVersion, quint8& aPage, QByteArray& aData ) const;
+
+    static void appendMbUInt32( QByteArray& aData, quint32 aValue );
+
+    static void appendUtf8( QByteArray& aData, const QString& aString, int aSize );
+
+};
+
+}
+
+#endif  //  WBXMLENCODER_H
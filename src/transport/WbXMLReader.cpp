@@ -0,0 +1,625 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "WbXMLReader.h"
+
+#include <string.h>
+
+#include "WbXMLTokens.h"
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+// Reader is called for every token of every incoming message, so function
+// tracing is intentionally not enabled here.
+
+using namespace DataSync;
+
+// IANA MIB enum of US-ASCII, a subset of UTF-8
+static const quint32 CHARSET_US_ASCII = 3;
+
+// Charset was not specified in the document
+static const quint32 CHARSET_UNKNOWN = 0;
+
+WbXMLReader::WbXMLReader()
+ : iPos( 0 ), iTokenType( QXmlStreamReader::NoToken ),
+   iResumeTokenType( QXmlStreamReader::NoToken ), iError( NoError ),
+   iEmptyElement( false ), iVersion( SYNCML_UNKNOWN )
+{
+}
+
+WbXMLReader::~WbXMLReader()
+{
+}
+
+void WbXMLReader::setData( const QByteArray& aData )
+{
+    iData = aData;
+    iPos = 0;
+    iTokenType = QXmlStreamReader::NoToken;
+    iResumeTokenType = QXmlStreamReader::NoToken;
+    iName.clear();
+    iText.clear();
+    iNamespace.clear();
+    iError = NoError;
+    iEmptyElement = false;
+    iDocuments.clear();
+    iElements.clear();
+    iVersion = SYNCML_UNKNOWN;
+}
+
+void WbXMLReader::addData( const QByteArray& aData )
+{
+    iData.append( aData );
+
+    if( !iDocuments.isEmpty() ) {
+        // Embedded documents have a fixed length, only the outermost
+        // document grows
+        iDocuments.first().iEnd = iData.size();
+    }
+
+    if( iError == PrematureEndOfDocumentError ) {
+        iError = NoError;
+        iTokenType = iResumeTokenType;
+    }
+}
+
+QXmlStreamReader::TokenType WbXMLReader::readNext()
+{
+    if( atEnd() ) {
+        return iTokenType;
+    }
+
+    iNamespace.clear();
+
+    if( iTokenType == QXmlStreamReader::NoToken ) {
+
+        Document document;
+        int pos = 0;
+        Error error = readHeader( iData, pos, iData.size(), document );
+
+        if( error != NoError ) {
+            return raiseError( error );
+        }
+
+        document.iDepth = 0;
+        iDocuments.append( document );
+        iVersion = document.iVersion;
+        iPos = pos;
+
+        iTokenType = QXmlStreamReader::StartDocument;
+        return iTokenType;
+    }
+
+    if( iEmptyElement ) {
+        // Element without content, name of the start element is still current
+        iEmptyElement = false;
+        iElements.removeLast();
+        iTokenType = QXmlStreamReader::EndElement;
+        return iTokenType;
+    }
+
+    while( true ) {
+
+        Document& document = iDocuments.last();
+
+        if( document.iRootRead && iElements.count() == document.iDepth ) {
+
+            if( iDocuments.count() > 1 ) {
+                // Embedded document ended, continue with the enclosing document
+                iPos = document.iEnd;
+                iDocuments.removeLast();
+                continue;
+            }
+
+            iTokenType = QXmlStreamReader::EndDocument;
+            return iTokenType;
+        }
+
+        if( iPos >= document.iEnd ) {
+            return raiseError( PrematureEndOfDocumentError );
+        }
+
+        quint8 token = static_cast<quint8>( iData.at( iPos ) );
+
+        switch( token )
+        {
+            case WbXMLTokens::SWITCH_PAGE:
+            {
+                if( iPos + 2 > document.iEnd ) {
+                    return raiseError( PrematureEndOfDocumentError );
+                }
+
+                document.iPage = static_cast<quint8>( iData.at( iPos + 1 ) );
+                iPos += 2;
+                break;
+            }
+            case WbXMLTokens::END:
+            {
+                if( iElements.count() <= document.iDepth ) {
+                    qCWarning(lcSyncML) << "WbXML END token without an open element";
+                    return raiseError( NotWellFormedError );
+                }
+
+                ++iPos;
+                iName = iElements.last().iName;
+                iElements.removeLast();
+                iTokenType = QXmlStreamReader::EndElement;
+                return iTokenType;
+            }
+            case WbXMLTokens::STR_I:
+            case WbXMLTokens::STR_T:
+            case WbXMLTokens::ENTITY:
+            case WbXMLTokens::OPAQUE:
+            {
+                if( iElements.count() <= document.iDepth ) {
+                    qCWarning(lcSyncML) << "WbXML content outside of the root element";
+                    return raiseError( NotWellFormedError );
+                }
+
+                return readCharacters();
+            }
+            case WbXMLTokens::PI:
+            case WbXMLTokens::EXT_I_0:
+            case WbXMLTokens::EXT_I_1:
+            case WbXMLTokens::EXT_I_2:
+            case WbXMLTokens::EXT_T_0:
+            case WbXMLTokens::EXT_T_1:
+            case WbXMLTokens::EXT_T_2:
+            case WbXMLTokens::EXT_0:
+            case WbXMLTokens::EXT_1:
+            case WbXMLTokens::EXT_2:
+            {
+                qCWarning(lcSyncML) << "Unsupported WbXML token" << token;
+                return raiseError( UnsupportedError );
+            }
+            default:
+            {
+                return readElement( token );
+            }
+        }
+
+    }
+
+}
+
+QXmlStreamReader::TokenType WbXMLReader::tokenType() const
+{
+    return iTokenType;
+}
+
+const QString& WbXMLReader::name() const
+{
+    return iName;
+}
+
+const QString& WbXMLReader::text() const
+{
+    return iText;
+}
+
+const QString& WbXMLReader::namespaceDeclaration() const
+{
+    return iNamespace;
+}
+
+bool WbXMLReader::atEnd() const
+{
+    return iError != NoError || iTokenType == QXmlStreamReader::EndDocument;
+}
+
+WbXMLReader::Error WbXMLReader::error() const
+{
+    return iError;
+}
+
+ProtocolVersion WbXMLReader::protocolVersion() const
+{
+    return iVersion;
+}
+
+bool WbXMLReader::isSyncMLDocument( const QByteArray& aData )
+{
+    Document document;
+    int pos = 0;
+
+    return readHeader( aData, pos, aData.size(), document ) == NoError &&
+           document.iCodeSpace == WbXMLSizeEstimator::CODESPACE_SYNCML;
+}
+
+QXmlStreamReader::TokenType WbXMLReader::readElement( quint8 aToken )
+{
+    Document& document = iDocuments.last();
+
+    if( document.iRootRead && iElements.count() == document.iDepth ) {
+        qCWarning(lcSyncML) << "WbXML document has multiple root elements";
+        return raiseError( NotWellFormedError );
+    }
+
+    if( aToken & WbXMLTokens::TAG_ATTRIBUTES ) {
+        // SyncML, MetInf and DevInf do not define any attributes
+        qCWarning(lcSyncML) << "Unsupported WbXML attributes in tag" << aToken;
+        return raiseError( UnsupportedError );
+    }
+
+    WbXMLSizeEstimator::CodeSpace codeSpace = document.iCodeSpace;
+
+    if( codeSpace == WbXMLSizeEstimator::CODESPACE_SYNCML && document.iPage == WbXMLTokens::PAGE_METINF ) {
+        codeSpace = WbXMLSizeEstimator::CODESPACE_METINF;
+    }
+
+    int pos = iPos + 1;
+    quint8 tag = aToken & WbXMLTokens::TAG_MASK;
+
+    if( tag == WbXMLTokens::LITERAL ) {
+
+        quint32 offset = 0;
+        QByteArray name;
+
+        if( !readMbUInt32( iData, pos, document.iEnd, offset ) ) {
+            return raiseError( PrematureEndOfDocumentError );
+        }
+
+        if( !readTableString( iData, document, offset, name ) ) {
+            qCWarning(lcSyncML) << "Invalid WbXML string table reference" << offset;
+            return raiseError( NotWellFormedError );
+        }
+
+        iName = QString::fromUtf8( name );
+    }
+    else {
+
+        // Only MetInf uses a code page other than the first one
+        if( document.iPage != 0 && codeSpace != WbXMLSizeEstimator::CODESPACE_METINF ) {
+            qCWarning(lcSyncML) << "Unknown WbXML code page" << document.iPage;
+            return raiseError( NotWellFormedError );
+        }
+
+        const QString& name = WbXMLTokens::tagName( codeSpace, document.iVersion, tag );
+
+        if( name.isEmpty() ) {
+            qCWarning(lcSyncML) << "Unknown WbXML tag" << tag << "on code page" << document.iPage;
+            return raiseError( NotWellFormedError );
+        }
+
+        iName = name;
+    }
+
+    iPos = pos;
+
+    if( !document.iRootRead ) {
+        iNamespace = documentNamespace( document );
+        document.iRootRead = true;
+    }
+    else if( iElements.last().iCodeSpace != codeSpace ) {
+
+        if( codeSpace == WbXMLSizeEstimator::CODESPACE_METINF ) {
+            static const QString metInf( XML_NAMESPACE_VALUE_METINF );
+            iNamespace = metInf;
+        }
+        else {
+            iNamespace = documentNamespace( document );
+        }
+    }
+
+    Element element;
+    element.iName = iName;
+    element.iCodeSpace = codeSpace;
+    iElements.append( element );
+
+    iEmptyElement = !( aToken & WbXMLTokens::TAG_CONTENT );
+    iTokenType = QXmlStreamReader::StartElement;
+    return iTokenType;
+}
+
+QXmlStreamReader::TokenType WbXMLReader::readCharacters()
+{
+    // Consecutive strings, entities and opaque data are combined to a single
+    // characters token like adjacent text and CDATA in XML
+    QByteArray text;
+    int start = iPos;
+
+    while( iPos < iDocuments.last().iEnd ) {
+
+        const Document& document = iDocuments.last();
+        quint8 token = static_cast<quint8>( iData.at( iPos ) );
+        int pos = iPos + 1;
+
+        if( token == WbXMLTokens::STR_I ) {
+
+            if( !readString( iData, pos, document.iEnd, text ) ) {
+                return rewind( start );
+            }
+
+        }
+        else if( token == WbXMLTokens::STR_T ) {
+
+            quint32 offset = 0;
+
+            if( !readMbUInt32( iData, pos, document.iEnd, offset ) ) {
+                return rewind( start );
+            }
+
+            if( !readTableString( iData, document, offset, text ) ) {
+                qCWarning(lcSyncML) << "Invalid WbXML string table reference" << offset;
+                return raiseError( NotWellFormedError );
+            }
+
+        }
+        else if( token == WbXMLTokens::ENTITY ) {
+
+            quint32 character = 0;
+
+            if( !readMbUInt32( iData, pos, document.iEnd, character ) ) {
+                return rewind( start );
+            }
+
+            text.append( QString::fromUcs4( &character, 1 ).toUtf8() );
+
+        }
+        else if( token == WbXMLTokens::OPAQUE ) {
+
+            quint32 length = 0;
+
+            if( !readMbUInt32( iData, pos, document.iEnd, length ) ) {
+                return rewind( start );
+            }
+
+            if( length > static_cast<quint32>( document.iEnd - pos ) ) {
+                return rewind( start );
+            }
+
+            int end = pos + length;
+
+            if( iElements.last().iName == QLatin1String( SYNCML_ELEMENT_DATA ) ) {
+
+                Document embedded;
+                int embeddedPos = pos;
+
+                if( readHeader( iData, embeddedPos, end, embedded ) == NoError &&
+                    embedded.iCodeSpace == WbXMLSizeEstimator::CODESPACE_DEVINF ) {
+
+                    if( !text.isEmpty() ) {
+                        // Deliver text preceding the embedded document first
+                        break;
+                    }
+
+                    embedded.iDepth = iElements.count();
+                    iDocuments.append( embedded );
+                    iPos = embeddedPos;
+                    return readNext();
+                }
+            }
+
+            text.append( iData.constData() + pos, length );
+            pos = end;
+
+        }
+        else {
+            break;
+        }
+
+        iPos = pos;
+    }
+
+    iText = QString::fromUtf8( text );
+    iTokenType = QXmlStreamReader::Characters;
+    return iTokenType;
+}
+
+QXmlStreamReader::TokenType WbXMLReader::rewind( int aPos )
+{
+    // Characters are read again from the beginning once the rest of them
+    // has been added
+    iPos = aPos;
+    return raiseError( PrematureEndOfDocumentError );
+}
+
+QXmlStreamReader::TokenType WbXMLReader::raiseError( Error aError )
+{
+    if( iTokenType != QXmlStreamReader::Invalid ) {
+        iResumeTokenType = iTokenType;
+    }
+
+    iError = aError;
+    iTokenType = QXmlStreamReader::Invalid;
+    return iTokenType;
+}
+
+WbXMLReader::Error WbXMLReader::readHeader( const QByteArray& aData, int& aPos, int aEnd,
+                                            Document& aDocument )
+{
+    int pos = aPos;
+
+    if( pos >= aEnd ) {
+        return PrematureEndOfDocumentError;
+    }
+
+    quint8 version = static_cast<quint8>( aData.at( pos++ ) );
+
+    if( version > 0x03 ) {
+        return NotWellFormedError;
+    }
+
+    quint32 publicId = 0;
+    quint32 publicIdOffset = 0;
+    quint32 charset = CHARSET_UNKNOWN;
+    quint32 stringTableLength = 0;
+
+    if( !readMbUInt32( aData, pos, aEnd, publicId ) ) {
+        return PrematureEndOfDocumentError;
+    }
+
+    // Public identifier 0 means that the identifier is in the string table
+    if( publicId == 0 && !readMbUInt32( aData, pos, aEnd, publicIdOffset ) ) {
+        return PrematureEndOfDocumentError;
+    }
+
+    // WbXML 1.0 does not have charset
+    if( version > 0x00 && !readMbUInt32( aData, pos, aEnd, charset ) ) {
+        return PrematureEndOfDocumentError;
+    }
+
+    if( !readMbUInt32( aData, pos, aEnd, stringTableLength ) ) {
+        return PrematureEndOfDocumentError;
+    }
+
+    if( stringTableLength > static_cast<quint32>( aEnd - pos ) ) {
+        return PrematureEndOfDocumentError;
+    }
+
+    aDocument.iEnd = aEnd;
+    aDocument.iStringTable = pos;
+    aDocument.iStringTableLength = stringTableLength;
+    aDocument.iPage = 0;
+    aDocument.iDepth = 0;
+    aDocument.iRootRead = false;
+
+    pos += stringTableLength;
+
+    if( publicId == 0 ) {
+
+        QByteArray formalPublicId;
+
+        if( !readTableString( aData, aDocument, publicIdOffset, formalPublicId ) ) {
+            return NotWellFormedError;
+        }
+
+        publicId = WbXMLTokens::publicId( formalPublicId );
+    }
+
+    if( charset != WbXMLTokens::CHARSET_UTF8 && charset != CHARSET_US_ASCII &&
+        charset != CHARSET_UNKNOWN ) {
+        return UnsupportedError;
+    }
+
+    switch( publicId )
+    {
+        case WbXMLTokens::PUBLICID_SYNCML_11:
+        {
+            aDocument.iCodeSpace = WbXMLSizeEstimator::CODESPACE_SYNCML;
+            aDocument.iVersion = SYNCML_1_1;
+            break;
+        }
+        case WbXMLTokens::PUBLICID_SYNCML_12:
+        {
+            aDocument.iCodeSpace = WbXMLSizeEstimator::CODESPACE_SYNCML;
+            aDocument.iVersion = SYNCML_1_2;
+            break;
+        }
+        case WbXMLTokens::PUBLICID_DEVINF_11:
+        {
+            aDocument.iCodeSpace = WbXMLSizeEstimator::CODESPACE_DEVINF;
+            aDocument.iVersion = SYNCML_1_1;
+            break;
+        }
+        case WbXMLTokens::PUBLICID_DEVINF_12:
+        {
+            aDocument.iCodeSpace = WbXMLSizeEstimator::CODESPACE_DEVINF;
+            aDocument.iVersion = SYNCML_1_2;
+            break;
+        }
+        default:
+        {
+            return UnsupportedError;
+        }
+    }
+
+    aPos = pos;
+
+    return NoError;
+}
+
+bool WbXMLReader::readMbUInt32( const QByteArray& aData, int& aPos, int aEnd, quint32& aValue )
+{
+    // Multi-byte integers are at most 5 bytes long, 7 bits per byte
+    quint32 value = 0;
+
+    for( int i = 0; i < 5 && aPos + i < aEnd; ++i ) {
+
+        quint8 byte = static_cast<quint8>( aData.at( aPos + i ) );
+        value = ( value << 7 ) | ( byte & 0x7F );
+
+        if( !( byte & 0x80 ) ) {
+            aValue = value;
+            aPos += i + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool WbXMLReader::readString( const QByteArray& aData, int& aPos, int aEnd, QByteArray& aString )
+{
+    const char* start = aData.constData() + aPos;
+    const char* terminator = static_cast<const char*>( memchr( start, 0, aEnd - aPos ) );
+
+    if( !terminator ) {
+        return false;
+    }
+
+    aString.append( start, terminator - start );
+    aPos += terminator - start + 1;
+
+    return true;
+}
+
+bool WbXMLReader::readTableString( const QByteArray& aData, const Document& aDocument,
+                                   quint32 aOffset, QByteArray& aString )
+{
+    if( aOffset >= static_cast<quint32>( aDocument.iStringTableLength ) ) {
+        return false;
+    }
+
+    int pos = aDocument.iStringTable + aOffset;
+
+    return readString( aData, pos, aDocument.iStringTable + aDocument.iStringTableLength, aString );
+}
+
+const QString& WbXMLReader::documentNamespace( const Document& aDocument ) const
+{
+    static const QString syncML11( XML_NAMESPACE_VALUE_SYNCML11 );
+    static const QString syncML12( XML_NAMESPACE_VALUE_SYNCML12 );
+    static const QString devInf( XML_NAMESPACE_VALUE_DEVINF );
+
+    if( aDocument.iCodeSpace == WbXMLSizeEstimator::CODESPACE_DEVINF ) {
+        return devInf;
+    }
+    else if( aDocument.iVersion == SYNCML_1_1 ) {
+        return syncML11;
+    }
+    else {
+        return syncML12;
+    }
+}
@@ -0,0 +1,215 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef WBXMLREADER_H
+#define WBXMLREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QXmlStreamReader>
+
+#include "SyncAgentConsts.h"
+#include "WbXMLSizeEstimator.h"
+
+namespace DataSync {
+
+/*! \brief Reads SyncML WbXML documents token by token
+ *
+ * Produces the same sequence of start element, end element and character
+ * tokens that QXmlStreamReader produces for the XML form of the document,
+ * without converting the document to XML first. SyncML, MetInf and DevInf
+ * code pages of SyncML 1.1 and 1.2 are supported. DevInf documents embedded
+ * as opaque data inside Data elements are read inline, like libwbxml2 does
+ * when converting to XML.
+ */
+class WbXMLReader
+{
+
+public:
+
+    /*! \brief Reader errors
+     *
+     */
+    enum Error
+    {
+        NoError,                        /*!< No error has occurred */
+        NotWellFormedError,             /*!< Document is not valid WbXML */
+        PrematureEndOfDocumentError,    /*!< Document ended before the root element was closed */
+        UnsupportedError                /*!< Document uses a language or feature that is not supported */
+    };
+
+    /*! \brief Constructor
+     *
+     */
+    WbXMLReader();
+
+    /*! \brief Destructor
+     *
+     */
+    ~WbXMLReader();
+
+    /*! \brief Sets the document to read and resets the reader
+     *
+     * @param aData WbXML document
+     */
+    void setData( const QByteArray& aData );
+
+    /*! \brief Appends data to the document being read
+     *
+     * Allows reading a document incrementally as it is received. Reading
+     * continues from where PrematureEndOfDocumentError was raised once more
+     * data has been added.
+     *
+     * @param aData Data to append
+     */
+    void addData( const QByteArray& aData );
+
+    /*! \brief Reads the next token
+     *
+     * @return Type of the token
+     */
+    QXmlStreamReader::TokenType readNext();
+
+    /*! \brief Returns the type of the current token
+     *
+     * @return Token type
+     */
+    QXmlStreamReader::TokenType tokenType() const;
+
+    /*! \brief Returns the name of the current start or end element
+     *
+     * @return Element name
+     */
+    const QString& name() const;
+
+    /*! \brief Returns the text of the current characters token
+     *
+     * @return Text
+     */
+    const QString& text() const;
+
+    /*! \brief Returns the namespace declared by the current start element
+     *
+     * Namespace is declared when an element starts a document or changes
+     * the code page, matching the xmlns attributes libwbxml2 generates.
+     *
+     * @return Namespace, or empty string if element does not declare one
+     */
+    const QString& namespaceDeclaration() const;
+
+    /*! \brief Checks if reading has ended
+     *
+     * @return True if end of document has been reached or an error has occurred
+     */
+    bool atEnd() const;
+
+    /*! \brief Returns the error that stopped reading
+     *
+     * @return Error
+     */
+    Error error() const;
+
+    /*! \brief Returns the SyncML version of the document
+     *
+     * @return Protocol version, SYNCML_UNKNOWN if header has not been read
+     */
+    ProtocolVersion protocolVersion() const;
+
+    /*! \brief Checks if data is a WbXML document that this reader supports
+     *
+     * Only the document header is examined.
+     *
+     * @param aData Data to check
+     * @return True if data starts with a SyncML 1.1 or 1.2 WbXML header
+     */
+    static bool isSyncMLDocument( const QByteArray& aData );
+
+protected:
+
+private:
+
+    struct Document
+    {
+        int                             iEnd;
+        int                             iStringTable;
+        int                             iStringTableLength;
+        WbXMLSizeEstimator::CodeSpace   iCodeSpace;
+        ProtocolVersion                 iVersion;
+        quint8                          iPage;
+        int                             iDepth;
+        bool                            iRootRead;
+    };
+
+    struct Element
+    {
+        QString                         iName;
+        WbXMLSizeEstimator::CodeSpace   iCodeSpace;
+    };
+
+    QXmlStreamReader::TokenType readElement( quint8 aToken );
+
+    QXmlStreamReader::TokenType readCharacters();
+
+    QXmlStreamReader::TokenType rewind( int aPos );
+
+    QXmlStreamReader::TokenType raiseError( Error aError );
+
+    static Error readHeader( const QByteArray& aData, int& aPos, int aEnd, Document& aDocument );
+
+    static bool readMbUInt32( const QByteArray& aData, int& aPos, int aEnd, quint32& aValue );
+
+    static bool readString( const QByteArray& aData, int& aPos, int aEnd, QByteArray& aString );
+
+    static bool readTableString( const QByteArray& aData, const Document& aDocument,
+                                 quint32 aOffset, QByteArray& aString );
+
+    const QString& documentNamespace( const Document& aDocument ) const;
+
+    QByteArray                  iData;
+    int                         iPos;
+    QXmlStreamReader::TokenType iTokenType;
+    QXmlStreamReader::TokenType iResumeTokenType;
+    QString                     iName;
+    QString                     iText;
+    QString                     iNamespace;
+    Error                       iError;
+    bool                        iEmptyElement;
+    QVector<Document>           iDocuments;
+    QVector<Element>            iElements;
+    ProtocolVersion             iVersion;
+
+};
+
+}
+
+#endif  //  WBXMLREADER_H
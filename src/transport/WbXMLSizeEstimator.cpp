@@ -0,0 +1,151 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "WbXMLSizeEstimator.h"
+
+#include "SyncMLCmdObject.h"
+#include "datatypes.h"
+
+// This class is used extensively when generating messages, so function
+// tracing is intentionally not enabled here.
+
+using namespace DataSync;
+
+WbXMLSizeEstimator::CodeSpace WbXMLSizeEstimator::codeSpace( const SyncMLCmdObject& aObject )
+{
+    const QMap<QString, QString>& attributes = aObject.getAttributes();
+
+    if( attributes.isEmpty() ) {
+        return CODESPACE_INHERIT;
+    }
+
+    QMap<QString, QString>::const_iterator i = attributes.constFind( XML_NAMESPACE );
+
+    if( i == attributes.constEnd() ) {
+        return CODESPACE_INHERIT;
+    }
+
+    const QString& ns = i.value();
+
+    if( ns == XML_NAMESPACE_VALUE_METINF ) {
+        return CODESPACE_METINF;
+    }
+    else if( ns == XML_NAMESPACE_VALUE_DEVINF ) {
+        return CODESPACE_DEVINF;
+    }
+    else if( ns == XML_NAMESPACE_VALUE_DMDDF ) {
+        return CODESPACE_DMDDF;
+    }
+    else {
+        return CODESPACE_SYNCML;
+    }
+
+}
+
+bool WbXMLSizeEstimator::sameLanguage( CodeSpace aFirst, CodeSpace aSecond )
+{
+    if( aFirst == CODESPACE_METINF ) {
+        aFirst = CODESPACE_SYNCML;
+    }
+
+    if( aSecond == CODESPACE_METINF ) {
+        aSecond = CODESPACE_SYNCML;
+    }
+
+    return aFirst == aSecond;
+}
+
+int WbXMLSizeEstimator::mbUInt32Size( quint32 aValue )
+{
+    // 7 bits per byte
+    int size = 1;
+
+    while( aValue >= 0x80 ) {
+        aValue >>= 7;
+        ++size;
+    }
+
+    return size;
+}
+
+int WbXMLSizeEstimator::utf8Size( const QString& aString )
+{
+    int size = 0;
+    const QChar* data = aString.constData();
+    const int length = aString.length();
+
+    for( int i = 0; i < length; ++i ) {
+
+        ushort c = data[i].unicode();
+
+        if( c < 0x80 ) {
+            size += 1;
+        }
+        else if( c < 0x800 ) {
+            size += 2;
+        }
+        else if( data[i].isHighSurrogate() && i + 1 < length && data[i + 1].isLowSurrogate() ) {
+            size += 4;
+            ++i;
+        }
+        else {
+            size += 3;
+        }
+    }
+
+    return size;
+}
+
+int WbXMLSizeEstimator::inlineStringSize( const QString& aString )
+{
+    // STR_I + string + terminating null
+    return 1 + utf8Size( aString ) + 1;
+}
+
+int WbXMLSizeEstimator::opaqueSize( int aLength )
+{
+    // OPAQUE + mb_u_int32 length + data
+    return 1 + mbUInt32Size( aLength ) + aLength;
+}
+
+int WbXMLSizeEstimator::elementSize( int aContentSize )
+{
+    if( aContentSize > 0 ) {
+        // Tag with content bit set + content + END
+        return 1 + aContentSize + 1;
+    }
+    else {
+        // Tag without content
+        return 1;
+    }
+}
@@ -0,0 +1,135 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef WBXMLSIZEESTIMATOR_H
+#define WBXMLSIZEESTIMATOR_H
+
+#include <QString>
+
+namespace DataSync {
+
+class SyncMLCmdObject;
+
+/*! \brief Model of the WbXML encoding size of SyncML elements
+ *
+ * Used to estimate the size of WbXML encoded messages without actually
+ * running them through libwbxml2. The model follows the encoding rules used
+ * by LibWbXML2Encoder: every SyncML, MetInf and DevInf tag is a single byte
+ * token, changing between the SyncML and MetInf code pages costs a SWITCH_PAGE,
+ * text content is written as inline strings, CDATA as opaque data and
+ * embedded documents of another language (DevInf) as opaque WbXML documents.
+ */
+class WbXMLSizeEstimator
+{
+
+public:
+
+    /*! \brief Code spaces of SyncML elements
+     *
+     */
+    enum CodeSpace
+    {
+        CODESPACE_INHERIT,  /*!< Element does not define its own namespace */
+        CODESPACE_SYNCML,   /*!< SyncML code page of the SyncML language */
+        CODESPACE_METINF,   /*!< MetInf code page of the SyncML language */
+        CODESPACE_DEVINF,   /*!< DevInf language */
+        CODESPACE_DMDDF     /*!< DM DDF language */
+    };
+
+    /*! \brief Size of WbXML document header
+     *
+     * Version (1), public id (2), charset (1) and string table length (1)
+     */
+    static const int HEADER_SIZE = 5;
+
+    /*! \brief Size of SWITCH_PAGE global token and the page index
+     *
+     */
+    static const int SWITCH_PAGE_SIZE = 2;
+
+    /*! \brief Returns the code space declared by an element
+     *
+     * @param aObject Element
+     * @return Code space, CODESPACE_INHERIT if the element has no namespace
+     */
+    static CodeSpace codeSpace( const SyncMLCmdObject& aObject );
+
+    /*! \brief Checks if two code spaces belong to the same WbXML language
+     *
+     * Elements of a different language are encoded as separate documents
+     *
+     * @param aFirst First code space
+     * @param aSecond Second code space
+     * @return True if code spaces are pages of the same language
+     */
+    static bool sameLanguage( CodeSpace aFirst, CodeSpace aSecond );
+
+    /*! \brief Returns the encoded size of a multi-byte unsigned integer
+     *
+     * @param aValue Value to encode
+     * @return Size in bytes
+     */
+    static int mbUInt32Size( quint32 aValue );
+
+    /*! \brief Returns the size of a string when encoded as UTF-8
+     *
+     * @param aString String
+     * @return Size in bytes
+     */
+    static int utf8Size( const QString& aString );
+
+    /*! \brief Returns the size of a string when written as STR_I
+     *
+     * @param aString String
+     * @return Size in bytes, including token and terminator
+     */
+    static int inlineStringSize( const QString& aString );
+
+    /*! \brief Returns the size of data when written as OPAQUE
+     *
+     * @param aLength Length of the data in bytes
+     * @return Size in bytes, including token and length prefix
+     */
+    static int opaqueSize( int aLength );
+
+    /*! \brief Returns the size of an element
+     *
+     * @param aContentSize Size of the content of the element
+     * @return Size in bytes, including tag token and END token if element has content
+     */
+    static int elementSize( int aContentSize );
+
+};
+
+}
+
+#endif  //  WBXMLSIZEESTIMATOR_H
@@ -0,0 +1,193 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "WbXMLTokens.h"
+
+#include <QVector>
+#include <QHash>
+
+// Token lookups are done for every element of every message, so function
+// tracing is intentionally not enabled here.
+
+using namespace DataSync;
+
+namespace {
+
+// First tag token of every code page, tokens below are global tokens
+const quint8 FIRST_TAG = 0x05;
+
+const char* const SYNCML_TAGS[] = {
+    "Add", "Alert", "Archive", "Atomic", "Chal", "Cmd", "CmdID", "CmdRef",
+    "Copy", "Cred", "Data", "Delete", "Exec", "Final", "Get", "Item",
+    "Lang", "LocName", "LocURI", "Map", "MapItem", "Meta", "MsgID", "MsgRef",
+    "NoResp", "NoResults", "Put", "Replace", "RespURI", "Results", "Search", "Sequence",
+    "SessionID", "SftDel", "Source", "SourceRef", "Status", "Sync", "SyncBody", "SyncHdr",
+    "SyncML", "Target", "TargetRef", "", "VerDTD", "VerProto", "NumberOfChanges", "MoreData",
+    "Field", "Filter", "Record", "FilterType", "SourceParent", "TargetParent", "Move", "Correlator"
+};
+
+const char* const METINF_TAGS[] = {
+    "Anchor", "EMI", "Format", "FreeID", "FreeMem", "Last", "Mark", "MaxMsgSize",
+    "Mem", "MetInf", "Next", "NextNonce", "SharedMem", "Size", "Type", "Version",
+    "MaxObjSize", "FieldLevel"
+};
+
+// DevInf 1.1 uses token 0x1C for Size, DevInf 1.2 for MaxSize
+const char* const DEVINF_TAGS[] = {
+    "CTCap", "CTType", "DataStore", "DataType", "DevID", "DevInf", "DevTyp", "DisplayName",
+    "DSMem", "Ext", "FwV", "HwV", "Man", "MaxGUIDSize", "MaxID", "MaxMem",
+    "Mod", "OEM", "ParamName", "PropName", "Rx", "Rx-Pref", "SharedMem", "MaxSize",
+    "SourceRef", "SwV", "SyncCap", "SyncType", "Tx", "Tx-Pref", "ValEnum", "VerCT",
+    "VerDTD", "XNam", "XVal", "UTC", "SupportNumberOfChanges", "SupportLargeObjs", "Property", "PropParam",
+    "MaxOccur", "NoTruncate", "", "Filter-Rx", "FilterCap", "FilterKeyword", "FieldLevel", "SupportHierarchicalSync"
+};
+
+const quint8 DEVINF_SIZE_TOKEN = 0x1C;
+
+class CodePage
+{
+public:
+    CodePage( const char* const* aNames, int aCount )
+    {
+        iNames.resize( FIRST_TAG + aCount );
+
+        for( int i = 0; i < aCount; ++i ) {
+            if( *aNames[i] ) {
+                iNames[FIRST_TAG + i] = QString::fromLatin1( aNames[i] );
+                iTokens.insert( iNames[FIRST_TAG + i], FIRST_TAG + i );
+            }
+        }
+    }
+
+    void rename( quint8 aToken, const char* aName )
+    {
+        iTokens.remove( iNames[aToken] );
+        iNames[aToken] = QString::fromLatin1( aName );
+        iTokens.insert( iNames[aToken], aToken );
+    }
+
+    const QString& name( quint8 aToken ) const
+    {
+        static const QString empty;
+        return aToken < iNames.size() ? iNames[aToken] : empty;
+    }
+
+    int token( const QString& aName ) const
+    {
+        return iTokens.value( aName, -1 );
+    }
+
+private:
+    QVector<QString>    iNames;
+    QHash<QString, int> iTokens;
+};
+
+#define TABLE_SIZE( x ) int( sizeof( x ) / sizeof( x[0] ) )
+
+CodePage devInf11Page()
+{
+    CodePage page( DEVINF_TAGS, TABLE_SIZE( DEVINF_TAGS ) );
+    page.rename( DEVINF_SIZE_TOKEN, "Size" );
+    return page;
+}
+
+const CodePage& codePage( WbXMLSizeEstimator::CodeSpace aCodeSpace, ProtocolVersion aVersion )
+{
+    static const CodePage syncml( SYNCML_TAGS, TABLE_SIZE( SYNCML_TAGS ) );
+    static const CodePage metinf( METINF_TAGS, TABLE_SIZE( METINF_TAGS ) );
+    static const CodePage devinf12( DEVINF_TAGS, TABLE_SIZE( DEVINF_TAGS ) );
+    static const CodePage devinf11 = devInf11Page();
+    static const CodePage none( 0, 0 );
+
+    switch( aCodeSpace )
+    {
+        case WbXMLSizeEstimator::CODESPACE_SYNCML:
+            return syncml;
+        case WbXMLSizeEstimator::CODESPACE_METINF:
+            return metinf;
+        case WbXMLSizeEstimator::CODESPACE_DEVINF:
+            return aVersion == SYNCML_1_1 ? devinf11 : devinf12;
+        default:
+            return none;
+    }
+}
+
+}
+
+const QString& WbXMLTokens::tagName( WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                                     ProtocolVersion aVersion, quint8 aToken )
+{
+    return codePage( aCodeSpace, aVersion ).name( aToken );
+}
+
+int WbXMLTokens::tagToken( WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                           ProtocolVersion aVersion, const QString& aName )
+{
+    return codePage( aCodeSpace, aVersion ).token( aName );
+}
+
+WbXMLTokens::PublicId WbXMLTokens::publicId( const QByteArray& aFormalPublicId )
+{
+    if( aFormalPublicId == "-//SYNCML//DTD SyncML 1.2//EN" ) {
+        return PUBLICID_SYNCML_12;
+    }
+    else if( aFormalPublicId == "-//SYNCML//DTD SyncML 1.1//EN" ) {
+        return PUBLICID_SYNCML_11;
+    }
+    else if( aFormalPublicId == "-//SYNCML//DTD DevInf 1.2//EN" ) {
+        return PUBLICID_DEVINF_12;
+    }
+    else if( aFormalPublicId == "-//SYNCML//DTD DevInf 1.1//EN" ) {
+        return PUBLICID_DEVINF_11;
+    }
+    else if( aFormalPublicId == "-//SYNCML//DTD MetInf 1.2//EN" ) {
+        return PUBLICID_METINF_12;
+    }
+    else {
+        return PUBLICID_UNKNOWN;
+    }
+}
+
+WbXMLTokens::PublicId WbXMLTokens::publicId( WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                                             ProtocolVersion aVersion )
+{
+    if( aCodeSpace == WbXMLSizeEstimator::CODESPACE_SYNCML ) {
+        return aVersion == SYNCML_1_1 ? PUBLICID_SYNCML_11 : PUBLICID_SYNCML_12;
+    }
+    else if( aCodeSpace == WbXMLSizeEstimator::CODESPACE_DEVINF ) {
+        return aVersion == SYNCML_1_1 ? PUBLICID_DEVINF_11 : PUBLICID_DEVINF_12;
+    }
+    else {
+        return PUBLICID_UNKNOWN;
+    }
+}
@@ -0,0 +1,175 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef WBXMLTOKENS_H
+#define WBXMLTOKENS_H
+
+#include <QString>
+#include <QByteArray>
+
+#include "SyncAgentConsts.h"
+#include "WbXMLSizeEstimator.h"
+
+namespace DataSync {
+
+/*! \brief WbXML global tokens and tag tokens of the SyncML, MetInf and DevInf
+ *         code pages
+ *
+ * Tag tables follow the OMA SyncML WbXML specifications and match the tables
+ * used by libwbxml2.
+ */
+class WbXMLTokens
+{
+
+public:
+
+    /*! \brief WbXML global tokens
+     *
+     */
+    enum GlobalToken
+    {
+        SWITCH_PAGE = 0x00,
+        END         = 0x01,
+        ENTITY      = 0x02,
+        STR_I       = 0x03,
+        LITERAL     = 0x04,
+        EXT_I_0     = 0x40,
+        EXT_I_1     = 0x41,
+        EXT_I_2     = 0x42,
+        PI          = 0x43,
+        LITERAL_C   = 0x44,
+        EXT_T_0     = 0x80,
+        EXT_T_1     = 0x81,
+        EXT_T_2     = 0x82,
+        STR_T       = 0x83,
+        LITERAL_A   = 0x84,
+        EXT_0       = 0xC0,
+        EXT_1       = 0xC1,
+        EXT_2       = 0xC2,
+        OPAQUE      = 0xC3,
+        LITERAL_AC  = 0xC4
+    };
+
+    /*! \brief Known public identifiers of SyncML documents
+     *
+     */
+    enum PublicId
+    {
+        PUBLICID_UNKNOWN    = 0x0000,
+        PUBLICID_SYNCML_11  = 0x0FD3,
+        PUBLICID_DEVINF_11  = 0x0FD4,
+        PUBLICID_SYNCML_12  = 0x1201,
+        PUBLICID_METINF_12  = 0x1202,
+        PUBLICID_DEVINF_12  = 0x1203
+    };
+
+    /*! \brief Bit of a tag token telling that element has content
+     *
+     */
+    static const quint8 TAG_CONTENT = 0x40;
+
+    /*! \brief Bit of a tag token telling that element has attributes
+     *
+     */
+    static const quint8 TAG_ATTRIBUTES = 0x80;
+
+    /*! \brief Mask of the tag identity in a tag token
+     *
+     */
+    static const quint8 TAG_MASK = 0x3F;
+
+    /*! \brief WbXML version written by the encoders (1.2)
+     *
+     */
+    static const quint8 WBXML_VERSION = 0x02;
+
+    /*! \brief IANA MIB enum of UTF-8
+     *
+     */
+    static const quint32 CHARSET_UTF8 = 106;
+
+    /*! \brief Code page of the SyncML tags
+     *
+     */
+    static const quint8 PAGE_SYNCML = 0;
+
+    /*! \brief Code page of the MetInf tags
+     *
+     */
+    static const quint8 PAGE_METINF = 1;
+
+    /*! \brief Code page of the DevInf tags
+     *
+     */
+    static const quint8 PAGE_DEVINF = 0;
+
+    /*! \brief Returns the name of a tag
+     *
+     * @param aCodeSpace Code space of the tag
+     * @param aVersion SyncML version of the document
+     * @param aToken Tag identity, without content and attribute bits
+     * @return Name of the tag, empty string if tag is not known
+     */
+    static const QString& tagName( WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                                   ProtocolVersion aVersion, quint8 aToken );
+
+    /*! \brief Returns the token of a tag
+     *
+     * @param aCodeSpace Code space of the tag
+     * @param aVersion SyncML version of the document
+     * @param aName Name of the tag
+     * @return Tag identity, or -1 if tag is not known
+     */
+    static int tagToken( WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                         ProtocolVersion aVersion, const QString& aName );
+
+    /*! \brief Returns the numeric identifier of a formal public identifier
+     *
+     * @param aFormalPublicId Formal public identifier, for example
+     *        "-//SYNCML//DTD SyncML 1.2//EN"
+     * @return Numeric identifier, PUBLICID_UNKNOWN if not known
+     */
+    static PublicId publicId( const QByteArray& aFormalPublicId );
+
+    /*! \brief Returns the numeric public identifier of a document
+     *
+     * @param aCodeSpace Code space of the root element of the document
+     * @param aVersion SyncML version
+     * @return Public identifier, PUBLICID_UNKNOWN if not known
+     */
+    static PublicId publicId( WbXMLSizeEstimator::CodeSpace aCodeSpace, ProtocolVersion aVersion );
+
+};
+
+}
+
+#endif  //  WBXMLTOKENS_H
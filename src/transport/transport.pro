@@ -1,7 +1,15 @@
 SOURCES += BaseTransport.cpp \
 	HTTPTransport.cpp \
+    HTTPContentEncoder.cpp \
+    HTTPServer.cpp \
+    HTTPServerTransport.cpp \
+    LoopbackTransport.cpp \
     OBEXDataHandler.cpp \
     LibWbXML2Encoder.cpp \
+    WbXMLSizeEstimator.cpp \
+    WbXMLTokens.cpp \
+    WbXMLReader.cpp \
+    WbXMLEncoder.cpp \
     QtEncoder.cpp \
     OBEXTransport.cpp \
     OBEXWorker.cpp \
@@ -11,9 +19,18 @@ SOURCES += BaseTransport.cpp \
 HEADERS += Transport.h \
 	BaseTransport.h \
 	HTTPTransport.h \
+    HTTPContentEncoder.h \
+    HTTPServer.h \
+    HTTPServerTransport.h \
+    TransportProvider.h \
+    LoopbackTransport.h \
 	OBEXConnection.h \
     OBEXDataHandler.h \
     LibWbXML2Encoder.h \
+    WbXMLSizeEstimator.h \
+    WbXMLTokens.h \
+    WbXMLReader.h \
+    WbXMLEncoder.h \
     QtEncoder.h \
     OBEXTransport.h \
     OBEXWorker.h \
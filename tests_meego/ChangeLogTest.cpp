@@ -34,6 +34,8 @@
 
 #include "ChangeLogTest.h"
 
+#include <QtSql>
+
 #include "DatabaseHandler.h"
 #include "SyncMode.h"
 
@@ -251,4 +253,86 @@ void ChangeLogTest::testOwnedGetSetMaps()
 
 }
 
+void ChangeLogTest::testSaveMapChanges()
+{
+    ChangeLog changeLog( "testdevice7", "sourcedb7", DIRECTION_TWO_WAY );
+
+    UIDMapping map1 = { "remote1", "local1" };
+    UIDMapping map2 = { "remote2", "local2" };
+    UIDMapping map3 = { "remote3", "local3" };
+
+    QList<UIDMapping> maps;
+    maps << map1 << map2;
+    changeLog.setMaps( maps );
+    QVERIFY( changeLog.save( iDbHandler->getDbHandle() ) );
+
+    QSqlQuery idQuery( iDbHandler->getDbHandle() );
+    idQuery.prepare( "SELECT id FROM id_maps WHERE remote_device = 'testdevice7' AND local_id = 'local1'" );
+    QVERIFY( idQuery.exec() && idQuery.next() );
+    int id = idQuery.value(0).toInt();
+
+    // Remove one map and add another one. Only the changes should be written,
+    // so the row of the unchanged map must stay intact
+    ChangeLog changeLog2( "testdevice7", "sourcedb7", DIRECTION_TWO_WAY );
+    QVERIFY( changeLog2.load( iDbHandler->getDbHandle() ) );
+    QCOMPARE( changeLog2.getMaps().count(), 2 );
+
+    maps.clear();
+    maps << map1 << map3;
+    changeLog2.setMaps( maps );
+    QVERIFY( changeLog2.save( iDbHandler->getDbHandle() ) );
+
+    QVERIFY( idQuery.exec() && idQuery.next() );
+    QCOMPARE( idQuery.value(0).toInt(), id );
+
+    ChangeLog changeLog3( "testdevice7", "sourcedb7", DIRECTION_TWO_WAY );
+    QVERIFY( changeLog3.load( iDbHandler->getDbHandle() ) );
+    QCOMPARE( changeLog3.getMaps().count(), 2 );
+    QCOMPARE( changeLog3.getMaps().at(0).iLocalUID, map1.iLocalUID );
+    QCOMPARE( changeLog3.getMaps().at(0).iRemoteUID, map1.iRemoteUID );
+    QCOMPARE( changeLog3.getMaps().at(1).iLocalUID, map3.iLocalUID );
+    QCOMPARE( changeLog3.getMaps().at(1).iRemoteUID, map3.iRemoteUID );
+
+    changeLog3.remove( iDbHandler->getDbHandle() );
+    QVERIFY( !changeLog3.load( iDbHandler->getDbHandle() ) );
+}
+
+void ChangeLogTest::testFingerprints()
+{
+    ChangeLog changeLog( "testdevice8", "sourcedb8", DIRECTION_TWO_WAY );
+
+    // Fingerprints are not saved unless they have been set
+    QVERIFY( changeLog.save( iDbHandler->getDbHandle() ) );
+    QVERIFY( changeLog.loadFingerprints( iDbHandler->getDbHandle() ) );
+    QVERIFY( changeLog.getFingerprints().isEmpty() );
+
+    QHash<SyncItemKey, QByteArray> fingerprints;
+    fingerprints.insert( "1", QByteArray( "fingerprint1" ) );
+    fingerprints.insert( "2", QByteArray( "fingerprint2" ) );
+    changeLog.setFingerprints( fingerprints );
+    QCOMPARE( changeLog.getFingerprints(), fingerprints );
+    QVERIFY( changeLog.save( iDbHandler->getDbHandle() ) );
+
+    ChangeLog changeLog2( "testdevice8", "sourcedb8", DIRECTION_TWO_WAY );
+    QVERIFY( changeLog2.load( iDbHandler->getDbHandle() ) );
+    QVERIFY( changeLog2.getFingerprints().isEmpty() );
+    QVERIFY( changeLog2.loadFingerprints( iDbHandler->getDbHandle() ) );
+    QCOMPARE( changeLog2.getFingerprints(), fingerprints );
+
+    // Change, remove and add a fingerprint
+    fingerprints.insert( "1", QByteArray( "fingerprint1b" ) );
+    fingerprints.remove( "2" );
+    fingerprints.insert( "3", QByteArray( "fingerprint3" ) );
+    changeLog2.setFingerprints( fingerprints );
+    QVERIFY( changeLog2.save( iDbHandler->getDbHandle() ) );
+
+    ChangeLog changeLog3( "testdevice8", "sourcedb8", DIRECTION_TWO_WAY );
+    QVERIFY( changeLog3.loadFingerprints( iDbHandler->getDbHandle() ) );
+    QCOMPARE( changeLog3.getFingerprints(), fingerprints );
+
+    QVERIFY( changeLog3.remove( iDbHandler->getDbHandle() ) );
+    QVERIFY( changeLog3.loadFingerprints( iDbHandler->getDbHandle() ) );
+    QVERIFY( changeLog3.getFingerprints().isEmpty() );
+}
+
 QTEST_MAIN(ChangeLogTest)
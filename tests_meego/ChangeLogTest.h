@@ -58,6 +58,10 @@ private slots:
     void testOwnedGetSetLastAnchor();
     void testOwnedGetSetMaps();
 
+    void testSaveMapChanges();
+
+    void testFingerprints();
+
 private:
 
     DataSync::DatabaseHandler* iDbHandler;
@@ -34,13 +34,16 @@
 #include "CommandHandlerTest.h"
 
 #include <QSignalSpy>
+#include <QBuffer>
 
 #include "CommandHandler.h"
 #include "ResponseGenerator.h"
 #include "ChangeLog.h"
 #include "ConflictResolver.h"
+#include "ItemMatcher.h"
 #include "QtEncoder.h"
 #include "SyncMLMessage.h"
+#include "SyncMLMessageParser.h"
 #include "DeviceInfo.h"
 #include "Mock.h"
 #include "TestUtils.h"
@@ -49,6 +52,43 @@
 
 using namespace DataSync;
 
+/*! \brief Commit test storage with one existing vCard item
+ */
+class MatchTestStorage : public CommitTestStorage
+{
+public:
+
+    MatchTestStorage( const QString& aSourceURI, const QByteArray& aData )
+     : CommitTestStorage( aSourceURI ), iData( aData )
+    {
+    }
+
+    virtual bool getAll( QList<SyncItemKey>& aKeys )
+    {
+        aKeys.append( "local1" );
+        return true;
+    }
+
+    virtual QList<SyncItem*> getSyncItems( const QList<SyncItemKey>& aKeyList )
+    {
+        QList<SyncItem*> items;
+
+        for( int i = 0; i < aKeyList.count(); ++i ) {
+            MockSyncItem* item = new MockSyncItem( aKeyList[i] );
+            item->setType( "text/x-vcard" );
+            item->write( 0, iData );
+            items.append( item );
+        }
+
+        return items;
+    }
+
+private:
+
+    QByteArray iData;
+
+};
+
 
 CommandHandlerTest::CommandHandlerTest()
 {
@@ -288,6 +328,68 @@ void CommandHandlerTest::testSyncAdd()
 
 }
 
+void CommandHandlerTest::testSyncAddMatched_Client()
+{
+    // Added item matches a local item by UID, but their content differs
+    QString localDb( "localdb" );
+    QString remoteDb( "remotedb" );
+
+    MatchTestStorage storage( localDb, "BEGIN:VCARD\nUID:abc-123\nN:Doe;John\nEND:VCARD\n" );
+    SyncMode mode;
+    QString anchor;
+    SyncTarget target( NULL, &storage, mode, anchor );
+    target.setItemMatcher( new ItemMatcher( storage ) );
+    target.getLocalChanges()->added.append( "local1" );
+
+    LocalChanges changes;
+    ConflictResolver conflictResolver( changes, PREFER_REMOTE_CHANGES );
+    StorageHandler storageHandler;
+    CommandHandler handler( ROLE_CLIENT );
+    ResponseGenerator generator;
+    generator.setRemoteMsgId( 1 );
+
+    SyncParams syncParams;
+
+    int cmdId = 1;
+
+    syncParams.cmdId = cmdId++;
+    syncParams.source = remoteDb;
+    syncParams.target = localDb;
+
+    CommandParams add( CommandParams::COMMAND_ADD );
+    add.cmdId = cmdId++;
+
+    ItemParams addItem;
+    addItem.source = "remote1";
+    addItem.data = "BEGIN:VCARD\nUID:abc-123\nN:Doe;Jane\nEND:VCARD\n";
+    addItem.meta.type = "text/x-vcard";
+    add.items.append( addItem );
+
+    syncParams.commands.append( add );
+
+    handler.handleSync( syncParams, target, storageHandler, generator, conflictResolver, false );
+
+    // Client doesn't resolve conflicts, so the local item is neither
+    // overwritten nor added again
+    QCOMPARE( storage.iAddedItems.count(), 0 );
+    QCOMPARE( storage.iReplacedItems.count(), 0 );
+    QCOMPARE( target.mapToLocalUID( "remote1" ), QString( "local1" ) );
+    QVERIFY( target.getLocalChanges()->added.isEmpty() );
+
+    bool found = false;
+
+    for( int i = 0; i < generator.getStatuses().count(); ++i ) {
+        const StatusParams* status = generator.getStatuses()[i];
+
+        if( status->cmdRef == add.cmdId ) {
+            QCOMPARE( status->data, ALREADY_EXISTS );
+            found = true;
+        }
+    }
+
+    QVERIFY( found );
+}
+
 void CommandHandlerTest::testSyncReplace()
 {
 
@@ -657,4 +759,145 @@ void CommandHandlerTest::testHandleMap()
     QCOMPARE(target.getUIDMappings().at(1).iLocalUID, trg2);
 }
 
+void CommandHandlerTest::testItemStatus()
+{
+    CommandHandler handler(ROLE_CLIENT);
+
+    qRegisterMetaType<SyncItemKey>("SyncItemKey");
+    QSignalSpy acknowledged_spy(&handler, SIGNAL(itemAcknowledged(int, int, SyncItemKey, int)));
+
+    // Status referring to several items of a command
+    StatusParams status;
+    status.msgRef = 1;
+    status.cmdRef = 3;
+    status.cmd = SYNCML_ELEMENT_ADD;
+    status.data = ITEM_ADDED;
+    status.sourceRefs.append("item1");
+    status.sourceRefs.append("item2");
+
+    handler.handleStatus(&status);
+    QCOMPARE(acknowledged_spy.count(), 2);
+    QCOMPARE(acknowledged_spy.at(0).at(2).toString(), QString("item1"));
+    QCOMPARE(acknowledged_spy.at(1).at(2).toString(), QString("item2"));
+    QCOMPARE(acknowledged_spy.at(1).at(3).toInt(), static_cast<int>(ITEM_ADDED));
+
+    // Status without references applies to the whole command
+    acknowledged_spy.clear();
+    status.sourceRefs.clear();
+
+    handler.handleStatus(&status);
+    QCOMPARE(acknowledged_spy.count(), 1);
+    QCOMPARE(acknowledged_spy.at(0).at(1).toInt(), 3);
+    QVERIFY(acknowledged_spy.at(0).at(2).toString().isEmpty());
+
+    // Status with only a target reference refers to the remote key
+    QSignalSpy remote_spy(&handler, SIGNAL(remoteItemAcknowledged(int, int, QString, int)));
+    acknowledged_spy.clear();
+    status.cmd = SYNCML_ELEMENT_REPLACE;
+    status.data = SUCCESS;
+    status.targetRef = "remote1";
+
+    handler.handleStatus(&status);
+    QCOMPARE(acknowledged_spy.count(), 0);
+    QCOMPARE(remote_spy.count(), 1);
+    QCOMPARE(remote_spy.at(0).at(2).toString(), QString("remote1"));
+    QCOMPARE(remote_spy.at(0).at(3).toInt(), static_cast<int>(SUCCESS));
+}
+
+void CommandHandlerTest::testMultiItemStatus()
+{
+    // Test that statuses generated for the items of one command, some
+    // sharing a status code, acknowledge exactly the items they refer to
+
+    ResponseGenerator generator;
+    HeaderParams header;
+    header.verDTD = SYNCML_DTD_VERSION_1_2;
+    header.sessionID = "1";
+    header.msgID = 2;
+    header.sourceDevice = "remote";
+    header.targetDevice = "local";
+    generator.setHeaderParams( header );
+    generator.setRemoteMsgId( 1 );
+
+    // Add of a client refers to items by source
+    CommandParams add( CommandParams::COMMAND_ADD );
+    add.cmdId = 3;
+    for( int i = 1; i <= 3; ++i ) {
+        ItemParams item;
+        item.source = QString( "item%1" ).arg( i );
+        add.items.append( item );
+    }
+
+    QList<int> added;
+    added << 0 << 2;
+    QList<int> failed;
+    failed << 1;
+    generator.addStatus( add, ITEM_ADDED, added );
+    generator.addStatus( add, COMMAND_FAILED, failed );
+
+    // Replace of a server refers to items by target only
+    CommandParams replace( CommandParams::COMMAND_REPLACE );
+    replace.cmdId = 4;
+    for( int i = 1; i <= 2; ++i ) {
+        ItemParams item;
+        item.target = QString( "remote%1" ).arg( i );
+        replace.items.append( item );
+    }
+
+    QList<int> replaced;
+    replaced << 0 << 1;
+    generator.addStatus( replace, SUCCESS, replaced );
+
+    SyncMLMessage* message = generator.generateNextMessage( 65535, SYNCML_1_2 );
+    QVERIFY( message );
+
+    QtEncoder encoder;
+    QByteArray xml;
+    QVERIFY( encoder.encodeToXML( *message, xml, false ) );
+    delete message;
+
+    QBuffer buffer( &xml );
+    buffer.open( QIODevice::ReadOnly );
+
+    SyncMLMessageParser parser;
+    parser.parseResponse( &buffer, true );
+    QList<Fragment*> fragments = parser.takeFragments();
+
+    CommandHandler handler( ROLE_CLIENT );
+
+    qRegisterMetaType<SyncItemKey>( "SyncItemKey" );
+    QSignalSpy acknowledged_spy( &handler, SIGNAL(itemAcknowledged(int, int, SyncItemKey, int)) );
+    QSignalSpy remote_spy( &handler, SIGNAL(remoteItemAcknowledged(int, int, QString, int)) );
+
+    foreach( Fragment* fragment, fragments ) {
+        if( fragment->fragmentType == Fragment::FRAGMENT_STATUS ) {
+            StatusParams* status = static_cast<StatusParams*>( fragment );
+
+            if( status->cmd != SYNCML_ELEMENT_SYNCHDR ) {
+                handler.handleStatus( status );
+            }
+        }
+    }
+
+    qDeleteAll( fragments );
+
+    QMap<QString, int> codes;
+    for( int i = 0; i < acknowledged_spy.count(); ++i ) {
+        QCOMPARE( acknowledged_spy.at(i).at(0).toInt(), 1 );
+        QCOMPARE( acknowledged_spy.at(i).at(1).toInt(), 3 );
+        codes.insert( acknowledged_spy.at(i).at(2).toString(), acknowledged_spy.at(i).at(3).toInt() );
+    }
+
+    QCOMPARE( acknowledged_spy.count(), 3 );
+    QCOMPARE( codes.value( "item1" ), static_cast<int>( ITEM_ADDED ) );
+    QCOMPARE( codes.value( "item2" ), static_cast<int>( COMMAND_FAILED ) );
+    QCOMPARE( codes.value( "item3" ), static_cast<int>( ITEM_ADDED ) );
+
+    QCOMPARE( remote_spy.count(), 2 );
+    QCOMPARE( remote_spy.at(0).at(1).toInt(), 4 );
+    QCOMPARE( remote_spy.at(0).at(2).toString(), QString( "remote1" ) );
+    QCOMPARE( remote_spy.at(1).at(2).toString(), QString( "remote2" ) );
+    QCOMPARE( remote_spy.at(1).at(3).toInt(), static_cast<int>( SUCCESS ) );
+}
+
 QTEST_MAIN(DataSync::CommandHandlerTest)
@@ -191,6 +191,7 @@ private slots:
     void testAdd_Server01();
 
     void testSyncAdd();
+    void testSyncAddMatched_Client();
     void testSyncReplace();
     void testSyncDelete();
     void testSyncReplaceConflict();
@@ -198,6 +199,8 @@ private slots:
     void testGetStatusType();
     void testNotImplemented();
     void testHandleMap();
+    void testItemStatus();
+    void testMultiItemStatus();
 
 private:
 
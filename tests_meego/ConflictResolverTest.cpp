@@ -34,8 +34,94 @@
 
 #include "ConflictResolverTest.h"
 
+#include "ConflictResolver.h"
+#include "LocalChanges.h"
 
 using namespace DataSync;
 
+void ConflictResolverTest::testIsConflict()
+{
+    LocalChanges changes;
+    changes.added.append( "added" );
+    changes.modified.append( "modified" );
+    changes.removed.append( "removed" );
+
+    ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
+
+    QVERIFY( !resolver.isConflict( "", false ) );
+    QVERIFY( !resolver.isConflict( "added", false ) );
+    QVERIFY( resolver.isConflict( "modified", false ) );
+    QVERIFY( resolver.isConflict( "modified", true ) );
+    QVERIFY( resolver.isConflict( "removed", false ) );
+    QVERIFY( !resolver.isConflict( "removed", true ) );
+    QVERIFY( !resolver.isConflict( "unknown", false ) );
+}
+
+void ConflictResolverTest::testRevertLocalChange()
+{
+    LocalChanges changes;
+    changes.modified << "m1" << "m2" << "m3";
+    changes.removed << "r1" << "r2";
+
+    {
+        ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
+
+        resolver.revertLocalChange( "m2", CR_MODIFY_TO_ADD );
+        resolver.revertLocalChange( "r1", CR_REMOVE_LOCAL );
+        resolver.revertLocalChange( "m3", CR_REMOVE_LOCAL );
+
+        QVERIFY( !resolver.isConflict( "m2", false ) );
+        QVERIFY( !resolver.isConflict( "m3", false ) );
+        QVERIFY( !resolver.isConflict( "r1", false ) );
+        QVERIFY( resolver.isConflict( "m1", false ) );
+        QVERIFY( resolver.isConflict( "r2", false ) );
+
+        resolver.applyRevertedChanges();
+
+        QCOMPARE( changes.added, QList<SyncItemKey>() << "m2" );
+        QCOMPARE( changes.modified, QList<SyncItemKey>() << "m1" );
+        QCOMPARE( changes.removed, QList<SyncItemKey>() << "r2" );
+
+        // Reverting again has no effect
+        resolver.revertLocalChange( "m2", CR_MODIFY_TO_ADD );
+        resolver.revertLocalChange( "r1", CR_REMOVE_LOCAL );
+
+        resolver.revertLocalChange( "r2", CR_REMOVE_LOCAL );
+    }
+
+    // Destructor applies remaining reverted changes
+    QCOMPARE( changes.added, QList<SyncItemKey>() << "m2" );
+    QCOMPARE( changes.modified, QList<SyncItemKey>() << "m1" );
+    QVERIFY( changes.removed.isEmpty() );
+}
+
+void ConflictResolverTest::benchmarkResolveConflicts()
+{
+    // 10k local changes, 10k incoming changes of which half overlap
+    const int count = 10000;
+
+    LocalChanges localChanges;
+    QList<SyncItemKey> incoming;
+
+    for( int i = 0; i < count; ++i ) {
+        localChanges.modified.append( QString::number( i ) );
+        localChanges.removed.append( QString::number( count + i ) );
+        incoming.append( QString::number( count / 2 + 2 * i ) );
+    }
+
+    QBENCHMARK {
+        LocalChanges changes = localChanges;
+        ConflictResolver resolver( changes, PREFER_REMOTE_CHANGES );
+
+        foreach( const SyncItemKey& key, incoming ) {
+            if( resolver.isConflict( key, false ) ) {
+                resolver.revertLocalChange( key, CR_REMOVE_LOCAL );
+            }
+        }
+
+        resolver.applyRevertedChanges();
+    }
+}
+
 
 QTEST_MAIN(DataSync::ConflictResolverTest)
@@ -44,6 +44,10 @@ class ConflictResolverTest: public QObject
     Q_OBJECT;
 private slots:
 
+    void testIsConflict();
+    void testRevertLocalChange();
+
+    void benchmarkResolveConflicts();
 
 private:
 
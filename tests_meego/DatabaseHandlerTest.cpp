@@ -0,0 +1,206 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "DatabaseHandlerTest.h"
+
+#include <QFile>
+
+#include "DatabaseHandler.h"
+
+const QString DB( "/tmp/databasehandlertest.db" );
+const QString CREATETABLE( "CREATE TABLE IF NOT EXISTS values_test(id integer primary key autoincrement, value varchar(128))" );
+const QString INSERTVALUE( "INSERT INTO values_test(value) VALUES(:value)" );
+const QString COUNTVALUES( "SELECT COUNT(*) FROM values_test" );
+
+using namespace DataSync;
+
+static int countValues( QSqlDatabase& aDbHandle )
+{
+    QSqlQuery query = DatabaseHandler::prepare( aDbHandle, COUNTVALUES );
+
+    if( !query.exec() || !query.next() ) {
+        return -1;
+    }
+
+    int count = query.value( 0 ).toInt();
+    query.finish();
+
+    return count;
+}
+
+void DatabaseHandlerTest::init()
+{
+    QFile::remove( DB );
+}
+
+void DatabaseHandlerTest::cleanup()
+{
+    QFile::remove( DB );
+    QFile::remove( DB + "-wal" );
+    QFile::remove( DB + "-shm" );
+}
+
+void DatabaseHandlerTest::testPooledConnection()
+{
+    DatabaseHandler handler1( DB );
+    QVERIFY( handler1.isValid() );
+
+    QSqlQuery query( handler1.getDbHandle() );
+    QVERIFY( query.exec( "PRAGMA journal_mode" ) );
+    QVERIFY( query.next() );
+    QCOMPARE( query.value( 0 ).toString().toLower(), QString( "wal" ) );
+    query.finish();
+
+    {
+        DatabaseHandler handler2( DB );
+        QVERIFY( handler2.isValid() );
+        QCOMPARE( handler2.getDbHandle().connectionName(), handler1.getDbHandle().connectionName() );
+    }
+
+    // Releasing the second handler must not close the shared connection
+    QVERIFY( handler1.isValid() );
+}
+
+void DatabaseHandlerTest::testPoolKey()
+{
+    DatabaseHandler handler1( DB, "session1" );
+    DatabaseHandler handler2( DB, "session2" );
+    DatabaseHandler handler3( DB, "session1" );
+    QVERIFY( handler1.isValid() );
+    QVERIFY( handler2.isValid() );
+
+    QVERIFY( handler1.getDbHandle().connectionName() != handler2.getDbHandle().connectionName() );
+    QCOMPARE( handler3.getDbHandle().connectionName(), handler1.getDbHandle().connectionName() );
+
+    // Transactions of one pool are not visible in the other
+    QSqlDatabase& db1 = handler1.getDbHandle();
+    QSqlDatabase& db2 = handler2.getDbHandle();
+    QVERIFY( DatabaseHandler::ensureSchema( db1, CREATETABLE ) );
+    QVERIFY( DatabaseHandler::ensureSchema( db2, CREATETABLE ) );
+
+    QVERIFY( DatabaseHandler::beginTransaction( db1 ) );
+    QSqlQuery query = DatabaseHandler::prepare( db1, INSERTVALUE );
+    query.bindValue( ":value", "session1" );
+    QVERIFY( query.exec() );
+
+    QCOMPARE( countValues( db2 ), 0 );
+    QVERIFY( !DatabaseHandler::commitTransaction( db2 ) );
+
+    QVERIFY( DatabaseHandler::commitTransaction( db1 ) );
+    QCOMPARE( countValues( db2 ), 1 );
+}
+
+void DatabaseHandlerTest::testPrepare()
+{
+    DatabaseHandler handler( DB );
+    QVERIFY( DatabaseHandler::ensureSchema( handler.getDbHandle(), CREATETABLE ) );
+
+    for( int i = 0; i < 3; ++i ) {
+        QSqlQuery query = DatabaseHandler::prepare( handler.getDbHandle(), INSERTVALUE );
+        query.bindValue( ":value", QString::number( i ) );
+        QVERIFY( query.exec() );
+    }
+
+    QCOMPARE( countValues( handler.getDbHandle() ), 3 );
+
+    QSqlQuery invalid = DatabaseHandler::prepare( handler.getDbHandle(), "SELECT * FROM no_such_table" );
+    QVERIFY( invalid.lastError().isValid() );
+}
+
+void DatabaseHandlerTest::testEnsureSchema()
+{
+    DatabaseHandler handler( DB );
+
+    QVERIFY( DatabaseHandler::ensureSchema( handler.getDbHandle(), CREATETABLE ) );
+    QVERIFY( handler.getDbHandle().tables().contains( "values_test" ) );
+
+    // Schema statements that have succeeded are not executed again
+    QSqlQuery drop( handler.getDbHandle() );
+    QVERIFY( drop.exec( "DROP TABLE values_test" ) );
+    QVERIFY( DatabaseHandler::ensureSchema( handler.getDbHandle(), CREATETABLE ) );
+    QVERIFY( !handler.getDbHandle().tables().contains( "values_test" ) );
+
+    QVERIFY( !DatabaseHandler::ensureSchema( handler.getDbHandle(), "CREATE TABLE" ) );
+}
+
+void DatabaseHandlerTest::testNestedTransactions()
+{
+    DatabaseHandler handler( DB );
+    QSqlDatabase& db = handler.getDbHandle();
+    QVERIFY( DatabaseHandler::ensureSchema( db, CREATETABLE ) );
+
+    QVERIFY( DatabaseHandler::beginTransaction( db ) );
+    QVERIFY( DatabaseHandler::beginTransaction( db ) );
+
+    QSqlQuery query = DatabaseHandler::prepare( db, INSERTVALUE );
+    query.bindValue( ":value", "nested" );
+    QVERIFY( query.exec() );
+
+    QVERIFY( DatabaseHandler::commitTransaction( db ) );
+    QVERIFY( DatabaseHandler::commitTransaction( db ) );
+
+    // Nothing to commit any more
+    QVERIFY( !DatabaseHandler::commitTransaction( db ) );
+
+    QCOMPARE( countValues( db ), 1 );
+}
+
+void DatabaseHandlerTest::testNestedRollback()
+{
+    DatabaseHandler handler( DB );
+    QSqlDatabase& db = handler.getDbHandle();
+    QVERIFY( DatabaseHandler::ensureSchema( db, CREATETABLE ) );
+
+    QVERIFY( DatabaseHandler::beginTransaction( db ) );
+
+    QSqlQuery query = DatabaseHandler::prepare( db, INSERTVALUE );
+    query.bindValue( ":value", "outer" );
+    QVERIFY( query.exec() );
+
+    QVERIFY( DatabaseHandler::beginTransaction( db ) );
+    DatabaseHandler::rollbackTransaction( db );
+
+    // Rolling back the nested transaction rolls back the outer one
+    QVERIFY( !DatabaseHandler::commitTransaction( db ) );
+    QCOMPARE( countValues( db ), 0 );
+
+    // Next transaction is not affected
+    QVERIFY( DatabaseHandler::beginTransaction( db ) );
+    query = DatabaseHandler::prepare( db, INSERTVALUE );
+    query.bindValue( ":value", "next" );
+    QVERIFY( query.exec() );
+    QVERIFY( DatabaseHandler::commitTransaction( db ) );
+    QCOMPARE( countValues( db ), 1 );
+}
+
+QTEST_MAIN(DataSync::DatabaseHandlerTest)
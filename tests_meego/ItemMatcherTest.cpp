@@ -0,0 +1,207 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "ItemMatcherTest.h"
+
+#include "ItemMatcher.h"
+#include "Mock.h"
+
+using namespace DataSync;
+
+/*! \brief Storage with items of given content
+ */
+class ItemMatcherStorage : public MockStorage
+{
+public:
+
+    ItemMatcherStorage() : MockStorage( "matcherstorage" )
+    {
+    }
+
+    void addItem( const SyncItemKey& aKey, const QByteArray& aData )
+    {
+        iKeys.append( aKey );
+        iData.insert( aKey, aData );
+    }
+
+    virtual bool getAll( QList<SyncItemKey>& aKeys )
+    {
+        aKeys = iKeys;
+        return true;
+    }
+
+    virtual SyncItem* getSyncItem( const SyncItemKey& aKey )
+    {
+        if( !iData.contains( aKey ) ) {
+            return NULL;
+        }
+
+        MockSyncItem* item = new MockSyncItem( aKey );
+        item->setType( "text/x-vcard" );
+        item->write( 0, iData.value( aKey ) );
+        return item;
+    }
+
+private:
+
+    QList<SyncItemKey>              iKeys;
+    QHash<SyncItemKey, QByteArray>  iData;
+
+};
+
+static QList<QByteArray> firstLineKeys( const QByteArray& aData )
+{
+    QList<QByteArray> keys;
+    keys.append( aData.left( aData.indexOf( '\n' ) ) );
+    return keys;
+}
+
+void ItemMatcherTest::testVCardKeys()
+{
+    const QByteArray vcard( "BEGIN:VCARD\r\nVERSION:2.1\r\nUID:abc-123\r\n"
+                            "N:Doe;John;;;\r\nTEL;CELL:+358 40\r\n 123 4567\r\n"
+                            "item1.TEL:(09) 555\r\nEND:VCARD\r\n" );
+
+    QList<QByteArray> keys = ItemMatcher::vCardKeys( vcard );
+    QCOMPARE( keys.count(), 3 );
+    QCOMPARE( keys[0], QByteArray( "UID:abc-123" ) );
+    QCOMPARE( keys[1], QByteArray( "N+TEL:doe;john:09555,358401234567" ) );
+    QCOMPARE( keys[2], ItemMatcher::contentKeys( vcard ).first() );
+
+    // Without UID and phone numbers only content is matched
+    const QByteArray nameOnly( "BEGIN:VCARD\nN:Doe;John\nEND:VCARD\n" );
+    keys = ItemMatcher::vCardKeys( nameOnly );
+    QCOMPARE( keys.count(), 1 );
+    QCOMPARE( keys[0], ItemMatcher::contentKeys( nameOnly ).first() );
+}
+
+void ItemMatcherTest::testICalendarKeys()
+{
+    const QByteArray event( "BEGIN:VCALENDAR\r\nBEGIN:VEVENT\r\nUID:event-1\r\n"
+                            "RECURRENCE-ID:20100101T100000Z\r\nSUMMARY:Meeting\r\n"
+                            "END:VEVENT\r\nEND:VCALENDAR\r\n" );
+
+    QList<QByteArray> keys = ItemMatcher::iCalendarKeys( event );
+    QCOMPARE( keys.count(), 2 );
+    QCOMPARE( keys[0], QByteArray( "UID:event-1;20100101T100000Z" ) );
+}
+
+void ItemMatcherTest::testContentKeys()
+{
+    // Line endings and trailing white space do not matter
+    QCOMPARE( ItemMatcher::contentKeys( "foo \r\nbar\r\n" ),
+              ItemMatcher::contentKeys( "foo\nbar\n" ) );
+    QVERIFY( ItemMatcher::contentKeys( "foo\nbar\n" ) != ItemMatcher::contentKeys( "foo\nbaz\n" ) );
+}
+
+void ItemMatcherTest::testMatch()
+{
+    const QByteArray withUid( "BEGIN:VCARD\nUID:abc\nN:Smith;Jane\nEND:VCARD\n" );
+    const QByteArray withPhone( "BEGIN:VCARD\nN:Doe;John\nTEL:+358 40 123\nEND:VCARD\n" );
+
+    ItemMatcherStorage storage;
+    storage.addItem( "1", withUid );
+    storage.addItem( "2", withPhone );
+    storage.addItem( "3", "BEGIN:VCARD\nN:Other;Person\nEND:VCARD\n" );
+
+    ItemMatcher matcher( storage );
+    QVERIFY( matcher.buildIndex() );
+
+    bool identical = false;
+
+    MockSyncItem sameItem( "" );
+    sameItem.setType( "text/x-vcard" );
+    sameItem.write( 0, withUid );
+    QCOMPARE( matcher.match( sameItem, identical ), SyncItemKey( "1" ) );
+    QVERIFY( identical );
+
+    // Name and phone number match even if formatting differs
+    MockSyncItem changedItem( "" );
+    changedItem.setType( "text/x-vcard" );
+    changedItem.write( 0, "BEGIN:VCARD\nN:doe;john;;;\nTEL:+35840123\nEMAIL:john@example.com\nEND:VCARD\n" );
+    QCOMPARE( matcher.match( changedItem, identical ), SyncItemKey( "2" ) );
+    QVERIFY( !identical );
+
+    // Each local item is matched only once
+    QVERIFY( matcher.match( sameItem, identical ).isEmpty() );
+
+    MockSyncItem newItem( "" );
+    newItem.setType( "text/x-vcard" );
+    newItem.write( 0, "BEGIN:VCARD\nN:New;Person\nEND:VCARD\n" );
+    QVERIFY( matcher.match( newItem, identical ).isEmpty() );
+}
+
+void ItemMatcherTest::testMatchSharedKey()
+{
+    const QByteArray duplicate( "BEGIN:VCARD\nN:Doe;John\nTEL:+358 40 123\nEND:VCARD\n" );
+
+    ItemMatcherStorage storage;
+    storage.addItem( "1", duplicate );
+    storage.addItem( "2", duplicate );
+
+    ItemMatcher matcher( storage );
+    QVERIFY( matcher.buildIndex() );
+
+    bool identical = false;
+
+    MockSyncItem item( "" );
+    item.setType( "text/x-vcard" );
+    item.write( 0, duplicate );
+
+    // Local items sharing a key are matched in turn
+    QCOMPARE( matcher.match( item, identical ), SyncItemKey( "1" ) );
+    QVERIFY( identical );
+    QCOMPARE( matcher.match( item, identical ), SyncItemKey( "2" ) );
+    QVERIFY( identical );
+    QVERIFY( matcher.match( item, identical ).isEmpty() );
+}
+
+void ItemMatcherTest::testCustomExtractor()
+{
+    ItemMatcherStorage storage;
+    storage.addItem( "1", "BEGIN:VCARD\nN:Doe;John\nEND:VCARD\n" );
+
+    ItemMatcher matcher( storage );
+    matcher.setKeyExtractor( "TEXT/X-VCARD", firstLineKeys );
+    QVERIFY( matcher.buildIndex() );
+
+    bool identical = false;
+
+    MockSyncItem item( "" );
+    item.setType( "text/x-vcard" );
+    item.write( 0, "BEGIN:VCARD\nN:Somebody;Else\nEND:VCARD\n" );
+    QCOMPARE( matcher.match( item, identical ), SyncItemKey( "1" ) );
+    QVERIFY( !identical );
+}
+
+QTEST_MAIN(DataSync::ItemMatcherTest)
@@ -33,8 +33,11 @@
 
 #include "LocalChangesPackageTest.h"
 
+#include <QSignalSpy>
+
 #include "SyncItem.h"
 #include "SyncTarget.h"
+#include "ChangeLog.h"
 #include "LocalChangesPackage.h"
 #include "SyncMLMessage.h"
 #include "QtEncoder.h"
@@ -228,6 +231,7 @@ void LocalChangesPackageTest::testSimpleClient()
     target.setTargetDatabase( "./RemoteContacts");
 
     LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    QSignalSpy prefetched( &package, SIGNAL( itemsPrefetched( int, int ) ) );
 
     SyncMLMessage msg( HeaderParams(), SYNCML_1_2 );
 
@@ -235,6 +239,10 @@ void LocalChangesPackageTest::testSimpleClient()
     QVERIFY( package.write( msg, remaining , false, SYNCML_1_2) );
     QVERIFY( remaining < msgSize );
 
+    // Added and replaced item were fetched from storage
+    QCOMPARE( prefetched.count(), 1 );
+    QCOMPARE( prefetched.at(0).at(0).toInt() + prefetched.at(0).at(1).toInt(), 2 );
+
     QtEncoder encoder;
     QByteArray result_xml;
     QVERIFY( encoder.encodeToXML( msg, result_xml, true ) );
@@ -383,4 +391,154 @@ void LocalChangesPackageTest::testLargeObjects()
     QVERIFY( !result_xml2.contains( "MoreData" ) );
 
 }
+
+void LocalChangesPackageTest::testSuppressUnchangedReplaces()
+{
+    // Test that modified items whose content has not changed since
+    // previous sync are not sent
+
+    const int msgSize = 65535;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+    const QString itemTypes( "text/foo" );
+
+    const QString unchangedItemId( "unchangedItem" );
+    const QByteArray unchangedItemData( "unchangedData" );
+    MockSyncItem* unchangedItem = new MockSyncItem( unchangedItemId );
+    unchangedItem->setType( itemTypes );
+    unchangedItem->write( 0, unchangedItemData );
+    items.append( unchangedItem );
+    changes.modified.append( unchangedItemId );
+
+    const QString changedItemId( "changedItem" );
+    const QByteArray changedItemData( "changedData" );
+    MockSyncItem* changedItem = new MockSyncItem( changedItemId );
+    changedItem->setType( itemTypes );
+    changedItem->write( 0, changedItemData );
+    items.append( changedItem );
+    changes.modified.append( changedItemId );
+
+    QHash<SyncItemKey, QByteArray> fingerprints;
+    fingerprints.insert( unchangedItemId, unchangedItem->getFingerprint() );
+    fingerprints.insert( changedItemId, QByteArray( "stale" ) );
+
+    storage.setItems( items );
+
+    ChangeLog* changeLog = new ChangeLog( "remoteDevice", "./LocalContacts", DIRECTION_TWO_WAY );
+    changeLog->setFingerprints( fingerprints );
+
+    SyncMode syncMode;
+    SyncTarget target( changeLog, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+    target.enableReplaceSuppression();
+
+    qRegisterMetaType<SyncItemKey>( "SyncItemKey" );
+
+    LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    QSignalSpy suppressed( &package, SIGNAL( itemSuppressed( SyncItemKey, QString ) ) );
+
+    SyncMLMessage msg( HeaderParams(), SYNCML_1_2 );
+
+    int remaining = msgSize;
+    QVERIFY( package.write( msg, remaining, false, SYNCML_1_2 ) );
+
+    QtEncoder encoder;
+    QByteArray result_xml;
+    QVERIFY( encoder.encodeToXML( msg, result_xml, true ) );
+
+    QVERIFY( !result_xml.contains( unchangedItemData ) );
+    QVERIFY( result_xml.contains( changedItemData ) );
+    QCOMPARE( suppressed.count(), 1 );
+    QCOMPARE( suppressed.at(0).at(0).toString(), unchangedItemId );
+
+}
+void LocalChangesPackageTest::testMultiItemCommands()
+{
+    // Test that consecutive items of the same type are written to
+    // a single command with shared meta
+
+    const int msgSize = 65535;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+    const QString fooType( "text/foo" );
+    const QString barType( "text/bar" );
+
+    const QString addedItemIds[] = { "addedItem1", "addedItem2", "addedItem3" };
+    const QString addedItemTypes[] = { fooType, fooType, barType };
+
+    for( int i = 0; i < 3; ++i ) {
+        MockSyncItem* addedItem = new MockSyncItem( addedItemIds[i] );
+        addedItem->setType( addedItemTypes[i] );
+        addedItem->write( 0, "addedData" + QByteArray::number( i ) );
+        items.append( addedItem );
+        changes.added.append( addedItemIds[i] );
+    }
+
+    const QString replacedItemIds[] = { "replacedItem1", "replacedItem2" };
+
+    for( int i = 0; i < 2; ++i ) {
+        MockSyncItem* replacedItem = new MockSyncItem( replacedItemIds[i] );
+        replacedItem->setType( fooType );
+        replacedItem->write( 0, "replacedData" + QByteArray::number( i ) );
+        items.append( replacedItem );
+        changes.modified.append( replacedItemIds[i] );
+    }
+
+    changes.removed.append( "deletedItem1" );
+    changes.removed.append( "deletedItem2" );
+    changes.removed.append( "deletedItem3" );
+
+    storage.setItems( items );
+
+    SyncMode syncMode;
+    SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+
+    qRegisterMetaType<SyncItemKey>( "SyncItemKey" );
+    qRegisterMetaType<ModificationType>( "ModificationType" );
+
+    LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    package.setMultiItemCommands( true );
+    QSignalSpy written( &package, SIGNAL( newItemWritten( int, int, SyncItemKey, ModificationType,
+                                                          QString, QString, QString ) ) );
+
+    SyncMLMessage msg( HeaderParams(), SYNCML_1_2 );
+
+    int remaining = msgSize;
+    QVERIFY( package.write( msg, remaining, false, SYNCML_1_2 ) );
+    QVERIFY( remaining < msgSize );
+
+    QtEncoder encoder;
+    QByteArray result_xml;
+    QVERIFY( encoder.encodeToXML( msg, result_xml, true ) );
+
+    // Added items of different types are in separate commands, others share one
+    QCOMPARE( result_xml.count( "<Add>" ), 2 );
+    QCOMPARE( result_xml.count( "<Replace>" ), 1 );
+    QCOMPARE( result_xml.count( "<Delete>" ), 1 );
+    QCOMPARE( result_xml.count( fooType.toLatin1() ), 2 );
+    QCOMPARE( result_xml.count( barType.toLatin1() ), 1 );
+
+    for( int i = 0; i < 3; ++i ) {
+        QVERIFY( result_xml.contains( "addedData" + QByteArray::number( i ) ) );
+    }
+
+    // Items sharing a command are reported with the same command id
+    QCOMPARE( written.count(), 8 );
+    QCOMPARE( written.at(0).at(1).toInt(), written.at(1).at(1).toInt() );
+    QVERIFY( written.at(2).at(1).toInt() != written.at(1).at(1).toInt() );
+    QCOMPARE( written.at(3).at(1).toInt(), written.at(4).at(1).toInt() );
+    QCOMPARE( written.at(5).at(1).toInt(), written.at(6).at(1).toInt() );
+    QCOMPARE( written.at(6).at(1).toInt(), written.at(7).at(1).toInt() );
+
+}
+
 QTEST_MAIN(LocalChangesPackageTest)
@@ -97,6 +97,10 @@ private slots:
 
     void testLargeObjects();
 
+    void testSuppressUnchangedReplaces();
+
+    void testMultiItemCommands();
+
 };
 
 #endif // LOCALCHANGESPACKAGETEST_H
@@ -67,6 +67,35 @@ void ResponseGeneratorTest::testAddStatusStatus()
     QCOMPARE(respGen.getStatuses().size(), 2);
 }
 
+void ResponseGeneratorTest::testTakeResponses()
+{
+    ResponseGenerator respGen;
+    StatusParams* stParams1 = new StatusParams();
+    stParams1->cmdId = 1;
+    respGen.addStatus(stParams1);
+
+    ResponseGenerator other;
+    StatusParams* stParams2 = new StatusParams();
+    stParams2->cmdId = 2;
+    other.addStatus(stParams2);
+    StatusParams* stParams3 = new StatusParams();
+    stParams3->cmdId = 3;
+    other.addStatus(stParams3);
+
+    respGen.takeResponses(other);
+    QCOMPARE(other.getStatuses().size(), 0);
+    QCOMPARE(respGen.getStatuses().size(), 3);
+    QCOMPARE(respGen.getStatuses().at(0)->cmdId, 1);
+    QCOMPARE(respGen.getStatuses().at(1)->cmdId, 2);
+    QCOMPARE(respGen.getStatuses().at(2)->cmdId, 3);
+
+    other.addStatus(new StatusParams());
+    respGen.ignoreStatuses(true);
+    respGen.takeResponses(other);
+    QCOMPARE(other.getStatuses().size(), 0);
+    QCOMPARE(respGen.getStatuses().size(), 3);
+}
+
 void ResponseGeneratorTest::testAddStatusHeader()
 {
     ResponseGenerator respGen;
@@ -51,6 +51,7 @@ private slots:
     void testAddStatusResults();
     void testAddStatusPut();
     void testNB182304();
+    void testTakeResponses();
 
     void test208762();
 
@@ -44,6 +44,7 @@
 #include "ServerAlertedNotification.h"
 #include "SyncAgentConfigProperties.h"
 #include "SyncCommonDefs.h"
+#include "SuspendLog.h"
 
 
 using namespace DataSync;
@@ -68,6 +69,7 @@ bool SessionHandlerTest::getStorageContentFormatInfo( const QString& aURI,
 
 StoragePlugin* SessionHandlerTest::acquireStorageByURI( const QString& /*aURI*/ )
 {
+    iAcquiredBy.append( iSessionHandler );
     return new MockStorage( "storage" );
 }
 
@@ -81,9 +83,18 @@ void SessionHandlerTest::releaseStorage( StoragePlugin* aStorage )
     delete aStorage;
 }
 
+void SessionHandlerTest::releaseSessionStorage( StoragePlugin* aStorage,
+                                                const SessionHandler* aSessionHandler )
+{
+    iReleasedBy.append( aSessionHandler );
+    StorageProvider::releaseSessionStorage( aStorage, aSessionHandler );
+}
+
 void SessionHandlerTest::init()
 {
     QFile::remove( DBFILE );
+    iAcquiredBy.clear();
+    iReleasedBy.clear();
 }
 
 void SessionHandlerTest::cleanup()
@@ -253,6 +264,37 @@ void SessionHandlerTest::testNoRespSyncElement()
 
 }
 
+void SessionHandlerTest::testStatistics()
+{
+    TestTransport transport( false );
+
+    SyncAgentConfig config;
+    config.setTransport(&transport);
+    config.setStorageProvider( this );
+    config.addSyncTarget( "calendar", "calendar" );
+    config.setDatabaseFilePath( DBFILE );
+
+    ClientSessionHandler session_handler(&config, NULL);
+    session_handler.initiateSync();
+
+    // Initialization package has been sent
+    const SessionStatistics& statistics = session_handler.getStatistics();
+    QCOMPARE( statistics.iMessagesSent, 1 );
+    QCOMPARE( statistics.iBytesSent, qint64( transport.iData.size() ) );
+    QCOMPARE( statistics.iMessagesReceived, 0 );
+    QCOMPARE( statistics.iMessages.count(), 1 );
+    QVERIFY( statistics.iMessages.first().iOutgoing );
+    QCOMPARE( statistics.iMessages.first().iMsgId, 1 );
+    QCOMPARE( statistics.iMessages.first().iBytes, qint64( transport.iData.size() ) );
+    QCOMPARE( statistics.iTimes.iEncodeTime, statistics.iMessages.first().iTimes.iEncodeTime );
+    QVERIFY( statistics.iStateTimes.contains( NOT_PREPARED ) );
+    QVERIFY( statistics.iStateTimes.contains( PREPARED ) );
+
+    session_handler.handleMessageReceived( 100 );
+    QCOMPARE( statistics.iMessagesReceived, 1 );
+    QCOMPARE( statistics.iBytesReceived, qint64( 100 ) );
+}
+
 void SessionHandlerTest::testClientWithServerInitiated()
 {
     MockTransport transport("transport");
@@ -1395,4 +1437,244 @@ void SessionHandlerTest::regression_NB153701_04()
 
 }
 
+void SessionHandlerTest::testParallelCommit()
+{
+    // Test that Sync elements of two targets in one message are committed
+    // in parallel and responded to in the order of the elements
+
+    TestTransport transport( false );
+    const QString DB1 = "calendar";
+    const QString DB2 = "contacts";
+
+    SyncAgentConfig config;
+    config.setTransport(&transport);
+    config.setStorageProvider( this );
+    config.addSyncTarget( DB1, DB1 );
+    config.addSyncTarget( DB2, DB2 );
+    config.setDatabaseFilePath( DBFILE );
+    config.setAgentProperty( PARALLELCOMMITPROP, "1" );
+
+    config.setAuthParams( AUTH_BASIC, "user", "password" );
+
+    ClientSessionHandler session_handler(&config, NULL);
+    session_handler.initiateSync();
+
+    HeaderParams* hp1 = new HeaderParams();
+    hp1->verDTD = SYNCML_DTD_VERSION_1_2;
+    hp1->sourceDevice = "Source device";
+    hp1->sessionID = "1";
+    hp1->msgID = 1;
+    hp1->targetDevice = SYNCML_UNKNOWN_DEVICE;
+    hp1->meta.maxMsgSize = 30000;
+    session_handler.handleHeaderElement(hp1);
+
+    StatusParams* sp1 = new StatusParams();
+    sp1->cmdId = 1;
+    sp1->msgRef = 1;
+    sp1->cmdRef = 0;
+    sp1->cmd = SYNCML_ELEMENT_SYNCHDR;
+    sp1->data = AUTH_ACCEPTED;
+    session_handler.handleStatusElement( sp1 );
+
+    const QString dbs[] = { DB1, DB2 };
+
+    for( int i = 0; i < 2; ++i ) {
+        CommandParams* alert = new CommandParams( CommandParams::COMMAND_ALERT );
+        alert->cmdId = 2 + i;
+        alert->data = QString::number( SLOW_SYNC );
+        ItemParams item;
+        item.source = dbs[i];
+        item.target = dbs[i];
+        item.meta.anchor.next = "something";
+        alert->items.append(item);
+        session_handler.handleAlertElement(alert);
+    }
+
+    session_handler.handleFinal();
+    QCOMPARE(session_handler.getSyncState(), SENDING_ITEMS);
+    session_handler.handleEndOfMessage();
+
+    int statusCount = session_handler.getResponseGenerator().getStatuses().count();
+
+    QList<SyncParams*> syncs;
+
+    for( int i = 0; i < 2; ++i ) {
+        SyncParams* sync = new SyncParams();
+        sync->cmdId = 1 + 2 * i;
+        sync->source = dbs[i];
+        sync->target = dbs[i];
+
+        CommandParams add( CommandParams::COMMAND_ADD );
+        add.cmdId = 2 + 2 * i;
+
+        ItemParams item;
+        item.source = "remote-" + dbs[i];
+        item.data = "data";
+        item.meta.type = "text/x-vcard";
+        add.items.append( item );
+
+        sync->commands.append( add );
+        syncs.append( sync );
+    }
+
+    session_handler.handleSyncElements( syncs );
+    QCOMPARE(session_handler.getSyncState(), RECEIVING_ITEMS);
+
+    // Status of each Sync element is followed by status of its Add
+    const QList<StatusParams*>& statuses = session_handler.getResponseGenerator().getStatuses();
+    QCOMPARE( statuses.count(), statusCount + 4 );
+
+    for( int i = 0; i < 2; ++i ) {
+        const StatusParams* syncStatus = statuses[statusCount + 2 * i];
+        QCOMPARE( syncStatus->cmd, QString( SYNCML_ELEMENT_SYNC ) );
+        QCOMPARE( syncStatus->cmdRef, 1 + 2 * i );
+        QCOMPARE( syncStatus->data, SUCCESS );
+
+        const StatusParams* addStatus = statuses[statusCount + 2 * i + 1];
+        QCOMPARE( addStatus->cmd, QString( SYNCML_ELEMENT_ADD ) );
+        QCOMPARE( addStatus->cmdRef, 2 + 2 * i );
+        QCOMPARE( addStatus->sourceRef, "remote-" + dbs[i] );
+        QCOMPARE( addStatus->data, ITEM_ADDED );
+
+        // Added item was mapped in its own target
+        SyncTarget* target = session_handler.getSyncTarget( dbs[i] );
+        QVERIFY( target );
+        QCOMPARE( target->getUIDMappings().count(), 1 );
+        QCOMPARE( target->getUIDMappings().first().iRemoteUID, "remote-" + dbs[i] );
+        QVERIFY( !target->getUIDMappings().first().iLocalUID.isEmpty() );
+    }
+
+}
+
+void SessionHandlerTest::testConcurrentStorageSessions()
+{
+    // Test that a provider shared by concurrent sessions is told which
+    // session acquires and releases each storage
+
+    TestTransport transport( false );
+    SyncAgentConfig config;
+    config.setTransport( &transport );
+    config.setStorageProvider( this );
+    config.setDatabaseFilePath( DBFILE );
+
+    ClientSessionHandler* session1 = new ClientSessionHandler( &config, NULL );
+    ClientSessionHandler* session2 = new ClientSessionHandler( &config, NULL );
+
+    QVERIFY( session1->createStorageByURI( "calendar" ) );
+    QVERIFY( session2->createStorageByURI( "calendar" ) );
+    QVERIFY( session1->createStorageByURI( "contacts" ) );
+
+    QCOMPARE( iAcquiredBy.count(), 3 );
+    QVERIFY( iAcquiredBy[0] == session1 );
+    QVERIFY( iAcquiredBy[1] == session2 );
+    QVERIFY( iAcquiredBy[2] == session1 );
+
+    delete session2;
+    QCOMPARE( iReleasedBy.count(), 1 );
+    QVERIFY( iReleasedBy[0] == session2 );
+
+    delete session1;
+    QCOMPARE( iReleasedBy.count(), 3 );
+    QVERIFY( iReleasedBy[1] == session1 );
+    QVERIFY( iReleasedBy[2] == session1 );
+}
+
+void SessionHandlerTest::testRejectedItemNotProcessed()
+{
+    // Test that only items the remote side accepted are recorded as
+    // processed for resuming the session
+
+    TestTransport transport( false );
+    const QString DB = "calendar";
+
+    SyncAgentConfig config;
+    config.setTransport( &transport );
+    config.setStorageProvider( this );
+    config.addSyncTarget( DB, DB );
+    config.setDatabaseFilePath( DBFILE );
+
+    ClientSessionHandler session_handler( &config, NULL );
+    session_handler.initiateSync();
+
+    SyncTarget* target = session_handler.getSyncTarget( DB );
+    QVERIFY( target );
+
+    SuspendLog* suspendLog = new SuspendLog( "remote", DB );
+    target->setSuspendLog( suspendLog );
+
+    ItemReferenceTarget referenceTarget;
+    referenceTarget.iLocalDatabase = DB;
+    referenceTarget.iRemoteDatabase = DB;
+    referenceTarget.iMimeType = "text/x-vcalendar";
+    session_handler.iItemReferenceTargets.append( referenceTarget );
+
+    ItemReference reference;
+    reference.iModificationType = MOD_ITEM_ADDED;
+    reference.iTarget = 0;
+
+    ItemReferenceKey accepted = { 1, 5, "accepted" };
+    ItemReferenceKey rejected = { 1, 5, "rejected" };
+    session_handler.iItemReferences.insert( accepted, reference );
+    session_handler.iItemReferences.insert( rejected, reference );
+
+    session_handler.processItemReference( accepted, ITEM_ADDED );
+    session_handler.processItemReference( rejected, COMMAND_FAILED );
+
+    QVERIFY( session_handler.iItemReferences.isEmpty() );
+    QCOMPARE( suspendLog->getProcessedItems().count(), 1 );
+    QVERIFY( suspendLog->getProcessedItems().contains( "accepted" ) );
+}
+
+void SessionHandlerTest::testServerItemStatusByTargetRef()
+{
+    // Test that status of a Replace a server sent with only the remote key
+    // is mapped back to the local item
+
+    MockTransport transport( "transport" );
+    const QString DB = "calendar";
+
+    SyncAgentConfig config;
+    config.setTransport( &transport );
+    config.setStorageProvider( this );
+    config.addSyncTarget( DB, DB );
+    config.setDatabaseFilePath( DBFILE );
+
+    ServerSessionHandler session_handler( &config, NULL );
+
+    StoragePlugin* plugin = session_handler.createStorageByURI( DB );
+    QVERIFY( plugin );
+
+    SyncTarget* target = session_handler.createSyncTarget( *plugin, SyncMode() );
+    QVERIFY( target );
+    session_handler.addSyncTarget( target );
+    target->setTargetDatabase( DB );
+
+    SuspendLog* suspendLog = new SuspendLog( "remote", DB );
+    target->setSuspendLog( suspendLog );
+
+    UIDMapping mapping;
+    mapping.iRemoteUID = "client-1";
+    mapping.iLocalUID = "local-1";
+    target->addUIDMapping( mapping );
+
+    session_handler.newItemReference( 1, 5, "local-1", MOD_ITEM_MODIFIED, DB, DB, "text/x-vcalendar" );
+
+    StatusParams status;
+    status.msgRef = 1;
+    status.cmdRef = 5;
+    status.cmd = SYNCML_ELEMENT_REPLACE;
+    status.data = SUCCESS;
+
+    // Unknown remote key does not acknowledge the item
+    status.targetRef = "client-2";
+    session_handler.iCommandHandler.handleStatus( &status );
+    QCOMPARE( session_handler.iItemReferences.count(), 1 );
+
+    status.targetRef = "client-1";
+    session_handler.iCommandHandler.handleStatus( &status );
+    QVERIFY( session_handler.iItemReferences.isEmpty() );
+    QCOMPARE( suspendLog->getProcessedItems().count(), 1 );
+    QVERIFY( suspendLog->getProcessedItems().contains( "local-1" ) );
+}
+
 QTEST_MAIN(SessionHandlerTest)
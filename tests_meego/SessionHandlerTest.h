@@ -52,6 +52,9 @@ public:
 
     virtual void releaseStorage( DataSync::StoragePlugin* aStorage );
 
+    virtual void releaseSessionStorage( DataSync::StoragePlugin* aStorage,
+                                        const DataSync::SessionHandler* aSessionHandler );
+
 private slots:
     void init();
     void cleanup();
@@ -82,9 +85,17 @@ private slots:
     void regression_NB153701_03();
     void regression_NB153701_04();
     void testNoRespSyncElement();
+    void testStatistics();
+    void testParallelCommit();
+    void testConcurrentStorageSessions();
+    void testRejectedItemNotProcessed();
+    void testServerItemStatusByTargetRef();
 
 private:
 
+    QList<const DataSync::SessionHandler*> iAcquiredBy;
+    QList<const DataSync::SessionHandler*> iReleasedBy;
+
 };
 
 #endif // SESSIONHANDLERTEST_H
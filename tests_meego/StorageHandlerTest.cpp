@@ -34,11 +34,70 @@
 #include "StorageHandlerTest.h"
 #include "Mock.h"
 #include "ConflictResolver.h"
+#include "ItemMatcher.h"
+#include "LargeObjectSpool.h"
 #include "SyncMLLogging.h"
 
 
 using namespace DataSync;
 
+/*! \brief Storage with items of given content that records replaced items
+ */
+class MatchStorage : public MockStorage
+{
+public:
+
+    MatchStorage() : MockStorage( "matchstorage" )
+    {
+    }
+
+    void addItem( const SyncItemKey& aKey, const QByteArray& aData )
+    {
+        iKeys.append( aKey );
+        iData.insert( aKey, aData );
+    }
+
+    virtual bool getAll( QList<SyncItemKey>& aKeys )
+    {
+        aKeys = iKeys;
+        return true;
+    }
+
+    virtual SyncItem* getSyncItem( const SyncItemKey& aKey )
+    {
+        if( !iData.contains( aKey ) ) {
+            return NULL;
+        }
+
+        MockSyncItem* item = new MockSyncItem( aKey );
+        item->setType( "text/x-vcard" );
+        item->write( 0, iData.value( aKey ) );
+        return item;
+    }
+
+    virtual QList<StoragePluginStatus> replaceItems( const QList<SyncItem*>& aItems )
+    {
+        QList<StoragePluginStatus> results;
+
+        for( int i = 0; i < aItems.count(); ++i ) {
+            QByteArray data;
+            aItems[i]->read( 0, aItems[i]->getSize(), data );
+            iReplaced.insert( *aItems[i]->getKey(), data );
+            results.append( STATUS_OK );
+        }
+
+        return results;
+    }
+
+    QHash<SyncItemKey, QByteArray>  iReplaced;
+
+private:
+
+    QList<SyncItemKey>              iKeys;
+    QHash<SyncItemKey, QByteArray>  iData;
+
+};
+
 void StorageHandlerTest::testAddItem()
 {
 
@@ -52,7 +111,7 @@ void StorageHandlerTest::testAddItem()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
     LocalChanges changes;
     ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
 
@@ -84,7 +143,7 @@ void StorageHandlerTest::testReplaceItem()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -98,6 +157,105 @@ void StorageHandlerTest::testReplaceItem()
 
 }
 
+void StorageHandlerTest::testMatchAddedItems()
+{
+    // Mock storage contains empty items 1, 2, 3 and 5
+    MockStorage storage( "id" );
+    ItemMatcher matcher( storage );
+
+    ItemId matchedId;
+    matchedId.iCmdId = 1;
+    matchedId.iItemIndex = 0;
+
+    ItemId addedId;
+    addedId.iCmdId = 2;
+    addedId.iItemIndex = 0;
+
+    QString type( "text/x-vcard" );
+
+    QVERIFY( iStorageHandler.addItem( matchedId, storage, QString(), QString(), type, QString(), QString(), QByteArray() ) );
+    QVERIFY( iStorageHandler.addItem( addedId, storage, QString(), QString(), type, QString(), QString(), QByteArray( "foo" ) ) );
+
+    QMap<ItemId, CommitResult> matches = iStorageHandler.matchAddedItems( matcher, storage, NULL );
+    QCOMPARE( matches.count(), 1 );
+    QVERIFY( matches.contains( matchedId ) );
+    QCOMPARE( matches[matchedId].iItemKey, SyncItemKey( "1" ) );
+    QVERIFY( matches[matchedId].iStatus == COMMIT_MATCHED );
+    QVERIFY( matches[matchedId].iConflict == CONFLICT_NO_CONFLICT );
+
+    // Only the item that did not match is added
+    QMap<ItemId, CommitResult> commits = iStorageHandler.commitAddedItems( storage, NULL );
+    QCOMPARE( commits.count(), 1 );
+    QVERIFY( commits.contains( addedId ) );
+    QVERIFY( commits[addedId].iStatus == COMMIT_ADDED );
+}
+
+void StorageHandlerTest::testMatchAddedItemsConflict()
+{
+    // Added item matches a local item by UID, but their content differs
+    const QByteArray local( "BEGIN:VCARD\nUID:abc-123\nN:Doe;John\nEND:VCARD\n" );
+    const QByteArray remote( "BEGIN:VCARD\nUID:abc-123\nN:Doe;Jane\nEND:VCARD\n" );
+    QString type( "text/x-vcard" );
+
+    ItemId id;
+    id.iCmdId = 1;
+    id.iItemIndex = 0;
+
+    LocalChanges changes;
+
+    // Local side wins, local item is kept
+    {
+        MatchStorage storage;
+        storage.addItem( "1", local );
+        ItemMatcher matcher( storage );
+        ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
+
+        QVERIFY( iStorageHandler.addItem( id, storage, QString(), QString(), type, QString(), QString(), remote ) );
+        QMap<ItemId, CommitResult> matches = iStorageHandler.matchAddedItems( matcher, storage, &resolver );
+        QCOMPARE( matches.count(), 1 );
+        QCOMPARE( matches[id].iItemKey, SyncItemKey( "1" ) );
+        QVERIFY( matches[id].iStatus == COMMIT_MATCHED );
+        QVERIFY( matches[id].iConflict == CONFLICT_LOCAL_WIN );
+        QVERIFY( storage.iReplaced.isEmpty() );
+    }
+
+    // Remote side wins, local item is replaced with the added data
+    {
+        MatchStorage storage;
+        storage.addItem( "1", local );
+        ItemMatcher matcher( storage );
+        ConflictResolver resolver( changes, PREFER_REMOTE_CHANGES );
+
+        QVERIFY( iStorageHandler.addItem( id, storage, QString(), QString(), type, QString(), QString(), remote ) );
+        QMap<ItemId, CommitResult> matches = iStorageHandler.matchAddedItems( matcher, storage, &resolver );
+        QCOMPARE( matches.count(), 1 );
+        QCOMPARE( matches[id].iItemKey, SyncItemKey( "1" ) );
+        QVERIFY( matches[id].iStatus == COMMIT_MATCHED );
+        QVERIFY( matches[id].iConflict == CONFLICT_REMOTE_WIN );
+        QCOMPARE( storage.iReplaced.count(), 1 );
+        QCOMPARE( storage.iReplaced.value( "1" ), remote );
+    }
+
+    // Without conflict resolution, as on client side, local item is kept
+    {
+        MatchStorage storage;
+        storage.addItem( "1", local );
+        ItemMatcher matcher( storage );
+
+        QVERIFY( iStorageHandler.addItem( id, storage, QString(), QString(), type, QString(), QString(), remote ) );
+        QMap<ItemId, CommitResult> matches = iStorageHandler.matchAddedItems( matcher, storage, NULL );
+        QCOMPARE( matches.count(), 1 );
+        QCOMPARE( matches[id].iItemKey, SyncItemKey( "1" ) );
+        QVERIFY( matches[id].iStatus == COMMIT_MATCHED );
+        QVERIFY( matches[id].iConflict == CONFLICT_NO_CONFLICT );
+        QVERIFY( storage.iReplaced.isEmpty() );
+    }
+
+    // Nothing is left to add
+    MockStorage storage( "id" );
+    QVERIFY( iStorageHandler.commitAddedItems( storage, NULL ).isEmpty() );
+}
+
 void StorageHandlerTest::testDeleteItem()
 {
 
@@ -138,7 +296,7 @@ void StorageHandlerTest::testLargeObjectReplace()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "ab" );
+    QByteArray data( "ab" );
     QString key = "fookey";
     qint64 size = 4;
 
@@ -159,6 +317,104 @@ void StorageHandlerTest::testLargeObjectReplace()
 
 }
 
+void StorageHandlerTest::testLargeObjectSpool()
+{
+
+    MockStorage storage( "id" );
+
+    ItemId id;
+    id.iCmdId = 1;
+    id.iItemIndex = 0;
+
+    QString key = "fookey";
+    QString parent = "";
+    QString type( "text/x-vcard" );
+    QString format("");
+    QString version("");
+    QByteArray data( "abc" );
+    qint64 size = 9;
+
+    StorageHandler storageHandler;
+    storageHandler.setLargeObjectSpoolThreshold( 4 );
+
+    QVERIFY( storageHandler.startLargeObjectAdd( storage, key, parent, type, format, version, size ) );
+    QVERIFY( storageHandler.iLargeObjectSpool );
+
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( !storageHandler.iLargeObjectSpool->spooledToDisk() );
+    QCOMPARE( storageHandler.iLargeObject->getSize(), qint64( 0 ) );
+
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( storageHandler.iLargeObjectSpool->spooledToDisk() );
+    QCOMPARE( storageHandler.iLargeObject->getSize(), qint64( 0 ) );
+
+    QVERIFY( !storageHandler.largeObjectSizeMatches() );
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( storageHandler.largeObjectSizeMatches() );
+    QVERIFY( storageHandler.finishLargeObject( id ) );
+    QVERIFY( !storageHandler.buildingLargeObject() );
+
+    QCOMPARE( storageHandler.iAddList.count(), 1 );
+
+    SyncItem* item = storageHandler.iAddList.value( id );
+    QVERIFY( item );
+
+    QByteArray itemData;
+    QVERIFY( item->read( 0, item->getSize(), itemData ) );
+    QCOMPARE( itemData, QByteArray( "abcabcabc" ) );
+
+}
+
+void StorageHandlerTest::testLargeObjectSizeMismatch()
+{
+
+    MockStorage storage( "id" );
+
+    ItemId id;
+    id.iCmdId = 1;
+    id.iItemIndex = 0;
+
+    QString key = "fookey";
+    QString parent = "";
+    QString type( "text/x-vcard" );
+    QString format("");
+    QString version("");
+    QByteArray data( "ab" );
+    qint64 size = 5;
+
+    StorageHandler storageHandler;
+
+    // Without spooling size is not checked
+    QVERIFY( storageHandler.startLargeObjectAdd( storage, key, parent, type, format, version, size ) );
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( storageHandler.largeObjectSizeMatches() );
+    QVERIFY( storageHandler.finishLargeObject( id ) );
+    QCOMPARE( storageHandler.iAddList.count(), 1 );
+    qDeleteAll( storageHandler.iAddList );
+    storageHandler.iAddList.clear();
+
+    storageHandler.setLargeObjectSpoolThreshold( 1024 );
+
+    QVERIFY( storageHandler.startLargeObjectAdd( storage, key, parent, type, format, version, size ) );
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( storageHandler.appendLargeObjectData( data ) );
+    QVERIFY( !storageHandler.largeObjectSizeMatches() );
+    QVERIFY( !storageHandler.finishLargeObject( id ) );
+    QVERIFY( !storageHandler.buildingLargeObject() );
+    QVERIFY( storageHandler.iAddList.isEmpty() );
+
+    // CRLF line breaks that were received as LF are allowed for
+    QVERIFY( storageHandler.startLargeObjectAdd( storage, key, parent, type, format, version, size ) );
+    QVERIFY( storageHandler.appendLargeObjectData( "a\n" ) );
+    QVERIFY( !storageHandler.largeObjectSizeMatches() );
+    QVERIFY( storageHandler.appendLargeObjectData( "b\n" ) );
+    QVERIFY( storageHandler.largeObjectSizeMatches() );
+    QVERIFY( storageHandler.finishLargeObject( id ) );
+    QCOMPARE( storageHandler.iAddList.count(), 1 );
+
+}
+
 void StorageHandlerTest::regression_NB153991_01()
 {
     // regression_NB153991_01:
@@ -178,7 +434,7 @@ void StorageHandlerTest::regression_NB153991_01()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -210,7 +466,7 @@ void StorageHandlerTest::regression_NB203771_01()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -240,7 +496,7 @@ void StorageHandlerTest::regression_NB203771_02()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.addItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -272,7 +528,7 @@ void StorageHandlerTest::regression_NB203771_03()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -309,7 +565,7 @@ void StorageHandlerTest::regression_NB203771_04()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -345,7 +601,7 @@ void StorageHandlerTest::regression_NB203771_05()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -49,8 +49,12 @@ private slots:
     void testAddItem();
     void testReplaceItem();
     void testDeleteItem();
+    void testMatchAddedItems();
+    void testMatchAddedItemsConflict();
 
     void testLargeObjectReplace();
+    void testLargeObjectSpool();
+    void testLargeObjectSizeMismatch();
 
     void regression_NB153991_01();
     void regression_NB203771_01();
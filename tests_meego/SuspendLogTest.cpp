@@ -0,0 +1,234 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SuspendLogTest.h"
+
+#include <QFile>
+
+#include "SuspendLog.h"
+#include "DatabaseHandler.h"
+
+const QString DB( "/tmp/suspendlogtest.db" );
+const QString REMOTEDEVICE( "remotedevice" );
+const QString SOURCEDB( "localcontacts" );
+const QString TARGETDB( "remotecontacts" );
+
+using namespace DataSync;
+
+static int countRows( QSqlDatabase& aDbHandle, const QString& aTable )
+{
+    QSqlQuery query( aDbHandle );
+
+    if( !query.exec( "SELECT COUNT(*) FROM " + aTable ) || !query.next() ) {
+        return -1;
+    }
+
+    return query.value( 0 ).toInt();
+}
+
+void SuspendLogTest::init()
+{
+    QFile::remove( DB );
+}
+
+void SuspendLogTest::cleanup()
+{
+    QFile::remove( DB );
+    QFile::remove( DB + "-wal" );
+    QFile::remove( DB + "-shm" );
+}
+
+void SuspendLogTest::testNoSession()
+{
+    DatabaseHandler handler( DB );
+    QVERIFY( handler.isValid() );
+
+    SuspendLog log( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( log.load( handler.getDbHandle() ) );
+    QVERIFY( !log.isSuspended() );
+    QVERIFY( log.getProcessedItems().isEmpty() );
+    QVERIFY( log.getMappings().isEmpty() );
+
+    // Without a session nothing is written
+    log.addProcessedItem( "1", "fingerprint1" );
+    QVERIFY( log.save( handler.getDbHandle() ) );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_logs" ), 0 );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_items" ), 0 );
+}
+
+void SuspendLogTest::testSaveLoad()
+{
+    DatabaseHandler handler( DB );
+    QVERIFY( handler.isValid() );
+
+    SuspendLog log( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( log.load( handler.getDbHandle() ) );
+
+    log.setSession( TARGETDB, 201, "localnext", "remotenext" );
+    log.addProcessedItem( "1", "fingerprint1" );
+    log.addProcessedItem( "2", "fingerprint2" );
+    log.addProcessedItem( "2", "fingerprint2" );
+    log.addProcessedItem( "3", QByteArray() );
+
+    UIDMapping added = { "remote1", "local1" };
+    UIDMapping removed;
+    removed.iLocalUID = "local0";
+    log.addMapping( added );
+    log.addMapping( removed );
+
+    QVERIFY( log.save( handler.getDbHandle() ) );
+
+    SuspendLog loaded( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( loaded.load( handler.getDbHandle() ) );
+    QVERIFY( loaded.isSuspended() );
+    QCOMPARE( loaded.getTargetDatabase(), TARGETDB );
+    QCOMPARE( loaded.getSyncMode(), 201 );
+    QCOMPARE( loaded.getLocalNextAnchor(), QString( "localnext" ) );
+    QCOMPARE( loaded.getRemoteNextAnchor(), QString( "remotenext" ) );
+
+    QCOMPARE( loaded.getProcessedItems().count(), 3 );
+    QCOMPARE( loaded.getProcessedItems().value( "1" ), QByteArray( "fingerprint1" ) );
+    QCOMPARE( loaded.getProcessedItems().value( "2" ), QByteArray( "fingerprint2" ) );
+
+    // Deleted items are stored without a fingerprint
+    QVERIFY( loaded.getProcessedItems().contains( "3" ) );
+    QVERIFY( loaded.getProcessedItems().value( "3" ).isEmpty() );
+
+    // Mapping changes are kept in order
+    QCOMPARE( loaded.getMappings().count(), 2 );
+    QCOMPARE( loaded.getMappings()[0].iLocalUID, QString( "local1" ) );
+    QCOMPARE( loaded.getMappings()[0].iRemoteUID, QString( "remote1" ) );
+    QCOMPARE( loaded.getMappings()[1].iLocalUID, QString( "local0" ) );
+    QVERIFY( loaded.getMappings()[1].iRemoteUID.isEmpty() );
+}
+
+void SuspendLogTest::testIncrementalSave()
+{
+    DatabaseHandler handler( DB );
+    QVERIFY( handler.isValid() );
+
+    SuspendLog log( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( log.load( handler.getDbHandle() ) );
+
+    log.setSession( TARGETDB, 200, "localnext", "remotenext" );
+    log.addProcessedItem( "1", "fingerprint1" );
+    UIDMapping mapping1 = { "remote1", "local1" };
+    log.addMapping( mapping1 );
+    QVERIFY( log.save( handler.getDbHandle() ) );
+
+    // Only changes made after the previous save are written
+    log.addProcessedItem( "1", "fingerprint1" );
+    log.addProcessedItem( "2", "fingerprint2" );
+    UIDMapping mapping2 = { "remote2", "local2" };
+    log.addMapping( mapping2 );
+    QVERIFY( log.save( handler.getDbHandle() ) );
+    QVERIFY( log.save( handler.getDbHandle() ) );
+
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_logs" ), 1 );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_items" ), 2 );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_maps" ), 2 );
+
+    // Loaded log continues from the stored state
+    SuspendLog loaded( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( loaded.load( handler.getDbHandle() ) );
+    loaded.addProcessedItem( "2", "fingerprint2" );
+    loaded.addProcessedItem( "3", "fingerprint3" );
+    QVERIFY( loaded.save( handler.getDbHandle() ) );
+
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_items" ), 3 );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_maps" ), 2 );
+
+    // Item sent again with other content overrides the stored fingerprint
+    loaded.addProcessedItem( "1", "changed" );
+    QVERIFY( loaded.save( handler.getDbHandle() ) );
+
+    SuspendLog reloaded( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( reloaded.load( handler.getDbHandle() ) );
+    QCOMPARE( reloaded.getProcessedItems().count(), 3 );
+    QCOMPARE( reloaded.getProcessedItems().value( "1" ), QByteArray( "changed" ) );
+}
+
+void SuspendLogTest::testRemove()
+{
+    DatabaseHandler handler( DB );
+    QVERIFY( handler.isValid() );
+
+    SuspendLog log( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( log.load( handler.getDbHandle() ) );
+    log.setSession( TARGETDB, 200, "localnext", "remotenext" );
+    log.addProcessedItem( "1", "fingerprint1" );
+    UIDMapping mapping = { "remote1", "local1" };
+    log.addMapping( mapping );
+    QVERIFY( log.save( handler.getDbHandle() ) );
+
+    QVERIFY( log.remove( handler.getDbHandle() ) );
+    QVERIFY( !log.isSuspended() );
+    QVERIFY( log.getProcessedItems().isEmpty() );
+
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_logs" ), 0 );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_items" ), 0 );
+    QCOMPARE( countRows( handler.getDbHandle(), "suspend_maps" ), 0 );
+
+    SuspendLog loaded( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( loaded.load( handler.getDbHandle() ) );
+    QVERIFY( !loaded.isSuspended() );
+}
+
+void SuspendLogTest::testSeparateDatabases()
+{
+    DatabaseHandler handler( DB );
+    QVERIFY( handler.isValid() );
+
+    SuspendLog contacts( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( contacts.load( handler.getDbHandle() ) );
+    contacts.setSession( TARGETDB, 200, "localnext", "remotenext" );
+    contacts.addProcessedItem( "1", "fingerprint1" );
+    QVERIFY( contacts.save( handler.getDbHandle() ) );
+
+    SuspendLog calendar( REMOTEDEVICE, "localcalendar" );
+    QVERIFY( calendar.load( handler.getDbHandle() ) );
+    QVERIFY( !calendar.isSuspended() );
+    calendar.setSession( "remotecalendar", 200, "localnext", "remotenext" );
+    calendar.addProcessedItem( "1", "fingerprint1" );
+    QVERIFY( calendar.save( handler.getDbHandle() ) );
+
+    // Removing one log leaves the other intact
+    QVERIFY( calendar.remove( handler.getDbHandle() ) );
+
+    SuspendLog loaded( REMOTEDEVICE, SOURCEDB );
+    QVERIFY( loaded.load( handler.getDbHandle() ) );
+    QVERIFY( loaded.isSuspended() );
+    QCOMPARE( loaded.getProcessedItems().count(), 1 );
+}
+
+QTEST_MAIN(DataSync::SuspendLogTest)
@@ -66,6 +66,8 @@ void SyncAgentConfigTest::testConfParsing()
 
     QCOMPARE( config.getAgentProperty( FASTMAPSSENDPROP ).toInt(), 1 );
 
+    QCOMPARE( config.getAgentProperty( LARGEOBJECTSPOOLTHRESHOLDPROP ).toLongLong(), Q_INT64_C( 1048576 ) );
+
     QCOMPARE( config.getTransportProperty( OBEXMTUBTPROP ).toInt(), 1024 );
 
     QCOMPARE( config.getTransportProperty( OBEXMTUUSBPROP ).toInt(), 2048 );
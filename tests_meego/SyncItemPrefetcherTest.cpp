@@ -118,8 +118,12 @@ SyncItem* PrefetchStorage::newItem()
 
 SyncItem* PrefetchStorage::getSyncItem( const SyncItemKey& aKey )
 {
-   Q_UNUSED( aKey );
-   return NULL;
+    if( iItemIds.contains( aKey ) )
+    {
+        return new MockSyncItem( aKey );
+    }
+
+    return NULL;
 }
 
 QList<SyncItem*> PrefetchStorage::getSyncItems( const QList<SyncItemKey>& aKeyList )
@@ -361,4 +365,218 @@ void SyncItemPrefetcherTest::testAbnormalBadItemCount()
     delete item;
 }
 
+void SyncItemPrefetcherTest::testAsynchronous()
+{
+    // Test item prefetcher fetching items in worker thread
+
+    QList<SyncItemKey> items;
+    items.append( "1" );
+    items.append( "2" );
+    items.append( "3" );
+    items.append( "4" );
+    items.append( "5" );
+    const int batchSizeHint = 2;
+
+    PrefetchStorage storage( items );
+
+    SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+    prefetcher.setAsynchronous( true );
+    QVERIFY( prefetcher.iWorker );
+
+    // Batch is requested but not waited for
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iPendingItemIds.count(), batchSizeHint );
+    QCOMPARE( prefetcher.iItemIdList.count(), items.count() - batchSizeHint );
+
+    // Only one batch can be pending
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iItemIdList.count(), items.count() - batchSizeHint );
+
+    SyncItem* item = prefetcher.getItem( items.at(0) );
+    QVERIFY( item );
+    QCOMPARE( *item->getKey(), items.at(0) );
+    QVERIFY( prefetcher.iPendingItemIds.isEmpty() );
+    QCOMPARE( prefetcher.iFetchedItems.count(), batchSizeHint - 1 );
+    delete item;
+
+    item = prefetcher.getItem( items.at(1) );
+    QVERIFY( item );
+    delete item;
+
+    // Next batch is loaded while previous items are used
+    prefetcher.schedulePrefetch();
+    QCOMPARE( prefetcher.iPendingItemIds.count(), batchSizeHint );
+
+    for( int i = 2; i < items.count(); ++i )
+    {
+        item = prefetcher.getItem( items.at(i) );
+        QVERIFY( item );
+        QCOMPARE( *item->getKey(), items.at(i) );
+        delete item;
+    }
+
+    QCOMPARE( prefetcher.iItemIdList.count(), 0 );
+    QCOMPARE( prefetcher.iFetchedItems.count(), 0 );
+
+    // Leave a batch pending to test cleanup
+    SyncItemPrefetcher prefetcher2( items, storage, batchSizeHint );
+    prefetcher2.setAsynchronous( true );
+    prefetcher2.prefetch();
+
+}
+
+void SyncItemPrefetcherTest::testMaxCacheSize()
+{
+    // Test that prefetching stops when prefetched items exceed the cache size
+
+    QList<SyncItemKey> itemIds;
+    itemIds.append( "1" );
+    itemIds.append( "2" );
+    itemIds.append( "3" );
+    const int batchSizeHint = 3;
+
+    PrefetchStorage storage( itemIds );
+
+    SyncItemPrefetcher prefetcher( itemIds, storage, batchSizeHint );
+    prefetcher.setMaxCacheSize( 10 );
+
+    QList<SyncItem*> items;
+    MockSyncItem* item1 = new MockSyncItem( "1" );
+    item1->write( 0, QByteArray( 10, 'a' ) );
+    items.append( item1 );
+    storage.forceSyncItems( items );
+
+    prefetcher.setBatchSizeHint( 1 );
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iFetchedItems.count(), 1 );
+    QCOMPARE( prefetcher.iFetchedSize, qint64( 10 ) );
+
+    // Cache is full, no new batch should be requested
+    prefetcher.setBatchSizeHint( batchSizeHint );
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iFetchedItems.count(), 1 );
+    QCOMPARE( prefetcher.iItemIdList.count(), 2 );
+
+    SyncItem* item = prefetcher.getItem( itemIds.at(0) );
+    QVERIFY( item );
+    QCOMPARE( prefetcher.iFetchedSize, qint64( 0 ) );
+    delete item;
+
+}
+
+void SyncItemPrefetcherTest::testMissWithFullCache()
+{
+    // Test that an item that is not prefetched is fetched directly when
+    // the cache is full
+
+    QList<SyncItemKey> itemIds;
+    itemIds.append( "1" );
+    itemIds.append( "2" );
+    itemIds.append( "3" );
+
+    PrefetchStorage storage( itemIds );
+
+    SyncItemPrefetcher prefetcher( itemIds, storage, 1 );
+    prefetcher.setMaxCacheSize( 10 );
+
+    QList<SyncItem*> items;
+    MockSyncItem* item1 = new MockSyncItem( "1" );
+    item1->write( 0, QByteArray( 10, 'a' ) );
+    items.append( item1 );
+    storage.forceSyncItems( items );
+
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iFetchedSize, qint64( 10 ) );
+
+    SyncItem* item = prefetcher.getItem( itemIds.at(1) );
+    QVERIFY( item );
+    QCOMPARE( *item->getKey(), itemIds.at(1) );
+    QCOMPARE( prefetcher.misses(), 1 );
+    delete item;
+
+    // Item is not fetched again
+    QCOMPARE( prefetcher.iItemIdList.count(), 1 );
+    QCOMPARE( prefetcher.iItemIdList.first(), itemIds.at(2) );
+
+}
+
+void SyncItemPrefetcherTest::testUnorderedItems()
+{
+    // Test that items returned by plugin in different order are matched by key
+
+    QList<SyncItemKey> itemIds;
+    itemIds.append( "1" );
+    itemIds.append( "2" );
+    itemIds.append( "3" );
+    const int batchSizeHint = 3;
+
+    PrefetchStorage storage( itemIds );
+
+    SyncItemPrefetcher prefetcher( itemIds, storage, batchSizeHint );
+
+    QList<SyncItem*> items;
+    items.append( new MockSyncItem( "3" ) );
+    items.append( new MockSyncItem( "1" ) );
+    items.append( new MockSyncItem( "2" ) );
+    storage.forceSyncItems( items );
+
+    for( int i = 0; i < itemIds.count(); ++i )
+    {
+        SyncItem* item = prefetcher.getItem( itemIds.at(i) );
+        QVERIFY( item );
+        QCOMPARE( *item->getKey(), itemIds.at(i) );
+        delete item;
+    }
+
+}
+
+void SyncItemPrefetcherTest::testBatchSizeEstimate()
+{
+    QList<SyncItemKey> itemIds;
+    PrefetchStorage storage( itemIds );
+    SyncItemPrefetcher prefetcher( itemIds, storage, 10 );
+
+    // No estimate yet, use maximum
+    QCOMPARE( prefetcher.estimateBatchSize( 1000, 10 ), 10 );
+
+    prefetcher.addEncodedItemSize( 300 );
+    QCOMPARE( prefetcher.estimateBatchSize( 1000, 10 ), 4 );
+    QCOMPARE( prefetcher.estimateBatchSize( 1000, 2 ), 2 );
+    QCOMPARE( prefetcher.estimateBatchSize( 100, 10 ), 1 );
+
+    // Estimate follows the observed sizes
+    for( int i = 0; i < 50; ++i )
+    {
+        prefetcher.addEncodedItemSize( 100 );
+    }
+
+    QCOMPARE( prefetcher.estimateBatchSize( 1000, 20 ), 10 );
+
+    // Invalid sizes are ignored
+    prefetcher.addEncodedItemSize( 0 );
+    QCOMPARE( prefetcher.estimateBatchSize( 1000, 20 ), 10 );
+}
+
+void SyncItemPrefetcherTest::testHitsAndMisses()
+{
+    QList<SyncItemKey> items;
+    items.append( "1" );
+    items.append( "2" );
+    items.append( "3" );
+    const int batchSizeHint = 2;
+
+    PrefetchStorage storage( items );
+
+    SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+
+    for( int i = 0; i < items.count(); ++i )
+    {
+        delete prefetcher.getItem( items.at(i) );
+    }
+
+    // Item 1 and 3 needed a fetch, item 2 was prefetched with item 1
+    QCOMPARE( prefetcher.hits(), 1 );
+    QCOMPARE( prefetcher.misses(), 2 );
+}
+
 QTEST_MAIN(SyncItemPrefetcherTest)
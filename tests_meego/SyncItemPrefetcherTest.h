@@ -99,6 +99,14 @@ private slots:
     void testAbnormalBadItems();
     void testAbnormalBadItemCount();
 
+    void testAsynchronous();
+    void testMaxCacheSize();
+    void testMissWithFullCache();
+    void testUnorderedItems();
+
+    void testBatchSizeEstimate();
+    void testHitsAndMisses();
+
 };
 
 #endif // SYNCITEMPREFETCHERTEST_H
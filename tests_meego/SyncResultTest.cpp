@@ -91,6 +91,45 @@ void SyncResultsTest::testAddProcessedItem()
     iSyncResults->addProcessedItem(modType, modBase, database);
 }
 
+void SyncResultsTest::testStatistics()
+{
+    SyncResults results;
+
+    QCOMPARE( results.getStatistics().iBytesSent, qint64( 0 ) );
+    QCOMPARE( results.getStatistics().iMessagesReceived, 0 );
+    QVERIFY( results.getStatistics().iMessages.isEmpty() );
+
+    MessageStatistics message;
+    message.iMsgId = 2;
+    message.iBytes = 512;
+    message.iTimes.iParseTime = 10;
+    message.iTimes.iStorageCommitTime = 20;
+
+    SessionStatistics statistics;
+    statistics.iBytesReceived = 512;
+    statistics.iMessagesReceived = 1;
+    statistics.iTimes.iParseTime = 10;
+    statistics.iTimes.iStorageCommitTime = 20;
+    statistics.iStateTimes[SENDING_ITEMS] = 100;
+    statistics.iMessages.append( message );
+
+    results.setStatistics( statistics );
+
+    QCOMPARE( results.getStatistics().iBytesReceived, qint64( 512 ) );
+    QCOMPARE( results.getStatistics().iMessagesReceived, 1 );
+    QCOMPARE( results.getStatistics().iTimes.iStorageCommitTime, qint64( 20 ) );
+    QCOMPARE( results.getStatistics().iStateTimes.value( SENDING_ITEMS ), qint64( 100 ) );
+    QCOMPARE( results.getStatistics().iMessages.count(), 1 );
+    QCOMPARE( results.getStatistics().iMessages.first().iMsgId, 2 );
+    QCOMPARE( results.getStatistics().iMessages.first().iOutgoing, false );
+
+    results.reset();
+
+    QCOMPARE( results.getStatistics().iBytesReceived, qint64( 0 ) );
+    QVERIFY( results.getStatistics().iStateTimes.isEmpty() );
+    QVERIFY( results.getStatistics().iMessages.isEmpty() );
+}
+
 
 
 QTEST_MAIN(DataSync::SyncResultsTest)
@@ -36,6 +36,8 @@
 #include "DatabaseHandler.h"
 #include "Mock.h"
 #include "ChangeLog.h"
+#include "SuspendLog.h"
+#include "ConflictResolver.h"
 
 using namespace DataSync;
 
@@ -90,9 +92,211 @@ void SyncTargetTest::testClearUIDMappings()
     iSyncTarget->clearUIDMappings();
 }
 
+void SyncTargetTest::testUIDMappings()
+{
+    iSyncTarget->clearUIDMappings();
+
+    UIDMapping mapping1 = { "remote1", "local1" };
+    UIDMapping mapping2 = { "remote2", "local2" };
+    UIDMapping mapping3 = { "remote3", "local3" };
+    iSyncTarget->addUIDMapping( mapping1 );
+    iSyncTarget->addUIDMapping( mapping2 );
+    iSyncTarget->addUIDMapping( mapping3 );
+
+    QCOMPARE( iSyncTarget->mapToLocalUID( "remote2" ), QString( "local2" ) );
+    QCOMPARE( iSyncTarget->mapToRemoteUID( "local3" ), QString( "remote3" ) );
+    QVERIFY( iSyncTarget->mapToLocalUID( "remote4" ).isEmpty() );
+
+    iSyncTarget->removeUIDMapping( "local2" );
+    QVERIFY( iSyncTarget->mapToLocalUID( "remote2" ).isEmpty() );
+    QVERIFY( iSyncTarget->mapToRemoteUID( "local2" ).isEmpty() );
+
+    // Insertion order must be preserved
+    const QList<UIDMapping>& mappings = iSyncTarget->getUIDMappings();
+    QCOMPARE( mappings.count(), 2 );
+    QCOMPARE( mappings[0].iLocalUID, QString( "local1" ) );
+    QCOMPARE( mappings[1].iLocalUID, QString( "local3" ) );
+
+    // Earlier mapping wins, later one is used once the earlier is removed
+    UIDMapping duplicate = { "remote1", "local4" };
+    iSyncTarget->addUIDMapping( duplicate );
+    QCOMPARE( iSyncTarget->mapToLocalUID( "remote1" ), QString( "local1" ) );
+    iSyncTarget->removeUIDMapping( "local1" );
+    QCOMPARE( iSyncTarget->mapToLocalUID( "remote1" ), QString( "local4" ) );
+
+    // Removed mappings are skipped when a hidden mapping becomes visible
+    UIDMapping shared1 = { "remote5", "local5" };
+    UIDMapping shared2 = { "remote5", "local6" };
+    UIDMapping shared3 = { "remote5", "local7" };
+    iSyncTarget->addUIDMapping( shared1 );
+    iSyncTarget->addUIDMapping( shared2 );
+    iSyncTarget->addUIDMapping( shared3 );
+    iSyncTarget->removeUIDMapping( "local6" );
+    QCOMPARE( iSyncTarget->mapToLocalUID( "remote5" ), QString( "local5" ) );
+    iSyncTarget->removeUIDMapping( "local5" );
+    QCOMPARE( iSyncTarget->mapToLocalUID( "remote5" ), QString( "local7" ) );
+
+    // Same local UID mapped twice
+    UIDMapping local1 = { "remote8", "local8" };
+    UIDMapping local2 = { "remote9", "local8" };
+    iSyncTarget->addUIDMapping( local1 );
+    iSyncTarget->addUIDMapping( local2 );
+    QCOMPARE( iSyncTarget->mapToRemoteUID( "local8" ), QString( "remote8" ) );
+    iSyncTarget->removeUIDMapping( "local8" );
+    QCOMPARE( iSyncTarget->mapToRemoteUID( "local8" ), QString( "remote9" ) );
+    QVERIFY( iSyncTarget->mapToLocalUID( "remote8" ).isEmpty() );
+    QCOMPARE( iSyncTarget->mapToLocalUID( "remote9" ), QString( "local8" ) );
+
+    iSyncTarget->clearUIDMappings();
+    QCOMPARE( iSyncTarget->getUIDMappings().count(), 0 );
+}
+
+void SyncTargetTest::benchmarkUIDMappings_data()
+{
+    QTest::addColumn<int>( "count" );
+
+    QTest::newRow( "1k" ) << 1000;
+    QTest::newRow( "10k" ) << 10000;
+    QTest::newRow( "100k" ) << 100000;
+}
+
+void SyncTargetTest::benchmarkUIDMappings()
+{
+    QFETCH( int, count );
+
+    iSyncTarget->clearUIDMappings();
+
+    for( int i = 0; i < count; ++i ) {
+        UIDMapping mapping = { "remote" + QString::number( i ), "local" + QString::number( i ) };
+        iSyncTarget->addUIDMapping( mapping );
+    }
+
+    // One lookup in both directions per item, as done when composing
+    // batches and writing local changes
+    QBENCHMARK {
+        for( int i = 0; i < count; ++i ) {
+            iSyncTarget->mapToLocalUID( "remote" + QString::number( i ) );
+            iSyncTarget->mapToRemoteUID( "local" + QString::number( i ) );
+        }
+    }
+
+    iSyncTarget->clearUIDMappings();
+}
+
 void SyncTargetTest::testSetRefreshFromClient()
 {
     QCOMPARE( iSyncTarget->setRefreshFromClient(), false );
 }
 
+void SyncTargetTest::testResumeSession()
+{
+    QSqlDatabase& db = iDbHandler->getDbHandle();
+    const SyncMode slowMode( DIRECTION_TWO_WAY, INIT_CLIENT, TYPE_SLOW );
+
+    SuspendLog stored( "remotedevice", "localcontacts" );
+    QVERIFY( stored.remove( db ) );
+    stored.setSession( "remotecontacts", slowMode.toSyncMLCode(), "localnext", "remotenext" );
+    // Mock storage returns empty items, so item 5 has changed since it was
+    // processed and item 2 has not
+    MockSyncItem emptyItem( "" );
+    stored.addProcessedItem( "2", emptyItem.getFingerprint() );
+    stored.addProcessedItem( "5", "changed" );
+    UIDMapping mapping = { "remote1", "local1" };
+    stored.addMapping( mapping );
+    QVERIFY( stored.save( db ) );
+
+    SuspendLog* suspendLog = new SuspendLog( "remotedevice", "localcontacts" );
+    QVERIFY( suspendLog->load( db ) );
+
+    SyncTarget target( new ChangeLog( "remotedevice", "localcontacts", DIRECTION_TWO_WAY ),
+                       iStorage, SyncMode(), "fooanchor" );
+    target.setSuspendLog( suspendLog );
+
+    // Session with another database is not resumed
+    target.setTargetDatabase( "othercontacts" );
+    QVERIFY( !target.resumeSession() );
+    QVERIFY( !target.resuming() );
+
+    target.setTargetDatabase( "remotecontacts" );
+    QVERIFY( target.resumeSession() );
+    QVERIFY( target.resuming() );
+    QCOMPARE( target.getSyncMode()->syncType(), TYPE_SLOW );
+    QCOMPARE( target.getLocalNextAnchor(), QString( "localnext" ) );
+    QCOMPARE( target.getRemoteNextAnchor(), QString( "remotenext" ) );
+    QCOMPARE( target.mapToLocalUID( "remote1" ), QString( "local1" ) );
+
+    // Items already processed by remote device are left out unless they
+    // have changed since
+    QVERIFY( target.discoverLocalChanges( ROLE_CLIENT ) );
+    QCOMPARE( target.getLocalChanges()->added.count(), 3 );
+    QCOMPARE( target.getLocalChanges()->added[0], SyncItemKey( "1" ) );
+    QCOMPARE( target.getLocalChanges()->added[1], SyncItemKey( "3" ) );
+    QCOMPARE( target.getLocalChanges()->added[2], SyncItemKey( "5" ) );
+
+    target.cancelResume( *iDbHandler );
+    QVERIFY( !target.resuming() );
+
+    SuspendLog removed( "remotedevice", "localcontacts" );
+    QVERIFY( removed.load( db ) );
+    QVERIFY( !removed.isSuspended() );
+}
+
+void SyncTargetTest::testFingerprintChanges()
+{
+    QSqlDatabase& db = iDbHandler->getDbHandle();
+
+    // Mock storage returns empty items 1, 2, 3 and 5
+    MockSyncItem emptyItem( "" );
+    QHash<SyncItemKey, QByteArray> fingerprints;
+    fingerprints.insert( "1", emptyItem.getFingerprint() );
+    fingerprints.insert( "2", QByteArray( "stale" ) );
+    fingerprints.insert( "4", QByteArray( "removed" ) );
+
+    ChangeLog* changeLog = new ChangeLog( "fingerprintdevice", "localcontacts", DIRECTION_TWO_WAY );
+    QVERIFY( changeLog->remove( db ) );
+    changeLog->setFingerprints( fingerprints );
+
+    SyncTarget target( changeLog, iStorage, SyncMode(), "fooanchor" );
+    target.enableFingerprints();
+
+    QVERIFY( target.discoverLocalChanges( ROLE_CLIENT ) );
+    QCOMPARE( target.getLocalChanges()->added.count(), 2 );
+    QCOMPARE( target.getLocalChanges()->added[0], SyncItemKey( "3" ) );
+    QCOMPARE( target.getLocalChanges()->added[1], SyncItemKey( "5" ) );
+    QCOMPARE( target.getLocalChanges()->modified.count(), 1 );
+    QCOMPARE( target.getLocalChanges()->modified[0], SyncItemKey( "2" ) );
+    QCOMPARE( target.getLocalChanges()->removed.count(), 1 );
+    QCOMPARE( target.getLocalChanges()->removed[0], SyncItemKey( "4" ) );
+
+    // Fingerprints of the items changed by remote device are updated when
+    // the session is saved
+    target.addCommittedItem( "6" );
+    target.saveSession( *iDbHandler, QDateTime::currentDateTime() );
+
+    ChangeLog saved( "fingerprintdevice", "localcontacts", DIRECTION_TWO_WAY );
+    QVERIFY( saved.loadFingerprints( db ) );
+    QCOMPARE( saved.getFingerprints().count(), 5 );
+    QVERIFY( saved.getFingerprints().contains( "6" ) );
+    QVERIFY( !saved.getFingerprints().contains( "4" ) );
+    QCOMPARE( saved.getFingerprints().value( "2" ), emptyItem.getFingerprint() );
+
+    QVERIFY( saved.remove( db ) );
+}
+
+void SyncTargetTest::testConflictResolver()
+{
+    SyncTarget target( new ChangeLog( "remotedevice", "localcontacts", DIRECTION_TWO_WAY ),
+                       iStorage, SyncMode(), "fooanchor" );
+    target.getLocalChanges()->modified.append( "1" );
+
+    // Same resolver is used for every Sync element of the session
+    ConflictResolver& resolver = target.getConflictResolver( PREFER_LOCAL_CHANGES );
+    QVERIFY( &target.getConflictResolver( PREFER_LOCAL_CHANGES ) == &resolver );
+    QVERIFY( resolver.isConflict( "1", false ) );
+
+    resolver.addLocalModification( "2" );
+    QVERIFY( resolver.isConflict( "2", false ) );
+    QCOMPARE( target.getLocalChanges()->modified.count(), 2 );
+}
+
 QTEST_MAIN(DataSync::SyncTargetTest)
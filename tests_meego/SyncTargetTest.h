@@ -55,7 +55,13 @@ class SyncTargetTest: public QObject {
         void testRevertSyncMode();
         void testReverted();
         void testClearUIDMappings();
+        void testUIDMappings();
+        void benchmarkUIDMappings_data();
+        void benchmarkUIDMappings();
         void testSetRefreshFromClient();
+        void testResumeSession();
+        void testFingerprintChanges();
+        void testConflictResolver();
 
     private:
         StoragePlugin* iStorage;
@@ -0,0 +1,231 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SyncBenchmark.h"
+
+#include <QFile>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#include "SyncAgent.h"
+#include "SyncAgentConfig.h"
+#include "LoopbackTransport.h"
+#include "SyntheticStorage.h"
+
+using namespace DataSync;
+
+static const QString CLIENT_DBFILE( "/tmp/syncbenchmark-client.db" );
+static const QString SERVER_DBFILE( "/tmp/syncbenchmark-server.db" );
+
+static const QString CLIENT_DB( "contacts" );
+static const QString SERVER_DB( "./contacts" );
+
+// Size of generated items in bytes
+static const int ITEM_SIZE = 1024;
+
+// Maximum time a session may take
+static const int SYNC_TIMEOUT = 60 * 60 * 1000;
+
+void SyncBenchmark::agentFinished( DataSync::SyncState aState )
+{
+    iStates.append( aState );
+
+    if( ++iFinishedAgents == 2 ) {
+        emit sessionsFinished();
+    }
+}
+
+void SyncBenchmark::testSync_data()
+{
+    QTest::addColumn<int>( "syncType" );
+    QTest::addColumn<int>( "items" );
+
+    QList<int> counts;
+    counts << 1000 << 10000 << 100000;
+
+    for( int i = 0; i < counts.count(); ++i ) {
+        QTest::newRow( QString( "slow-%1" ).arg( counts[i] ).toLatin1() ) << int( TYPE_SLOW ) << counts[i];
+        QTest::newRow( QString( "two-way-%1" ).arg( counts[i] ).toLatin1() ) << int( TYPE_FAST ) << counts[i];
+        QTest::newRow( QString( "refresh-%1" ).arg( counts[i] ).toLatin1() ) << int( TYPE_REFRESH ) << counts[i];
+    }
+}
+
+void SyncBenchmark::testSync()
+{
+    QFETCH( int, syncType );
+    QFETCH( int, items );
+
+    QFile::remove( CLIENT_DBFILE );
+    QFile::remove( SERVER_DBFILE );
+
+    SyntheticStorageProvider clientProvider;
+    SyntheticStorageProvider serverProvider;
+    SyntheticStorage* clientStorage = clientProvider.addStorage( CLIENT_DB );
+    SyntheticStorage* serverStorage = serverProvider.addStorage( SERVER_DB );
+
+    LoopbackTransport clientTransport;
+    LoopbackTransport serverTransport;
+    clientTransport.setPeer( &serverTransport );
+
+    SyncMode mode;
+
+    if( syncType == TYPE_SLOW ) {
+        mode = SyncMode( DIRECTION_TWO_WAY, INIT_CLIENT, TYPE_SLOW );
+    }
+    else if( syncType == TYPE_REFRESH ) {
+        mode = SyncMode( DIRECTION_FROM_CLIENT, INIT_CLIENT, TYPE_REFRESH );
+    }
+    else {
+        mode = SyncMode( DIRECTION_TWO_WAY, INIT_CLIENT, TYPE_FAST );
+    }
+
+    SyncAgentConfig clientConfig;
+    clientConfig.setTransport( &clientTransport );
+    clientConfig.setStorageProvider( &clientProvider );
+    clientConfig.setDatabaseFilePath( CLIENT_DBFILE );
+    clientConfig.setLocalDeviceName( "benchmark-client" );
+    clientConfig.setSyncParams( "benchmark-server", SYNCML_1_2, mode );
+    clientConfig.addSyncTarget( CLIENT_DB, SERVER_DB );
+
+    SyncAgentConfig serverConfig;
+    serverConfig.setTransport( &serverTransport );
+    serverConfig.setStorageProvider( &serverProvider );
+    serverConfig.setDatabaseFilePath( SERVER_DBFILE );
+    serverConfig.setLocalDeviceName( "benchmark-server" );
+
+    int expectedItems = items;
+
+    if( syncType == TYPE_FAST ) {
+        // Establish anchors with an empty session first, then create changes
+        // on both sides after it
+        QVERIFY( runSync( clientConfig, serverConfig ) );
+
+        QDateTime timeStamp = QDateTime::currentDateTime().addSecs( 60 );
+        clientStorage->generateItems( items / 2, ITEM_SIZE, timeStamp );
+        serverStorage->generateItems( items - items / 2, ITEM_SIZE, timeStamp );
+
+        clientTransport.resetStatistics();
+        serverTransport.resetStatistics();
+    }
+    else {
+        clientStorage->generateItems( items, ITEM_SIZE );
+    }
+
+    resetPeakRSS();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVERIFY( runSync( clientConfig, serverConfig ) );
+
+    qint64 elapsed = qMax( timer.elapsed(), qint64( 1 ) );
+
+    QCOMPARE( serverStorage->count(), expectedItems );
+    QCOMPARE( clientStorage->count(), expectedItems );
+
+    qint64 bytes = clientTransport.bytesSent() + serverTransport.bytesSent();
+    int messages = clientTransport.messagesSent() + serverTransport.messagesSent();
+
+    qDebug() << QTest::currentDataTag() << ":"
+             << items << "items in" << elapsed << "ms,"
+             << qRound64( items * 1000.0 / elapsed ) << "items/s,"
+             << bytes << "bytes on the wire in"
+             << messages << "messages, peak RSS"
+             << peakRSS() << "kB";
+
+    QTest::setBenchmarkResult( elapsed, QTest::WalltimeMilliseconds );
+
+    QFile::remove( CLIENT_DBFILE );
+    QFile::remove( SERVER_DBFILE );
+}
+
+bool SyncBenchmark::runSync( const SyncAgentConfig& aClientConfig,
+                             const SyncAgentConfig& aServerConfig )
+{
+    SyncAgent client;
+    SyncAgent server;
+
+    iFinishedAgents = 0;
+    iStates.clear();
+
+    connect( &client, SIGNAL(syncFinished(DataSync::SyncState)),
+             this, SLOT(agentFinished(DataSync::SyncState)) );
+    connect( &server, SIGNAL(syncFinished(DataSync::SyncState)),
+             this, SLOT(agentFinished(DataSync::SyncState)) );
+
+    if( !server.listen( aServerConfig ) || !client.startSync( aClientConfig ) ) {
+        return false;
+    }
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot( true );
+    connect( &timeout, SIGNAL(timeout()), &loop, SLOT(quit()) );
+    connect( this, SIGNAL(sessionsFinished()), &loop, SLOT(quit()) );
+    timeout.start( SYNC_TIMEOUT );
+
+    loop.exec();
+
+    return iFinishedAgents == 2 && iStates.count( SYNC_FINISHED ) == 2;
+}
+
+qint64 SyncBenchmark::peakRSS()
+{
+    QFile status( "/proc/self/status" );
+
+    if( !status.open( QIODevice::ReadOnly ) ) {
+        return -1;
+    }
+
+    while( !status.atEnd() ) {
+        QByteArray line = status.readLine();
+        if( line.startsWith( "VmHWM:" ) ) {
+            return line.mid( 6 ).trimmed().split( ' ' ).first().toLongLong();
+        }
+    }
+
+    return -1;
+}
+
+void SyncBenchmark::resetPeakRSS()
+{
+    // Supported since Linux 4.0. If it fails, peak is over the whole process
+    QFile clearRefs( "/proc/self/clear_refs" );
+
+    if( clearRefs.open( QIODevice::WriteOnly ) ) {
+        clearRefs.write( "5" );
+    }
+}
+
+QTEST_MAIN(SyncBenchmark)
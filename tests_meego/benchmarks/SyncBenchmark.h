@@ -0,0 +1,86 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef SYNCBENCHMARK_H
+#define SYNCBENCHMARK_H
+
+#include <QTest>
+
+#include "SyncAgentConsts.h"
+
+namespace DataSync {
+class SyncAgentConfig;
+}
+
+/*! \brief End-to-end sync throughput benchmark
+ *
+ * Runs complete sessions between a client and a server SyncAgent in the
+ * same process, connected with LoopbackTransport and using synthetic
+ * in-memory storages. For each session, items per second, bytes on the
+ * wire, message count and peak resident set size are reported.
+ *
+ * Rows with 100k items take a long time, so they can be run separately:
+ *   SyncBenchmark testSync:slow-100000
+ */
+class SyncBenchmark : public QObject {
+    Q_OBJECT;
+public:
+
+signals:
+
+    void sessionsFinished();
+
+protected slots:
+
+    void agentFinished( DataSync::SyncState aState );
+
+private slots:
+
+    void testSync_data();
+    void testSync();
+
+private:
+
+    bool runSync( const DataSync::SyncAgentConfig& aClientConfig,
+                  const DataSync::SyncAgentConfig& aServerConfig );
+
+    static qint64 peakRSS();
+
+    static void resetPeakRSS();
+
+    int                         iFinishedAgents;
+    QList<DataSync::SyncState>  iStates;
+
+};
+
+#endif  //  SYNCBENCHMARK_H
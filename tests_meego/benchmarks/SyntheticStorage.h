@@ -0,0 +1,370 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#ifndef SYNTHETICSTORAGE_H
+#define SYNTHETICSTORAGE_H
+
+#include <QMap>
+#include <QDateTime>
+
+#include "StoragePlugin.h"
+#include "StorageProvider.h"
+#include "SyncItem.h"
+
+/*! \brief In-memory sync item
+ */
+class SyntheticSyncItem : public DataSync::SyncItem {
+public:
+
+    SyntheticSyncItem( const DataSync::SyncItemKey& aKey = DataSync::SyncItemKey(),
+                       const QByteArray& aData = QByteArray() ) : iData( aData )
+    {
+        setKey( aKey );
+    }
+
+    virtual ~SyntheticSyncItem() { }
+
+    virtual qint64 getSize() const
+    {
+        return iData.size();
+    }
+
+    virtual bool read( qint64 aOffset, qint64 aLength, QByteArray& aData ) const
+    {
+        aData = iData.mid( aOffset, aLength );
+        return true;
+    }
+
+    virtual bool write( qint64 aOffset, const QByteArray& aData )
+    {
+        if( aOffset + aData.size() > iData.size() ) {
+            iData.resize( aOffset + aData.size() );
+        }
+        iData.replace( aOffset, aData.size(), aData );
+        return true;
+    }
+
+    virtual bool resize( qint64 aLength )
+    {
+        iData.resize( aLength );
+        return true;
+    }
+
+    const QByteArray& data() const
+    {
+        return iData;
+    }
+
+private:
+    QByteArray iData;
+
+};
+
+/*! \brief In-memory storage plugin with generated content
+ *
+ * Items are vCards padded to a requested size. Modifications are reported
+ * based on creation, modification and deletion times of the items.
+ */
+class SyntheticStorage : public DataSync::StoragePlugin {
+public:
+
+    SyntheticStorage( const QString& aURI, const QString& aContentFormat = "text/x-vcard",
+                      const QString& aContentVersion = "2.1" )
+     : iSourceURI( aURI ), iIdCounter( 0 )
+    {
+        DataSync::ContentFormat format;
+        format.iType = aContentFormat;
+        format.iVersion = aContentVersion;
+        iFormats.setPreferredRx( format );
+        iFormats.setPreferredTx( format );
+        iFormats.rx().append( format );
+        iFormats.tx().append( format );
+    }
+
+    virtual ~SyntheticStorage() { }
+
+    /*! \brief Adds generated items to the storage
+     *
+     * @param aCount Number of items to add
+     * @param aSize Size of each item in bytes
+     * @param aTimeStamp Creation time of the items
+     */
+    void generateItems( int aCount, int aSize,
+                        const QDateTime& aTimeStamp = QDateTime::currentDateTime() )
+    {
+        for( int i = 0; i < aCount; ++i ) {
+            int id = ++iIdCounter;
+            Item item;
+            item.iData = "BEGIN:VCARD\r\nVERSION:2.1\r\nN:" + iSourceURI.toUtf8() + ";Item " +
+                         QByteArray::number( id ) + "\r\nNOTE:";
+            QByteArray end( "\r\nEND:VCARD\r\n" );
+            if( item.iData.size() + end.size() < aSize ) {
+                item.iData.append( QByteArray( aSize - item.iData.size() - end.size(), 'x' ) );
+            }
+            item.iData.append( end );
+            item.iCreated = aTimeStamp;
+            item.iModified = aTimeStamp;
+            iItems.insert( QString::number( id ), item );
+        }
+    }
+
+    /*! \brief Removes all items without recording them as deleted
+     */
+    void clear()
+    {
+        iItems.clear();
+        iDeleted.clear();
+    }
+
+    int count() const
+    {
+        return iItems.count();
+    }
+
+    virtual const QString& getSourceURI() const
+    {
+        return iSourceURI;
+    }
+
+    virtual const DataSync::StorageContentFormatInfo& getFormatInfo() const
+    {
+        return iFormats;
+    }
+
+    virtual qint64 getMaxObjSize() const
+    {
+        return 1024 * 1024;
+    }
+
+    virtual QByteArray getPluginCTCaps( DataSync::ProtocolVersion /*aVersion*/ ) const
+    {
+        return QByteArray();
+    }
+
+    virtual QByteArray getPluginExts() const
+    {
+        return QByteArray();
+    }
+
+    virtual bool getAll( QList<DataSync::SyncItemKey>& aKeys )
+    {
+        aKeys = iItems.keys();
+        return true;
+    }
+
+    virtual bool getModifications( QList<DataSync::SyncItemKey>& aNewKeys,
+                                   QList<DataSync::SyncItemKey>& aReplacedKeys,
+                                   QList<DataSync::SyncItemKey>& aDeletedKeys,
+                                   const QDateTime& aTimeStamp )
+    {
+        QMap<QString, Item>::const_iterator i;
+        for( i = iItems.constBegin(); i != iItems.constEnd(); ++i ) {
+            if( i.value().iCreated > aTimeStamp ) {
+                aNewKeys.append( i.key() );
+            }
+            else if( i.value().iModified > aTimeStamp ) {
+                aReplacedKeys.append( i.key() );
+            }
+        }
+
+        QMap<QString, QDateTime>::const_iterator d;
+        for( d = iDeleted.constBegin(); d != iDeleted.constEnd(); ++d ) {
+            if( d.value() > aTimeStamp ) {
+                aDeletedKeys.append( d.key() );
+            }
+        }
+
+        return true;
+    }
+
+    virtual DataSync::SyncItem* newItem()
+    {
+        return new SyntheticSyncItem;
+    }
+
+    virtual DataSync::SyncItem* getSyncItem( const DataSync::SyncItemKey& aKey )
+    {
+        if( !iItems.contains( aKey ) ) {
+            return NULL;
+        }
+
+        SyntheticSyncItem* item = new SyntheticSyncItem( aKey, iItems.value( aKey ).iData );
+        item->setType( iFormats.getPreferredTx().iType );
+        item->setVersion( iFormats.getPreferredTx().iVersion );
+        return item;
+    }
+
+    virtual QList<DataSync::SyncItem*> getSyncItems( const QList<DataSync::SyncItemKey>& aKeyList )
+    {
+        QList<DataSync::SyncItem*> items;
+        for( int i = 0; i < aKeyList.count(); ++i ) {
+            items.append( getSyncItem( aKeyList[i] ) );
+        }
+        return items;
+    }
+
+    virtual QList<StoragePluginStatus> addItems( const QList<DataSync::SyncItem*>& aItems )
+    {
+        QList<StoragePluginStatus> results;
+        QDateTime now = QDateTime::currentDateTime();
+
+        for( int i = 0; i < aItems.count(); ++i ) {
+            Item item;
+            aItems[i]->read( 0, aItems[i]->getSize(), item.iData );
+            item.iCreated = now;
+            item.iModified = now;
+
+            QString key = QString::number( ++iIdCounter );
+            iItems.insert( key, item );
+            aItems[i]->setKey( key );
+            results.append( STATUS_OK );
+        }
+
+        return results;
+    }
+
+    virtual QList<StoragePluginStatus> replaceItems( const QList<DataSync::SyncItem*>& aItems )
+    {
+        QList<StoragePluginStatus> results;
+        QDateTime now = QDateTime::currentDateTime();
+
+        for( int i = 0; i < aItems.count(); ++i ) {
+            QMap<QString, Item>::iterator item = iItems.find( *aItems[i]->getKey() );
+            if( item == iItems.end() ) {
+                results.append( STATUS_NOT_FOUND );
+                continue;
+            }
+
+            aItems[i]->read( 0, aItems[i]->getSize(), item.value().iData );
+            item.value().iModified = now;
+            results.append( STATUS_OK );
+        }
+
+        return results;
+    }
+
+    virtual QList<StoragePluginStatus> deleteItems( const QList<DataSync::SyncItemKey>& aKeys )
+    {
+        QList<StoragePluginStatus> results;
+        QDateTime now = QDateTime::currentDateTime();
+
+        for( int i = 0; i < aKeys.count(); ++i ) {
+            if( iItems.remove( aKeys[i] ) > 0 ) {
+                iDeleted.insert( aKeys[i], now );
+                results.append( STATUS_OK );
+            }
+            else {
+                results.append( STATUS_NOT_FOUND );
+            }
+        }
+
+        return results;
+    }
+
+private:
+
+    struct Item
+    {
+        QByteArray  iData;
+        QDateTime   iCreated;
+        QDateTime   iModified;
+    };
+
+    QString                                 iSourceURI;
+    DataSync::StorageContentFormatInfo      iFormats;
+    QMap<QString, Item>                     iItems;
+    QMap<QString, QDateTime>                iDeleted;
+    int                                     iIdCounter;
+
+};
+
+/*! \brief Storage provider for synthetic storages
+ *
+ * Storages are owned by the provider and kept between sessions
+ */
+class SyntheticStorageProvider : public DataSync::StorageProvider {
+public:
+
+    SyntheticStorageProvider() { }
+
+    virtual ~SyntheticStorageProvider()
+    {
+        qDeleteAll( iStorages );
+    }
+
+    SyntheticStorage* addStorage( const QString& aURI )
+    {
+        SyntheticStorage* storage = new SyntheticStorage( aURI );
+        iStorages.insert( aURI, storage );
+        return storage;
+    }
+
+    virtual bool getStorageContentFormatInfo( const QString& aURI,
+                                              DataSync::StorageContentFormatInfo& aInfo )
+    {
+        if( !iStorages.contains( aURI ) ) {
+            return false;
+        }
+
+        aInfo = iStorages.value( aURI )->getFormatInfo();
+        return true;
+    }
+
+    virtual DataSync::StoragePlugin* acquireStorageByURI( const QString& aURI )
+    {
+        return iStorages.value( aURI );
+    }
+
+    virtual DataSync::StoragePlugin* acquireStorageByMIME( const QString& aMIME )
+    {
+        QMap<QString, SyntheticStorage*>::const_iterator i;
+        for( i = iStorages.constBegin(); i != iStorages.constEnd(); ++i ) {
+            if( i.value()->getFormatInfo().getPreferredRx().iType == aMIME ) {
+                return i.value();
+            }
+        }
+
+        return NULL;
+    }
+
+    virtual void releaseStorage( DataSync::StoragePlugin* /*aStorage*/ )
+    {
+    }
+
+private:
+
+    QMap<QString, SyntheticStorage*> iStorages;
+
+};
+
+#endif  //  SYNTHETICSTORAGE_H
@@ -0,0 +1,5 @@
+include(../tests_common.pri)
+TEMPLATE = subdirs
+SUBDIRS = \
+    SyncBenchmark.pro \
+
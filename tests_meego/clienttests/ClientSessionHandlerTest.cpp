@@ -159,6 +159,46 @@ void ClientSessionHandlerTest::testBusyStatusReceived()
 	QVERIFY(iHandler->isRemoteBusyStatusSet() == false);
 }
 
+void ClientSessionHandlerTest::testItemReferences()
+{
+    qRegisterMetaType<DataSync::ModificationType>("DataSync::ModificationType");
+    qRegisterMetaType<DataSync::ModifiedDatabase>("DataSync::ModifiedDatabase");
+
+    QSignalSpy spy( iHandler, SIGNAL(itemProcessed(DataSync::ModificationType, DataSync::ModifiedDatabase, QString, QString, int)) );
+
+    iHandler->newItemReference( 1, 2, "key1", MOD_ITEM_ADDED, "localdb", "remotedb", "text/x-vcard" );
+    iHandler->newItemReference( 1, 3, "key2", MOD_ITEM_MODIFIED, "localdb", "remotedb", "text/x-vcard" );
+    iHandler->newItemReference( 2, 2, "key3", MOD_ITEM_DELETED, "localdb2", "remotedb2", "text/x-vcalendar" );
+
+    QCOMPARE( iHandler->iItemReferences.count(), 3 );
+    QCOMPARE( iHandler->iItemReferenceTargets.count(), 2 );
+
+    // Unknown reference
+    iHandler->processItemStatus( 1, 2, "key2" );
+    QCOMPARE( spy.count(), 0 );
+
+    iHandler->processItemStatus( 2, 2, "key3" );
+    QCOMPARE( spy.count(), 1 );
+    QList<QVariant> arguments = spy.takeFirst();
+    QCOMPARE( arguments.at(0).value<DataSync::ModificationType>(), MOD_ITEM_DELETED );
+    QCOMPARE( arguments.at(1).value<DataSync::ModifiedDatabase>(), MOD_REMOTE_DATABASE );
+    QCOMPARE( arguments.at(2).toString(), QString( "localdb2" ) );
+    QCOMPARE( arguments.at(3).toString(), QString( "text/x-vcalendar" ) );
+    QCOMPARE( arguments.at(4).toInt(), 3 );
+
+    iHandler->processItemStatus( 1, 2, "key1" );
+    QCOMPARE( spy.count(), 1 );
+    arguments = spy.takeFirst();
+    QCOMPARE( arguments.at(0).value<DataSync::ModificationType>(), MOD_ITEM_ADDED );
+    QCOMPARE( arguments.at(2).toString(), QString( "localdb" ) );
+
+    // Status for the same item again is ignored
+    iHandler->processItemStatus( 1, 2, "key1" );
+    QCOMPARE( spy.count(), 0 );
+
+    QCOMPARE( iHandler->iItemReferences.count(), 1 );
+}
+
 void ClientSessionHandlerTest::regression_NB166841_01()
 {
 
@@ -57,6 +57,7 @@ private slots:
     void testSyncReceived();
     void testFinalReceived();
     void testBusyStatusReceived();
+    void testItemReferences();
 
     void regression_NB166841_01();
     void regression_NB166841_02();
@@ -6,9 +6,11 @@ SUBDIRS = \
     AuthHelperTest.pro \
     CommandHandlerTest.pro \
     ConflictResolverTest.pro \
+    DatabaseHandlerTest.pro \
     DevInfHandlerTest.pro \
     DevInfPackageTest.pro \
     FinalPackageTest.pro \
+    ItemMatcherTest.pro \
     ChangeLogTest.pro \
     LocalChangesPackageTest.pro \
     LocalMappingsPackageTest.pro \
@@ -17,6 +19,7 @@ SUBDIRS = \
     SANTest.pro \
     SessionHandlerTest.pro \
     StorageHandlerTest.pro \
+    SuspendLogTest.pro \
     SyncAgentConfigTest.pro \
     SyncAgentTest.pro \
     SyncItemPrefetcherTest.pro \
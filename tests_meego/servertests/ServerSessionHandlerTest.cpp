@@ -240,6 +240,13 @@ void ServerSessionHandlerTest::testHandleInformativeAlert()
     response = iHandler->handleInformativeAlert(alertParams);
     QVERIFY(response == NOT_IMPLEMENTED);
 
+    QVERIFY(!iHandler->remoteSuspended());
+    alertParams.data = QString::number( ALERT_SUSPEND );
+    response = iHandler->handleInformativeAlert(alertParams);
+    QVERIFY(response == SUCCESS);
+    QVERIFY(iHandler->remoteSuspended());
+    iHandler->iRemoteSuspended = false;
+
 }
 
 void ServerSessionHandlerTest::testSyncInitiate()
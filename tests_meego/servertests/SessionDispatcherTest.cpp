@@ -0,0 +1,212 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SessionDispatcherTest.h"
+
+#include <QSignalSpy>
+
+#include "SessionDispatcher.h"
+#include "SyncAgentConfig.h"
+#include "SyncAgentConfigProperties.h"
+#include "Fragments.h"
+#include "Mock.h"
+
+using namespace DataSync;
+
+static const QString DBFILE( "/tmp/sessiondispatchertest.db" );
+
+bool SessionDispatcherTest::getStorageContentFormatInfo( const QString& aURI,
+                                                         StorageContentFormatInfo& aInfo )
+{
+    Q_UNUSED( aURI );
+    MockStorage temp( "storage" );
+    aInfo = temp.getFormatInfo();
+    return true;
+}
+
+StoragePlugin* SessionDispatcherTest::acquireStorageByURI( const QString& /*aURI*/ )
+{
+    return new MockStorage( "storage" );
+}
+
+StoragePlugin* SessionDispatcherTest::acquireStorageByMIME( const QString& /*aMIME*/ )
+{
+    return new MockStorage( "storage" );
+}
+
+void SessionDispatcherTest::releaseStorage( StoragePlugin* aStorage )
+{
+    delete aStorage;
+}
+
+Transport* SessionDispatcherTest::acquireTransport()
+{
+    if( iAvailableTransports <= 0 ) {
+        return NULL;
+    }
+
+    --iAvailableTransports;
+
+    Transport* transport = new TestTransport( false );
+    iTransports.append( transport );
+
+    return transport;
+}
+
+void SessionDispatcherTest::releaseTransport( Transport* aTransport )
+{
+    QVERIFY( iTransports.removeAll( aTransport ) == 1 );
+
+    ++iReleasedTransports;
+    delete aTransport;
+}
+
+void SessionDispatcherTest::init()
+{
+    qRegisterMetaType<DataSync::SyncState>( "DataSync::SyncState" );
+    qRegisterMetaType<DataSync::ModificationType>( "DataSync::ModificationType" );
+    qRegisterMetaType<DataSync::ModifiedDatabase>( "DataSync::ModifiedDatabase" );
+    qRegisterMetaType<DataSync::SyncResults>( "DataSync::SyncResults" );
+
+    iAvailableTransports = 10;
+    iReleasedTransports = 0;
+}
+
+void SessionDispatcherTest::cleanup()
+{
+    qDeleteAll( iTransports );
+    iTransports.clear();
+
+    QFile::remove( DBFILE );
+}
+
+void SessionDispatcherTest::testStart()
+{
+    SyncAgentConfig config;
+    config.setStorageProvider( this );
+    config.setDatabaseFilePath( DBFILE );
+
+    // Transport provider is mandatory
+    SessionDispatcher dispatcher;
+    QVERIFY( !dispatcher.start( config ) );
+    QVERIFY( !dispatcher.isListening() );
+
+    config.setTransportProvider( this );
+    QVERIFY( dispatcher.start( config ) );
+    QVERIFY( dispatcher.isListening() );
+    QCOMPARE( dispatcher.sessionCount(), 0 );
+    QCOMPARE( iTransports.count(), 1 );
+
+    // Listening fails if there are no transports
+    SessionDispatcher dispatcher2;
+    iAvailableTransports = 0;
+    QVERIFY( !dispatcher2.start( config ) );
+    QVERIFY( !dispatcher2.isListening() );
+
+    // Listening transport is released when listening stops
+    dispatcher.abort( ABORTED );
+    QVERIFY( !dispatcher.isListening() );
+    QCOMPARE( iTransports.count(), 0 );
+    QCOMPARE( iReleasedTransports, 1 );
+}
+
+void SessionDispatcherTest::testSessionLimit()
+{
+    SyncAgentConfig config;
+    config.setStorageProvider( this );
+    config.setTransportProvider( this );
+    config.setDatabaseFilePath( DBFILE );
+
+    SessionDispatcher dispatcher;
+    QVERIFY( dispatcher.start( config ) );
+    QCOMPARE( dispatcher.maxSessions(), 16 );
+
+    config.setAgentProperty( MAXCONCURRENTSESSIONSPROP, QString::number( 2 ) );
+
+    SessionDispatcher dispatcher2;
+    QVERIFY( dispatcher2.start( config ) );
+    QCOMPARE( dispatcher2.maxSessions(), 2 );
+
+    QList<Fragment*> fragments;
+    Transport* transport = acquireTransport();
+    dispatcher2.startSession( transport, "device1", fragments );
+    QCOMPARE( dispatcher2.sessionCount(), 1 );
+
+    // Each session has its own copy of the configuration, using its own transport
+    const SyncAgentConfig* sessionConfig = dispatcher2.iSessions.first()->iConfig;
+    QVERIFY( sessionConfig != &config );
+    QCOMPARE( sessionConfig->getTransport(), transport );
+    QCOMPARE( sessionConfig->getAgentProperty( MAXCONCURRENTSESSIONSPROP ), QString::number( 2 ) );
+
+    QVERIFY( dispatcher2.isServing( "device1" ) );
+    QVERIFY( !dispatcher2.isServing( "device2" ) );
+    QVERIFY( !dispatcher2.isServing( "" ) );
+}
+
+void SessionDispatcherTest::testAbort()
+{
+    SyncAgentConfig config;
+    config.setStorageProvider( this );
+    config.setTransportProvider( this );
+    config.setDatabaseFilePath( DBFILE );
+
+    SessionDispatcher dispatcher;
+    QSignalSpy sessionSpy( &dispatcher, SIGNAL(sessionFinished(DataSync::SyncResults)) );
+    QSignalSpy finishedSpy( &dispatcher, SIGNAL(finished(DataSync::SyncState,QString)) );
+
+    QVERIFY( dispatcher.start( config ) );
+
+    QList<Fragment*> fragments;
+    dispatcher.startSession( acquireTransport(), "device1", fragments );
+    dispatcher.startSession( acquireTransport(), "device2", fragments );
+    QCOMPARE( dispatcher.sessionCount(), 2 );
+    QCOMPARE( iTransports.count(), 3 );
+
+    // Sessions don't share database connections
+    QVERIFY( dispatcher.iSessions[0]->iConfig->getDatabasePoolKey() !=
+             dispatcher.iSessions[1]->iConfig->getDatabasePoolKey() );
+
+    dispatcher.abort( ABORTED );
+    QVERIFY( !dispatcher.isListening() );
+
+    QTRY_COMPARE( finishedSpy.count(), 1 );
+    QCOMPARE( sessionSpy.count(), 2 );
+    QCOMPARE( dispatcher.sessionCount(), 0 );
+    QCOMPARE( qvariant_cast<SyncState>( finishedSpy.at(0).at(0) ), ABORTED );
+
+    // All transports have been released
+    QCOMPARE( iTransports.count(), 0 );
+    QCOMPARE( iReleasedTransports, 3 );
+}
+
+QTEST_MAIN(SessionDispatcherTest)
@@ -2,6 +2,7 @@ include(../tests_common.pri)
 TEMPLATE = subdirs
 SUBDIRS = \
     ServerSessionHandlerTest.pro \
+    SessionDispatcherTest.pro \
 
     # Dead code?
     #ServerCommandHandlerTest.pro
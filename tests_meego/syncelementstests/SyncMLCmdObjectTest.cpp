@@ -36,9 +36,91 @@
 #include <QtTest>
 
 #include "SyncMLCmdObject.h"
+#include "SyncMLSync.h"
+#include "SyncMLAdd.h"
+#include "SyncMLItem.h"
+#include "SyncMLStatus.h"
+#include "SyncMLAlert.h"
+#include "SyncMLPut.h"
+#include "DeviceInfo.h"
+#include "Fragments.h"
+#include "LibWbXML2Encoder.h"
+#include "WbXMLEncoder.h"
+#include "datatypes.h"
 
 using namespace DataSync;
 
+static const int BENCHMARK_ITEMS = 1000;
+
+static SyncMLAdd* createAdd( int aCmdId )
+{
+    SyncMLAdd* add = new SyncMLAdd( aCmdId );
+    add->addMimeMetadata( "text/x-vcard" );
+
+    SyncMLItem* item = new SyncMLItem;
+    item->insertSource( QString::number( aCmdId ) );
+    item->insertData( QByteArray( "BEGIN:VCARD\r\nVERSION:2.1\r\nN:Doe;John\r\n"
+                                  "TEL;CELL:+358401234567\r\nEND:VCARD\r\n" ) );
+    add->addChild( item );
+
+    return add;
+}
+
+static SyncMLCmdObject* createMessage()
+{
+    SyncMLCmdObject* message = new SyncMLCmdObject( SYNCML_ELEMENT_SYNCML );
+    message->addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_SYNCML12 );
+    return message;
+}
+
+static SyncMLCmdObject* createFullMessage( ProtocolVersion aVersion, int aItems )
+{
+    SyncMLCmdObject* message = new SyncMLCmdObject( SYNCML_ELEMENT_SYNCML );
+    message->addAttribute( XML_NAMESPACE, aVersion == SYNCML_1_1 ?
+                           XML_NAMESPACE_VALUE_SYNCML11 : XML_NAMESPACE_VALUE_SYNCML12 );
+
+    SyncMLCmdObject* body = new SyncMLCmdObject( SYNCML_ELEMENT_SYNCBODY );
+    message->addChild( body );
+
+    StatusParams statusParams;
+    statusParams.cmdId = 1;
+    statusParams.msgRef = 1;
+    statusParams.cmdRef = 2;
+    statusParams.cmd = SYNCML_ELEMENT_ALERT;
+    statusParams.targetRef = "./contacts";
+    statusParams.sourceRef = "./Contacts";
+    statusParams.data = SUCCESS;
+    statusParams.nextAnchor = "1234";
+    body->addChild( new SyncMLStatus( statusParams ) );
+
+    CommandParams alertParams;
+    alertParams.cmdId = 2;
+    alertParams.data = "200";
+    ItemParams alertItem;
+    alertItem.target = "./contacts";
+    alertItem.source = "./Contacts";
+    alertItem.meta.anchor.last = "1233";
+    alertItem.meta.anchor.next = QString::fromUtf8( "1234\xc3\xa4" );
+    alertParams.items.append( alertItem );
+    body->addChild( new SyncMLAlert( alertParams ) );
+
+    DeviceInfo deviceInfo;
+    deviceInfo.setManufacturer( "Manufacturer" );
+    deviceInfo.setDeviceID( "IMEI:123456789012345" );
+    body->addChild( new SyncMLPut( 3, QList<StoragePlugin*>(), deviceInfo, aVersion, ROLE_CLIENT ) );
+
+    SyncMLSync* sync = new SyncMLSync( 4, "./contacts", "./Contacts" );
+    body->addChild( sync );
+
+    for( int i = 0; i < aItems; ++i ) {
+        sync->addChild( createAdd( i + 5 ) );
+    }
+
+    body->addChild( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
 void SyncMLCmdObjectTest::testSetGetNameValue()
 {
     QString name1("objname");
@@ -105,4 +187,184 @@ void SyncMLCmdObjectTest::testAddGetChildren()
 
 }
 
+void SyncMLCmdObjectTest::testWbXMLSizeEstimate()
+{
+    SyncMLCmdObject* message = createMessage();
+    SyncMLCmdObject* body = new SyncMLCmdObject( SYNCML_ELEMENT_SYNCBODY );
+    message->addChild( body );
+    SyncMLSync* sync = new SyncMLSync( 1, "./contacts", "./contacts" );
+    body->addChild( sync );
+
+    for( int i = 0; i < 100; ++i ) {
+        sync->addChild( createAdd( i + 2 ) );
+    }
+
+    LibWbXML2Encoder encoder;
+    QByteArray wbxml;
+    QVERIFY( encoder.encodeToWbXML( *message, SYNCML_1_2, wbxml ) );
+
+    int estimate = message->calculateSize( true, SYNCML_1_2 );
+    double error = qAbs( estimate - wbxml.size() ) / double( wbxml.size() );
+
+    qDebug() << "Estimated size:" << estimate << "actual size:" << wbxml.size()
+             << "error:" << error * 100 << "%";
+
+    QVERIFY( error < 0.10 );
+
+    delete message;
+}
+
+void SyncMLCmdObjectTest::testWbXMLSizeCache()
+{
+    SyncMLCmdObject* message = createMessage();
+    SyncMLCmdObject* body = new SyncMLCmdObject( SYNCML_ELEMENT_SYNCBODY );
+    body->addChild( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+    message->addChild( body );
+
+    int emptySize = message->calculateSize( true, SYNCML_1_2 );
+
+    SyncMLAdd* add = createAdd( 1 );
+    int addSize = add->calculateSize( true, SYNCML_1_2 );
+    body->addChild( add );
+
+    // Cached size of the message must be updated when descendants change
+    QCOMPARE( message->calculateSize( true, SYNCML_1_2 ), emptySize + addSize );
+
+    SyncMLCmdObject* child = add->getChildren().last();
+    child->setValue( "abc" );
+    QVERIFY( message->calculateSize( true, SYNCML_1_2 ) > emptySize + addSize );
+
+    delete message;
+}
+
+void SyncMLCmdObjectTest::benchmarkWbXMLSizeEstimate()
+{
+    // Mimics generation of a message: size of each command and size of the
+    // whole message is checked after every addition
+    QBENCHMARK {
+        SyncMLCmdObject* message = createMessage();
+        SyncMLSync* sync = new SyncMLSync( 1, "./contacts", "./contacts" );
+        message->addChild( sync );
+
+        for( int i = 0; i < BENCHMARK_ITEMS; ++i ) {
+            SyncMLAdd* add = createAdd( i + 2 );
+            add->calculateSize( true, SYNCML_1_2 );
+            sync->addChild( add );
+            message->calculateSize( true, SYNCML_1_2 );
+        }
+
+        delete message;
+    }
+}
+
+void SyncMLCmdObjectTest::benchmarkWbXMLSizeEncode()
+{
+    // Reference for benchmarkWbXMLSizeEstimate(): sizes calculated by
+    // encoding each command with libwbxml2, as was done before the estimator
+    LibWbXML2Encoder encoder;
+
+    QBENCHMARK {
+        SyncMLCmdObject* message = createMessage();
+        SyncMLSync* sync = new SyncMLSync( 1, "./contacts", "./contacts" );
+        message->addChild( sync );
+
+        for( int i = 0; i < BENCHMARK_ITEMS; ++i ) {
+            SyncMLAdd* add = createAdd( i + 2 );
+            add->addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_SYNCML12 );
+            QByteArray data;
+            encoder.encodeToWbXML( *add, SYNCML_1_2, data );
+            sync->addChild( add );
+        }
+
+        delete message;
+    }
+}
+
+void SyncMLCmdObjectTest::testWbXMLEncoder()
+{
+    // Output must be identical to libwbxml2 output
+    LibWbXML2Encoder libwbxml2Encoder;
+    WbXMLEncoder encoder;
+
+    SyncMLCmdObject* message12 = createFullMessage( SYNCML_1_2, 10 );
+
+    QByteArray expected12;
+    QVERIFY( libwbxml2Encoder.encodeToWbXML( *message12, SYNCML_1_2, expected12 ) );
+    QByteArray wbxml12;
+    QVERIFY( encoder.encodeToWbXML( *message12, SYNCML_1_2, wbxml12 ) );
+    QCOMPARE( wbxml12.toHex(), expected12.toHex() );
+
+    delete message12;
+
+    SyncMLCmdObject* message11 = createFullMessage( SYNCML_1_1, 10 );
+
+    QByteArray expected11;
+    QVERIFY( libwbxml2Encoder.encodeToWbXML( *message11, SYNCML_1_1, expected11 ) );
+    QByteArray wbxml11;
+    QVERIFY( encoder.encodeToWbXML( *message11, SYNCML_1_1, wbxml11 ) );
+    QCOMPARE( wbxml11.toHex(), expected11.toHex() );
+
+    // Document is appended to existing data
+    QByteArray prefix( "prefix" );
+    QByteArray appended( prefix );
+    QVERIFY( encoder.encodeToWbXML( *message11, SYNCML_1_1, appended ) );
+    QCOMPARE( appended, prefix + expected11 );
+
+    delete message11;
+}
+
+void SyncMLCmdObjectTest::testWbXMLEncoderUnsupported()
+{
+    WbXMLEncoder encoder;
+    QByteArray data( "data" );
+
+    // No namespace in root element
+    SyncMLCmdObject noNamespace( SYNCML_ELEMENT_SYNCML );
+    QVERIFY( !encoder.encodeToWbXML( noNamespace, SYNCML_1_2, data ) );
+
+    // Unknown element
+    SyncMLCmdObject* message = createMessage();
+    message->addChild( new SyncMLCmdObject( "Unknown" ) );
+    QVERIFY( !encoder.encodeToWbXML( *message, SYNCML_1_2, data ) );
+    delete message;
+
+    // Attribute other than namespace declaration
+    message = createMessage();
+    SyncMLCmdObject* finalObject = new SyncMLCmdObject( SYNCML_ELEMENT_FINAL );
+    finalObject->addAttribute( "attr", "value" );
+    message->addChild( finalObject );
+    QVERIFY( !encoder.encodeToWbXML( *message, SYNCML_1_2, data ) );
+    delete message;
+
+    // Output is left untouched on failure
+    QCOMPARE( data, QByteArray( "data" ) );
+}
+
+void SyncMLCmdObjectTest::benchmarkWbXMLEncoder()
+{
+    SyncMLCmdObject* message = createFullMessage( SYNCML_1_2, BENCHMARK_ITEMS );
+    WbXMLEncoder encoder;
+
+    QBENCHMARK {
+        QByteArray data;
+        encoder.encodeToWbXML( *message, SYNCML_1_2, data );
+    }
+
+    delete message;
+}
+
+void SyncMLCmdObjectTest::benchmarkLibWbXML2Encoder()
+{
+    // Reference for benchmarkWbXMLEncoder()
+    SyncMLCmdObject* message = createFullMessage( SYNCML_1_2, BENCHMARK_ITEMS );
+    LibWbXML2Encoder encoder;
+
+    QBENCHMARK {
+        QByteArray data;
+        encoder.encodeToWbXML( *message, SYNCML_1_2, data );
+    }
+
+    delete message;
+}
+
 QTEST_MAIN(SyncMLCmdObjectTest)
@@ -45,6 +45,14 @@ private slots:
     void testSetGetCData();
     void testAddGetAttribute();
     void testAddGetChildren();
+    void testWbXMLSizeEstimate();
+    void testWbXMLSizeCache();
+    void benchmarkWbXMLSizeEstimate();
+    void benchmarkWbXMLSizeEncode();
+    void testWbXMLEncoder();
+    void testWbXMLEncoderUnsupported();
+    void benchmarkWbXMLEncoder();
+    void benchmarkLibWbXML2Encoder();
 
 };
 #endif // SYNCMLCMDOBJECTTEST_H
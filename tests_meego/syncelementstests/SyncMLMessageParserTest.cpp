@@ -38,11 +38,282 @@
 #include <QBuffer>
 
 #include "SyncMLMessageParser.h"
+#include "SyncMLReader.h"
+#include "WbXMLTokens.h"
 #include "TestUtils.h"
 #include "RemoteDeviceInfo.h"
+#include "datatypes.h"
 
 using namespace DataSync;
 
+namespace {
+
+void appendMbUInt32( QByteArray& aData, quint32 aValue )
+{
+    QByteArray bytes;
+    bytes.prepend( char( aValue & 0x7F ) );
+
+    while( aValue >>= 7 ) {
+        bytes.prepend( char( 0x80 | ( aValue & 0x7F ) ) );
+    }
+
+    aData.append( bytes );
+}
+
+bool encodeDocument( QXmlStreamReader& aReader, WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                     ProtocolVersion aVersion, QByteArray& aData );
+
+// Minimal XML to WbXML converter for the test corpus. Whitespace-only text is
+// dropped, CDATA is written as opaque data and DevInf inside SyncML as an
+// embedded opaque document, like libwbxml2 does.
+bool encodeElement( QXmlStreamReader& aReader, WbXMLSizeEstimator::CodeSpace aDocumentSpace,
+                    WbXMLSizeEstimator::CodeSpace aParentSpace, ProtocolVersion aVersion,
+                    quint8& aPage, QByteArray& aData )
+{
+    WbXMLSizeEstimator::CodeSpace codeSpace = aParentSpace;
+    QXmlStreamAttributes attributes = aReader.attributes();
+    QStringRef ns = attributes.value( XML_NAMESPACE );
+
+    if( ns == QLatin1String( XML_NAMESPACE_VALUE_METINF ) ) {
+        codeSpace = WbXMLSizeEstimator::CODESPACE_METINF;
+    }
+    else if( ns == QLatin1String( XML_NAMESPACE_VALUE_DEVINF ) ) {
+        codeSpace = WbXMLSizeEstimator::CODESPACE_DEVINF;
+    }
+    else if( !ns.isEmpty() ) {
+        codeSpace = WbXMLSizeEstimator::CODESPACE_SYNCML;
+    }
+
+    if( codeSpace == WbXMLSizeEstimator::CODESPACE_DEVINF &&
+        aDocumentSpace != WbXMLSizeEstimator::CODESPACE_DEVINF ) {
+        QByteArray document;
+
+        if( !encodeDocument( aReader, codeSpace, aVersion, document ) ) {
+            return false;
+        }
+
+        aData.append( char( WbXMLTokens::OPAQUE ) );
+        appendMbUInt32( aData, document.size() );
+        aData.append( document );
+        return true;
+    }
+
+    quint8 page = WbXMLTokens::PAGE_SYNCML;
+
+    if( codeSpace == WbXMLSizeEstimator::CODESPACE_METINF ) {
+        page = WbXMLTokens::PAGE_METINF;
+    }
+
+    if( page != aPage ) {
+        aData.append( char( WbXMLTokens::SWITCH_PAGE ) );
+        aData.append( char( page ) );
+        aPage = page;
+    }
+
+    int token = WbXMLTokens::tagToken( codeSpace, aVersion, aReader.name().toString() );
+
+    if( token < 0 ) {
+        qWarning() << "No token for" << aReader.name();
+        return false;
+    }
+
+    int tagPos = aData.size();
+    aData.append( char( token ) );
+
+    while( !aReader.atEnd() ) {
+
+        aReader.readNext();
+
+        if( aReader.isStartElement() ) {
+            aData[tagPos] = char( token | WbXMLTokens::TAG_CONTENT );
+
+            if( !encodeElement( aReader, aDocumentSpace, codeSpace, aVersion, aPage, aData ) ) {
+                return false;
+            }
+        }
+        else if( aReader.isCDATA() ) {
+            QByteArray text = aReader.text().toUtf8();
+            aData[tagPos] = char( token | WbXMLTokens::TAG_CONTENT );
+            aData.append( char( WbXMLTokens::OPAQUE ) );
+            appendMbUInt32( aData, text.size() );
+            aData.append( text );
+        }
+        else if( aReader.isCharacters() && !aReader.isWhitespace() ) {
+            aData[tagPos] = char( token | WbXMLTokens::TAG_CONTENT );
+            aData.append( char( WbXMLTokens::STR_I ) );
+            aData.append( aReader.text().toUtf8() );
+            aData.append( '\0' );
+        }
+        else if( aReader.isEndElement() ) {
+            if( aData.at( tagPos ) & WbXMLTokens::TAG_CONTENT ) {
+                aData.append( char( WbXMLTokens::END ) );
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool encodeDocument( QXmlStreamReader& aReader, WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                     ProtocolVersion aVersion, QByteArray& aData )
+{
+    aData.append( char( WbXMLTokens::WBXML_VERSION ) );
+    appendMbUInt32( aData, WbXMLTokens::publicId( aCodeSpace, aVersion ) );
+    appendMbUInt32( aData, WbXMLTokens::CHARSET_UTF8 );
+    aData.append( char( 0 ) );
+
+    quint8 page = 0;
+    return encodeElement( aReader, aCodeSpace, aCodeSpace, aVersion, page, aData );
+}
+
+bool xmlToWbXML( const QByteArray& aXML, WbXMLSizeEstimator::CodeSpace aCodeSpace,
+                 ProtocolVersion aVersion, QByteArray& aWbXML )
+{
+    QXmlStreamReader reader( aXML );
+
+    while( !reader.atEnd() ) {
+        if( reader.readNext() == QXmlStreamReader::StartElement ) {
+            return encodeDocument( reader, aCodeSpace, aVersion, aWbXML );
+        }
+    }
+
+    return false;
+}
+
+// Elements and text read from a document, adjacent text combined and
+// whitespace-only text dropped
+QStringList readTokens( const QByteArray& aData, bool& aWbXML )
+{
+    QByteArray data( aData );
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+
+    SyncMLReader reader;
+    reader.setDevice( &buffer );
+    reader.setNamespaceProcessing( false );
+    aWbXML = reader.isWbXML();
+
+    QStringList tokens;
+    QString text;
+
+    while( !reader.atEnd() ) {
+
+        reader.readNext();
+
+        if( reader.isCharacters() ) {
+            text.append( reader.text() );
+            continue;
+        }
+
+        if( !text.trimmed().isEmpty() ) {
+            tokens.append( "T:" + text );
+        }
+        text.clear();
+
+        if( reader.isStartElement() ) {
+            tokens.append( "S:" + reader.name().toString() );
+        }
+        else if( reader.isEndElement() ) {
+            tokens.append( "E:" + reader.name().toString() );
+        }
+    }
+
+    if( reader.error() != QXmlStreamReader::NoError ) {
+        tokens.append( "ERROR" );
+    }
+
+    return tokens;
+}
+
+QList<int> parseFragmentTypes( const QByteArray& aData, int& aErrors )
+{
+    QByteArray data( aData );
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+
+    SyncMLMessageParser parser;
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+    parser.parseResponse( &buffer, true );
+    aErrors = errorSpy.count();
+
+    QList<Fragment*> fragments = parser.takeFragments();
+    QList<int> types;
+
+    foreach( Fragment* fragment, fragments ) {
+        types.append( fragment->fragmentType );
+    }
+
+    qDeleteAll( fragments );
+    return types;
+}
+
+// Parses data in parts of given size. Fragments made available before the
+// last part are counted separately
+QList<int> parseFragmentTypesInParts( const QByteArray& aData, int aPartSize,
+                                      int& aErrors, int& aEarlyFragments )
+{
+    SyncMLMessageParser parser;
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+    QSignalSpy completeSpy( &parser, SIGNAL(parsingComplete(bool)) );
+
+    QList<Fragment*> fragments;
+
+    for( int pos = 0; pos < aData.size(); pos += aPartSize ) {
+        parser.parseResponsePart( aData.mid( pos, aPartSize ), pos == 0,
+                                  pos + aPartSize >= aData.size() );
+
+        if( completeSpy.isEmpty() && errorSpy.isEmpty() ) {
+            fragments.append( parser.takeFragments() );
+        }
+    }
+
+    aEarlyFragments = fragments.count();
+    aErrors = errorSpy.count();
+
+    fragments.append( parser.takeFragments() );
+
+    QList<int> types;
+
+    foreach( Fragment* fragment, fragments ) {
+        types.append( fragment->fragmentType );
+    }
+
+    qDeleteAll( fragments );
+    return types;
+}
+
+// Message with a header followed by a large Sync element
+QByteArray createLargeMessage( int aItems )
+{
+    QByteArray data;
+    QByteArray itemData( 1024, 'x' );
+
+    data.append( "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<SyncML>\n<SyncHdr>\n"
+                 "<VerDTD>1.2</VerDTD><VerProto>SyncML/1.2</VerProto>"
+                 "<SessionID>1</SessionID><MsgID>2</MsgID>"
+                 "<Target><LocURI>IMEI:493005100592800</LocURI></Target>"
+                 "<Source><LocURI>http://www.syncml.org/sync-server</LocURI></Source>\n"
+                 "</SyncHdr>\n<SyncBody>\n"
+                 "<Status><CmdID>1</CmdID><MsgRef>1</MsgRef><CmdRef>0</CmdRef>"
+                 "<Cmd>SyncHdr</Cmd><Data>200</Data></Status>\n"
+                 "<Sync><CmdID>2</CmdID><Target><LocURI>./contacts</LocURI></Target>"
+                 "<Source><LocURI>./dev-contacts</LocURI></Source>\n" );
+
+    for( int i = 0; i < aItems; ++i ) {
+        data.append( "<Add><CmdID>" + QByteArray::number( i + 3 ) + "</CmdID>"
+                     "<Meta><Type xmlns=\"syncml:metinf\">text/x-vcard</Type></Meta>"
+                     "<Item><Source><LocURI>" + QByteArray::number( i ) + "</LocURI></Source>"
+                     "<Data>" + itemData + "</Data></Item></Add>\n" );
+    }
+
+    data.append( "</Sync>\n<Final/>\n</SyncBody>\n</SyncML>\n" );
+
+    return data;
+}
+
+}
+
 void SyncMLMessageParserTest::testResp1()
 {
 
@@ -244,7 +515,7 @@ void SyncMLMessageParserTest::verifyAdd( const DataSync::CommandParams& aData )
     QCOMPARE(aData.items.count(), 1 );
     QCOMPARE(aData.items[0].source, QString( "0" ) );
     QCOMPARE(aData.items[0].sourceParent, QString( "1" ) );
-    QCOMPARE(aData.items[0].data.simplified(), QString( "BEGIN:VCARD VERSION:2.1 N:Lahtela;Tatu;;; FN:Lahtela, Tatu TEL;TYPE=PREF:+35840 7532165 EMAIL;INTERNET:tatu.lahtela TITLE: ORG:; END:VCARD") );
+    QCOMPARE(aData.items[0].data.simplified(), QByteArray( "BEGIN:VCARD VERSION:2.1 N:Lahtela;Tatu;;; FN:Lahtela, Tatu TEL;TYPE=PREF:+35840 7532165 EMAIL;INTERNET:tatu.lahtela TITLE: ORG:; END:VCARD") );
 }
 
 void SyncMLMessageParserTest::verifyReplace( const DataSync::CommandParams& aData )
@@ -254,7 +525,7 @@ void SyncMLMessageParserTest::verifyReplace( const DataSync::CommandParams& aDat
     QCOMPARE(aData.items.count(), 1);
     QCOMPARE(aData.items.at(0).target,QString("244"));
     QCOMPARE(aData.items.at(0).targetParent,QString("245"));
-    QCOMPARE(aData.items.at(0).data,QString("ReplaceData"));
+    QCOMPARE(aData.items.at(0).data,QByteArray("ReplaceData"));
 }
 
 
@@ -551,4 +822,254 @@ void SyncMLMessageParserTest::testEmbeddedXML()
     QCOMPARE( status->items.first().data, expected );
 }
 
+void SyncMLMessageParserTest::testWbXMLEquivalence_data()
+{
+    QTest::addColumn<QString>( "file" );
+    QTest::addColumn<int>( "codeSpace" );
+    QTest::addColumn<int>( "version" );
+
+    const int syncml = WbXMLSizeEstimator::CODESPACE_SYNCML;
+    const int devinf = WbXMLSizeEstimator::CODESPACE_DEVINF;
+
+    QTest::newRow( "resp" ) << "data/resp.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "resp2" ) << "data/resp2.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "subcommands01" ) << "data/subcommands01.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "cmdhandler_get" ) << "data/cmdhandler_get.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "cmdhandler_put" ) << "data/cmdhandler_put.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "basicbasetransport" ) << "data/basicbasetransport.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "transport_initrequest" ) << "data/transport_initrequest_nohdr.txt" << syncml << int( SYNCML_1_2 );
+    QTest::newRow( "syncml_init" ) << "data/syncml_init.txt" << syncml << int( SYNCML_1_1 );
+    QTest::newRow( "syncml_resp" ) << "data/syncml_resp.txt" << syncml << int( SYNCML_1_1 );
+    QTest::newRow( "syncml_resp2" ) << "data/syncml_resp2.txt" << syncml << int( SYNCML_1_1 );
+    QTest::newRow( "syncml_resp3" ) << "data/syncml_resp3.txt" << syncml << int( SYNCML_1_1 );
+    QTest::newRow( "syncml_resp4" ) << "data/syncml_resp4.txt" << syncml << int( SYNCML_1_1 );
+    QTest::newRow( "syncml_resp5" ) << "data/syncml_resp5.txt" << syncml << int( SYNCML_1_1 );
+    QTest::newRow( "devinf01" ) << "data/devinf01.txt" << devinf << int( SYNCML_1_1 );
+    QTest::newRow( "devinf02" ) << "data/devinf02.txt" << devinf << int( SYNCML_1_2 );
+}
+
+void SyncMLMessageParserTest::testWbXMLEquivalence()
+{
+    QFETCH( QString, file );
+    QFETCH( int, codeSpace );
+    QFETCH( int, version );
+
+    QByteArray xml;
+    QVERIFY( readFile( file, xml ) );
+
+    QByteArray wbxml;
+    QVERIFY( xmlToWbXML( xml, static_cast<WbXMLSizeEstimator::CodeSpace>( codeSpace ),
+                         static_cast<ProtocolVersion>( version ), wbxml ) );
+    QCOMPARE( WbXMLReader::isSyncMLDocument( wbxml ), codeSpace == WbXMLSizeEstimator::CODESPACE_SYNCML );
+
+    bool isWbXML = true;
+    QStringList xmlTokens = readTokens( xml, isWbXML );
+    QVERIFY( !isWbXML );
+
+    QStringList wbxmlTokens = readTokens( wbxml, isWbXML );
+    QVERIFY( isWbXML );
+
+    QVERIFY( !xmlTokens.contains( "ERROR" ) );
+    QCOMPARE( wbxmlTokens, xmlTokens );
+
+    if( codeSpace == WbXMLSizeEstimator::CODESPACE_SYNCML ) {
+        int xmlErrors = 0;
+        int wbxmlErrors = 0;
+        QList<int> xmlFragments = parseFragmentTypes( xml, xmlErrors );
+        QList<int> wbxmlFragments = parseFragmentTypes( wbxml, wbxmlErrors );
+
+        QCOMPARE( wbxmlErrors, xmlErrors );
+        QCOMPARE( wbxmlFragments, xmlFragments );
+    }
+}
+
+void SyncMLMessageParserTest::testWbXMLLibWbXML2Output()
+{
+    // Message encoded by libwbxml2
+    QByteArray wbxml;
+    QVERIFY( readFile( "data/basicbasetransport.bin", wbxml ) );
+    QVERIFY( WbXMLReader::isSyncMLDocument( wbxml ) );
+
+    QByteArray xml;
+    QVERIFY( readFile( "data/basicbasetransport.txt", xml ) );
+
+    bool isWbXML = false;
+    QStringList wbxmlTokens = readTokens( wbxml, isWbXML );
+    QVERIFY( isWbXML );
+
+    QCOMPARE( wbxmlTokens, readTokens( xml, isWbXML ) );
+
+    // Truncated message
+    isWbXML = false;
+    QStringList truncatedTokens = readTokens( wbxml.left( wbxml.size() - 2 ), isWbXML );
+    QVERIFY( isWbXML );
+    QCOMPARE( truncatedTokens.last(), QString( "ERROR" ) );
+
+    int errors = 0;
+    parseFragmentTypes( wbxml.left( wbxml.size() - 2 ), errors );
+    QCOMPARE( errors, 1 );
+
+    // SAN messages are not SyncML WbXML documents
+    QByteArray san;
+    QVERIFY( readFile( "data/SAN01.bin", san ) );
+    QVERIFY( !WbXMLReader::isSyncMLDocument( san ) );
+}
+
+void SyncMLMessageParserTest::testParseInParts_data()
+{
+    QTest::addColumn<QString>( "file" );
+    QTest::addColumn<int>( "version" );
+    QTest::addColumn<bool>( "wbxml" );
+    QTest::addColumn<int>( "partSize" );
+
+    QStringList files;
+    files << "data/resp.txt" << "data/resp2.txt" << "data/subcommands01.txt"
+          << "data/cmdhandler_put.txt" << "data/syncml_resp.txt" << "data/syncml_resp4.txt";
+
+    QList<int> partSizes;
+    partSizes << 1 << 7 << 64 << 100000;
+
+    foreach( const QString& file, files ) {
+
+        int version = file.contains( "syncml_" ) ? SYNCML_1_1 : SYNCML_1_2;
+
+        foreach( int partSize, partSizes ) {
+            QByteArray name = QString( "%1 %2" ).arg( file ).arg( partSize ).toLatin1();
+            QTest::newRow( ( "xml " + name ).constData() ) << file << version << false << partSize;
+            QTest::newRow( ( "wbxml " + name ).constData() ) << file << version << true << partSize;
+        }
+    }
+}
+
+void SyncMLMessageParserTest::testParseInParts()
+{
+    QFETCH( QString, file );
+    QFETCH( int, version );
+    QFETCH( bool, wbxml );
+    QFETCH( int, partSize );
+
+    QByteArray data;
+    QVERIFY( readFile( file, data ) );
+
+    if( wbxml ) {
+        QByteArray xml = data;
+        data.clear();
+        QVERIFY( xmlToWbXML( xml, WbXMLSizeEstimator::CODESPACE_SYNCML,
+                             static_cast<ProtocolVersion>( version ), data ) );
+    }
+
+    int errors = 0;
+    QList<int> expected = parseFragmentTypes( data, errors );
+    QCOMPARE( errors, 0 );
+
+    int earlyFragments = 0;
+    QList<int> fragments = parseFragmentTypesInParts( data, partSize, errors, earlyFragments );
+    QCOMPARE( errors, 0 );
+    QCOMPARE( fragments, expected );
+
+    if( partSize < data.size() / 2 ) {
+        // At least header is available before the whole message
+        QVERIFY( earlyFragments > 0 );
+        QCOMPARE( fragments.first(), int( Fragment::FRAGMENT_HEADER ) );
+    }
+    else if( partSize >= data.size() ) {
+        QCOMPARE( earlyFragments, 0 );
+    }
+}
+
+void SyncMLMessageParserTest::testParseInPartsErrors()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    // Truncated message reports a single error at the end, and fragments
+    // that were not taken before it are discarded
+    QByteArray truncated = data.left( data.size() - 20 );
+    int errors = 0;
+    int earlyFragments = 0;
+    QList<int> fragments = parseFragmentTypesInParts( truncated, 16, errors, earlyFragments );
+    QCOMPARE( errors, 1 );
+    QCOMPARE( fragments.count(), earlyFragments );
+
+    // Invalid characters are reported so that the message can be purged and
+    // parsed again. Fragments that were taken already are not returned again.
+    QByteArray invalid = data;
+    invalid.insert( invalid.lastIndexOf( "</SyncBody>" ), '\x01' );
+
+    SyncMLMessageParser parser;
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+    QSignalSpy completeSpy( &parser, SIGNAL(parsingComplete(bool)) );
+
+    int half = invalid.size() / 2;
+    parser.parseResponsePart( invalid.left( half ), true, false );
+    QList<Fragment*> taken = parser.takeFragments();
+    QVERIFY( !taken.isEmpty() );
+
+    parser.parseResponsePart( invalid.mid( half ), false, true );
+    QCOMPARE( errorSpy.count(), 1 );
+    QCOMPARE( errorSpy.first().first().value<DataSync::ParserError>(), PARSER_ERROR_INVALID_CHARS );
+    QVERIFY( parser.takeFragments().isEmpty() );
+
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+    parser.parseResponse( &buffer, false );
+    QCOMPARE( completeSpy.count(), 1 );
+
+    errors = 0;
+    QList<int> expected = parseFragmentTypes( data, errors );
+    QList<Fragment*> rest = parser.takeFragments();
+    QCOMPARE( taken.count() + rest.count(), expected.count() );
+    QCOMPARE( int( rest.last()->fragmentType ), expected.last() );
+
+    qDeleteAll( taken );
+    qDeleteAll( rest );
+
+    // Parts that do not belong to a started message are ignored
+    errorSpy.clear();
+    parser.parseResponsePart( data, false, true );
+    QCOMPARE( errorSpy.count(), 0 );
+    QVERIFY( parser.takeFragments().isEmpty() );
+}
+
+void SyncMLMessageParserTest::benchmarkTimeToFirstFragment_data()
+{
+    QTest::addColumn<bool>( "inParts" );
+
+    QTest::newRow( "whole message" ) << false;
+    QTest::newRow( "in parts" ) << true;
+}
+
+void SyncMLMessageParserTest::benchmarkTimeToFirstFragment()
+{
+    QFETCH( bool, inParts );
+
+    // About 2 MB message, received in parts of 16 kB
+    const int partSize = 16 * 1024;
+    QByteArray data = createLargeMessage( 2000 );
+
+    QBENCHMARK {
+
+        SyncMLMessageParser parser;
+        QList<Fragment*> fragments;
+
+        if( inParts ) {
+            for( int pos = 0; pos < data.size() && fragments.isEmpty(); pos += partSize ) {
+                parser.parseResponsePart( data.mid( pos, partSize ), pos == 0,
+                                          pos + partSize >= data.size() );
+                fragments = parser.takeFragments();
+            }
+        }
+        else {
+            QBuffer buffer( &data );
+            buffer.open( QIODevice::ReadOnly );
+            parser.parseResponse( &buffer, true );
+            fragments = parser.takeFragments();
+        }
+
+        QVERIFY( !fragments.isEmpty() );
+        QCOMPARE( int( fragments.first()->fragmentType ), int( Fragment::FRAGMENT_HEADER ) );
+        qDeleteAll( fragments );
+    }
+}
+
 QTEST_MAIN(SyncMLMessageParserTest)
@@ -50,6 +50,14 @@ private slots:
     void testDevInf12();
     void testSubcommands();
     void testEmbeddedXML();
+    void testWbXMLEquivalence_data();
+    void testWbXMLEquivalence();
+    void testWbXMLLibWbXML2Output();
+    void testParseInParts_data();
+    void testParseInParts();
+    void testParseInPartsErrors();
+    void benchmarkTimeToFirstFragment_data();
+    void benchmarkTimeToFirstFragment();
 
 private:
     void verifyAdd( const DataSync::CommandParams& aData );
@@ -9,6 +9,7 @@ SUBDIRS = \
     servertests \
     syncelementstests \
     transporttests \
+    benchmarks \
 
 OTHER_FILES += \
     data/transport_initrequest_nohdr.txt \
@@ -62,6 +62,7 @@ void BaseTransportTest::testBasicXMLSend()
 
     QSignalSpy sendEvent( &transport, SIGNAL( sendEvent( DataSync::TransportStatusEvent, const QString& ) ) );
     QSignalSpy readData( &transport, SIGNAL( readXMLData( QIODevice*, bool ) ) );
+    QSignalSpy messageSent( &transport, SIGNAL( messageSent( qint64, qint64 ) ) );
 
     transport.setWbXml( false );
 
@@ -89,6 +90,10 @@ void BaseTransportTest::testBasicXMLSend()
     QVERIFY( transport.iContentType == SYNCML_CONTTYPE_XML );
     QVERIFY( transport.iData == correctOutput );
 
+    QCOMPARE( messageSent.count(), 1 );
+    QCOMPARE( messageSent.at(0).at(0).toLongLong(), qint64( correctOutput.size() ) );
+    QVERIFY( messageSent.at(0).at(1).toLongLong() >= 0 );
+
 }
 
 
@@ -98,6 +103,7 @@ void BaseTransportTest::testBasicXMLReceive()
 
     QSignalSpy sendEvent( &transport, SIGNAL( sendEvent( DataSync::TransportStatusEvent, const QString& ) ) );
     QSignalSpy readData( &transport, SIGNAL( readXMLData( QIODevice*, bool ) ) );
+    QSignalSpy messageReceived( &transport, SIGNAL( messageReceived( qint64 ) ) );
 
     transport.setWbXml( false );
 
@@ -108,6 +114,8 @@ void BaseTransportTest::testBasicXMLReceive()
 
     QVERIFY( sendEvent.count() == 0 );
     QVERIFY( readData.count() == 1 );
+    QCOMPARE( messageReceived.count(), 1 );
+    QCOMPARE( messageReceived.at(0).at(0).toLongLong(), qint64( transport.iData.size() ) );
 
     QIODevice* dev = qvariant_cast<QIODevice*>( readData.at(0).at(0) );
 
@@ -256,4 +264,96 @@ void BaseTransportTest::testSANReceive02()
 
 }
 
+
+void BaseTransportTest::testRemoveInvalidXMLChars()
+{
+    QByteArray empty;
+    QCOMPARE( BaseTransport::removeInvalidXMLChars( empty ), 0 );
+    QVERIFY( empty.isEmpty() );
+
+    // Valid data is not modified or detached
+    QByteArray valid( "<Data>a,b\tc\r\nd \xc3\xa4</Data>" );
+    QByteArray copy( valid );
+    QCOMPARE( BaseTransport::removeInvalidXMLChars( copy ), 0 );
+    QCOMPARE( copy, valid );
+    QVERIFY( copy.constData() == valid.constData() );
+
+    // Invalid characters at start, end and across word boundaries
+    QByteArray data( "\x01<SyncML>\x00\x02<Data>x\x1F\x0By\xc3\xa4</Data>\x0C\x0E</SyncML>\x08", 42 );
+    QCOMPARE( BaseTransport::removeInvalidXMLChars( data ), 8 );
+    QCOMPARE( data, QByteArray( "<SyncML><Data>xy\xc3\xa4</Data></SyncML>" ) );
+
+    QByteArray invalid( 100, '\x01' );
+    QCOMPARE( BaseTransport::removeInvalidXMLChars( invalid ), 100 );
+    QVERIFY( invalid.isEmpty() );
+}
+
+void BaseTransportTest::testEagerXMLSanitizing()
+{
+    TestTransport transport( true );
+
+    QSignalSpy readData( &transport, SIGNAL( readXMLData( QIODevice*, bool ) ) );
+
+    transport.setWbXml( false );
+    transport.setEagerXMLSanitizing( true );
+
+    QByteArray expected;
+    QVERIFY( readFile( "data/basicbasetransport.txt", expected ) );
+
+    transport.iContentType = SYNCML_CONTTYPE_XML;
+    transport.iData = expected;
+    transport.iData.insert( transport.iData.indexOf( "</SyncHdr>" ), "\x01\x02" );
+
+    QVERIFY( transport.receive() == true );
+    QCOMPARE( readData.count(), 1 );
+
+    QIODevice* dev = qvariant_cast<QIODevice*>( readData.at(0).at(0) );
+    QCOMPARE( dev->readAll(), expected );
+}
+
+void BaseTransportTest::testPurgeAndResendBuffer()
+{
+    TestTransport transport( true );
+
+    QSignalSpy readData( &transport, SIGNAL( readXMLData( QIODevice*, bool ) ) );
+
+    transport.setWbXml( false );
+
+    QByteArray expected;
+    QVERIFY( readFile( "data/basicbasetransport.txt", expected ) );
+
+    transport.iContentType = SYNCML_CONTTYPE_XML;
+    transport.iData = expected;
+    transport.iData.insert( transport.iData.indexOf( "</SyncHdr>" ), '\x00' );
+
+    // Invalid characters are kept until parser asks for purging
+    QVERIFY( transport.receive() == true );
+    QCOMPARE( readData.count(), 1 );
+    QCOMPARE( qvariant_cast<QIODevice*>( readData.at(0).at(0) )->readAll(), transport.iData );
+
+    QVERIFY( QMetaObject::invokeMethod( &transport, "purgeAndResendBuffer" ) );
+    QCOMPARE( readData.count(), 2 );
+    QCOMPARE( readData.at(1).at(1).toBool(), false );
+    QCOMPARE( qvariant_cast<QIODevice*>( readData.at(1).at(0) )->readAll(), expected );
+}
+
+void BaseTransportTest::benchmarkRemoveInvalidXMLChars()
+{
+    QByteArray message;
+    QVERIFY( readFile( "data/basicbasetransport.txt", message ) );
+
+    // About 1 MB of data with an invalid character in every message
+    QByteArray data;
+
+    while( data.size() < 1024 * 1024 ) {
+        data.append( message );
+        data.append( '\x0B' );
+    }
+
+    QBENCHMARK {
+        QByteArray copy( data );
+        BaseTransport::removeInvalidXMLChars( copy );
+    }
+}
+
 QTEST_MAIN(BaseTransportTest)
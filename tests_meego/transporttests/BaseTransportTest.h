@@ -53,6 +53,11 @@ private slots:
     void testSANReceive01();
     void testSANReceive02();
 
+    void testRemoveInvalidXMLChars();
+    void testEagerXMLSanitizing();
+    void testPurgeAndResendBuffer();
+    void benchmarkRemoveInvalidXMLChars();
+
 };
 
 #endif  //  BASETRANSPORTTEST_H
@@ -0,0 +1,484 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "HTTPServerTransportTest.h"
+
+#include "SyncMLMessage.h"
+#include "HTTPServer.h"
+#include "HTTPServerTransport.h"
+#include "HTTPTransport.h"
+#include "HTTPContentEncoder.h"
+#include "SyncAgentConfigProperties.h"
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QtTest>
+
+using namespace DataSync;
+
+Q_DECLARE_METATYPE(QIODevice*);
+
+static QByteArray createRequestBody(const QByteArray& aSessionId, const QByteArray& aSource, int aMsgId)
+{
+    return "<?xml version=\"1.0\"?><SyncML><SyncHdr><VerDTD>1.2</VerDTD>"
+           "<VerProto>SyncML/1.2</VerProto><SessionID>" + aSessionId + "</SessionID>"
+           "<MsgID>" + QByteArray::number(aMsgId) + "</MsgID>"
+           "<Target><LocURI>server</LocURI></Target>"
+           "<Source><LocURI>" + aSource + "</LocURI></Source></SyncHdr>"
+           "<SyncBody><Final/></SyncBody></SyncML>";
+}
+
+static QByteArray createRequest(const QByteArray& aBody, const QByteArray& aHeaders = QByteArray())
+{
+    return "POST /sync HTTP/1.1\r\n"
+           "Host: localhost\r\n"
+           "Content-Type: " SYNCML_CONTTYPE_DS_XML "\r\n"
+           "Content-Length: " + QByteArray::number(aBody.size()) + "\r\n" +
+           aHeaders +
+           "\r\n" +
+           aBody;
+}
+
+static SyncMLMessage* createMessage(const QString& aSessionId, const QString& aSource, int aMsgId)
+{
+    HeaderParams params;
+
+    params.verDTD = SYNCML_DTD_VERSION_1_2;
+    params.verProto = DS_VERPROTO_1_2;
+    params.sessionID = aSessionId;
+    params.msgID = aMsgId;
+    params.targetDevice = "server";
+    params.sourceDevice = aSource;
+
+    return new SyncMLMessage(params, SYNCML_1_2);
+}
+
+static QByteArray headerValue(const QByteArray& aHeaders, const QByteArray& aName)
+{
+    QList<QByteArray> lines = aHeaders.split('\n');
+
+    foreach (const QByteArray& line, lines) {
+        int colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == aName.toLower()) {
+            return line.mid(colon + 1).trimmed();
+        }
+    }
+
+    return QByteArray();
+}
+
+static int statusCode(const QByteArray& aHeaders)
+{
+    return aHeaders.split(' ').value(1).toInt();
+}
+
+// Reads a response while letting the server in the same thread process events
+static bool readResponse(QTcpSocket& aSocket, QByteArray& aHeaders, QByteArray& aBody)
+{
+    QByteArray data;
+    QElapsedTimer timer;
+    timer.start();
+
+    while (timer.elapsed() < 5000) {
+
+        data.append(aSocket.readAll());
+
+        int headerEnd = data.indexOf("\r\n\r\n");
+
+        if (headerEnd >= 0) {
+            int length = headerValue(data.left(headerEnd), "Content-Length").toInt();
+
+            if (data.size() >= headerEnd + 4 + length) {
+                aHeaders = data.left(headerEnd);
+                aBody = data.mid(headerEnd + 4, length);
+                return true;
+            }
+        }
+
+        QTest::qWait(10);
+    }
+
+    return false;
+}
+
+static int sendRequest(quint16 aPort, const QByteArray& aRequest, QByteArray& aHeaders)
+{
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, aPort);
+
+    if (!client.waitForConnected(5000)) {
+        return 0;
+    }
+
+    client.write(aRequest);
+
+    QByteArray body;
+
+    if (!readResponse(client, aHeaders, body)) {
+        return 0;
+    }
+
+    return statusCode(aHeaders);
+}
+
+void HTTPServerTransportTest::testSessionKey()
+{
+    QCOMPARE(HTTPServer::sessionKey(createRequestBody("12", "IMEI:1234", 1)), QString("IMEI:1234#12"));
+
+    // Elements with same names outside of header are not used
+    QByteArray body = createRequestBody("12", "IMEI:1234", 1);
+    body.replace("<Target><LocURI>server</LocURI></Target>", "");
+    QCOMPARE(HTTPServer::sessionKey(body), QString("IMEI:1234#12"));
+
+    QVERIFY(HTTPServer::sessionKey(createRequestBody("", "IMEI:1234", 1)).isEmpty());
+    QVERIFY(HTTPServer::sessionKey(createRequestBody("12", "", 1)).isEmpty());
+    QVERIFY(HTTPServer::sessionKey("not a SyncML message").isEmpty());
+}
+
+void HTTPServerTransportTest::testRequestResponse()
+{
+    HTTPServerTransport transport;
+    transport.setProperty(HTTPSERVERADDRESSPROP, "127.0.0.1");
+    transport.setProperty(HTTPSERVERPORTPROP, "0");
+    QVERIFY(transport.init());
+    QVERIFY(transport.server().isListening());
+
+    QSignalSpy readData(&transport, SIGNAL(readXMLData(QIODevice*, bool)));
+    QVERIFY(transport.receive());
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, transport.server().serverPort());
+    QVERIFY(client.waitForConnected(5000));
+
+    QByteArray body = createRequestBody("1", "IMEI:1234", 1);
+    client.write(createRequest(body));
+    QTRY_COMPARE(readData.count(), 1);
+
+    QIODevice* device = readData.at(0).at(0).value<QIODevice*>();
+    QVERIFY(device);
+    QCOMPARE(device->readAll(), body);
+
+    QVERIFY(transport.sendSyncML(createMessage("1", "server", 1)));
+
+    QByteArray headers;
+    QByteArray response;
+    QVERIFY(readResponse(client, headers, response));
+    QCOMPARE(statusCode(headers), 200);
+    QCOMPARE(headerValue(headers, HTTP_HDRSTR_CONTENT_TYPE), QByteArray(SYNCML_CONTTYPE_DS_XML));
+    QCOMPARE(headerValue(headers, HTTP_HDRSTR_CONNECTION), QByteArray("keep-alive"));
+    QVERIFY(response.contains("<SyncML"));
+
+    // Next message of the session comes on the same connection
+    QVERIFY(transport.receive());
+    client.write(createRequest(createRequestBody("1", "IMEI:1234", 2)));
+    QTRY_COMPARE(readData.count(), 2);
+
+    QVERIFY(transport.sendSyncML(createMessage("1", "server", 2)));
+    QVERIFY(readResponse(client, headers, response));
+    QCOMPARE(statusCode(headers), 200);
+    QVERIFY(response.contains("<MsgID>2</MsgID>"));
+    QCOMPARE(client.state(), QAbstractSocket::ConnectedState);
+
+    // Nothing to respond to
+    SyncMLMessage* message = createMessage("1", "server", 3);
+    QVERIFY(!transport.sendSyncML(message));
+    delete message;
+
+    // Client asking to close the connection
+    QVERIFY(transport.receive());
+    client.write(createRequest(createRequestBody("1", "IMEI:1234", 3), "Connection: close\r\n"));
+    QTRY_COMPARE(readData.count(), 3);
+
+    QVERIFY(transport.sendSyncML(createMessage("1", "server", 3)));
+    QVERIFY(readResponse(client, headers, response));
+    QCOMPARE(headerValue(headers, HTTP_HDRSTR_CONNECTION), QByteArray("close"));
+    QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+
+    transport.close();
+}
+
+void HTTPServerTransportTest::testInvalidRequests()
+{
+    HTTPServerTransport transport;
+    transport.setProperty(HTTPSERVERADDRESSPROP, "127.0.0.1");
+    QVERIFY(transport.init());
+
+    QSignalSpy readData(&transport, SIGNAL(readXMLData(QIODevice*, bool)));
+    QVERIFY(transport.receive());
+
+    quint16 port = transport.server().serverPort();
+    QByteArray body = createRequestBody("1", "IMEI:1234", 1);
+    QByteArray headers;
+
+    QCOMPARE(sendRequest(port, "GET /sync HTTP/1.1\r\nHost: localhost\r\n\r\n", headers), 405);
+    QCOMPARE(headerValue(headers, "Allow"), QByteArray("POST"));
+
+    QByteArray request = createRequest(body);
+    request.replace("Content-Length", "X-Length");
+    QCOMPARE(sendRequest(port, request, headers), 411);
+
+    request = createRequest(body);
+    request.replace(SYNCML_CONTTYPE_DS_XML, "text/plain");
+    QCOMPARE(sendRequest(port, request, headers), 415);
+
+    QCOMPARE(sendRequest(port, createRequest(body, "Content-Encoding: br\r\n"), headers), 415);
+
+    QCOMPARE(sendRequest(port, createRequest(createRequestBody("", "IMEI:1234", 1)), headers), 400);
+
+    QCOMPARE(sendRequest(port, "POST /sync\r\n\r\n", headers), 400);
+
+    // Compressed body within the limit that inflates beyond it
+    HTTPContentEncoder encoder;
+    QByteArray bomb;
+    QVERIFY(encoder.encode(QByteArray(1024 * 1024, 'a'), bomb));
+    transport.server().setMaxRequestSize(64 * 1024);
+    QVERIFY(bomb.size() < 64 * 1024);
+    QCOMPARE(sendRequest(port, createRequest(bomb, "Content-Encoding: gzip\r\n"), headers), 413);
+
+    transport.server().setMaxRequestSize(10);
+    QCOMPARE(sendRequest(port, createRequest(body), headers), 413);
+    QCOMPARE(headerValue(headers, HTTP_HDRSTR_CONNECTION), QByteArray("close"));
+
+    QCOMPARE(readData.count(), 0);
+}
+
+void HTTPServerTransportTest::testPipelinedRequestLimit()
+{
+    HTTPServerTransport transport;
+    transport.setProperty(HTTPSERVERADDRESSPROP, "127.0.0.1");
+    QVERIFY(transport.init());
+    transport.server().setMaxRequestSize(1024);
+
+    QSignalSpy readData(&transport, SIGNAL(readXMLData(QIODevice*, bool)));
+    QVERIFY(transport.receive());
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, transport.server().serverPort());
+    QVERIFY(client.waitForConnected(5000));
+
+    // First request is being served, so data that follows it is buffered
+    client.write(createRequest(createRequestBody("1", "IMEI:1234", 1)));
+    QTRY_COMPARE(readData.count(), 1);
+
+    // Connection is closed once buffered data exceeds the largest accepted request
+    client.write(QByteArray(64 * 1024, 'x'));
+    QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+
+    transport.close();
+}
+
+void HTTPServerTransportTest::testConcurrentSessions()
+{
+    HTTPServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    HTTPServerTransport first(server);
+    HTTPServerTransport second(server);
+    QVERIFY(first.init());
+    QVERIFY(second.init());
+
+    QSignalSpy firstData(&first, SIGNAL(readXMLData(QIODevice*, bool)));
+    QSignalSpy secondData(&second, SIGNAL(readXMLData(QIODevice*, bool)));
+    QVERIFY(first.receive());
+    QVERIFY(second.receive());
+
+    QTcpSocket firstClient;
+    firstClient.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(firstClient.waitForConnected(5000));
+
+    QTcpSocket secondClient;
+    secondClient.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(secondClient.waitForConnected(5000));
+
+    firstClient.write(createRequest(createRequestBody("1", "IMEI:1", 1)));
+    QTRY_COMPARE(firstData.count(), 1);
+
+    secondClient.write(createRequest(createRequestBody("1", "IMEI:2", 1)));
+    QTRY_COMPARE(secondData.count(), 1);
+    QCOMPARE(firstData.count(), 1);
+
+    // No transport left for third session
+    QByteArray headers;
+    QByteArray response;
+    QCOMPARE(sendRequest(server.serverPort(), createRequest(createRequestBody("1", "IMEI:3", 1)), headers), 503);
+    QVERIFY(!headerValue(headers, "Retry-After").isEmpty());
+
+    // Responses go to the connections of the sessions
+    QVERIFY(second.sendSyncML(createMessage("1", "second", 1)));
+    QVERIFY(readResponse(secondClient, headers, response));
+    QVERIFY(response.contains("second"));
+
+    QVERIFY(first.sendSyncML(createMessage("1", "first", 1)));
+    QVERIFY(readResponse(firstClient, headers, response));
+    QVERIFY(response.contains("first"));
+
+    // Session of a closed transport is over, so the transport can serve a new one
+    first.close();
+    QVERIFY(first.receive());
+    QTcpSocket thirdClient;
+    thirdClient.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(thirdClient.waitForConnected(5000));
+    thirdClient.write(createRequest(createRequestBody("1", "IMEI:3", 1)));
+    QTRY_COMPARE(firstData.count(), 2);
+    QCOMPARE(secondData.count(), 1);
+
+    // Next message of ongoing session goes to the same transport, even when it
+    // comes on another connection
+    QVERIFY(second.receive());
+    QTcpSocket otherClient;
+    otherClient.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(otherClient.waitForConnected(5000));
+    otherClient.write(createRequest(createRequestBody("1", "IMEI:2", 2)));
+    QTRY_COMPARE(secondData.count(), 2);
+    QCOMPARE(firstData.count(), 2);
+}
+
+void HTTPServerTransportTest::testTransportProvider()
+{
+    HTTPServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    // Provided transports are attached to the server
+    Transport* transport = server.acquireTransport();
+    QVERIFY(transport != NULL);
+    QVERIFY(qobject_cast<HTTPServerTransport*>(transport) != NULL);
+    QVERIFY(transport->init());
+
+    QSignalSpy data(transport, SIGNAL(readXMLData(QIODevice*, bool)));
+    QVERIFY(transport->receive());
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(client.waitForConnected(5000));
+    client.write(createRequest(createRequestBody("1", "IMEI:1", 1)));
+    QTRY_COMPARE(data.count(), 1);
+
+    // Released transport is detached, so new sessions are not served
+    server.releaseTransport(transport);
+    transport = NULL;
+
+    QByteArray headers;
+    QCOMPARE(sendRequest(server.serverPort(), createRequest(createRequestBody("1", "IMEI:2", 1)), headers), 503);
+
+    // Transports that are not released are deleted with the server
+    QVERIFY(server.acquireTransport() != NULL);
+}
+
+void HTTPServerTransportTest::testCompression()
+{
+    HTTPServerTransport transport;
+    transport.setProperty(HTTPSERVERADDRESSPROP, "127.0.0.1");
+    transport.setProperty(HTTPCOMPRESSIONTHRESHOLDPROP, "100");
+    QVERIFY(transport.init());
+
+    QSignalSpy readData(&transport, SIGNAL(readXMLData(QIODevice*, bool)));
+    QVERIFY(transport.receive());
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, transport.server().serverPort());
+    QVERIFY(client.waitForConnected(5000));
+
+    HTTPContentEncoder encoder;
+    QByteArray body = createRequestBody("1", "IMEI:1234", 1);
+    QByteArray encoded;
+    QVERIFY(encoder.encode(body, encoded));
+
+    client.write(createRequest(encoded, "Content-Encoding: gzip\r\nAccept-Encoding: gzip\r\n"));
+    QTRY_COMPARE(readData.count(), 1);
+
+    QIODevice* device = readData.at(0).at(0).value<QIODevice*>();
+    QVERIFY(device);
+    QCOMPARE(device->readAll(), body);
+
+    QVERIFY(transport.sendSyncML(createMessage("1", "server", 1)));
+
+    QByteArray headers;
+    QByteArray response;
+    QVERIFY(readResponse(client, headers, response));
+    QCOMPARE(statusCode(headers), 200);
+    QCOMPARE(headerValue(headers, HTTP_HDRSTR_CONTENT_ENCODING), QByteArray(HTTP_CONTENT_ENCODING_GZIP));
+    QVERIFY(HTTPContentEncoder::acceptsGZip(headerValue(headers, HTTP_HDRSTR_ACCEPT_ENCODING)));
+
+    QByteArray decoded;
+    QVERIFY(encoder.decode(response, decoded));
+    QVERIFY(decoded.contains("<SyncML"));
+
+    // Responses are not compressed for clients that do not accept gzip
+    QVERIFY(transport.receive());
+    client.write(createRequest(createRequestBody("1", "IMEI:1234", 2)));
+    QTRY_COMPARE(readData.count(), 2);
+
+    QVERIFY(transport.sendSyncML(createMessage("1", "server", 2)));
+    QVERIFY(readResponse(client, headers, response));
+    QVERIFY(headerValue(headers, HTTP_HDRSTR_CONTENT_ENCODING).isEmpty());
+    QVERIFY(response.contains("<SyncML"));
+}
+
+void HTTPServerTransportTest::testClientTransport()
+{
+    HTTPServerTransport server;
+    server.setProperty(HTTPSERVERADDRESSPROP, "127.0.0.1");
+    QVERIFY(server.init());
+
+    HTTPTransport client;
+    client.setWbXml(false);
+    client.setRemoteLocURI(QString("http://127.0.0.1:%1/sync").arg(server.server().serverPort()));
+    QVERIFY(client.init());
+
+    QSignalSpy serverData(&server, SIGNAL(readXMLData(QIODevice*, bool)));
+    QSignalSpy clientData(&client, SIGNAL(readXMLData(QIODevice*, bool)));
+
+    for (int i = 1; i <= 3; ++i) {
+
+        QVERIFY(server.receive());
+        QVERIFY(client.sendSyncML(createMessage("1", "IMEI:1234", i)));
+        QVERIFY(client.receive());
+        QTRY_COMPARE(serverData.count(), i);
+
+        QVERIFY(server.sendSyncML(createMessage("1", "server", i)));
+        QTRY_COMPARE(clientData.count(), i);
+
+        QIODevice* device = clientData.at(i - 1).at(0).value<QIODevice*>();
+        QVERIFY(device);
+        QVERIFY(device->readAll().contains("<MsgID>" + QByteArray::number(i) + "</MsgID>"));
+    }
+
+    client.close();
+    server.close();
+}
+
+QTEST_MAIN(HTTPServerTransportTest)
@@ -35,8 +35,12 @@
 
 #include "SyncMLMessage.h"
 #include "HTTPTransport.h"
+#include "HTTPContentEncoder.h"
+#include "datatypes.h"
 #include "SyncAgentConfigProperties.h"
 #include <QNetworkProxy>
+#include <QTcpServer>
+#include <QTcpSocket>
 
 #include "TestUtils.h"
 #include "Fragments.h"
@@ -120,4 +124,275 @@ void HTTPTransportTest::testSetProxy()
     QCOMPARE(proxy.port(), port);
 }
 
+void HTTPTransportTest::testContentEncoder()
+{
+    HTTPContentEncoder encoder;
+
+    QByteArray data;
+    for (int i = 0; i < 100; ++i) {
+        data.append("<Item><Data>foo</Data></Item>");
+    }
+
+    // gzip round trip
+    QByteArray encoded;
+    QVERIFY(encoder.encode(data, encoded));
+    QVERIFY(encoded.size() < data.size());
+    QCOMPARE(encoded.left(2), QByteArray("\x1f\x8b"));
+
+    QByteArray decoded;
+    QVERIFY(encoder.decode(encoded, decoded));
+    QCOMPARE(decoded, data);
+
+    // deflate in zlib format, qCompress() prefixes it with 4 bytes of length
+    QByteArray zlib = qCompress(data).mid(4);
+    decoded.clear();
+    QVERIFY(encoder.decode(zlib, decoded));
+    QCOMPARE(decoded, data);
+
+    // deflate without zlib header and trailer, as sent by some servers
+    QByteArray raw = zlib.mid(2, zlib.size() - 6);
+    decoded.clear();
+    QVERIFY(encoder.decode(raw, decoded));
+    QCOMPARE(decoded, data);
+
+    decoded.clear();
+    QVERIFY(!encoder.decode(QByteArray("not compressed"), decoded));
+
+    // Decompression stops at the size limit
+    bool tooLarge = true;
+    decoded.clear();
+    QVERIFY(encoder.decode(encoded, decoded, data.size(), tooLarge));
+    QVERIFY(!tooLarge);
+    QCOMPARE(decoded, data);
+
+    QByteArray large(1024 * 1024, 'a');
+    QVERIFY(encoder.encode(large, encoded));
+    decoded.clear();
+    QVERIFY(!encoder.decode(encoded, decoded, 64 * 1024, tooLarge));
+    QVERIFY(tooLarge);
+
+    decoded.clear();
+    QVERIFY(!encoder.decode(QByteArray("not compressed"), decoded, 64 * 1024, tooLarge));
+    QVERIFY(!tooLarge);
+
+    QVERIFY(HTTPContentEncoder::canDecode("gzip"));
+    QVERIFY(HTTPContentEncoder::canDecode("x-gzip"));
+    QVERIFY(HTTPContentEncoder::canDecode("Deflate"));
+    QVERIFY(!HTTPContentEncoder::canDecode("br"));
+
+    QVERIFY(HTTPContentEncoder::acceptsGZip("gzip"));
+    QVERIFY(HTTPContentEncoder::acceptsGZip("deflate, GZIP;q=0.5"));
+    QVERIFY(HTTPContentEncoder::acceptsGZip("*"));
+    QVERIFY(!HTTPContentEncoder::acceptsGZip(""));
+    QVERIFY(!HTTPContentEncoder::acceptsGZip("identity"));
+    QVERIFY(!HTTPContentEncoder::acceptsGZip("gzip;q=0, deflate"));
+}
+
+static SyncMLMessage* createMessage(int aMsgId)
+{
+    HeaderParams params;
+
+    params.verDTD = SYNCML_DTD_VERSION_1_2;
+    params.verProto = DS_VERPROTO_1_2;
+    params.msgID = aMsgId;
+    params.targetDevice = "targetDevice";
+    params.sourceDevice = "sourceDevice";
+
+    return new SyncMLMessage(params, SYNCML_1_2);
+}
+
+void HTTPTransportTest::testCompression()
+{
+    HTTPServerStandIn server;
+    QVERIFY(server.listen());
+
+    QByteArray response("<SyncML>");
+    for (int i = 0; i < 100; ++i) {
+        response.append("<Status><CmdID>1</CmdID><Data>200</Data></Status>");
+    }
+    response.append("</SyncML>");
+    server.setResponse(response, SYNCML_CONTTYPE_DS_XML, HTTP_CONTENT_ENCODING_GZIP, HTTP_CONTENT_ENCODING_GZIP);
+
+    HTTPTransport transport;
+    QSignalSpy readData(&transport, SIGNAL(readXMLData(QIODevice*, bool)));
+
+    transport.setWbXml(false);
+    transport.setRemoteLocURI(QString("http://127.0.0.1:%1/sync").arg(server.port()));
+    transport.setProperty(HTTPCOMPRESSIONTHRESHOLDPROP, "100");
+    transport.init();
+
+    // Remote side has not announced yet that it accepts gzip, so first message
+    // is sent uncompressed
+    QVERIFY(transport.sendSyncML(createMessage(1)));
+    QVERIFY(transport.receive());
+    QTRY_COMPARE(readData.count(), 1);
+
+    QVERIFY(HTTPContentEncoder::acceptsGZip(server.requestHeader(0, HTTP_HDRSTR_ACCEPT_ENCODING)));
+    QVERIFY(server.requestHeader(0, HTTP_HDRSTR_CONTENT_ENCODING).isEmpty());
+    QVERIFY(server.requestBody(0).contains("<SyncML"));
+
+    // Response is delivered decoded
+    QIODevice* device = readData.at(0).at(0).value<QIODevice*>();
+    QVERIFY(device);
+    QCOMPARE(device->readAll(), response);
+
+    // Response announced gzip, so message above the threshold is now compressed
+    QVERIFY(transport.sendSyncML(createMessage(2)));
+    QVERIFY(transport.receive());
+    QTRY_COMPARE(readData.count(), 2);
+
+    QCOMPARE(server.requestHeader(1, HTTP_HDRSTR_CONTENT_ENCODING), QByteArray(HTTP_CONTENT_ENCODING_GZIP));
+
+    HTTPContentEncoder encoder;
+    QByteArray request;
+    QVERIFY(encoder.decode(server.requestBody(1), request));
+    QVERIFY(request.contains("<SyncML"));
+    QVERIFY(request.contains("<MsgID>2</MsgID>"));
+
+    device = readData.at(1).at(0).value<QIODevice*>();
+    QVERIFY(device);
+    QCOMPARE(device->readAll(), response);
+
+    transport.close();
+}
+
+void HTTPTransportTest::testCompressedReplyLimit()
+{
+    // Response that inflates beyond the maximum message size is rejected
+    HTTPServerStandIn server;
+    QVERIFY(server.listen());
+    server.setResponse(QByteArray(2 * HTTP_DEFAULT_MAX_MESSAGE_SIZE, 'a'), SYNCML_CONTTYPE_DS_XML,
+                       HTTP_CONTENT_ENCODING_GZIP, HTTP_CONTENT_ENCODING_GZIP);
+
+    HTTPTransport transport;
+    QSignalSpy readData(&transport, SIGNAL(readXMLData(QIODevice*, bool)));
+    QSignalSpy sendEvent(&transport, SIGNAL(sendEvent(DataSync::TransportStatusEvent, const QString&)));
+
+    transport.setWbXml(false);
+    transport.setRemoteLocURI(QString("http://127.0.0.1:%1/sync").arg(server.port()));
+    transport.init();
+
+    QVERIFY(transport.sendSyncML(createMessage(1)));
+    QVERIFY(transport.receive());
+    QTRY_COMPARE(sendEvent.count(), 1);
+    QCOMPARE(sendEvent.at(0).at(0).value<DataSync::TransportStatusEvent>(), TRANSPORT_DATA_INVALID_CONTENT);
+    QCOMPARE(readData.count(), 0);
+
+    transport.close();
+}
+
+static QByteArray headerValue(const QByteArray& aHeaders, const QByteArray& aName)
+{
+    QList<QByteArray> lines = aHeaders.split('\n');
+
+    foreach (const QByteArray& line, lines) {
+        int colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == aName.toLower()) {
+            return line.mid(colon + 1).trimmed();
+        }
+    }
+
+    return QByteArray();
+}
+
+HTTPServerStandIn::HTTPServerStandIn()
+ : iServer(new QTcpServer(this))
+{
+    connect(iServer, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+HTTPServerStandIn::~HTTPServerStandIn()
+{
+}
+
+bool HTTPServerStandIn::listen()
+{
+    return iServer->listen(QHostAddress::LocalHost);
+}
+
+quint16 HTTPServerStandIn::port() const
+{
+    return iServer->serverPort();
+}
+
+void HTTPServerStandIn::setResponse(const QByteArray& aBody, const QByteArray& aContentType,
+                                    const QByteArray& aContentEncoding, const QByteArray& aAcceptEncoding)
+{
+    QByteArray body = aBody;
+
+    if (!aContentEncoding.isEmpty()) {
+        HTTPContentEncoder encoder;
+        encoder.encode(aBody, body);
+    }
+
+    iResponse = "HTTP/1.1 200 OK\r\n";
+    iResponse += "Content-Type: " + aContentType + "\r\n";
+    iResponse += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    iResponse += "Connection: close\r\n";
+
+    if (!aContentEncoding.isEmpty()) {
+        iResponse += "Content-Encoding: " + aContentEncoding + "\r\n";
+    }
+
+    if (!aAcceptEncoding.isEmpty()) {
+        iResponse += "Accept-Encoding: " + aAcceptEncoding + "\r\n";
+    }
+
+    iResponse += "\r\n";
+    iResponse += body;
+}
+
+QByteArray HTTPServerStandIn::requestHeader(int aRequest, const QByteArray& aName) const
+{
+    return headerValue(iRequestHeaders.value(aRequest), aName);
+}
+
+QByteArray HTTPServerStandIn::requestBody(int aRequest) const
+{
+    return iRequestBodies.value(aRequest);
+}
+
+void HTTPServerStandIn::newConnection()
+{
+    while (iServer->hasPendingConnections()) {
+        QTcpSocket* socket = iServer->nextPendingConnection();
+        iBuffers.insert(socket, QByteArray());
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readData()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void HTTPServerStandIn::readData()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket || !iBuffers.contains(socket)) {
+        return;
+    }
+
+    QByteArray& buffer = iBuffers[socket];
+    buffer.append(socket->readAll());
+
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return;
+    }
+
+    QByteArray headers = buffer.left(headerEnd);
+    int contentLength = headerValue(headers, "Content-Length").toInt();
+
+    if (buffer.size() < headerEnd + 4 + contentLength) {
+        return;
+    }
+
+    iRequestHeaders.append(headers);
+    iRequestBodies.append(buffer.mid(headerEnd + 4, contentLength));
+    iBuffers.remove(socket);
+
+    socket->write(iResponse);
+    socket->disconnectFromHost();
+
+    emit requestReceived();
+}
+
 QTEST_MAIN(HTTPTransportTest)
@@ -34,6 +34,10 @@
 #define HTTPTRANSPORTTEST_H
 
 #include <QTest>
+#include <QMap>
+
+class QTcpServer;
+class QTcpSocket;
 
 class HTTPTransportTest : public QObject {
     Q_OBJECT;
@@ -47,6 +51,48 @@ private slots:
     void testBasicXMLSend();
     void testSetProperty();
     void testSetProxy();
+    void testContentEncoder();
+    void testCompression();
+    void testCompressedReplyLimit();
+};
+
+/*! \brief Loopback stand-in for a HTTP server
+ *
+ * Records the requests it receives and replies to each of them with
+ * the same response
+ */
+class HTTPServerStandIn : public QObject
+{
+    Q_OBJECT;
+
+public:
+    HTTPServerStandIn();
+    virtual ~HTTPServerStandIn();
+
+    bool listen();
+
+    quint16 port() const;
+
+    void setResponse( const QByteArray& aBody, const QByteArray& aContentType,
+                      const QByteArray& aContentEncoding, const QByteArray& aAcceptEncoding );
+
+    QByteArray requestHeader( int aRequest, const QByteArray& aName ) const;
+
+    QByteArray requestBody( int aRequest ) const;
+
+signals:
+    void requestReceived();
+
+private slots:
+    void newConnection();
+    void readData();
+
+private:
+    QTcpServer*                     iServer;
+    QMap<QTcpSocket*, QByteArray>   iBuffers;
+    QList<QByteArray>               iRequestHeaders;
+    QList<QByteArray>               iRequestBodies;
+    QByteArray                      iResponse;
 };
 
 #endif  //  HTTPTRANSPORTTEST_H
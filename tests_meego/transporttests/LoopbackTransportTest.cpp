@@ -0,0 +1,143 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "LoopbackTransportTest.h"
+
+#include "LoopbackTransport.h"
+#include "SyncMLMessage.h"
+#include "datatypes.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+
+using namespace DataSync;
+
+Q_DECLARE_METATYPE(QIODevice*);
+
+static SyncMLMessage* createMessage(const QString& aSessionId, const QString& aSource, int aMsgId)
+{
+    HeaderParams params;
+
+    params.verDTD = SYNCML_DTD_VERSION_1_2;
+    params.verProto = DS_VERPROTO_1_2;
+    params.sessionID = aSessionId;
+    params.msgID = aMsgId;
+    params.targetDevice = "target";
+    params.sourceDevice = aSource;
+
+    return new SyncMLMessage(params, SYNCML_1_2);
+}
+
+void LoopbackTransportTest::testPeers()
+{
+    LoopbackTransport first;
+    LoopbackTransport second;
+    QVERIFY(!first.init());
+
+    first.setPeer(&second);
+    QCOMPARE(first.peer(), &second);
+    QCOMPARE(second.peer(), &first);
+    QVERIFY(first.init());
+    QVERIFY(second.init());
+
+    // Connecting with a new peer disconnects the old one
+    LoopbackTransport third;
+    third.setPeer(&second);
+    QCOMPARE(third.peer(), &second);
+    QCOMPARE(second.peer(), &third);
+    QVERIFY(first.peer() == NULL);
+
+    {
+        LoopbackTransport fourth;
+        fourth.setPeer(&third);
+        QVERIFY(second.peer() == NULL);
+    }
+
+    // Deleted peer is disconnected
+    QVERIFY(third.peer() == NULL);
+}
+
+void LoopbackTransportTest::testSendReceive()
+{
+    qRegisterMetaType<QIODevice*>("QIODevice*");
+
+    LoopbackTransport client;
+    LoopbackTransport server;
+    client.setPeer(&server);
+
+    QSignalSpy clientData(&client, SIGNAL(readXMLData(QIODevice*, bool)));
+    QSignalSpy serverData(&server, SIGNAL(readXMLData(QIODevice*, bool)));
+
+    // Message is delivered through the event loop
+    QVERIFY(client.sendSyncML(createMessage("1", "client", 1)));
+    QCOMPARE(serverData.count(), 0);
+    QCOMPARE(client.messagesSent(), 1);
+    QVERIFY(client.bytesSent() > 0);
+    QCOMPARE(server.messagesSent(), 0);
+
+    // Receiving after delivery reads the buffered message
+    QTest::qWait(0);
+    QCOMPARE(serverData.count(), 0);
+    QVERIFY(server.receive());
+    QCOMPARE(serverData.count(), 1);
+
+    // Receiving before delivery reads the message when it arrives
+    QVERIFY(client.receive());
+    QVERIFY(server.sendSyncML(createMessage("1", "server", 1)));
+    QCOMPARE(clientData.count(), 0);
+    QTRY_COMPARE(clientData.count(), 1);
+
+    qint64 bytes = client.bytesSent();
+    QVERIFY(client.sendSyncML(createMessage("1", "client", 2)));
+    QCOMPARE(client.messagesSent(), 2);
+    QVERIFY(client.bytesSent() > bytes);
+
+    client.resetStatistics();
+    QCOMPARE(client.messagesSent(), 0);
+    QCOMPARE(client.bytesSent(), qint64(0));
+}
+
+void LoopbackTransportTest::testNotConnected()
+{
+    LoopbackTransport transport;
+    QSignalSpy events(&transport, SIGNAL(sendEvent(DataSync::TransportStatusEvent, QString)));
+
+    // Message is not consumed when sending fails
+    SyncMLMessage* message = createMessage("1", "client", 1);
+    QVERIFY(!transport.sendSyncML(message));
+    delete message;
+    QCOMPARE(events.count(), 1);
+    QCOMPARE(transport.messagesSent(), 0);
+}
+
+QTEST_MAIN(LoopbackTransportTest)
@@ -3,7 +3,9 @@ TEMPLATE = subdirs
 SUBDIRS = \
     BaseTransportTest.pro \
     ClientWorkerTest.pro \
+    HTTPServerTransportTest.pro \
     HTTPTransportTest.pro \
+    LoopbackTransportTest.pro \
     OBEXTransportTest.pro \
     ServerWorkerTest.pro \
 